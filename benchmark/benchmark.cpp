@@ -0,0 +1,1977 @@
+//
+// CSC 212 - Data Structures and Abstractions
+// Dominic Tucchio, Jennipher Day, Maya Geva, Thomas Williams
+// Spring 2024 Term Project - benchmark.cpp
+//
+
+#include "workload.h"
+#include "../warehouse/warehouse.h"
+#include "../warehouse/site.h"
+#include "../warehouse/parallel.h"
+
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <cstdlib>
+#include <filesystem>
+#include <functional>
+#include <iomanip>
+#include <map>
+#include <mutex>
+#include <queue>
+#include <sstream>
+#include <thread>
+#include <cmath>
+
+//
+// COUNTING ALLOCATOR
+// Replaces the global operator new and delete for the benchmark executable so the number of heap allocations made by
+// a block of code can be measured. Every allocation, including over-aligned ones, increments allocation_count and adds
+// its size to allocation_bytes.
+//
+
+// ALLOCATION_COUNT, ALLOCATION_BYTES: The number and total size of the heap allocations made since the program started.
+static std::atomic<long long> allocation_count(0);
+static std::atomic<long long> allocation_bytes(0);
+
+void* operator new(std::size_t size){
+    allocation_count.fetch_add(1, std::memory_order_relaxed);
+    allocation_bytes.fetch_add(size, std::memory_order_relaxed);
+    void* p = std::malloc(size == 0 ? 1 : size);
+    if(p == nullptr) throw std::bad_alloc();
+    return p;
+}
+
+void* operator new(std::size_t size, std::align_val_t align){
+    allocation_count.fetch_add(1, std::memory_order_relaxed);
+    allocation_bytes.fetch_add(size, std::memory_order_relaxed);
+    std::size_t a = (std::size_t)align;
+    void* p = std::aligned_alloc(a, (size + a - 1) / a * a);
+    if(p == nullptr) throw std::bad_alloc();
+    return p;
+}
+
+void* operator new[](std::size_t size){ return operator new(size); }
+void* operator new[](std::size_t size, std::align_val_t align){ return operator new(size, align); }
+// FUNCTION: Frees memory from the operators above. It is kept out of line so GCC does not see std::free(...) called on
+// memory from operator new, which -Wmismatched-new-delete reports once the operators are inlined into their callers.
+__attribute__((noinline)) static void release(void* p) noexcept { std::free(p); }
+
+void operator delete(void* p) noexcept { release(p); }
+void operator delete[](void* p) noexcept { release(p); }
+void operator delete(void* p, std::size_t) noexcept { release(p); }
+void operator delete[](void* p, std::size_t) noexcept { release(p); }
+void operator delete(void* p, std::align_val_t) noexcept { release(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { release(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept { release(p); }
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept { release(p); }
+
+//
+// STRUCTURE: NullBuffer
+// A stream buffer that discards everything written to it. The Warehouse class reports results and errors on the standard
+// output, so std::cout is pointed at this buffer while operations are being timed.
+//
+
+struct NullBuffer : public std::streambuf {
+    int overflow(int c) { return c; }
+};
+
+//
+// STRUCTURE: BenchmarkOptions
+// Options controlling how the benchmark is run. Each repetition rebuilds the Warehouse from scratch and times every
+// selected operation; warm-up repetitions run the same steps without recording samples.
+//
+
+struct BenchmarkOptions {
+    // WARMUP: The number of untimed repetitions.
+    int warmup = 1;
+    // REPETITIONS: The number of timed repetitions.
+    int repetitions = 5;
+    // QUERIES: The number of findItem(...), findSpace(...), findNearestSpace(...), canStore(...) and getPath(...) calls made
+    // per repetition.
+    int queries = 100;
+    // OPERATIONS: The operations to time. add_unit is always executed because every other operation needs a floor.
+    std::vector<std::string> operations = {"add_unit", "add", "findItem", "findSpace", "findNearestSpace", "canStore", "getPath", "remove", "pick", "print"};
+    // OUTPUT: The file the machine-readable results are written to.
+    std::string output = "benchmark_results.json";
+    // SCAN_FLOOR: The side length of the full floor used to compare free-capacity scans, or 0 to skip them.
+    int scan_floor = 0;
+    // CHECK_ALLOCATIONS: The number of placements checked for heap allocations, or 0 to run the benchmark instead.
+    int check_allocations = 0;
+    // ROUTE_FLOOR: The side length of the floor used to compare routing modes, or 0 to skip them.
+    int route_floor = 0;
+    // ROUTE_QUERIES: The number of paths found with each routing mode.
+    int route_queries = 20;
+    // PICK_FLOOR: The side length of the floor used to compare pick list orders, or 0 to skip them.
+    int pick_floor = 0;
+    // PICK_STOPS, PICK_LISTS: The number of Items on each pick list and the number of pick lists planned.
+    int pick_stops = 50;
+    int pick_lists = 10;
+    // WAVE_ORDERS, WAVE_CAPACITY: The number of orders in the wave planned on the pick floor, or 0 to skip it, and the
+    // most Items picked on one tour.
+    int wave_orders = 0;
+    int wave_capacity = 20;
+    // SLOTTING_FLOOR, SLOTTING_PICKS: The side length of the floor used to compare placement policies, or 0 to skip
+    // them, and the number of pick lists in the pick history, half learned from and half replayed.
+    int slotting_floor = 0;
+    int slotting_picks = 1000;
+    // CONSOLIDATE_FLOOR, CONSOLIDATE_BUDGET: The side length of the floor used to measure consolidation, or 0 to skip
+    // it, and the most moves made by each consolidation cycle.
+    int consolidate_floor = 0;
+    int consolidate_budget = 200;
+    // FORK_FLOOR, FORKS, FORK_ITEMS: The side length of the floor used to measure Warehouse::fork(), or 0 to skip it,
+    // the number of scenarios forked from it, and the number of Items added to each scenario.
+    int fork_floor = 0;
+    int forks = 100;
+    int fork_items = 10;
+    // SITE_FLOORS, SITE_SIDE, SITE_QUERIES: The number of floors of the Site used to measure multi-floor building and
+    // routing, or 0 to skip it, the side length of each floor, and the number of paths found between random floors.
+    int site_floors = 0;
+    int site_side = 200;
+    int site_queries = 20;
+    // CONGESTION_FLOOR, PICKERS, CONGESTION_ROUNDS, CONGESTION_PENALTY: The side length of the floor used to measure
+    // congestion-aware routing, or 0 to skip it, the number of pickers routed at once, the number of trips each picker
+    // makes, and the penalty per unit of traffic compared with routing by distance alone.
+    int congestion_floor = 0;
+    int pickers = 16;
+    int congestion_rounds = 20;
+    int congestion_penalty = 1;
+    // AGENTS_FLOOR, AGENTS, AGENTS_BUDGET: The side length of the floor used to measure multi-agent planning, or 0 to
+    // skip it, the number of agents planned at once, and the planning budget in milliseconds.
+    int agents_floor = 0;
+    int agents = 200;
+    int agents_budget = 2000;
+    // INDEX_SKUS, INDEX_QUERIES: The number of distinct Item names put in an ItemIndex to measure prefix and pattern
+    // queries, or 0 to skip it, and the number of queries of each kind.
+    int index_skus = 0;
+    int index_queries = 100;
+    // RESERVE_FLOOR, DOCKS, PALLETS: The side length of the floor used to measure capacity reservations, or 0 to skip
+    // it, the number of docks reserving at once, each on its own thread, and the number of pallets each dock reserves.
+    int reserve_floor = 0;
+    int docks = 8;
+    int pallets = 2000;
+    // PARALLEL_FLOOR, THREADS: The side length of the floor used to measure the passes over every cell that run in
+    // parallel, or 0 to skip them, and the most threads they are run with, doubling from 1.
+    int parallel_floor = 0;
+    int threads = 64;
+};
+
+//
+// STRUCTURE: ForkResults
+// The cost of what-if scenarios made with Warehouse::fork(), against copying the Warehouse by rebuilding it.
+//
+
+struct ForkResults {
+    // BASE_BYTES: The estimated heap memory of the Warehouse the scenarios are forked from.
+    size_t base_bytes = 0;
+    // REBUILD_NS, REBUILD_BYTES: The time and heap bytes allocated to copy the Warehouse by rebuilding it from its
+    // StorageUnits.
+    long long rebuild_ns = 0;
+    long long rebuild_bytes = 0;
+    // FORK_NS: The median time of a single fork().
+    long long fork_ns = 0;
+    // SCENARIO_BYTES: The mean heap bytes allocated by a fork() and the Items added to it.
+    long long scenario_bytes = 0;
+    // MISMATCHES: The number of scenarios whose results differed from the same Items added to a rebuilt copy.
+    int mismatches = 0;
+    // BASE_UNCHANGED: True if the Warehouse the scenarios were forked from was left as it was.
+    bool base_unchanged = true;
+};
+
+//
+// STRUCTURE: SiteResults
+// The cost of building a Site's floors one after another and in parallel, and of finding paths between its floors,
+// checked against a search over every cell of every floor.
+//
+
+struct SiteResults {
+    // SERIAL_NS, PARALLEL_NS: The time taken to build every floor on one thread and with Site's parallel constructor.
+    long long serial_ns = 0;
+    long long parallel_ns = 0;
+    // PORTALS_NS: The time taken to measure the distances between the portals of every floor.
+    long long portals_ns = 0;
+    // ROUTE_NS, REFERENCE_NS: The median time of Site::route(...) and of the search over every cell.
+    long long route_ns = 0;
+    long long reference_ns = 0;
+    // MISMATCHES, BROKEN: The number of paths whose length differed from the search over every cell, and the number
+    // whose cells did not join up or did not add up to their length.
+    int mismatches = 0;
+    int broken = 0;
+    // ADD_NS, FLOORS_USED: The mean time to add one of the workload's Items preferring the first floor, and the number
+    // of floors the Items ended up on.
+    long long add_ns = 0;
+    int floors_used = 0;
+    // MEMORY: The estimated heap memory of the Site.
+    size_t memory = 0;
+};
+
+//
+// STRUCTURE: CongestionResults
+// The distance walked and time taken by pickers routed at once, by distance alone or with a congestion penalty.
+//
+
+struct CongestionResults {
+    // PENALTY: The penalty per unit of traffic, 0 for routing by distance alone.
+    int penalty = 0;
+    // DISTANCE: The total length of every trip.
+    long long distance = 0;
+    // TRAVEL: The total time of every trip, where a step shared by k pickers in the same round takes k times as long.
+    long long travel = 0;
+    // SHARED_STEPS: The number of steps taken by a picker on an edge another picker used in the same round.
+    long long shared_steps = 0;
+    // ROUTE_NS: The median time of one route(...).
+    long long route_ns = 0;
+};
+
+//
+// STRUCTURE: IndexResults
+// The cost of building an ItemIndex of many Item names and of prefix and pattern queries against it, compared with
+// scanning every name.
+//
+
+struct IndexResults {
+    // BUILD_NS, MEMORY: The time taken to index every name and the estimated heap memory of the index.
+    long long build_ns = 0;
+    size_t memory = 0;
+    // TOTALS_NS, FIRST_NS, PATTERN_NS: The median time of ItemIndex::totals(...) for a prefix, of listing the first 100
+    // Items starting with a prefix, and of listing every Item matching a pattern with a ? and a *.
+    long long totals_ns = 0;
+    long long first_ns = 0;
+    long long pattern_ns = 0;
+    // SCAN_NS: The median time of counting the names starting with a prefix by checking every name.
+    long long scan_ns = 0;
+    // MATCHES, MISMATCHES: The mean number of Items matching a prefix, and the number of queries whose totals or first
+    // Items differed from the scan.
+    long long matches = 0;
+    int mismatches = 0;
+};
+
+//
+// STRUCTURE: ReserveResults
+// Many docks reserving, committing, and aborting space for pallets at once, either concurrently through the
+// ReservationBook's striped locks or one at a time behind a single lock, and whether any StorageUnit was overbooked.
+//
+
+struct ReserveResults {
+    // MODE: "striped" or "global lock".
+    std::string mode;
+    // RESERVE_NS: The wall time taken by every dock, excluding settling.
+    long long reserve_ns = 0;
+    // RESERVED, FAILED, COMMITTED: The number of pallets held, the number that could not be held, and the number
+    // committed; the rest were aborted or timed out.
+    int reserved = 0;
+    int failed = 0;
+    int committed = 0;
+    // OVERBOOKED: The number of StorageUnits holding more than their capacity afterwards, and the number of rounds in
+    // which the space stored differed from the space committed.
+    int overbooked = 0;
+    int mismatched = 0;
+};
+
+//
+// STRUCTURE: ParallelResults
+// The passes over every cell of a floor run with a given number of threads, and whether their results matched the
+// results with one thread.
+//
+
+struct ParallelResults {
+    // THREADS: The number of threads the passes were limited to.
+    int threads = 0;
+    // BUILD_NS, EMPTY_NS, PRINT_NS: The median time of building the graph of a full floor, of finding the only empty cell
+    // of that floor, and of Warehouse::print().
+    long long build_ns = 0;
+    long long empty_ns = 0;
+    long long print_ns = 0;
+    // IDENTICAL: True if the graph, the empty cell, and the exports were the same as with one thread.
+    bool identical = true;
+};
+
+//
+// STRUCTURE: AgentsResults
+// The routes planned for many agents at once, checked for conflicts and compared with each agent taking its own
+// shortest path regardless of the others.
+//
+
+struct AgentsResults {
+    // PLANNED, MAKESPAN, COST: The number of agents routed, the time the last one arrives, and the sum of arrival times.
+    int planned = 0;
+    int makespan = 0;
+    long long cost = 0;
+    // CONFLICTS: The number of times two planned agents share a cell or an edge at the same time step; always 0.
+    long long conflicts = 0;
+    // LOWER_BOUND, SHORTEST_MAKESPAN, SHORTEST_CONFLICTS: The sum and the largest of the agents' shortest path lengths,
+    // and the number of conflicts if every agent took its shortest path without waiting.
+    long long lower_bound = 0;
+    int shortest_makespan = 0;
+    long long shortest_conflicts = 0;
+    // PLAN_NS, RESERVATIONS: The time spent planning and the number of reservations made.
+    long long plan_ns = 0;
+    size_t reservations = 0;
+};
+
+//
+// STRUCTURE: ConsolidationResults
+// How fragmented a nearly full floor was before and after consolidation, and the cost of the consolidation cycles.
+//
+
+struct ConsolidationResults {
+    // BEFORE, AFTER: The fragmentation before the first cycle and after the last.
+    Fragmentation before;
+    Fragmentation after;
+    // LARGE_BEFORE, LARGE_AFTER: The number of StorageUnits with at least half of the largest capacity free.
+    int large_before = 0;
+    int large_after = 0;
+    // CYCLES, MOVES, SKIPPED: The number of cycles run and the moves made and skipped over all of them.
+    int cycles = 0;
+    int moves = 0;
+    int skipped = 0;
+    // PLAN_NS, COMMIT_NS: The total time spent waiting for cycles to be planned and committing their moves.
+    long long plan_ns = 0;
+    long long commit_ns = 0;
+    // QUERIES: The number of findNearestSpace(...) queries answered while cycles were being planned.
+    long long queries = 0;
+};
+
+//
+// STRUCTURE: SlottingResults
+// The cost of placing the workload's Items with a placement policy and the distance walked replaying picks afterwards.
+//
+
+struct SlottingResults {
+    // NAME: The placement policy, such as "velocity".
+    std::string name;
+    // PLACE_NS: The time taken to place every Item.
+    long long place_ns = 0;
+    // DISTANCE, LISTS: The total distance walked by the replayed pick lists and the number that could be picked.
+    long long distance = 0;
+    int lists = 0;
+};
+
+//
+// STRUCTURE: RoutingResults
+// The preprocessing cost and accuracy of each hierarchical routing configuration compared with flat Dijkstra.
+//
+
+struct RoutingResults {
+    // NAME: The configuration, such as "hpa_exact".
+    std::string name;
+    // BUILD_NS, LOAD_NS, MEMORY: The time taken to build the hierarchy, to load it from a file if it can be saved, and
+    // the memory it uses.
+    long long build_ns = 0;
+    long long load_ns = 0;
+    MemoryUsage memory;
+    // MISMATCHES: The number of paths longer than the shortest path.
+    int mismatches = 0;
+    // MAX_ERROR, MEAN_ERROR: The largest and mean relative excess length over the shortest path.
+    double max_error = 0;
+    double mean_error = 0;
+};
+
+//
+// STRUCTURE: PickingResults
+// The walk lengths of pick lists visited in input order and in the order planned by Warehouse::planPick(...), and how
+// far planned tours of short pick lists are from the shortest possible tour.
+//
+
+struct PickingResults {
+    // NAME: The routing mode used to measure distances, such as "ch".
+    std::string name;
+    // INPUT, OPTIMIZED: The mean walk length in input order and in planned order.
+    double input = 0;
+    double optimized = 0;
+    // MAX_GAP, MEAN_GAP: The largest and mean relative excess length of planned tours of short pick lists over the
+    // shortest tour.
+    double max_gap = 0;
+    double mean_gap = 0;
+};
+
+//
+// CLASS: Timings
+// Collects latency samples for each operation and computes summary statistics.
+//
+
+class Timings {
+    public:
+        // FUNCTION: Runs f and records its latency under the given operation name if recording is enabled.
+        void time(const std::string& op, bool record, const std::function<void()>& f){
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            f();
+            std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+            if(record) samples[op].push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
+        }
+
+        // FUNCTION: Returns the p-th percentile (0-100) of a sorted vector of samples using the nearest-rank method.
+        static long long percentile(const std::vector<long long>& sorted, double p){
+            if(sorted.empty()) return 0;
+            size_t rank = (size_t)std::ceil(p / 100.0 * sorted.size());
+            return sorted[rank == 0 ? 0 : rank - 1];
+        }
+
+        // SAMPLES: Latency samples in nanoseconds, keyed by operation name.
+        std::map<std::string, std::vector<long long> > samples;
+};
+
+
+//
+// STRUCTURE: BenchmarkResults
+// Everything measured by a run of the benchmark, written out by writeResults(...). Each list is empty, and each Timings
+// has no samples, when its benchmark was not selected.
+//
+
+struct BenchmarkResults {
+    // TIMINGS, MEMORY: The latency of each operation over the repetitions and the memory report of the last one.
+    Timings timings;
+    MemoryReport memory;
+    // SCANS: The free-capacity scans over StorageUnit objects and over the Grid.
+    Timings scans;
+    // ROUTING, ROUTES: The routing queries and each hierarchical routing configuration.
+    Timings routing;
+    std::vector<RoutingResults> routes;
+    // PICKING, PICKS: The pick list planning queries and the walk lengths of each routing mode.
+    Timings picking;
+    std::vector<PickingResults> picks;
+    // WAVES, WAVE_PLANS: The wave planning queries and the wave planned in each mode.
+    Timings waves;
+    std::vector<std::pair<std::string, WavePlan> > wave_plans;
+    // SLOTTING, CONSOLIDATION, FORKS, SITES, CONGESTION, AGENTS, INDEXES, RESERVES, PARALLEL: The results of the other
+    // benchmarks.
+    std::vector<SlottingResults> slotting;
+    std::vector<ConsolidationResults> consolidation;
+    std::vector<ForkResults> forks;
+    std::vector<SiteResults> sites;
+    std::vector<CongestionResults> congestion;
+    std::vector<AgentsResults> agents;
+    std::vector<IndexResults> indexes;
+    std::vector<ReserveResults> reserves;
+    std::vector<ParallelResults> parallel;
+};
+
+// FUNCTION: Returns true if the given operation was selected on the command line.
+bool selected(const BenchmarkOptions& options, const std::string& op){
+    return std::find(options.operations.begin(), options.operations.end(), op) != options.operations.end();
+}
+
+// FUNCTION: Runs a single repetition: builds a Warehouse from the generated units, inserts the generated items, and runs
+// the query operations. Latencies are only recorded when record is true. The Warehouse's memory report is stored in
+// memory at the end of the repetition.
+void runRepetition(WorkloadGenerator& generator, const WorkloadConfig& config, const BenchmarkOptions& options, Timings& timings, bool record, std::mt19937& rng, MemoryReport& memory){
+    Warehouse w;
+
+    for(StorageUnit& u : generator.units()){
+        timings.time("add_unit", record && selected(options, "add_unit"), [&](){ w.add_unit(u); });
+    }
+
+    if(selected(options, "add")){
+        for(Item& i : generator.items()){
+            timings.time("add", record, [&](){ w.add(i); });
+        }
+    }
+
+    std::uniform_int_distribution<int> sku(0, config.skus - 1);
+    std::uniform_int_distribution<int> row(0, config.rows - 1);
+    std::uniform_int_distribution<int> col(0, config.cols - 1);
+
+    if(selected(options, "findItem")){
+        for(int q = 0; q < options.queries; q++){
+            std::string name = generator.skuName(sku(rng));
+            timings.time("findItem", record, [&](){ w.findItem(name); });
+        }
+    }
+
+    std::uniform_int_distribution<int> space(1, config.max_capacity);
+
+    if(selected(options, "findSpace")){
+        for(int q = 0; q < options.queries; q++){
+            std::pair<int, int> low = {row(rng), col(rng)};
+            std::pair<int, int> high = {low.first + 9, low.second + 9};
+            int k = space(rng);
+            timings.time("findSpace", record, [&](){ w.findSpace(low, high, k); });
+        }
+    }
+
+    if(selected(options, "findNearestSpace")){
+        for(int q = 0; q < options.queries; q++){
+            std::pair<int, int> loc = {row(rng), col(rng)};
+            int k = space(rng);
+            timings.time("findNearestSpace", record, [&](){ w.findNearestSpace(loc, k, 1); });
+        }
+    }
+
+    if(selected(options, "canStore")){
+        std::uniform_int_distribution<int> quantity(1, config.max_quantity), size(1, config.max_size);
+        for(int q = 0; q < options.queries; q++){
+            Item i(generator.skuName(sku(rng)), quantity(rng), size(rng));
+            timings.time("canStore", record, [&](){ w.canStore(i); });
+        }
+    }
+
+    if(selected(options, "getPath")){
+        for(int q = 0; q < options.queries; q++){
+            std::pair<int, int> src = {row(rng), col(rng)};
+            std::vector<std::pair<int, int> > dest = {{row(rng), col(rng)}};
+            timings.time("getPath", record, [&](){ w.getPath(src, dest); });
+        }
+    }
+
+    // Removing and picking drain the stock the queries above ran against, so they run last.
+    std::uniform_int_distribution<int> drained(1, config.max_quantity);
+
+    if(selected(options, "remove")){
+        for(int q = 0; q < options.queries; q++){
+            std::string name = generator.skuName(sku(rng));
+            int n = drained(rng);
+            timings.time("remove", record, [&](){ w.remove(name, n); });
+        }
+    }
+
+    if(selected(options, "pick")){
+        for(int q = 0; q < options.queries; q++){
+            std::string name = generator.skuName(sku(rng));
+            std::pair<int, int> src = {row(rng), col(rng)};
+            int n = drained(rng);
+            timings.time("pick", record, [&](){ w.pick(src, name, n); });
+        }
+    }
+
+    if(selected(options, "print")){
+        timings.time("print", record, [&](){ w.print(); });
+    }
+
+    memory = w.memoryUsage();
+}
+
+// FUNCTION: Compares the Grid's structure-of-arrays scans against the same scans over one StorageUnit object per cell,
+// the layout the Grid replaced, on a full side x side floor. Each scan is timed once per repetition after one untimed
+// pass; samples are recorded as "<scan>/objects" and "<scan>/grid".
+void runScans(int side, const WorkloadConfig& config, const BenchmarkOptions& options, Timings& scans){
+    std::mt19937 rng(config.seed + 4);
+    std::uniform_int_distribution<int> capacity_dist(config.min_capacity, config.max_capacity);
+
+    // Both layouts hold the same capacities and used capacities.
+    std::vector<StorageUnit> objects;
+    objects.reserve((size_t)side * side);
+    Grid grid;
+    for(int x = 0; x < side; x++){
+        for(int y = 0; y < side; y++){
+            int capacity = capacity_dist(rng);
+            StorageUnit u(capacity, {x, y}, std::map<std::string, Item>(), std::uniform_int_distribution<int>(0, capacity)(rng));
+            grid.set(u);
+            objects.push_back(u);
+        }
+    }
+
+    // A threshold no StorageUnit meets makes "first free" scan the whole floor; the midpoint selects about half of them.
+    int none = config.max_capacity + 1;
+    int half = (config.max_capacity + 1) / 2;
+    volatile long long sink = 0;
+
+    for(int r = 0; r <= options.repetitions; r++){
+        bool record = r > 0;
+        scans.time("first_free/objects", record, [&](){
+            std::pair<int, int> found = {-1, -1};
+            for(StorageUnit& u : objects){
+                if(u.getCapacity() - u.getUsedCapacity() >= none){ found = u.getLocation(); break; }
+            }
+            sink += found.first;
+        });
+        scans.time("first_free/grid", record, [&](){ sink += grid.firstFree(none).first; });
+
+        scans.time("count_free/objects", record, [&](){
+            long long n = 0;
+            for(StorageUnit& u : objects) n += (u.getCapacity() - u.getUsedCapacity() >= half);
+            sink += n;
+        });
+        scans.time("count_free/grid", record, [&](){
+            long long n = 0;
+            grid.forEachFree(half, [&](const GridCell&){ n++; });
+            sink += n;
+        });
+
+        scans.time("sum_used/objects", record, [&](){
+            long long total = 0;
+            for(StorageUnit& u : objects) total += u.getUsedCapacity();
+            sink += total;
+        });
+        scans.time("sum_used/grid", record, [&](){ sink += grid.totalUsed(); });
+    }
+}
+
+//
+// STRUCTURE: RandomFloor
+// The StorageUnits of a random side x side floor, and the capacity of every cell in row-major order, 0 for an empty cell.
+//
+
+struct RandomFloor {
+    std::vector<StorageUnit> units;
+    std::vector<int> capacities;
+};
+
+// FUNCTION: Returns a side x side floor whose cells each hold a StorageUnit with probability config.fill, drawn from
+// rng. Each StorageUnit is made by make(capacity, loc), which may draw from rng to stock it. The far corner is made
+// first so a Warehouse built from the StorageUnits never grows and only builds its graph once.
+template <typename F>
+RandomFloor randomFloor(int side, const WorkloadConfig& config, std::mt19937& rng, F make){
+    std::uniform_int_distribution<int> capacity(config.min_capacity, config.max_capacity);
+    std::uniform_real_distribution<double> chance(0.0, 1.0);
+    int cells = side * side;
+    RandomFloor floor;
+    floor.capacities.assign(cells, 0);
+    for(int c = -1; c < cells; c++){
+        std::pair<int, int> loc = c == -1 ? std::make_pair(side - 1, side - 1) : std::make_pair(c / side, c % side);
+        if(c == cells - 1 || (c != -1 && chance(rng) >= config.fill)) continue;
+        floor.units.push_back(make(capacity(rng), loc));
+        floor.capacities[loc.first * side + loc.second] = floor.units.back().getCapacity();
+    }
+    return floor;
+}
+
+// FUNCTION: Returns a random side x side floor of empty StorageUnits, as above.
+RandomFloor randomFloor(int side, const WorkloadConfig& config, std::mt19937& rng){
+    return randomFloor(side, config, rng, [](int capacity, std::pair<int, int> loc){ return StorageUnit(capacity, loc); });
+}
+
+// FUNCTION: Compares hierarchical routing against flat Dijkstra on a side x side floor whose cells each hold a StorageUnit
+// with probability config.fill. The same random pairs of cells are routed with FLAT_ROUTING, with HPA_ROUTING using an
+// entrance on every border cell (exact), with HPA_ROUTING using the default entrance spacing of 4, and with CH_ROUTING,
+// whose hierarchy is also saved to a temporary file and loaded back. Query samples are recorded as "flat", "hpa_exact",
+// "hpa_4" and "ch"; each hierarchy's build time, memory, and path length error are stored in results.
+void runRouting(int side, const WorkloadConfig& config, const BenchmarkOptions& options, Timings& routing, std::vector<RoutingResults>& results){
+    std::mt19937 rng(config.seed + 5);
+    std::uniform_int_distribution<int> cell(0, side - 1);
+
+    Warehouse w(randomFloor(side, config, rng).units);
+
+    std::vector<std::pair<std::pair<int, int>, std::pair<int, int> > > pairs;
+    for(int q = 0; q < options.route_queries; q++) pairs.push_back({{cell(rng), cell(rng)}, {cell(rng), cell(rng)}});
+
+    std::vector<int> shortest;
+    w.setRouting(FLAT_ROUTING, 16, 4);
+    for(auto& p : pairs) routing.time("flat", true, [&](){ shortest.push_back(w.route(p.first, p.second).first); });
+
+    for(int spacing : {1, 4}){
+        RoutingResults r;
+        r.name = spacing == 1 ? "hpa_exact" : "hpa_4";
+        w.setRouting(HPA_ROUTING, 16, spacing);
+
+        // Routing a cell to itself builds the hierarchy without searching it.
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        w.route({0, 0}, {0, 0});
+        r.build_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+        for(std::pair<std::string, MemoryUsage>& m : w.memoryUsage().subsystems){
+            if(m.first == "hierarchical graph") r.memory = m.second;
+        }
+
+        for(int q = 0; q < (int)pairs.size(); q++){
+            int length = 0;
+            routing.time(r.name, true, [&](){ length = w.route(pairs[q].first, pairs[q].second).first; });
+            double error = shortest[q] == 0 ? 0 : (double)(length - shortest[q]) / shortest[q];
+            if(length != shortest[q]) r.mismatches++;
+            r.max_error = std::max(r.max_error, error);
+            r.mean_error += error / pairs.size();
+        }
+        results.push_back(r);
+    }
+
+    // The contraction hierarchy is built and saved, then loaded back from the file.
+    RoutingResults r;
+    r.name = "ch";
+    std::string file = (std::filesystem::temp_directory_path() / "warehouse_benchmark.ch").string();
+    std::filesystem::remove(file);
+    w.setRouting(CH_ROUTING, 16, 4);
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    w.preprocessRoutes(file);
+    r.build_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+    start = std::chrono::steady_clock::now();
+    w.preprocessRoutes(file);
+    r.load_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+    std::filesystem::remove(file);
+    for(std::pair<std::string, MemoryUsage>& m : w.memoryUsage().subsystems){
+        if(m.first == "contraction hierarchy") r.memory = m.second;
+    }
+    for(int q = 0; q < (int)pairs.size(); q++){
+        int length = 0;
+        routing.time(r.name, true, [&](){ length = w.route(pairs[q].first, pairs[q].second).first; });
+        if(length != shortest[q]) r.mismatches++;
+    }
+    results.push_back(r);
+}
+
+// FUNCTION: Returns the length of the walk from src through every location in stops in order.
+long long walkLength(Warehouse& w, std::pair<int, int> src, const std::vector<std::pair<int, int> >& stops){
+    std::vector<std::pair<int, int> > points = {src};
+    points.insert(points.end(), stops.begin(), stops.end());
+    std::vector<int> matrix = w.distanceMatrix(points);
+    long long total = 0;
+    for(int k = 0; k + 1 < (int)points.size(); k++) total += matrix[k * points.size() + k + 1];
+    return total;
+}
+
+// FUNCTION: Returns the length of the shortest tour from point 0 that visits one candidate of every stop, found by
+// dynamic programming over the subsets of stops visited (Held-Karp). Only practical for a dozen or so stops.
+long long shortestTour(const std::vector<int>& matrix, int points, const std::vector<std::vector<int> >& stops){
+    int n = stops.size();
+    std::vector<long long> best((1 << n) * points, LLONG_MAX);
+    for(int s = 0; s < n; s++){
+        for(int c : stops[s]) best[(1 << s) * points + c] = std::min(best[(1 << s) * points + c], (long long)matrix[c]);
+    }
+    for(int mask = 1; mask < (1 << n); mask++){
+        for(int s = 0; s < n; s++){
+            if(!(mask & (1 << s))) continue;
+            for(int c : stops[s]){
+                long long length = best[mask * points + c];
+                if(length == LLONG_MAX) continue;
+                for(int t = 0; t < n; t++){
+                    if(mask & (1 << t)) continue;
+                    for(int d : stops[t]){
+                        long long& next = best[(mask | (1 << t)) * points + d];
+                        next = std::min(next, length + matrix[c * points + d]);
+                    }
+                }
+            }
+        }
+    }
+    long long shortest = LLONG_MAX;
+    for(int s = 0; s < n; s++){
+        for(int c : stops[s]) shortest = std::min(shortest, best[((1 << n) - 1) * points + c]);
+    }
+    return shortest;
+}
+
+// FUNCTION: Fills an empty Warehouse with a side x side floor whose cells each hold a StorageUnit with probability
+// config.fill, and stores each of config.skus Items, named "sku0" and up, in one to three random StorageUnits.
+void stockFloor(Warehouse& w, int side, const WorkloadConfig& config, std::mt19937& rng){
+    std::vector<StorageUnit> units = randomFloor(side, config, rng).units;
+    std::vector<std::vector<Item> > stored(units.size());
+    std::uniform_int_distribution<int> unit(0, units.size() - 1), copies(1, 3);
+    for(int k = 0; k < config.skus; k++){
+        for(int c = copies(rng); c > 0; c--) stored[unit(rng)].push_back(Item("sku" + std::to_string(k), 1, 1));
+    }
+    for(int u = 0; u < (int)units.size(); u++) w.add_unit(StorageUnit(units[u].getCapacity() + stored[u].size(), units[u].getLocation(), stored[u]));
+    return;
+}
+
+// FUNCTION: Compares pick list orders on a floor stocked by stockFloor(...). Random pick lists of
+// options.pick_stops Items are walked in input order, visiting the first StorageUnit holding each Item, and in the
+// order planned by Warehouse::planPick(...), with distances measured by FLAT_ROUTING and by CH_ROUTING. Planning samples
+// are recorded as "flat" and "ch". Pick lists of 10 Items are also planned and compared against the shortest tour. No
+// Item is stored in more StorageUnits than planPick(...) considers, so both see the same candidates.
+void runPicking(int side, const WorkloadConfig& config, const BenchmarkOptions& options, Timings& picking, std::vector<PickingResults>& results){
+    std::mt19937 rng(config.seed + 7);
+    Warehouse w;
+    stockFloor(w, side, config, rng);
+    std::uniform_int_distribution<int> cell(0, side - 1);
+
+
+    // Each pick list holds distinct Items.
+    std::vector<std::string> names;
+    for(int k = 0; k < config.skus; k++) names.push_back("sku" + std::to_string(k));
+    auto pickList = [&](int stops){
+        std::shuffle(names.begin(), names.end(), rng);
+        return std::vector<std::string>(names.begin(), names.begin() + std::min(stops, (int)names.size()));
+    };
+    std::vector<std::pair<std::pair<int, int>, std::vector<std::string> > > lists, short_lists;
+    for(int l = 0; l < options.pick_lists; l++) lists.push_back({{cell(rng), cell(rng)}, pickList(options.pick_stops)});
+    for(int l = 0; l < options.pick_lists; l++) short_lists.push_back({{cell(rng), cell(rng)}, pickList(10)});
+
+    for(RoutingMode mode : {FLAT_ROUTING, CH_ROUTING}){
+        PickingResults r;
+        r.name = mode == FLAT_ROUTING ? "flat" : "ch";
+        w.setRouting(mode, 16, 4);
+        if(mode == CH_ROUTING) w.preprocessRoutes("");
+
+        for(auto& list : lists){
+            std::vector<std::pair<int, int> > ordered, input;
+            picking.time(r.name, true, [&](){ ordered = w.planPick(list.first, list.second); });
+            for(std::string& i : list.second) input.push_back(w.findItem(i)[0]);
+            r.input += (double)walkLength(w, list.first, input) / lists.size();
+            r.optimized += (double)walkLength(w, list.first, ordered) / lists.size();
+        }
+
+        for(auto& list : short_lists){
+            std::vector<std::pair<int, int> > points = {list.first};
+            std::vector<std::vector<int> > stops;
+            for(std::string& i : list.second){
+                stops.push_back({});
+                for(std::pair<int, int> l : w.findItem(i)){
+                    int index = std::find(points.begin(), points.end(), l) - points.begin();
+                    if(index == (int)points.size()) points.push_back(l);
+                    stops.back().push_back(index);
+                }
+            }
+            long long shortest = shortestTour(w.distanceMatrix(points), points.size(), stops);
+            long long planned = walkLength(w, list.first, w.planPick(list.first, list.second));
+            double gap = shortest == 0 ? 0 : (double)(planned - shortest) / shortest;
+            r.max_gap = std::max(r.max_gap, gap);
+            r.mean_gap += gap / short_lists.size();
+        }
+        results.push_back(r);
+    }
+}
+
+// FUNCTION: Plans a wave of options.wave_orders random orders of one to five Items from the middle of a floor stocked
+// by stockFloor(...), grouped into tours of at most options.wave_capacity Items, with FLAT_ROUTING and with CH_ROUTING
+// distances. Planning samples are recorded as "flat" and "ch"; the number of tours and the distance walked by the wave
+// and by picking each order separately are stored in results.
+void runWave(int side, const WorkloadConfig& config, const BenchmarkOptions& options, Timings& waves, std::vector<std::pair<std::string, WavePlan> >& results){
+    std::mt19937 rng(config.seed + 11);
+    Warehouse w;
+    stockFloor(w, side, config, rng);
+
+    std::uniform_int_distribution<int> sku(0, config.skus - 1), size(1, 5);
+    std::vector<std::vector<std::string> > orders(options.wave_orders);
+    for(std::vector<std::string>& order : orders){
+        for(int i = size(rng); i > 0; i--) order.push_back("sku" + std::to_string(sku(rng)));
+    }
+
+    for(RoutingMode mode : {FLAT_ROUTING, CH_ROUTING}){
+        std::string name = mode == FLAT_ROUTING ? "flat" : "ch";
+        w.setRouting(mode, 16, 4);
+        if(mode == CH_ROUTING) w.preprocessRoutes("");
+        WavePlan wave;
+        for(int r = 0; r < options.repetitions; r++){
+            waves.time(name, true, [&](){ wave = w.planWave({side / 2, side / 2}, orders, options.wave_capacity); });
+        }
+        results.push_back({name, wave});
+    }
+}
+
+// FUNCTION: Compares placement policies on a replayed pick history. A side x side floor whose cells each hold a
+// StorageUnit with probability config.fill is filled with config.items random Items from config.skus SKUs. SKU k is
+// picked with a probability proportional to 1 / (k + 1), and options.slotting_picks pick lists of one to
+// config.max_stops SKUs are drawn. Before placing the Items the Warehouse learns the pick counts of the first half; the
+// second half is then replayed from a dock in the corner with OPTIMIZED_ORDER picking. The same floor, Items, and picks
+// are used with the BestFitPolicy, a NearestFitPolicy anchored at the dock, and a VelocityPolicy with the same dock.
+void runSlotting(int side, const WorkloadConfig& config, const BenchmarkOptions& options, std::vector<SlottingResults>& results){
+    std::mt19937 rng(config.seed + 13);
+    std::vector<StorageUnit> units = randomFloor(side, config, rng).units;
+
+    std::uniform_int_distribution<int> sku(0, config.skus - 1), quantity(1, config.max_quantity), size(1, config.max_size), stops(1, config.max_stops);
+    std::vector<Item> items;
+    for(int i = 0; i < config.items; i++) items.push_back(Item("sku" + std::to_string(sku(rng)), quantity(rng), size(rng)));
+
+    std::vector<double> weights;
+    for(int k = 0; k < config.skus; k++) weights.push_back(1.0 / (k + 1));
+    std::discrete_distribution<int> popular(weights.begin(), weights.end());
+    std::vector<std::vector<std::string> > history(options.slotting_picks);
+    for(std::vector<std::string>& list : history){
+        for(int s = stops(rng); s > 0; s--) list.push_back("sku" + std::to_string(popular(rng)));
+    }
+    int learned = history.size() / 2;
+    std::pair<int, int> dock = {0, 0};
+
+    for(std::string name : {"best_fit", "nearest", "velocity"}){
+        SlottingResults r;
+        r.name = name;
+        Warehouse w(units);
+        for(int l = 0; l < learned; l++) w.recordPicks(history[l]);
+        if(name == "nearest") w.setPlacement(std::unique_ptr<PlacementPolicy>(new NearestFitPolicy(dock)));
+        if(name == "velocity") w.setPlacement(std::unique_ptr<PlacementPolicy>(new VelocityPolicy(dock)));
+
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        for(Item& i : items) w.add(i);
+        r.place_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+
+        w.setPicking(OPTIMIZED_ORDER);
+        w.setRouting(CH_ROUTING, 16, 4);
+        w.preprocessRoutes("");
+        for(int l = learned; l < (int)history.size(); l++){
+            int distance = w.getPath(dock, history[l]);
+            if(distance < 0) continue;
+            r.distance += distance;
+            r.lists++;
+        }
+        results.push_back(r);
+    }
+}
+
+// FUNCTION: Measures consolidation on a side x side floor whose cells each hold a StorageUnit with probability
+// config.fill, left in the state a long run of stocking and picking leaves it in: each StorageUnit is filled to a random
+// level with small fragments of random Items from config.skus SKUs, so every SKU is scattered and the free space is in
+// slivers. Cycles of options.consolidate_budget moves are then run until one makes no move. While each cycle is planned
+// on its background thread, the benchmark keeps answering findNearestSpace(...) queries.
+void runConsolidation(int side, const WorkloadConfig& config, const BenchmarkOptions& options, ConsolidationResults& r){
+    std::mt19937 rng(config.seed + 17);
+    std::uniform_int_distribution<int> cell(0, side - 1);
+    std::uniform_int_distribution<int> sku(0, config.skus - 1), quantity(1, std::max(1, config.max_quantity / 2)), size(1, config.max_size);
+    std::uniform_real_distribution<double> chance(0.0, 1.0);
+
+    Warehouse w(randomFloor(side, config, rng, [&](int capacity, std::pair<int, int> loc){
+        int level = capacity * chance(rng), used = 0;
+        std::map<std::string, Item> stock;
+        for(int attempt = 0; attempt < 8; attempt++){
+            Item i("sku" + std::to_string(sku(rng)), quantity(rng), size(rng));
+            if(used + i.quantity * i.size_per_unit > level || (stock.count(i.name) != 0 && stock[i.name].size_per_unit != i.size_per_unit)) continue;
+            StorageUnit::add(stock, used, capacity, i);
+        }
+        return StorageUnit(capacity, loc, stock, used);
+    }).units);
+
+    r.before = w.fragmentation();
+    r.large_before = w.freeSpace(config.max_capacity / 2).first;
+    for(int moves = -1; moves != 0; r.cycles++){
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        w.startConsolidation(options.consolidate_budget);
+        while(!w.consolidationReady()){
+            w.findNearestSpace({cell(rng), cell(rng)}, 1, 1);
+            r.queries++;
+        }
+        std::chrono::steady_clock::time_point planned = std::chrono::steady_clock::now();
+        std::pair<int, int> result = w.finishConsolidation();
+        std::chrono::steady_clock::time_point committed = std::chrono::steady_clock::now();
+
+        r.plan_ns += std::chrono::duration_cast<std::chrono::nanoseconds>(planned - start).count();
+        r.commit_ns += std::chrono::duration_cast<std::chrono::nanoseconds>(committed - planned).count();
+        r.moves += result.first;
+        r.skipped += result.second;
+        moves = result.first;
+    }
+    r.after = w.fragmentation();
+    r.large_after = w.freeSpace(config.max_capacity / 2).first;
+    return;
+}
+
+// FUNCTION: Measures what-if scenarios on a side x side floor whose cells each hold a StorageUnit with probability
+// config.fill, stocked with the workload's Items. A copy made by rebuilding a Warehouse from every StorageUnit is timed
+// first; then options.forks scenarios are forked from the floor and each is given options.fork_items random Items. Every
+// scenario is checked against a rebuilt copy given the same Items, and the floor against its state before the scenarios.
+void runForks(int side, WorkloadGenerator& generator, const WorkloadConfig& config, const BenchmarkOptions& options, ForkResults& r){
+    std::mt19937 rng(config.seed + 19);
+    std::uniform_int_distribution<int> sku(0, config.skus - 1), quantity(1, config.max_quantity), size(1, config.max_size);
+
+    std::vector<StorageUnit> units = randomFloor(side, config, rng).units;
+    Warehouse base(units);
+    for(const Item& i : generator.items()) base.add(i);
+
+    size_t usage = base.getUsage();
+    Fragmentation before = base.fragmentation();
+    r.base_bytes = base.memoryUsage().total().bytes;
+
+    // The baseline copy reads every StorageUnit, Items included, back out of the floor and rebuilds the Warehouse.
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    long long bytes = allocation_bytes.load(std::memory_order_relaxed);
+    std::vector<StorageUnit> stocked;
+    for(StorageUnit& u : units) stocked.push_back(base.getUnit(u.getLocation()));
+    Warehouse rebuilt(stocked);
+    r.rebuild_bytes = allocation_bytes.load(std::memory_order_relaxed) - bytes;
+    r.rebuild_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+
+    // Every scenario is kept until all of them are made, so they share the floor with each other as well as with it.
+    std::vector<long long> fork_ns;
+    long long scenario_bytes = 0;
+    std::vector<std::unique_ptr<Warehouse> > scenarios;
+    std::vector<std::vector<Item> > added(options.forks);
+    for(int f = 0; f < options.forks; f++){
+        for(int k = 0; k < options.fork_items; k++) added[f].push_back(Item("sku" + std::to_string(sku(rng)), quantity(rng), size(rng)));
+
+        bytes = allocation_bytes.load(std::memory_order_relaxed);
+        start = std::chrono::steady_clock::now();
+        scenarios.push_back(base.fork());
+        fork_ns.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+        for(const Item& i : added[f]) scenarios.back()->add(i);
+        scenario_bytes += allocation_bytes.load(std::memory_order_relaxed) - bytes;
+    }
+
+    for(int f = 0; f < options.forks; f++){
+        Warehouse copy(stocked);
+        for(const Item& i : added[f]) copy.add(i);
+        Fragmentation a = scenarios[f]->fragmentation(), b = copy.fragmentation();
+        bool same = scenarios[f]->getUsage() == copy.getUsage() && a.fragments == b.fragments && a.free_space == b.free_space;
+        for(const Item& i : added[f]) same = same && scenarios[f]->findItem(i.name) == copy.findItem(i.name);
+        if(!same) r.mismatches++;
+    }
+
+    Fragmentation after = base.fragmentation();
+    r.base_unchanged = (size_t)base.getUsage() == usage && after.fragments == before.fragments && after.free_space == before.free_space;
+    std::sort(fork_ns.begin(), fork_ns.end());
+    r.fork_ns = Timings::percentile(fork_ns, 50);
+    r.scenario_bytes = options.forks > 0 ? scenario_bytes / options.forks : 0;
+    return;
+}
+
+// FUNCTION: Returns the length of a step between two neighboring cells of a floor with the given capacities, as weighed
+// by the Warehouse's graph.
+static int stepWeight(const std::vector<int>& capacities, int a, int b){
+    return 1 + CapacityWeight::cell(capacities[a]) + CapacityWeight::cell(capacities[b]);
+}
+
+// FUNCTION: Measures a Site of floors floors, each side x side with a StorageUnit in each cell with probability
+// config.fill. The floors are built one after another and then by Site's parallel constructor. Lifts at three places on
+// every floor join it to the floor above at a cost of 10, and options.site_queries paths between random cells of random
+// floors are found with Site::route(...). Each length is checked against Dijkstra's Algorithm over every cell of every
+// floor at once, and each path is checked to join up and add up to its length. Last, the workload's Items are added
+// preferring the first floor.
+void runSite(int floors, int side, WorkloadGenerator& generator, const WorkloadConfig& config, const BenchmarkOptions& options, SiteResults& r){
+    std::mt19937 rng(config.seed + 23);
+    std::uniform_int_distribution<int> cell(0, side - 1), level(0, floors - 1);
+
+    // The capacities of every floor are kept one floor after another.
+    int cells = side * side;
+    std::vector<std::vector<StorageUnit> > units(floors);
+    std::vector<int> capacities;
+    for(int f = 0; f < floors; f++){
+        RandomFloor floor = randomFloor(side, config, rng);
+        units[f] = std::move(floor.units);
+        capacities.insert(capacities.end(), floor.capacities.begin(), floor.capacities.end());
+    }
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    {
+        std::vector<std::unique_ptr<Warehouse> > serial;
+        for(int f = 0; f < floors; f++) serial.push_back(std::unique_ptr<Warehouse>(new Warehouse(units[f])));
+        r.serial_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+    }
+    start = std::chrono::steady_clock::now();
+    Site site(units);
+    r.parallel_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+
+    std::vector<std::pair<int, int> > lifts = {{side / 4, side / 4}, {side / 2, 3 * side / 4}, {3 * side / 4, side / 4}};
+    for(int f = 0; f + 1 < floors; f++){
+        for(std::pair<int, int> lift : lifts) site.addTransfer({f, lift}, {f + 1, lift}, 10);
+    }
+    start = std::chrono::steady_clock::now();
+    site.preprocessPortals();
+    r.portals_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+
+    // The transfers of each cell, for the search over every cell, as (cell, cost) pairs.
+    std::map<int, std::vector<std::pair<int, int> > > transfers;
+    for(const Transfer& t : site.getTransfers()){
+        int a = t.a.floor * cells + t.a.loc.first * side + t.a.loc.second, b = t.b.floor * cells + t.b.loc.first * side + t.b.loc.second;
+        transfers[a].push_back({b, t.cost});
+        transfers[b].push_back({a, t.cost});
+    }
+
+    std::vector<long long> route_ns, reference_ns;
+    for(int q = 0; q < options.site_queries; q++){
+        SiteLocation src = {level(rng), {cell(rng), cell(rng)}}, dest = {level(rng), {cell(rng), cell(rng)}};
+        start = std::chrono::steady_clock::now();
+        std::pair<int, std::vector<SiteLocation> > path = site.route(src, dest);
+        route_ns.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+
+        // Dijkstra's Algorithm over every cell of every floor.
+        start = std::chrono::steady_clock::now();
+        int from = src.floor * cells + src.loc.first * side + src.loc.second, to = dest.floor * cells + dest.loc.first * side + dest.loc.second;
+        std::vector<int> distance(floors * cells, INT_MAX);
+        std::priority_queue<std::pair<int, int>, std::vector<std::pair<int, int> >, std::greater<std::pair<int, int> > > queue;
+        distance[from] = 0;
+        queue.push({0, from});
+        while(!queue.empty()){
+            std::pair<int, int> current = queue.top();
+            queue.pop();
+            int u = current.second;
+            if(current.first > distance[u]) continue;
+            if(u == to) break;
+            int x = (u % cells) / side, y = u % side;
+            std::vector<std::pair<int, int> > next;
+            if(x > 0) next.push_back({u - side, stepWeight(capacities, u, u - side)});
+            if(x + 1 < side) next.push_back({u + side, stepWeight(capacities, u, u + side)});
+            if(y > 0) next.push_back({u - 1, stepWeight(capacities, u, u - 1)});
+            if(y + 1 < side) next.push_back({u + 1, stepWeight(capacities, u, u + 1)});
+            std::map<int, std::vector<std::pair<int, int> > >::iterator lift = transfers.find(u);
+            if(lift != transfers.end()) next.insert(next.end(), lift->second.begin(), lift->second.end());
+            for(std::pair<int, int> e : next){
+                if(distance[u] + e.second < distance[e.first]){
+                    distance[e.first] = distance[u] + e.second;
+                    queue.push({distance[e.first], e.first});
+                }
+            }
+        }
+        reference_ns.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+        if(path.first != distance[to]) r.mismatches++;
+
+        // Every step must be to a neighboring cell on the same floor or along a Transfer, and the steps must add up.
+        long long length = 0;
+        bool joined = !path.second.empty() && path.second.front().floor == src.floor && path.second.front().loc == src.loc
+                      && path.second.back().floor == dest.floor && path.second.back().loc == dest.loc;
+        for(int s = 1; joined && s < (int)path.second.size(); s++){
+            SiteLocation a = path.second[s - 1], b = path.second[s];
+            int ia = a.floor * cells + a.loc.first * side + a.loc.second, ib = b.floor * cells + b.loc.first * side + b.loc.second;
+            int cost = -1;
+            if(a.floor == b.floor && std::abs(a.loc.first - b.loc.first) + std::abs(a.loc.second - b.loc.second) == 1) cost = stepWeight(capacities, ia, ib);
+            else if(transfers.count(ia) != 0){
+                for(std::pair<int, int> e : transfers[ia]) if(e.first == ib) cost = e.second;
+            }
+            if(cost < 0) joined = false;
+            length += cost;
+        }
+        if(!joined || length != path.first) r.broken++;
+    }
+    std::sort(route_ns.begin(), route_ns.end());
+    std::sort(reference_ns.begin(), reference_ns.end());
+    r.route_ns = Timings::percentile(route_ns, 50);
+    r.reference_ns = Timings::percentile(reference_ns, 50);
+
+    std::vector<Item> items = generator.items();
+    start = std::chrono::steady_clock::now();
+    for(const Item& i : items) site.add(i, 0);
+    r.add_ns = items.empty() ? 0 : std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count() / items.size();
+    for(int f = 0; f < floors; f++) if(site.floor(f).getUsage() > 0) r.floors_used++;
+    r.memory = site.memoryUsage().total().bytes;
+    return;
+}
+
+// FUNCTION: Measures congestion-aware routing on a side x side floor whose cells each hold a StorageUnit with probability
+// config.fill. In each of options.congestion_rounds rounds every one of options.pickers pickers is routed from a random
+// cell to another, the pickers of a round on as many threads as there are cores. A step shared by k pickers in the same
+// round counts k times toward their travel time, as they queue behind each other. The same trips are routed once by
+// distance alone and once with options.congestion_penalty, and results holds both.
+void runCongestion(int side, const WorkloadConfig& config, const BenchmarkOptions& options, std::vector<CongestionResults>& results){
+    std::mt19937 rng(config.seed + 29);
+    std::uniform_int_distribution<int> cell(0, side - 1);
+
+    RandomFloor floor = randomFloor(side, config, rng);
+    std::vector<std::pair<std::pair<int, int>, std::pair<int, int> > > trips;
+    for(int t = 0; t < options.pickers * options.congestion_rounds; t++) trips.push_back({{cell(rng), cell(rng)}, {cell(rng), cell(rng)}});
+
+    for(int penalty : {0, options.congestion_penalty}){
+        CongestionResults r;
+        r.penalty = penalty;
+        Warehouse w(floor.units);
+        w.setCongestion(penalty, 4 * options.pickers);
+
+        std::vector<long long> route_ns(trips.size());
+        std::vector<std::vector<std::pair<int, int> > > paths(options.pickers);
+        for(int round = 0; round < options.congestion_rounds; round++){
+            parallelFor(options.pickers, [&](int p){
+                int t = round * options.pickers + p;
+                std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+                paths[p] = w.route(trips[t].first, trips[t].second).second;
+                route_ns[t] = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+            });
+
+            // Counting the pickers on each edge this round, then charging each step for everyone sharing it.
+            std::map<std::pair<int, int>, int> load;
+            auto edge = [&](std::pair<int, int> a, std::pair<int, int> b){
+                int ia = a.first * side + a.second, ib = b.first * side + b.second;
+                return std::make_pair(std::min(ia, ib), std::max(ia, ib));
+            };
+            for(std::vector<std::pair<int, int> >& path : paths){
+                for(int s = 1; s < (int)path.size(); s++) load[edge(path[s - 1], path[s])]++;
+            }
+            for(std::vector<std::pair<int, int> >& path : paths){
+                for(int s = 1; s < (int)path.size(); s++){
+                    std::pair<int, int> e = edge(path[s - 1], path[s]);
+                    int weight = stepWeight(floor.capacities, e.first, e.second);
+                    r.distance += weight;
+                    r.travel += (long long)weight * load[e];
+                    if(load[e] > 1) r.shared_steps++;
+                }
+            }
+        }
+        std::sort(route_ns.begin(), route_ns.end());
+        r.route_ns = Timings::percentile(route_ns, 50);
+        results.push_back(r);
+    }
+    return;
+}
+
+// FUNCTION: Returns the number of times two agents are in the same cell or on the same edge at the same time step when
+// each follows its route: it waits in a cell from its arrival until it leaves for the next, is on the edge between them
+// while moving, and stays at its last cell until time step end. Routes are given as cells and arrival times, as in an
+// AgentRoute, on a floor side cells wide.
+static long long countConflicts(const std::vector<AgentRoute>& routes, const std::vector<int>& capacities, int side, int end){
+    // Each claim is a time step and a cell (even) or the edge from a cell to its right or lower neighbor (odd).
+    std::map<std::pair<int, long long>, int> claims;
+    long long conflicts = 0;
+    for(int a = 0; a < (int)routes.size(); a++){
+        const AgentRoute& route = routes[a];
+        if(!route.planned) continue;
+        auto claim = [&](int t, long long key){
+            std::pair<std::map<std::pair<int, long long>, int>::iterator, bool> inserted = claims.insert({{t, key}, a});
+            if(!inserted.second && inserted.first->second != a) conflicts++;
+        };
+        for(int k = 0; k < (int)route.cells.size(); k++){
+            int cell = route.cells[k].first * side + route.cells[k].second;
+            if(k + 1 == (int)route.cells.size()){
+                for(int t = route.times[k]; t <= end; t++) claim(t, 2LL * cell);
+                break;
+            }
+            int next = route.cells[k + 1].first * side + route.cells[k + 1].second;
+            int leaves = route.times[k + 1] - stepWeight(capacities, cell, next);
+            for(int t = route.times[k]; t <= leaves; t++) claim(t, 2LL * cell);
+            for(int t = leaves + 1; t <= route.times[k + 1]; t++) claim(t, 2LL * (std::min(cell, next) * 2 + (std::abs(cell - next) == 1 ? 0 : 1)) + 1);
+        }
+    }
+    return conflicts;
+}
+
+// FUNCTION: Measures multi-agent planning on a side x side floor whose cells each hold a StorageUnit with probability
+// config.fill. options.agents agents are given distinct random starts and distinct random goals and planned with
+// Warehouse::planAgents(...) within options.agents_budget milliseconds. The plan is checked for conflicts by following
+// every route step by step, and compared with every agent taking its own shortest path at once, which is the lower
+// bound on the cost but collides.
+void runAgents(int side, const WorkloadConfig& config, const BenchmarkOptions& options, AgentsResults& r){
+    std::mt19937 rng(config.seed + 31);
+    int cells = side * side;
+    RandomFloor floor = randomFloor(side, config, rng);
+    Warehouse w(floor.units);
+
+    // Starts and goals are drawn from one shuffle of the floor, so no two agents share either.
+    std::vector<int> order(cells);
+    for(int c = 0; c < cells; c++) order[c] = c;
+    std::shuffle(order.begin(), order.end(), rng);
+    int count = std::min(options.agents, cells / 2);
+    std::vector<std::pair<std::pair<int, int>, std::pair<int, int> > > agents;
+    for(int a = 0; a < count; a++) agents.push_back({{order[a] / side, order[a] % side}, {order[count + a] / side, order[count + a] % side}});
+
+    AgentPlan plan = w.planAgents(agents, options.agents_budget * 1000000LL);
+    r.planned = count - plan.failed;
+    r.makespan = plan.makespan;
+    r.cost = plan.cost;
+    r.plan_ns = plan.plan_ns;
+    r.reservations = plan.reservations;
+
+    // Every agent on its own shortest path, leaving at once and never waiting.
+    std::vector<AgentRoute> shortest(count);
+    for(int a = 0; a < count; a++){
+        std::vector<std::pair<int, int> > path = w.route(agents[a].first, agents[a].second).second;
+        int t = 0;
+        for(int s = 0; s < (int)path.size(); s++){
+            if(s > 0) t += stepWeight(floor.capacities, path[s - 1].first * side + path[s - 1].second, path[s].first * side + path[s].second);
+            shortest[a].cells.push_back(path[s]);
+            shortest[a].times.push_back(t);
+        }
+        shortest[a].planned = true;
+        r.lower_bound += t;
+        r.shortest_makespan = std::max(r.shortest_makespan, t);
+    }
+    r.conflicts = countConflicts(plan.routes, floor.capacities, side, plan.makespan);
+    r.shortest_conflicts = countConflicts(shortest, floor.capacities, side, r.shortest_makespan);
+    return;
+}
+
+// FUNCTION: Measures capacity reservations on a side x side floor with config.fill of its cells holding a StorageUnit.
+// options.docks threads each reserve options.pallets pallets of 1 to 4 units of one of 100 SKUs in rounds, committing two
+// of every three pallets held and aborting the third, and the Warehouse settles the reservations between rounds, as a
+// receiving office would between waves of trucks. With global set, every call is made behind one mutex instead, as
+// docks sharing a Warehouse without reservations would have to. Every round checks that the space stored is the space
+// committed, and at the end no StorageUnit may hold more than its capacity.
+void runReserve(int side, bool global, const WorkloadConfig& config, const BenchmarkOptions& options, ReserveResults& r){
+    std::mt19937 rng(config.seed + 41);
+    std::vector<StorageUnit> units = randomFloor(side, config, rng).units;
+    Warehouse w(units);
+    r.mode = global ? "global lock" : "striped";
+
+    std::mutex lock;
+    // Each round is one truck of 50 pallets per dock.
+    const int rounds = std::max(1, options.pallets / 50);
+    for(int round = 0; round < rounds; round++){
+        std::atomic<int> reserved(0), failed(0), committed(0);
+        std::atomic<long long> space(0);
+        std::vector<std::thread> docks;
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        for(int d = 0; d < options.docks; d++){
+            docks.emplace_back([&, d](){
+                std::mt19937 dock(config.seed + round * 1000 + d);
+                for(int p = 0; p < options.pallets / rounds; p++){
+                    int sku = dock() % 100;
+                    Item pallet("Pallet-" + std::to_string(sku), 1 + dock() % 4, 1 + sku % 5);
+                    long long id;
+                    if(global){
+                        std::lock_guard<std::mutex> guard(lock);
+                        id = w.reserve(pallet, 60000000000LL);
+                    } else id = w.reserve(pallet, 60000000000LL);
+                    if(id < 0){
+                        failed++;
+                        continue;
+                    }
+                    reserved++;
+                    ReservationState state;
+                    if(global){
+                        std::lock_guard<std::mutex> guard(lock);
+                        state = p % 3 == 2 ? w.abortReservation(id) : w.commitReservation(id);
+                    } else state = p % 3 == 2 ? w.abortReservation(id) : w.commitReservation(id);
+                    if(state == RESERVATION_COMMITTED){
+                        committed++;
+                        space += pallet.quantity * pallet.size_per_unit;
+                    }
+                }
+            });
+        }
+        for(std::thread& dock : docks) dock.join();
+        r.reserve_ns += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+        r.reserved += reserved;
+        r.failed += failed;
+        r.committed += committed;
+
+        int used = w.getUsage();
+        w.settleReservations();
+        if(w.getUsage() - used != space) r.mismatched++;
+    }
+    for(const StorageUnit& u : units){
+        if(w.getUnit(u.getLocation()).getUsedCapacity() + w.reservedAt(u.getLocation()) > u.getCapacity()) r.overbooked++;
+    }
+    return;
+}
+
+// FUNCTION: Returns the contents of an export, leaving out the lines reporting the process's memory, which change from
+// one run to the next. Accepts parameter path.
+static std::string readExport(const std::string& path){
+    std::ifstream in(path);
+    std::string line, text;
+    while(std::getline(in, line)){
+        if(line.find("RSS") == std::string::npos) text += line + "\n";
+    }
+    return text;
+}
+
+// FUNCTION: Returns true if two graphs hold the same adjacency lists, with their edges in the same order. Accepts
+// parameters a and b.
+static bool sameGraph(const Graph& a, const Graph& b){
+    if(a.size() != b.size()) return false;
+    for(const std::pair<const int, std::vector<GraphEdge> >& node : a){
+        Graph::const_iterator other = b.find(node.first);
+        if(other == b.end() || other->second.size() != node.second.size()) return false;
+        for(size_t k = 0; k < node.second.size(); k++){
+            const GraphEdge& x = node.second[k];
+            const GraphEdge& y = other->second[k];
+            if(x.src != y.src || x.dest != y.dest || x.weight != y.weight) return false;
+        }
+    }
+    return true;
+}
+
+// FUNCTION: Measures the passes over every cell of a floor with 1, 2, 4, ... threads, up to options.threads. The graph
+// is built and the empty cell found on a side x side Grid with every cell occupied but the first of its last row, and
+// print() is timed on a Warehouse of the same size with config.fill of its cells holding a StorageUnit and the generated
+// Items stored. Each pass is timed over options.repetitions runs, and its result is compared with the result with one
+// thread.
+void runParallel(int side, WorkloadGenerator& generator, const WorkloadConfig& config, const BenchmarkOptions& options, std::vector<ParallelResults>& results){
+    std::mt19937 rng(config.seed + 43);
+    std::uniform_int_distribution<int> capacity(config.min_capacity, config.max_capacity);
+    std::uniform_real_distribution<double> chance(0.0, 1.0);
+    Grid grid;
+    std::vector<StorageUnit> units;
+    for(int c = -1; c < side * side; c++){
+        std::pair<int, int> loc = c == -1 ? std::make_pair(side - 1, side - 1) : std::make_pair(c / side, c % side);
+        if(c == side * side - 1 || loc == std::make_pair(side - 1, 0)) continue;
+        grid.set(StorageUnit(capacity(rng), loc));
+        if(c == -1 || chance(rng) < config.fill) units.push_back(StorageUnit(capacity(rng), loc));
+    }
+    Warehouse w(units);
+    units.clear();
+    for(Item& i : generator.items()) w.add(i);
+
+    Graph serial_graph;
+    std::pair<int, int> serial_empty;
+    std::string serial_exports;
+    for(int threads = 1; threads <= std::max(1, options.threads); threads *= 2){
+        setParallelism(threads);
+        ParallelResults r;
+        r.threads = threads;
+        std::vector<long long> build, empty, print;
+        Graph graph;
+        std::pair<int, int> found;
+        for(int rep = 0; rep < std::max(1, options.repetitions); rep++){
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            graph = WarehousePaths::buildGraph(grid);
+            std::chrono::steady_clock::time_point built = std::chrono::steady_clock::now();
+            found = grid.firstEmpty();
+            std::chrono::steady_clock::time_point searched = std::chrono::steady_clock::now();
+            w.print();
+            std::chrono::steady_clock::time_point printed = std::chrono::steady_clock::now();
+            build.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(built - start).count());
+            empty.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(searched - built).count());
+            print.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(printed - searched).count());
+        }
+        for(std::vector<long long>* samples : {&build, &empty, &print}) std::sort(samples->begin(), samples->end());
+        r.build_ns = Timings::percentile(build, 50);
+        r.empty_ns = Timings::percentile(empty, 50);
+        r.print_ns = Timings::percentile(print, 50);
+
+        std::string exports = readExport("exports/warehouse_statistics.txt") + readExport("exports/warehouse_units.csv") + readExport("exports/warehouse_items.csv");
+        if(threads == 1){
+            serial_graph.swap(graph);
+            serial_empty = found;
+            serial_exports.swap(exports);
+        } else r.identical = sameGraph(graph, serial_graph) && found == serial_empty && exports == serial_exports;
+        results.push_back(r);
+    }
+    setParallelism(0);
+    return;
+}
+
+// FUNCTION: Measures the ItemIndex on options.index_skus Item names made of one of a few dozen product families, a
+// model number, and a variant, such as "Monitor-48213-B", each stored in one location with a random quantity. Every query
+// prefix is a family and the start of a model number taken from a random name. The totals of each prefix, the first 100
+// Items starting with it, and the Items matching a pattern with a ? in the model number are timed and checked against a
+// scan of every name, which is also timed.
+void runIndex(const WorkloadConfig& config, const BenchmarkOptions& options, IndexResults& r){
+    std::mt19937 rng(config.seed + 37);
+    std::uniform_int_distribution<int> quantity(1, config.max_quantity), model(0, 99999), variant(0, 25);
+    const std::vector<std::string> families = {"Monitor", "Mouse", "Keyboard", "Cable", "Charger", "Laptop", "Dock", "Headset", "Speaker", "Camera",
+        "Router", "Switch", "Tablet", "Phone", "Printer", "Scanner", "Webcam", "Microphone", "Adapter", "Battery", "Drive", "Memory", "Monitor Arm", "Mount"};
+    std::uniform_int_distribution<int> family(0, families.size() - 1);
+
+    std::vector<std::string> names;
+    std::vector<int> quantities;
+    names.reserve(options.index_skus);
+    ItemIndex index;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for(int k = 0; k < options.index_skus; k++){
+        std::string name = families[family(rng)] + "-" + std::to_string(model(rng)) + "-" + (char)('A' + variant(rng));
+        if(index.find(name) != nullptr) continue;
+        index.insert(name, {k / 1000, k % 1000});
+        quantities.push_back(quantity(rng));
+        index.adjust(name, quantities.back());
+        names.push_back(name);
+    }
+    r.build_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+    r.memory = index.memoryUsage().bytes;
+
+    std::vector<long long> totals_ns, first_ns, pattern_ns, scan_ns;
+    std::uniform_int_distribution<int> pick(0, names.size() - 1);
+    for(int q = 0; q < options.index_queries && !names.empty(); q++){
+        const std::string& from = names[pick(rng)];
+        std::string prefix = from.substr(0, from.find('-') + 3);
+        std::string pattern = from.substr(0, from.find('-') + 2) + "?" + from.substr(from.find('-') + 3, 1) + "*";
+
+        start = std::chrono::steady_clock::now();
+        ItemTotals totals = index.totals(prefix);
+        totals_ns.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+
+        std::vector<std::string> first;
+        start = std::chrono::steady_clock::now();
+        index.forEachPrefix(prefix, [&](const std::string& name, const ItemLocations& at){
+            first.push_back(name);
+            return first.size() < 100;
+        });
+        first_ns.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+
+        int matched = 0;
+        start = std::chrono::steady_clock::now();
+        index.forEachMatch(pattern, [&](const std::string& name, const ItemLocations& at){
+            matched++;
+            return true;
+        });
+        pattern_ns.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+
+        // Every name is checked against the prefix and the pattern, as a scan of the floor would.
+        ItemTotals scanned;
+        std::vector<std::string> scanned_first;
+        int scanned_matches = 0;
+        size_t dash = pattern.find('?');
+        start = std::chrono::steady_clock::now();
+        for(int k = 0; k < (int)names.size(); k++){
+            if(names[k].compare(0, prefix.size(), prefix) == 0){
+                scanned.items++;
+                scanned.quantity += quantities[k];
+                scanned_first.push_back(names[k]);
+            }
+        }
+        scan_ns.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+        for(const std::string& name : names){
+            if(name.size() > dash + 1 && name.compare(0, dash, pattern, 0, dash) == 0 && name[dash + 1] == pattern[dash + 1]) scanned_matches++;
+        }
+        std::sort(scanned_first.begin(), scanned_first.end());
+        if(scanned_first.size() > 100) scanned_first.resize(100);
+        if(totals.items != scanned.items || totals.quantity != scanned.quantity || first != scanned_first || matched != scanned_matches) r.mismatches++;
+        r.matches += totals.items;
+    }
+    if(!totals_ns.empty()) r.matches /= (long long)totals_ns.size();
+    for(std::vector<long long>* times : {&totals_ns, &first_ns, &pattern_ns, &scan_ns}) std::sort(times->begin(), times->end());
+    r.totals_ns = Timings::percentile(totals_ns, 50);
+    r.first_ns = Timings::percentile(first_ns, 50);
+    r.pattern_ns = Timings::percentile(pattern_ns, 50);
+    r.scan_ns = Timings::percentile(scan_ns, 50);
+    return;
+}
+
+// FUNCTION: Checks that placing an Item into a StorageUnit that already holds an Item of the same name makes no heap
+// allocations. A Warehouse is filled with the generated workload, then each probe places a single unit of a generated
+// Item twice. The first placement may open a new slot; the second is counted. Warehouse::add(...) picks the candidate with
+// the least free space, so it normally picks the same StorageUnit again. A probe is only checked if the set of
+// StorageUnits holding the Item did not change and the whole Item was stored. Returns true if no checked probe allocated.
+bool checkAllocations(WorkloadGenerator& generator, int probes){
+    Warehouse w(generator.units());
+    std::vector<Item> items = generator.items();
+    for(Item& i : items) w.add(i);
+
+    int checked = 0, failed = 0;
+    long long worst = 0;
+    for(int p = 0; p < probes && !items.empty(); p++){
+        Item probe(items[p % items.size()].name, 1, items[p % items.size()].size_per_unit);
+        w.add(probe);
+
+        std::vector<std::pair<int, int> > before = w.findItem(probe.name);
+        int used = w.getUsage();
+
+        long long start = allocation_count.load(std::memory_order_relaxed);
+        w.add(probe);
+        long long allocations = allocation_count.load(std::memory_order_relaxed) - start;
+
+        if(w.findItem(probe.name) != before || w.getUsage() != used + probe.size_per_unit) continue;
+        checked++;
+        if(allocations != 0) failed++;
+        worst = std::max(worst, allocations);
+    }
+
+    std::cerr << "[Allocation Check] " << checked << " of " << probes << " placements went to an existing slot; " << failed
+              << " allocated (max " << worst << " allocations)" << std::endl;
+    return failed == 0;
+}
+
+// FUNCTION: Writes the workload description, the summary statistics of every timed operation, the memory report of
+// the last repetition, the median time of each free-capacity scan, the routing comparison, the pick list comparison, the
+// wave plans, the placement policy comparison, the consolidation results, the cost of forks, and the Site, congestion,
+// multi-agent, item index, and reservation results as JSON.
+void writeResults(const std::string& file_name, const WorkloadConfig& config, const BenchmarkOptions& options, BenchmarkResults& results){
+    std::ofstream out(file_name);
+
+    out << "{\n";
+    out << "  \"config\": {\"rows\": " << config.rows << ", \"cols\": " << config.cols << ", \"fill\": " << config.fill
+        << ", \"skus\": " << config.skus << ", \"items\": " << config.items << ", \"seed\": " << config.seed << "},\n";
+    out << "  \"warmup\": " << options.warmup << ",\n";
+    out << "  \"repetitions\": " << options.repetitions << ",\n";
+    out << "  \"operations\": {";
+
+    bool first = true;
+    for(auto& op : results.timings.samples){
+        std::vector<long long>& s = op.second;
+        std::sort(s.begin(), s.end());
+        long long total = 0;
+        for(long long t : s) total += t;
+
+        out << (first ? "\n" : ",\n");
+        out << "    \"" << op.first << "\": {\"samples\": " << s.size() << ", \"total_ns\": " << total
+            << ", \"mean_ns\": " << (s.empty() ? 0 : total / (long long)s.size())
+            << ", \"min_ns\": " << (s.empty() ? 0 : s.front())
+            << ", \"p50_ns\": " << Timings::percentile(s, 50) << ", \"p90_ns\": " << Timings::percentile(s, 90)
+            << ", \"p99_ns\": " << Timings::percentile(s, 99) << ", \"max_ns\": " << (s.empty() ? 0 : s.back()) << "}";
+        first = false;
+    }
+    out << "\n  },\n  \"memory\": ";
+    results.memory.printJSON(out, "  ");
+    out << ",\n  \"scans\": {";
+
+    first = true;
+    for(auto& op : results.scans.samples){
+        std::vector<long long>& s = op.second;
+        std::sort(s.begin(), s.end());
+        out << (first ? "\n" : ",\n") << "    \"" << op.first << "\": {\"floor\": " << options.scan_floor << ", \"p50_ns\": " << Timings::percentile(s, 50) << "}";
+        first = false;
+    }
+    out << "\n  },\n  \"routing\": {";
+
+    first = true;
+    for(auto& op : results.routing.samples){
+        std::vector<long long>& s = op.second;
+        std::sort(s.begin(), s.end());
+        out << (first ? "\n" : ",\n") << "    \"" << op.first << "\": {\"floor\": " << options.route_floor << ", \"queries\": " << s.size()
+            << ", \"p50_ns\": " << Timings::percentile(s, 50) << ", \"max_ns\": " << (s.empty() ? 0 : s.back());
+        for(RoutingResults& r : results.routes){
+            if(r.name != op.first) continue;
+            out << ", \"build_ns\": " << r.build_ns << ", \"load_ns\": " << r.load_ns << ", \"memory_bytes\": " << r.memory.bytes << ", \"mismatches\": " << r.mismatches
+                << ", \"max_error\": " << r.max_error << ", \"mean_error\": " << r.mean_error;
+        }
+        out << "}";
+        first = false;
+    }
+    out << "\n  },\n  \"picking\": {";
+
+    first = true;
+    for(PickingResults& r : results.picks){
+        std::vector<long long>& s = results.picking.samples[r.name];
+        std::sort(s.begin(), s.end());
+        out << (first ? "\n" : ",\n") << "    \"" << r.name << "\": {\"floor\": " << options.pick_floor << ", \"stops\": " << options.pick_stops
+            << ", \"lists\": " << s.size() << ", \"p50_ns\": " << Timings::percentile(s, 50) << ", \"max_ns\": " << (s.empty() ? 0 : s.back())
+            << ", \"input_length\": " << r.input << ", \"optimized_length\": " << r.optimized << ", \"max_gap\": " << r.max_gap
+            << ", \"mean_gap\": " << r.mean_gap << "}";
+        first = false;
+    }
+    out << "\n  },\n  \"waves\": {";
+
+    first = true;
+    for(std::pair<std::string, WavePlan>& plan : results.wave_plans){
+        std::vector<long long>& s = results.waves.samples[plan.first];
+        std::sort(s.begin(), s.end());
+        out << (first ? "\n" : ",\n") << "    \"" << plan.first << "\": {\"floor\": " << options.pick_floor << ", \"orders\": " << options.wave_orders
+            << ", \"capacity\": " << options.wave_capacity << ", \"p50_ns\": " << Timings::percentile(s, 50) << ", \"tours\": " << plan.second.tours.size()
+            << ", \"separate_length\": " << plan.second.separate << ", \"wave_length\": " << plan.second.distance << "}";
+        first = false;
+    }
+    out << "\n  },\n  \"slotting\": {";
+
+    first = true;
+    for(SlottingResults& r : results.slotting){
+        out << (first ? "\n" : ",\n") << "    \"" << r.name << "\": {\"floor\": " << options.slotting_floor << ", \"place_ns\": " << r.place_ns
+            << ", \"lists\": " << r.lists << ", \"distance\": " << r.distance << "}";
+        first = false;
+    }
+    out << "\n  },\n  \"consolidation\": {";
+
+    for(ConsolidationResults& r : results.consolidation){
+        out << "\n    \"floor\": " << options.consolidate_floor << ", \"budget\": " << options.consolidate_budget << ", \"cycles\": " << r.cycles
+            << ", \"moves\": " << r.moves << ", \"skipped\": " << r.skipped << ", \"plan_ns\": " << r.plan_ns << ", \"commit_ns\": " << r.commit_ns
+            << ", \"queries\": " << r.queries << ",";
+        for(int after = 0; after < 2; after++){
+            Fragmentation& f = after ? r.after : r.before;
+            out << "\n    \"" << (after ? "after" : "before") << "\": {\"skus\": " << f.skus << ", \"split_skus\": " << f.split_skus << ", \"fragments\": " << f.fragments
+                << ", \"empty_units\": " << f.empty_units << ", \"free_space\": " << f.free_space << ", \"sliver_space\": " << f.sliver_space << ", \"largest_free\": " << f.largest_free
+                << ", \"half_free_units\": " << (after ? r.large_after : r.large_before) << "}" << (after ? "" : ",");
+        }
+    }
+    out << "\n  },\n  \"forks\": {";
+
+    for(ForkResults& r : results.forks){
+        out << "\n    \"floor\": " << options.fork_floor << ", \"forks\": " << options.forks << ", \"items\": " << options.fork_items << ", \"base_bytes\": " << r.base_bytes
+            << ", \"rebuild_ns\": " << r.rebuild_ns << ", \"rebuild_bytes\": " << r.rebuild_bytes << ", \"fork_ns\": " << r.fork_ns << ", \"scenario_bytes\": " << r.scenario_bytes
+            << ", \"mismatches\": " << r.mismatches << ", \"base_unchanged\": " << (r.base_unchanged ? "true" : "false");
+    }
+    out << "\n  },\n  \"site\": {";
+
+    for(SiteResults& r : results.sites){
+        out << "\n    \"floors\": " << options.site_floors << ", \"side\": " << options.site_side << ", \"queries\": " << options.site_queries << ", \"serial_build_ns\": " << r.serial_ns
+            << ", \"parallel_build_ns\": " << r.parallel_ns << ", \"portals_ns\": " << r.portals_ns << ", \"route_ns\": " << r.route_ns << ", \"reference_ns\": " << r.reference_ns
+            << ", \"mismatches\": " << r.mismatches << ", \"broken\": " << r.broken << ", \"add_ns\": " << r.add_ns << ", \"floors_used\": " << r.floors_used << ", \"bytes\": " << r.memory;
+    }
+    out << "\n  },\n  \"congestion\": [";
+
+    for(int c = 0; c < (int)results.congestion.size(); c++){
+        CongestionResults& r = results.congestion[c];
+        out << (c == 0 ? "" : ",") << "\n    {\"floor\": " << options.congestion_floor << ", \"pickers\": " << options.pickers << ", \"rounds\": " << options.congestion_rounds
+            << ", \"penalty\": " << r.penalty << ", \"distance\": " << r.distance << ", \"travel\": " << r.travel << ", \"shared_steps\": " << r.shared_steps << ", \"route_ns\": " << r.route_ns << "}";
+    }
+    out << "\n  ],\n  \"agents\": {";
+
+    for(AgentsResults& r : results.agents){
+        out << "\n    \"floor\": " << options.agents_floor << ", \"agents\": " << options.agents << ", \"budget_ms\": " << options.agents_budget << ", \"planned\": " << r.planned
+            << ", \"makespan\": " << r.makespan << ", \"cost\": " << r.cost << ", \"conflicts\": " << r.conflicts << ", \"lower_bound\": " << r.lower_bound
+            << ", \"shortest_makespan\": " << r.shortest_makespan << ", \"shortest_conflicts\": " << r.shortest_conflicts << ", \"plan_ns\": " << r.plan_ns
+            << ", \"reservations\": " << r.reservations;
+    }
+    out << "\n  },\n  \"item_index\": {";
+
+    for(IndexResults& r : results.indexes){
+        out << "\n    \"skus\": " << options.index_skus << ", \"queries\": " << options.index_queries << ", \"build_ns\": " << r.build_ns << ", \"bytes\": " << r.memory
+            << ", \"totals_ns\": " << r.totals_ns << ", \"first_ns\": " << r.first_ns << ", \"pattern_ns\": " << r.pattern_ns << ", \"scan_ns\": " << r.scan_ns
+            << ", \"matches\": " << r.matches << ", \"mismatches\": " << r.mismatches;
+    }
+    out << "\n  },\n  \"reservations\": [";
+
+    for(int k = 0; k < (int)results.reserves.size(); k++){
+        ReserveResults& r = results.reserves[k];
+        out << (k == 0 ? "" : ",") << "\n    {\"floor\": " << options.reserve_floor << ", \"docks\": " << options.docks << ", \"pallets\": " << options.pallets
+            << ", \"mode\": \"" << r.mode << "\", \"reserve_ns\": " << r.reserve_ns << ", \"reserved\": " << r.reserved << ", \"failed\": " << r.failed
+            << ", \"committed\": " << r.committed << ", \"overbooked\": " << r.overbooked << ", \"mismatched\": " << r.mismatched << "}";
+    }
+    out << "\n  ],\n  \"parallel\": [";
+
+    for(int k = 0; k < (int)results.parallel.size(); k++){
+        ParallelResults& r = results.parallel[k];
+        out << (k == 0 ? "" : ",") << "\n    {\"floor\": " << options.parallel_floor << ", \"threads\": " << r.threads << ", \"build_ns\": " << r.build_ns
+            << ", \"empty_ns\": " << r.empty_ns << ", \"print_ns\": " << r.print_ns << ", \"identical\": " << (r.identical ? "true" : "false") << "}";
+    }
+    out << "\n  ]\n}" << std::endl;
+}
+
+// MAIN FUNCTION: Times each Warehouse operation on a synthetic workload. Results are summarized on the standard output
+// and written as JSON so they can be compared between runs.
+int main(int argc, char*argv[]){
+    WorkloadConfig config;
+    BenchmarkOptions options;
+
+    if((argc - 1) % 2 != 0){
+        std::cout << "[Benchmark Error] Incorrect command line arguments.\nUsage: ./benchmark [--warmup N] [--reps N] [--queries N] [--ops add_unit,add,findItem,findSpace,findNearestSpace,canStore,getPath,remove,pick,print] [--out results.json] [--scan-floor N] [--route-floor N] [--route-queries N] [--pick-floor N] [--pick-stops N] [--pick-lists N] [--wave-orders N] [--wave-capacity N] [--slotting-floor N] [--slotting-picks N] [--consolidate-floor N] [--consolidate-budget N] [--fork-floor N] [--forks N] [--fork-items N] [--site-floors N] [--site-side N] [--site-queries N] [--congestion-floor N] [--pickers N] [--congestion-rounds N] [--congestion-penalty N] [--agents-floor N] [--agents N] [--agents-budget MS] [--index-skus N] [--index-queries N] [--reserve-floor N] [--docks N] [--pallets N] [--parallel-floor N] [--threads N] [--check-allocations N] [workload options]" << std::endl;
+        return 1;
+    }
+
+    for(int i = 1; i < argc; i += 2){
+        std::string key(argv[i]), value(argv[i + 1]);
+        if(key == "--warmup") options.warmup = std::stoi(value);
+        else if(key == "--reps") options.repetitions = std::stoi(value);
+        else if(key == "--queries") options.queries = std::stoi(value);
+        else if(key == "--out") options.output = value;
+        else if(key == "--scan-floor") options.scan_floor = std::stoi(value);
+        else if(key == "--check-allocations") options.check_allocations = std::stoi(value);
+        else if(key == "--route-floor") options.route_floor = std::stoi(value);
+        else if(key == "--route-queries") options.route_queries = std::stoi(value);
+        else if(key == "--pick-floor") options.pick_floor = std::stoi(value);
+        else if(key == "--pick-stops") options.pick_stops = std::stoi(value);
+        else if(key == "--pick-lists") options.pick_lists = std::stoi(value);
+        else if(key == "--wave-orders") options.wave_orders = std::stoi(value);
+        else if(key == "--wave-capacity") options.wave_capacity = std::stoi(value);
+        else if(key == "--slotting-floor") options.slotting_floor = std::stoi(value);
+        else if(key == "--slotting-picks") options.slotting_picks = std::stoi(value);
+        else if(key == "--consolidate-floor") options.consolidate_floor = std::stoi(value);
+        else if(key == "--consolidate-budget") options.consolidate_budget = std::stoi(value);
+        else if(key == "--fork-floor") options.fork_floor = std::stoi(value);
+        else if(key == "--forks") options.forks = std::stoi(value);
+        else if(key == "--fork-items") options.fork_items = std::stoi(value);
+        else if(key == "--site-floors") options.site_floors = std::stoi(value);
+        else if(key == "--site-side") options.site_side = std::stoi(value);
+        else if(key == "--site-queries") options.site_queries = std::stoi(value);
+        else if(key == "--congestion-floor") options.congestion_floor = std::stoi(value);
+        else if(key == "--pickers") options.pickers = std::stoi(value);
+        else if(key == "--congestion-rounds") options.congestion_rounds = std::stoi(value);
+        else if(key == "--congestion-penalty") options.congestion_penalty = std::stoi(value);
+        else if(key == "--agents-floor") options.agents_floor = std::stoi(value);
+        else if(key == "--agents") options.agents = std::stoi(value);
+        else if(key == "--agents-budget") options.agents_budget = std::stoi(value);
+        else if(key == "--index-skus") options.index_skus = std::stoi(value);
+        else if(key == "--index-queries") options.index_queries = std::stoi(value);
+        else if(key == "--reserve-floor") options.reserve_floor = std::stoi(value);
+        else if(key == "--docks") options.docks = std::stoi(value);
+        else if(key == "--pallets") options.pallets = std::stoi(value);
+        else if(key == "--parallel-floor") options.parallel_floor = std::stoi(value);
+        else if(key == "--threads") options.threads = std::stoi(value);
+        else if(key == "--ops"){
+            std::stringstream ops(value);
+            std::string op;
+            options.operations.clear();
+            while(std::getline(ops, op, ',')) options.operations.push_back(op);
+        }
+        else if(!parseWorkloadOption(config, key, value)){
+            std::cout << "[Benchmark Error] Unknown option " << key << "." << std::endl;
+            return 1;
+        }
+    }
+
+    // Warehouse::print() exports to ./exports, so make sure it exists before timing it.
+    std::filesystem::create_directories("exports");
+
+    WorkloadGenerator generator(config);
+
+    // In allocation check mode the Warehouse's output is silenced and the result is reported on the standard error.
+    if(options.check_allocations > 0){
+        NullBuffer null_buffer;
+        std::streambuf* console = std::cout.rdbuf(&null_buffer);
+        bool passed = checkAllocations(generator, options.check_allocations);
+        std::cout.rdbuf(console);
+        return passed ? 0 : 1;
+    }
+
+    BenchmarkResults results;
+    std::mt19937 rng(config.seed + 3);
+
+    // Silence the Warehouse's standard output while operations run.
+    NullBuffer null_buffer;
+    std::streambuf* console = std::cout.rdbuf(&null_buffer);
+    for(int r = 0; r < options.warmup + options.repetitions; r++){
+        runRepetition(generator, config, options, results.timings, r >= options.warmup, rng, results.memory);
+    }
+    std::cout.rdbuf(console);
+
+    std::cout << "[Benchmark] " << config.rows << "x" << config.cols << " floor, " << options.repetitions << " repetitions" << std::endl;
+    std::cout << std::left << std::setw(18) << "operation" << std::right << std::setw(10) << "samples" << std::setw(14) << "p50 (us)" << std::setw(14) << "p90 (us)" << std::setw(14) << "p99 (us)" << std::setw(14) << "max (us)" << std::endl;
+    for(auto& op : results.timings.samples){
+        std::vector<long long> s = op.second;
+        std::sort(s.begin(), s.end());
+        std::cout << std::left << std::setw(18) << op.first << std::right << std::setw(10) << s.size() << std::fixed << std::setprecision(2)
+                  << std::setw(14) << Timings::percentile(s, 50) / 1000.0 << std::setw(14) << Timings::percentile(s, 90) / 1000.0
+                  << std::setw(14) << Timings::percentile(s, 99) / 1000.0 << std::setw(14) << (s.empty() ? 0 : s.back()) / 1000.0 << std::endl;
+    }
+
+    // Throughput of the commands that drain stock, from the mean latency.
+    for(std::string op : {"remove", "pick"}){
+        std::vector<long long>& s = results.timings.samples[op];
+        long long total = 0;
+        for(long long t : s) total += t;
+        if(total > 0) std::cout << "[Benchmark] " << op << ": " << (long long)(s.size() * 1e9 / total) << " per second" << std::endl;
+    }
+
+    MemoryUsage total = results.memory.total();
+    std::cout << "[Benchmark] Warehouse memory: " << total.bytes << " bytes in " << total.allocations << " allocations, peak RSS " << MemoryReport::peakRSS() << " bytes" << std::endl;
+
+    if(options.scan_floor > 0){
+        runScans(options.scan_floor, config, options, results.scans);
+
+        std::cout << "[Benchmark] Free-capacity scans on a " << options.scan_floor << "x" << options.scan_floor << " floor" << std::endl;
+        std::cout << std::left << std::setw(12) << "scan" << std::right << std::setw(16) << "objects (ms)" << std::setw(14) << "grid (ms)" << std::setw(12) << "speedup" << std::endl;
+        for(std::string scan : {"first_free", "count_free", "sum_used"}){
+            std::vector<long long> objects = results.scans.samples[scan + "/objects"], grid = results.scans.samples[scan + "/grid"];
+            std::sort(objects.begin(), objects.end());
+            std::sort(grid.begin(), grid.end());
+            double before = Timings::percentile(objects, 50) / 1e6, after = Timings::percentile(grid, 50) / 1e6;
+            std::cout << std::left << std::setw(12) << scan << std::right << std::fixed << std::setprecision(2) << std::setw(16) << before
+                      << std::setw(14) << after << std::setw(11) << (after > 0 ? before / after : 0) << "x" << std::endl;
+        }
+    }
+
+    if(options.route_floor > 0){
+        std::cout.rdbuf(&null_buffer);
+        runRouting(options.route_floor, config, options, results.routing, results.routes);
+        std::cout.rdbuf(console);
+
+        std::vector<long long> flat = results.routing.samples["flat"];
+        std::sort(flat.begin(), flat.end());
+        double flat_ms = Timings::percentile(flat, 50) / 1e6;
+        std::cout << "[Benchmark] Routing on a " << options.route_floor << "x" << options.route_floor << " floor, " << options.route_queries << " queries" << std::endl;
+        std::cout << std::left << std::setw(12) << "mode" << std::right << std::setw(12) << "build (ms)" << std::setw(12) << "load (ms)" << std::setw(14) << "memory (MB)" << std::setw(12) << "p50 (ms)"
+                  << std::setw(12) << "speedup" << std::setw(12) << "mismatch" << std::setw(14) << "max error" << std::endl;
+        std::cout << std::left << std::setw(12) << "flat" << std::right << std::fixed << std::setprecision(2) << std::setw(12) << 0.0 << std::setw(12) << 0.0 << std::setw(14) << 0.0
+                  << std::setw(12) << flat_ms << std::setw(11) << 1.0 << "x" << std::setw(12) << 0 << std::setw(13) << 0.0 << "%" << std::endl;
+        for(RoutingResults& r : results.routes){
+            std::vector<long long> s = results.routing.samples[r.name];
+            std::sort(s.begin(), s.end());
+            double ms = Timings::percentile(s, 50) / 1e6;
+            std::cout << std::left << std::setw(12) << r.name << std::right << std::fixed << std::setprecision(2) << std::setw(12) << r.build_ns / 1e6 << std::setw(12) << r.load_ns / 1e6
+                      << std::setw(14) << r.memory.bytes / 1e6 << std::setw(12) << ms << std::setw(11) << (ms > 0 ? flat_ms / ms : 0) << "x"
+                      << std::setw(12) << r.mismatches << std::setw(13) << r.max_error * 100 << "%" << std::endl;
+        }
+    }
+
+    if(options.pick_floor > 0){
+        std::cout.rdbuf(&null_buffer);
+        runPicking(options.pick_floor, config, options, results.picking, results.picks);
+        std::cout.rdbuf(console);
+
+        std::cout << "[Benchmark] Pick lists on a " << options.pick_floor << "x" << options.pick_floor << " floor, " << options.pick_lists << " lists of " << options.pick_stops << " items" << std::endl;
+        std::cout << std::left << std::setw(12) << "mode" << std::right << std::setw(14) << "plan (ms)" << std::setw(12) << "input" << std::setw(12) << "optimized"
+                  << std::setw(12) << "saving" << std::setw(14) << "mean gap" << std::setw(14) << "max gap" << std::endl;
+        for(PickingResults& r : results.picks){
+            std::vector<long long> s = results.picking.samples[r.name];
+            std::sort(s.begin(), s.end());
+            std::cout << std::left << std::setw(12) << r.name << std::right << std::fixed << std::setprecision(2) << std::setw(14) << Timings::percentile(s, 50) / 1e6
+                      << std::setw(12) << r.input << std::setw(12) << r.optimized << std::setw(11) << (r.input > 0 ? (1 - r.optimized / r.input) * 100 : 0) << "%"
+                      << std::setw(13) << r.mean_gap * 100 << "%" << std::setw(13) << r.max_gap * 100 << "%" << std::endl;
+        }
+    }
+
+    if(options.pick_floor > 0 && options.wave_orders > 0){
+        std::cout.rdbuf(&null_buffer);
+        runWave(options.pick_floor, config, options, results.waves, results.wave_plans);
+        std::cout.rdbuf(console);
+
+        std::cout << "[Benchmark] Wave of " << options.wave_orders << " orders on a " << options.pick_floor << "x" << options.pick_floor << " floor, " << options.wave_capacity << " items per tour" << std::endl;
+        std::cout << std::left << std::setw(12) << "mode" << std::right << std::setw(14) << "plan (ms)" << std::setw(10) << "tours" << std::setw(14) << "per-order" << std::setw(12) << "wave"
+                  << std::setw(12) << "saving" << std::endl;
+        for(std::pair<std::string, WavePlan>& plan : results.wave_plans){
+            std::vector<long long> s = results.waves.samples[plan.first];
+            std::sort(s.begin(), s.end());
+            WavePlan& wave = plan.second;
+            std::cout << std::left << std::setw(12) << plan.first << std::right << std::fixed << std::setprecision(2) << std::setw(14) << Timings::percentile(s, 50) / 1e6
+                      << std::setw(10) << wave.tours.size() << std::setw(14) << wave.separate << std::setw(12) << wave.distance
+                      << std::setw(11) << (wave.separate > 0 ? (1 - (double)wave.distance / wave.separate) * 100 : 0) << "%" << std::endl;
+        }
+    }
+
+    if(options.slotting_floor > 0){
+        std::cout.rdbuf(&null_buffer);
+        runSlotting(options.slotting_floor, config, options, results.slotting);
+        std::cout.rdbuf(console);
+
+        std::cout << "[Benchmark] Placement policies on a " << options.slotting_floor << "x" << options.slotting_floor << " floor, " << results.slotting[0].lists << " replayed pick lists" << std::endl;
+        std::cout << std::left << std::setw(12) << "policy" << std::right << std::setw(14) << "place (ms)" << std::setw(14) << "distance" << std::setw(12) << "change" << std::endl;
+        for(SlottingResults& r : results.slotting){
+            std::cout << std::left << std::setw(12) << r.name << std::right << std::fixed << std::setprecision(2) << std::setw(14) << r.place_ns / 1e6 << std::setw(14) << r.distance
+                      << std::setw(11) << (results.slotting[0].distance > 0 ? ((double)r.distance / results.slotting[0].distance - 1) * 100 : 0) << "%" << std::endl;
+        }
+    }
+
+    if(options.consolidate_floor > 0){
+        results.consolidation.push_back(ConsolidationResults());
+        ConsolidationResults& r = results.consolidation.back();
+        std::cout.rdbuf(&null_buffer);
+        runConsolidation(options.consolidate_floor, config, options, r);
+        std::cout.rdbuf(console);
+
+        std::cout << "[Benchmark] Consolidation on a " << options.consolidate_floor << "x" << options.consolidate_floor << " floor: " << r.moves << " moves (" << r.skipped << " skipped) in "
+                  << r.cycles << " cycles, " << std::fixed << std::setprecision(2) << r.plan_ns / 1e6 << " ms planning, " << r.commit_ns / 1e6 << " ms committing, "
+                  << r.queries << " queries answered while planning" << std::endl;
+        std::cout << std::left << std::setw(10) << "" << std::right << std::setw(12) << "split SKUs" << std::setw(12) << "fragments" << std::setw(8) << "empty"
+                  << std::setw(12) << "free space" << std::setw(14) << "in slivers" << std::setw(12) << "half free" << std::endl;
+        for(int after = 0; after < 2; after++){
+            Fragmentation& f = after ? r.after : r.before;
+            std::cout << std::left << std::setw(10) << (after ? "after" : "before") << std::right << std::setw(12) << f.split_skus << std::setw(12) << f.fragments << std::setw(8) << f.empty_units
+                      << std::setw(12) << f.free_space << std::setw(13) << f.freeFragmentation() * 100 << "%" << std::setw(12) << (after ? r.large_after : r.large_before) << std::endl;
+        }
+    }
+
+    if(options.fork_floor > 0){
+        results.forks.push_back(ForkResults());
+        ForkResults& r = results.forks.back();
+        std::cout.rdbuf(&null_buffer);
+        runForks(options.fork_floor, generator, config, options, r);
+        std::cout.rdbuf(console);
+
+        std::cout << "[Benchmark] Forks of a " << options.fork_floor << "x" << options.fork_floor << " floor (" << r.base_bytes << " bytes): rebuilt copy " << std::fixed << std::setprecision(2)
+                  << r.rebuild_ns / 1e6 << " ms and " << r.rebuild_bytes << " bytes; fork " << r.fork_ns / 1e3 << " us, " << r.scenario_bytes << " bytes with "
+                  << options.fork_items << " items added; " << r.mismatches << " of " << options.forks << " scenarios mismatched, floor "
+                  << (r.base_unchanged ? "unchanged" : "changed") << std::endl;
+    }
+
+    if(options.site_floors > 0){
+        results.sites.push_back(SiteResults());
+        SiteResults& r = results.sites.back();
+        std::cout.rdbuf(&null_buffer);
+        runSite(options.site_floors, options.site_side, generator, config, options, r);
+        std::cout.rdbuf(console);
+
+        std::cout << "[Benchmark] Site of " << options.site_floors << " floors of " << options.site_side << "x" << options.site_side << " (" << r.memory << " bytes): built in "
+                  << std::fixed << std::setprecision(2) << r.serial_ns / 1e6 << " ms serially and " << r.parallel_ns / 1e6 << " ms in parallel, portals measured in "
+                  << r.portals_ns / 1e6 << " ms; route " << r.route_ns / 1e3 << " us against " << r.reference_ns / 1e3 << " us over every cell, " << r.mismatches
+                  << " of " << options.site_queries << " lengths mismatched and " << r.broken << " paths broken; add " << r.add_ns / 1e3 << " us over "
+                  << r.floors_used << " floors" << std::endl;
+    }
+
+    if(options.congestion_floor > 0){
+        std::cout.rdbuf(&null_buffer);
+        runCongestion(options.congestion_floor, config, options, results.congestion);
+        std::cout.rdbuf(console);
+
+        std::cout << "[Benchmark] Congestion on a " << options.congestion_floor << "x" << options.congestion_floor << " floor with " << options.pickers << " pickers:" << std::endl;
+        for(CongestionResults& r : results.congestion){
+            std::cout << "  penalty " << std::setw(3) << r.penalty << ": distance " << r.distance << ", travel " << r.travel << ", " << r.shared_steps
+                      << " shared steps, route " << std::fixed << std::setprecision(2) << r.route_ns / 1e3 << " us" << std::endl;
+        }
+    }
+
+    if(options.agents_floor > 0){
+        AgentsResults r;
+        std::cout.rdbuf(&null_buffer);
+        runAgents(options.agents_floor, config, options, r);
+        std::cout.rdbuf(console);
+        results.agents.push_back(r);
+
+        std::cout << "[Benchmark] " << options.agents << " agents on a " << options.agents_floor << "x" << options.agents_floor << " floor: " << r.planned
+                  << " planned in " << std::fixed << std::setprecision(2) << r.plan_ns / 1e6 << " ms with " << r.reservations << " reservations, makespan "
+                  << r.makespan << ", cost " << r.cost << ", " << r.conflicts << " conflicts; shortest paths alone: makespan " << r.shortest_makespan
+                  << ", cost " << r.lower_bound << ", " << r.shortest_conflicts << " conflicts" << std::endl;
+    }
+
+    if(options.index_skus > 0){
+        IndexResults r;
+        runIndex(config, options, r);
+        results.indexes.push_back(r);
+
+        std::cout << "[Benchmark] Item index of " << options.index_skus << " names (" << r.memory << " bytes) built in " << std::fixed << std::setprecision(2)
+                  << r.build_ns / 1e6 << " ms; prefix totals " << r.totals_ns / 1e3 << " us, first 100 " << r.first_ns / 1e3 << " us, pattern "
+                  << r.pattern_ns / 1e3 << " us, scan " << r.scan_ns / 1e3 << " us; " << r.matches << " matches per prefix, " << r.mismatches << " of "
+                  << options.index_queries << " queries mismatched" << std::endl;
+    }
+
+    if(options.reserve_floor > 0){
+        std::cout.rdbuf(&null_buffer);
+        for(bool global : {false, true}){
+            ReserveResults r;
+            runReserve(options.reserve_floor, global, config, options, r);
+            results.reserves.push_back(r);
+        }
+        std::cout.rdbuf(console);
+
+        std::cout << "[Benchmark] Reservations by " << options.docks << " docks on a " << options.reserve_floor << "x" << options.reserve_floor << " floor:" << std::endl;
+        for(ReserveResults& r : results.reserves){
+            std::cout << "  " << std::setw(11) << r.mode << ": " << r.reserved << " held, " << r.failed << " failed, " << r.committed << " committed in "
+                      << std::fixed << std::setprecision(2) << r.reserve_ns / 1e6 << " ms (" << (r.reserved + r.failed) / (r.reserve_ns / 1e9) << " per second); "
+                      << r.overbooked << " overbooked, " << r.mismatched << " mismatched rounds" << std::endl;
+        }
+    }
+
+    if(options.parallel_floor > 0){
+        std::cout.rdbuf(&null_buffer);
+        runParallel(options.parallel_floor, generator, config, options, results.parallel);
+        std::cout.rdbuf(console);
+
+        std::cout << "[Benchmark] Passes over every cell of a " << options.parallel_floor << "x" << options.parallel_floor << " floor on " << std::thread::hardware_concurrency() << " cores" << std::endl;
+        std::cout << std::left << std::setw(10) << "threads" << std::right << std::setw(14) << "graph (ms)" << std::setw(14) << "empty (ms)" << std::setw(14) << "print (ms)"
+                  << std::setw(12) << "identical" << std::endl;
+        for(ParallelResults& r : results.parallel){
+            std::cout << std::left << std::setw(10) << r.threads << std::right << std::fixed << std::setprecision(2) << std::setw(14) << r.build_ns / 1e6
+                      << std::setw(14) << r.empty_ns / 1e6 << std::setw(14) << r.print_ns / 1e6 << std::setw(12) << (r.identical ? "yes" : "no") << std::endl;
+        }
+    }
+
+    writeResults(options.output, config, options, results);
+    std::cout << "[Benchmark] Results written to " << options.output << std::endl;
+    return 0;
+}
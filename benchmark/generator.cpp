@@ -0,0 +1,33 @@
+//
+// CSC 212 - Data Structures and Abstractions
+// Dominic Tucchio, Jennipher Day, Maya Geva, Thomas Williams
+// Spring 2024 Term Project - generator.cpp
+//
+
+#include "workload.h"
+
+// MAIN FUNCTION: Writes a synthetic workload (units.csv, items.csv, commands.txt) that can be passed directly to the
+// warehouse executable. Every option other than the output directory is described in WorkloadConfig.
+int main(int argc, char*argv[]){
+    if(argc < 2 || (argc - 2) % 2 != 0){
+        std::cout << "[Generator Error] Incorrect command line arguments.\nUsage: ./generator <output_directory> [--rows N] [--cols N] [--fill F] [--min-capacity N] [--max-capacity N] [--skus N] [--items N] [--max-quantity N] [--max-size N] [--commands N] [--max-stops N] [--mix U,A,F,P,I] [--seed N]" << std::endl;
+        return 1;
+    }
+
+    WorkloadConfig config;
+    for(int i = 2; i < argc; i += 2){
+        if(!parseWorkloadOption(config, argv[i], argv[i + 1])){
+            std::cout << "[Generator Error] Unknown option " << argv[i] << "." << std::endl;
+            return 1;
+        }
+    }
+
+    WorkloadGenerator generator(config);
+    if(!generator.write(argv[1])){
+        std::cout << "[Generator Error] Unable to write to the output directory " << argv[1] << "." << std::endl;
+        return 1;
+    }
+
+    std::cout << "[Generator] Wrote a " << config.rows << "x" << config.cols << " floor, " << config.items << " items, and " << config.commands << " commands to " << argv[1] << std::endl;
+    return 0;
+}
@@ -0,0 +1,141 @@
+//
+// CSC 212 - Data Structures and Abstractions
+// Dominic Tucchio, Jennipher Day, Maya Geva, Thomas Williams
+// Spring 2024 Term Project - workload.cpp
+//
+
+#include "workload.h"
+
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+
+// FUNCTION: Applies a single "--key value" command line option to a WorkloadConfig. The command mix is given as five
+// comma separated weights in the order ADD_UNIT, ADD_ITEM, FIND_ITEM, FIND_PATH_UNITS, FIND_PATH_ITEMS. Returns false if
+// the key is not a workload option.
+bool parseWorkloadOption(WorkloadConfig& config, std::string key, std::string value){
+    if(key == "--rows") config.rows = std::stoi(value);
+    else if(key == "--cols") config.cols = std::stoi(value);
+    else if(key == "--fill") config.fill = std::stod(value);
+    else if(key == "--min-capacity") config.min_capacity = std::stoi(value);
+    else if(key == "--max-capacity") config.max_capacity = std::stoi(value);
+    else if(key == "--skus") config.skus = std::stoi(value);
+    else if(key == "--items") config.items = std::stoi(value);
+    else if(key == "--max-quantity") config.max_quantity = std::stoi(value);
+    else if(key == "--max-size") config.max_size = std::stoi(value);
+    else if(key == "--commands") config.commands = std::stoi(value);
+    else if(key == "--max-stops") config.max_stops = std::stoi(value);
+    else if(key == "--seed") config.seed = std::stoul(value);
+    else if(key == "--mix"){
+        std::stringstream weights(value);
+        std::string w;
+        int* mix[] = {&config.mix_add_unit, &config.mix_add_item, &config.mix_find_item, &config.mix_path_units, &config.mix_path_items};
+        for(int i = 0; i < 5 && std::getline(weights, w, ','); i++) *mix[i] = std::stoi(w);
+    }
+    else return false;
+    return true;
+}
+
+//
+// CLASS: WorkloadGenerator
+// Produces the StorageUnit, Item, and command data described by a WorkloadConfig. The data can either be written to
+// the same CSV and TXT formats read by main.cpp or used directly by the benchmark executable.
+//
+
+// CONSTRUCTOR: Creates a generator for the given workload description.
+WorkloadGenerator::WorkloadGenerator(WorkloadConfig config){
+    this->config = config;
+}
+
+// FUNCTION: Returns a uniformly distributed integer between low and high, inclusive.
+int WorkloadGenerator::uniform(int low, int high){
+    std::uniform_int_distribution<int> dist(low, high);
+    return dist(rng);
+}
+
+// FUNCTION: Returns the name of a SKU. Names are zero padded so that they sort in the same order as their index.
+std::string WorkloadGenerator::skuName(int sku){
+    std::stringstream name;
+    name << "SKU" << std::setw(6) << std::setfill('0') << sku;
+    return name.str();
+}
+
+// FUNCTION: Generates one StorageUnit for each cell of the floor selected by the fill ratio. Each generating function
+// reseeds the random number generator so the units, items, and commands are reproducible independently of each other.
+std::vector<StorageUnit> WorkloadGenerator::units(){
+    rng.seed(config.seed);
+    std::uniform_real_distribution<double> cell(0.0, 1.0);
+    std::vector<StorageUnit> result;
+
+    for(int x = 0; x < config.rows; x++){
+        for(int y = 0; y < config.cols; y++){
+            if(cell(rng) < config.fill) result.push_back(StorageUnit(uniform(config.min_capacity, config.max_capacity), {x, y}));
+        }
+    }
+    return result;
+}
+
+// FUNCTION: Generates the Item rows for the items CSV. Each row picks a random SKU, quantity, and size per unit.
+std::vector<Item> WorkloadGenerator::items(){
+    rng.seed(config.seed + 1);
+    std::vector<Item> result;
+
+    for(int i = 0; i < config.items; i++){
+        result.push_back(Item(skuName(uniform(0, config.skus - 1)), uniform(1, config.max_quantity), uniform(1, config.max_size)));
+    }
+    return result;
+}
+
+// FUNCTION: Generates a command stream. The command type of each line is drawn from the weighted mix in the config and
+// the command arguments are drawn from the floor dimensions and SKU pool.
+std::vector<std::string> WorkloadGenerator::commands(){
+    rng.seed(config.seed + 2);
+    std::discrete_distribution<int> mix({(double)config.mix_add_unit, (double)config.mix_add_item, (double)config.mix_find_item, (double)config.mix_path_units, (double)config.mix_path_items});
+    std::vector<std::string> result;
+
+    for(int i = 0; i < config.commands; i++){
+        std::stringstream command;
+        int stops = uniform(1, config.max_stops);
+
+        switch(mix(rng)){
+            case 0:
+                command << "ADD_UNIT " << uniform(config.min_capacity, config.max_capacity);
+                break;
+            case 1:
+                command << "ADD_ITEM " << skuName(uniform(0, config.skus - 1)) << " " << uniform(1, config.max_quantity) << " " << uniform(1, config.max_size);
+                break;
+            case 2:
+                command << "FIND_ITEM " << skuName(uniform(0, config.skus - 1));
+                break;
+            case 3:
+                command << "FIND_PATH_UNITS " << uniform(0, config.rows - 1) << " " << uniform(0, config.cols - 1);
+                for(int s = 0; s < stops; s++) command << " " << uniform(0, config.rows - 1) << " " << uniform(0, config.cols - 1);
+                break;
+            default:
+                command << "FIND_PATH_ITEMS " << uniform(0, config.rows - 1) << " " << uniform(0, config.cols - 1);
+                for(int s = 0; s < stops; s++) command << " " << skuName(uniform(0, config.skus - 1));
+                break;
+        }
+        result.push_back(command.str());
+    }
+    return result;
+}
+
+// FUNCTION: Writes units.csv, items.csv, and commands.txt to the given directory using the formats read by main.cpp.
+// Returns false if any of the files could not be opened.
+bool WorkloadGenerator::write(std::string directory){
+    std::ofstream units_out_file(directory + "/units.csv");
+    std::ofstream items_out_file(directory + "/items.csv");
+    std::ofstream commands_out_file(directory + "/commands.txt");
+    if(!units_out_file || !items_out_file || !commands_out_file) return false;
+
+    units_out_file << "Capacity,XCoord,YCoord" << std::endl;
+    for(StorageUnit& u : units()) units_out_file << u.getCapacity() << "," << u.getLocation().first << "," << u.getLocation().second << "\n";
+
+    items_out_file << "Name,Quantity,UnitSize" << std::endl;
+    for(Item& i : items()) items_out_file << i.name << "," << i.quantity << "," << i.size_per_unit << "\n";
+
+    for(std::string& c : commands()) commands_out_file << c << "\n";
+
+    return true;
+}
@@ -0,0 +1,95 @@
+//
+// CSC 212 - Data Structures and Abstractions
+// Dominic Tucchio, Jennipher Day, Maya Geva, Thomas Williams
+// Spring 2024 Term Project - workload.h
+//
+
+#ifndef Workload_H
+#define Workload_H
+
+#include "../warehouse/container.h"
+
+#include <string>
+#include <vector>
+#include <random>
+
+//
+// STRUCTURE: WorkloadConfig
+// Describes a synthetic Warehouse workload. The floor is a rows x cols grid where each cell holds a StorageUnit with the
+// probability given by fill. Items are drawn from a fixed pool of SKUs and the command stream is drawn from a weighted
+// mix of the command types understood by main.cpp.
+//
+
+struct WorkloadConfig {
+    // FLOOR: The dimensions of the floor and the fraction of cells that hold a StorageUnit.
+    int rows = 100;
+    int cols = 100;
+    double fill = 1.0;
+    // CAPACITY: The range of capacities assigned to each StorageUnit.
+    int min_capacity = 10;
+    int max_capacity = 50;
+
+    // SKUS: The number of distinct Item names and the number of Item rows written to the items CSV.
+    int skus = 100;
+    int items = 1000;
+    // ITEM SIZE: The range of quantities and sizes per unit assigned to each Item.
+    int max_quantity = 10;
+    int max_size = 5;
+
+    // COMMANDS: The number of commands to generate and the relative weight of each command type.
+    int commands = 1000;
+    int mix_add_unit = 1;
+    int mix_add_item = 40;
+    int mix_find_item = 30;
+    int mix_path_units = 20;
+    int mix_path_items = 9;
+    // PATH STOPS: The maximum number of destinations in a single FIND_PATH_* command.
+    int max_stops = 4;
+
+    // SEED: Seed for the random number generator so workloads are reproducible.
+    unsigned int seed = 212;
+};
+
+// FUNCTION: Applies a single "--key value" command line option to a WorkloadConfig. Returns false if the option is not a
+// workload option. Shared by the generator and benchmark executables.
+bool parseWorkloadOption(WorkloadConfig& config, std::string key, std::string value);
+
+//
+// CLASS: WorkloadGenerator
+// Produces the StorageUnit, Item, and command data described by a WorkloadConfig. The data can either be written to
+// the same CSV and TXT formats read by main.cpp or used directly by the benchmark executable.
+//
+
+class WorkloadGenerator {
+    public:
+        // CONSTRUCTORS
+        WorkloadGenerator(WorkloadConfig config);
+
+        // FUNCTIONS
+
+        // FUNCTION: Generates the StorageUnit instances for the floor.
+        std::vector<StorageUnit> units();
+        // FUNCTION: Generates the Item instances to be inserted.
+        std::vector<Item> items();
+        // FUNCTION: Generates a command stream in the format of commands.txt.
+        std::vector<std::string> commands();
+
+        // FUNCTION: Returns the name of the SKU with the given index.
+        std::string skuName(int sku);
+
+        // FUNCTION: Writes the units CSV, items CSV, and commands TXT files to the given directory.
+        bool write(std::string directory);
+
+    private:
+        // MEMBER VARIABLES
+
+        // CONFIG: The workload description.
+        WorkloadConfig config;
+        // RNG: Random number generator shared by every generating function.
+        std::mt19937 rng;
+
+        // FUNCTION: Returns a uniformly distributed integer in [low, high].
+        int uniform(int low, int high);
+};
+
+#endif
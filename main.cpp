@@ -5,25 +5,36 @@
 //
 
 #include "./warehouse/warehouse.h"
+#include "./warehouse/metrics/metrics.h"
+#include "./warehouse/metrics/trace.h"
 #include <sstream>
 
 // MAIN FUNCTION: Main function of the program. Fun fact: this project contains 1,351 lines of code!
 int main(int argc, char*argv[]){
+    // Separating options from the positional arguments. "--trace <file>" enables the Chrome trace profiling mode.
+    std::vector<std::string> args;
+    for(int i = 1; i < argc; i++){
+        std::string arg(argv[i]);
+        if(arg == "--trace" && i + 1 < argc) Tracer::start(argv[++i]);
+        else args.push_back(arg);
+    }
+
     // Check for the correct number of command line arguments.
-    if (argc < 3) {
-        std::cout << "[Warehouse Build Error] Incorrect number of command line arguments.\nUsage: ./warehouse <unitdata.csv> <itemdata.csv> [commands.txt]" << std::endl;
+    if (args.size() < 2) {
+        std::cout << "[Warehouse Build Error] Incorrect number of command line arguments.\nUsage: ./warehouse <unitdata.csv> <itemdata.csv> [commands.txt] [--trace out.json]" << std::endl;
         return 0;
     }
 
     // Parsing filenames from the command line arguments.
-    std::string units_csv_file_name(argv[1]);
-    std::string items_csv_file_name(argv[2]);
+    std::string units_csv_file_name(args[0]);
+    std::string items_csv_file_name(args[1]);
 
     //
     // Importing StorageUnit Data
     //
 
     // Open the file and initialize vectors to store information.
+    TraceScope load_units_span("load units");
     std::ifstream units_in_file(units_csv_file_name);
     std::vector<StorageUnit> units;
     std::vector<int> unassigned_units;
@@ -66,6 +77,7 @@ int main(int argc, char*argv[]){
 
     // Closing the StorageUnit CSV file.
     units_in_file.close();
+    load_units_span.end();
 
     //
     // INITIALIZING THE WAREHOUSE CLASS
@@ -73,14 +85,17 @@ int main(int argc, char*argv[]){
 
     // The vector of complete StorageUnits is passed in to the constructor of Warehouse. Any additional partial StorageUnits
     // are added after the defined StorageUnits have been added.
+    TraceScope build_span("build warehouse");
     Warehouse w(units);
     for(int i : unassigned_units) w.add_unit(i);
+    build_span.end();
 
     //
     // Importing Item Data
     //
 
     // Open the file and initialize vectors to store information.
+    TraceScope load_items_span("load items");
     std::ifstream items_in_file(items_csv_file_name);
     std::vector<Item> items;
 
@@ -121,6 +136,7 @@ int main(int argc, char*argv[]){
 
     // Inserting Items from the CSV file.
     for(Item i : items) w.add(i);
+    load_items_span.end();
 
     //
     // IMPORTING AND HANDLING COMMANDS
@@ -128,9 +144,9 @@ int main(int argc, char*argv[]){
 
     // Commands are not required for the Warehouse program to run. This code only runs if a command file is provided via
     // command line argument.
-    if(argc == 4){
+    if(args.size() == 3){
         // Open the file.
-        std::string commands_txt_file_name(argv[3]);
+        std::string commands_txt_file_name(args[2]);
         std::ifstream commands_in_file(commands_txt_file_name);
 
         // Check to ensure the provided file is valid.
@@ -139,8 +155,26 @@ int main(int argc, char*argv[]){
             return 1;
         }
 
+        // Reports the quantity of an Item REMOVE_ITEM or PICK took from each StorageUnit and any shortfall.
+        auto report_withdrawals = [](const std::string& command, const std::string& verb, const std::string& name, int quantity, const std::vector<Withdrawal>& taken){
+            if(taken.empty()){
+                std::cout << "[" << command << "] The provided item \"" << name << "\" was not found in the Warehouse.\n" << std::endl;
+                return;
+            }
+            int total = 0;
+            std::cout << "[" << command << "] " << verb << " " << name << "(s) from the StorageUnit(s) located at";
+            for(const Withdrawal& t : taken){
+                std::cout << " (" << t.loc.first << "," << t.loc.second << ")=" << t.quantity;
+                total += t.quantity;
+            }
+            std::cout << ", " << total << " in total.";
+            if(total < quantity) std::cout << " Only " << total << " of the " << quantity << " requested were in the Warehouse.";
+            std::cout << "\n" << std::endl;
+        };
+
         // Parse through each command.
         while(std::getline(commands_in_file, line)){
+            TraceScope parse_span("command parse");
             std::stringstream command_stream(line);
             std::string command, parameter;
             // Parsing the command.
@@ -149,6 +183,7 @@ int main(int argc, char*argv[]){
             // Parsing command arguments.
             std::vector<std::string> parameters;
             while(command_stream >> parameter) parameters.push_back(parameter);
+            parse_span.end();
 
             // Command switcher. Each command checks the parameters to ensure they are valid and calls the appropriate
             // function. If there is a syntax error the user is notified via command line and given the correct syntax.
@@ -157,6 +192,8 @@ int main(int argc, char*argv[]){
                     std::cout << "[Command Error] Invalid StorageUnit constructor value found in the provided TXT file.\nUsage: ADD_UNIT <Name> <Quantity> <SizePerUnit>" << std::endl;
                     continue;
                 }
+                METRICS_TIME(CMD_ADD_UNIT);
+                TRACE_SCOPE("ADD_UNIT");
                 if(parameters.size() == 1) w.add_unit(std::stoi(parameters[0]));
                 else w.add_unit(StorageUnit(std::stoi(parameters[0]), {std::stoi(parameters[1]), std::stoi(parameters[2])}));
             }
@@ -165,14 +202,65 @@ int main(int argc, char*argv[]){
                     std::cout << "[Command Error] Invalid Item constructor value found in provided TXT file.\nUsage: ADD_ITEM <Name> <Quantity> <SizePerUnit>\n" << std::endl;
                     continue;
                 }
+                METRICS_TIME(CMD_ADD_ITEM);
+                TRACE_SCOPE("ADD_ITEM");
                 w.add(Item(parameters[0], std::stoi(parameters[1]), std::stoi(parameters[2])));
             }
+            else if(command == "RESERVE"){
+                if(parameters.size() < 3 || parameters.size() > 4 || parameters[0].empty() || std::stoi(parameters[1]) < 1 || std::stoi(parameters[2]) < 1 || (parameters.size() == 4 && std::stoi(parameters[3]) < 1)){
+                    std::cout << "[Command Error] Invalid invocation of RESERVE found in the provided TXT file.\nUsage: RESERVE <Name> <Quantity> <SizePerUnit> [TimeoutMs]\n" << std::endl;
+                    continue;
+                }
+                METRICS_TIME(CMD_RESERVE);
+                TRACE_SCOPE("RESERVE");
+                // Holds last 60 seconds unless another timeout is given, and are settled right away, as only one dock
+                // reads the commands file.
+                long long id = w.reserve(Item(parameters[0], std::stoi(parameters[1]), std::stoi(parameters[2])), (parameters.size() == 4 ? std::stoll(parameters[3]) : 60000LL) * 1000000LL);
+                w.settleReservations();
+                if(id < 0) std::cout << "[RESERVE] Unable to hold space for " << parameters[1] << " " << parameters[0] << "(s) due to lack of available storage space.\n" << std::endl;
+                else std::cout << "[RESERVE] Space for " << parameters[1] << " " << parameters[0] << "(s) is held as reservation " << id << ".\n" << std::endl;
+            }
+            else if(command == "COMMIT_RESERVATION" || command == "ABORT_RESERVATION"){
+                if(parameters.size() != 1 || std::stoll(parameters[0]) < 1){
+                    std::cout << "[Command Error] Invalid invocation of " << command << " found in the provided TXT file.\nUsage: " << command << " <Reservation>\n" << std::endl;
+                    continue;
+                }
+                METRICS_TIME(CMD_RESERVE);
+                TRACE_SCOPE("RESERVE");
+                long long id = std::stoll(parameters[0]);
+                ReservationState state = command == "COMMIT_RESERVATION" ? w.commitReservation(id) : w.abortReservation(id);
+                // Reservations are settled right after every commit, so this commit is the only one settled here.
+                std::pair<int, int> settled = w.settleReservations();
+                if(state == RESERVATION_COMMITTED && settled.first == 0) std::cout << "[" << command << "] Reservation " << id << " was committed but not all of its Items could be stored.\n" << std::endl;
+                else if(state == RESERVATION_COMMITTED) std::cout << "[" << command << "] Reservation " << id << " was committed and its Items stored.\n" << std::endl;
+                else if(state == RESERVATION_ABORTED) std::cout << "[" << command << "] Reservation " << id << " was aborted and its space released.\n" << std::endl;
+                else if(state == RESERVATION_EXPIRED) std::cout << "[" << command << "] Reservation " << id << " timed out and its space was released.\n" << std::endl;
+                else if(state == RESERVATION_CANCELLED) std::cout << "[" << command << "] Reservation " << id << " was cancelled when a StorageUnit holding its space was replaced.\n" << std::endl;
+                else std::cout << "[" << command << "] Reservation " << id << " is not open.\n" << std::endl;
+            }
             else if(command == "FIND_ITEM"){
                 if(parameters.size() != 1 || parameters[0].empty()){
-                    std::cout << "[Command Error] Invalid invocation of FIND_ITEM found in the provided TXT file.\nUsage: FIND_ITEM <Name>\n" << std::endl;
+                    std::cout << "[Command Error] Invalid invocation of FIND_ITEM found in the provided TXT file.\nUsage: FIND_ITEM <Name | Pattern>\n" << std::endl;
+                    continue;
+                }
+                METRICS_TIME(CMD_FIND_ITEM);
+                TRACE_SCOPE("FIND_ITEM");
+                // A name with a * or ? is a pattern; every matching Item is listed with its quantity as it is found.
+                if(parameter.find_first_of("*?") != std::string::npos){
+                    long long quantity = 0;
+                    int matched = w.findItems(parameter, [&](const std::string& name, const ItemLocations& at){
+                        std::cout << "[FIND_ITEM] " << name << " (" << at.quantity << ") was found in the StorageUnit(s) located at ";
+                        at.by_location.forEach([&](std::pair<int, int> loc, unsigned long long){ std::cout << "(" << loc.first << "," << loc.second << ") "; });
+                        std::cout << std::endl;
+                        quantity += at.quantity;
+                        return true;
+                    });
+                    if(matched < 0) std::cout << "[FIND_ITEM] The pattern \"" << parameter << "\" is longer than 63 characters.\n" << std::endl;
+                    else std::cout << "[FIND_ITEM] " << matched << " item(s) matching \"" << parameter << "\" with " << quantity << " stored in total.\n" << std::endl;
                     continue;
                 }
                 std::vector<std::pair<int, int> > results = w.findItem(parameter);
+                w.recordPicks({parameter});
                 if(results.empty()) std::cout << "[FIND_ITEM] The provided item \"" << parameters[0] << "\" was not found in the Warehouse.\n";
                 else {
                     std::cout << "[FIND_ITEM] " << parameters[0] << " was found in the StorageUnit(s) located at ";
@@ -182,11 +270,33 @@ int main(int argc, char*argv[]){
                     std::cout << "\n" << std::endl;
                 }
             }
+            else if(command == "REMOVE_ITEM"){
+                if(parameters.size() != 2 || parameters[0].empty() || std::stoi(parameters[1]) < 1){
+                    std::cout << "[Command Error] Invalid invocation of REMOVE_ITEM found in the provided TXT file.\nUsage: REMOVE_ITEM <Name> <Quantity>\n" << std::endl;
+                    continue;
+                }
+                METRICS_TIME(CMD_REMOVE_ITEM);
+                TRACE_SCOPE("REMOVE_ITEM");
+                report_withdrawals("REMOVE_ITEM", "Removed", parameters[0], std::stoi(parameters[1]), w.remove(parameters[0], std::stoi(parameters[1])));
+            }
+            else if(command == "PICK"){
+                if(parameters.size() != 4 || std::stoi(parameters[0]) < 0 || std::stoi(parameters[1]) < 0 || parameters[2].empty() || std::stoi(parameters[3]) < 1){
+                    std::cout << "[Command Error] Invalid invocation of PICK found in the provided TXT file.\nUsage: PICK <XCoord> <YCoord> <Name> <Quantity>\n" << std::endl;
+                    continue;
+                }
+                METRICS_TIME(CMD_PICK);
+                TRACE_SCOPE("PICK");
+                std::pair<int, int> origin = {std::stoi(parameters[0]), std::stoi(parameters[1])};
+                report_withdrawals("PICK", "Picked", parameters[2], std::stoi(parameters[3]), w.pick(origin, parameters[2], std::stoi(parameters[3])));
+                w.recordPicks({parameters[2]});
+            }
             else if(command == "FIND_PATH_UNITS"){
                 if(parameters.size() < 4 || (std::stoi(parameters[0]) < 0) || (std::stoi(parameters[1]) < 0) || (std::stoi(parameters[2]) < 0) || (std::stoi(parameters[3]) < 0)  ||  (parameters.size() % 2 != 0)){
                     std::cout << "[Command Error] Invalid invocation of FIND_PATH_ITEMS found in the provided TXT file.\nUsage: FIND_PATH_ITEMS <ORIGIN_XCoord> <ORIGIN_YCoord> <DEST_XCoord> <DEST_YCoord> [DEST_XCoord] [DEST_YCoord]...\n" << std::endl;
                     continue;
                 }
+                METRICS_TIME(CMD_FIND_PATH_UNITS);
+                TRACE_SCOPE("FIND_PATH_UNITS");
                 std::pair<int, int> origin = {std::stoi(parameters[0]), std::stoi(parameters[1])};
                 std::vector<std::pair<int, int> > dest_coords;
                 for(int i = 2; i < parameters.size(); i += 2) dest_coords.push_back({std::stoi(parameters[i]), std::stoi(parameters[i+1])});
@@ -198,11 +308,197 @@ int main(int argc, char*argv[]){
                     std::cout << "[Command Error] Invalid invocation of FIND_PATH_ITEMS found in the provided TXT file.\nUsage: FIND_PATH_ITEMS <ORIGIN_XCoord> <ORIGIN_YCoord> <Item Name> [Item Name]...\n" << std::endl;
                     continue;
                 }
+                METRICS_TIME(CMD_FIND_PATH_ITEMS);
+                TRACE_SCOPE("FIND_PATH_ITEMS");
                 std::pair<int, int> origin = {std::stoi(parameters[0]), std::stoi(parameters[1])};
                 std::vector<std::string> items;
                 for(int i = 2; i < parameters.size(); i++) items.push_back(parameters[i]);
                 w.getPath(origin, items);
                 std::cout << std::endl;
+            }
+            else if(command == "FIND_SPACE"){
+                if(parameters.size() != 5 || std::stoi(parameters[0]) < 0 || std::stoi(parameters[1]) < 0 || std::stoi(parameters[2]) < 0 || std::stoi(parameters[3]) < 0 || std::stoi(parameters[4]) < 0){
+                    std::cout << "[Command Error] Invalid invocation of FIND_SPACE found in the provided TXT file.\nUsage: FIND_SPACE <XCoord1> <YCoord1> <XCoord2> <YCoord2> <Space>\n" << std::endl;
+                    continue;
+                }
+                METRICS_TIME(CMD_FIND_SPACE);
+                TRACE_SCOPE("FIND_SPACE");
+                std::pair<int, int> low = {std::stoi(parameters[0]), std::stoi(parameters[1])};
+                std::pair<int, int> high = {std::stoi(parameters[2]), std::stoi(parameters[3])};
+                std::vector<UnitHandle> results = w.findSpace(low, high, std::stoi(parameters[4]));
+                std::cout << "[FIND_SPACE] " << results.size() << " StorageUnit(s) between (" << low.first << "," << low.second << ") and (" << high.first << "," << high.second << ") have at least " << parameters[4] << " free space";
+                for(UnitHandle& u : results) std::cout << (&u == &results[0] ? ": " : " ") << "(" << u.loc.first << "," << u.loc.second << ")=" << u.free;
+                std::cout << "\n" << std::endl;
+            }
+            else if(command == "FIND_NEAREST_SPACE"){
+                if((parameters.size() != 3 && parameters.size() != 4) || std::stoi(parameters[0]) < 0 || std::stoi(parameters[1]) < 0 || std::stoi(parameters[2]) < 0 || (parameters.size() == 4 && std::stoi(parameters[3]) < 1)){
+                    std::cout << "[Command Error] Invalid invocation of FIND_NEAREST_SPACE found in the provided TXT file.\nUsage: FIND_NEAREST_SPACE <XCoord> <YCoord> <Space> [Count]\n" << std::endl;
+                    continue;
+                }
+                METRICS_TIME(CMD_FIND_NEAREST_SPACE);
+                TRACE_SCOPE("FIND_NEAREST_SPACE");
+                std::pair<int, int> origin = {std::stoi(parameters[0]), std::stoi(parameters[1])};
+                std::vector<UnitHandle> results = w.findNearestSpace(origin, std::stoi(parameters[2]), parameters.size() == 4 ? std::stoi(parameters[3]) : 1);
+                if(results.empty()) std::cout << "[FIND_NEAREST_SPACE] No StorageUnit has at least " << parameters[2] << " free space.\n" << std::endl;
+                else {
+                    std::cout << "[FIND_NEAREST_SPACE] Nearest StorageUnit(s) to (" << origin.first << "," << origin.second << ") with at least " << parameters[2] << " free space:";
+                    for(UnitHandle& u : results) std::cout << " (" << u.loc.first << "," << u.loc.second << ")=" << u.free;
+                    std::cout << "\n" << std::endl;
+                }
+            }
+            else if(command == "CAN_STORE"){
+                if(parameters.size() != 3 || parameters[0].empty() || std::stoi(parameters[1]) < 0 || std::stoi(parameters[2]) < 0){
+                    std::cout << "[Command Error] Invalid invocation of CAN_STORE found in the provided TXT file.\nUsage: CAN_STORE <Name> <Quantity> <SizePerUnit>\n" << std::endl;
+                    continue;
+                }
+                METRICS_TIME(CMD_CAN_STORE);
+                TRACE_SCOPE("CAN_STORE");
+                Item i(parameters[0], std::stoi(parameters[1]), std::stoi(parameters[2]));
+                std::cout << "[CAN_STORE] " << i.quantity << " " << i.name << "(s) of size " << i.size_per_unit << (w.canStore(i) ? " can" : " cannot") << " be stored";
+                if(i.size_per_unit > 0) std::cout << "; up to " << w.maxPlaceable(i.size_per_unit) << " fit";
+                std::cout << ".\n" << std::endl;
+            }
+            else if(command == "FREE_SPACE"){
+                if(parameters.size() > 1 || (parameters.size() == 1 && std::stoi(parameters[0]) < 0)){
+                    std::cout << "[Command Error] Invalid invocation of FREE_SPACE found in the provided TXT file.\nUsage: FREE_SPACE [Space]\n" << std::endl;
+                    continue;
+                }
+                METRICS_TIME(CMD_FREE_SPACE);
+                TRACE_SCOPE("FREE_SPACE");
+                int space = parameters.empty() ? 1 : std::stoi(parameters[0]);
+                std::pair<int, long long> results = w.freeSpace(space);
+                std::cout << "[FREE_SPACE] " << results.first << " StorageUnit(s) have at least " << space << " free space, " << results.second << " in total.\n" << std::endl;
+            }
+            else if(command == "PLAN_WAVE"){
+                if(parameters.size() < 4 || std::stoi(parameters[0]) < 0 || std::stoi(parameters[1]) < 0 || std::stoi(parameters[2]) < 1){
+                    std::cout << "[Command Error] Invalid invocation of PLAN_WAVE found in the provided TXT file.\nUsage: PLAN_WAVE <ORIGIN_XCoord> <ORIGIN_YCoord> <Capacity> <Item Name>[,Item Name]... [<Item Name>[,Item Name]...]...\n" << std::endl;
+                    continue;
+                }
+                METRICS_TIME(CMD_PLAN_WAVE);
+                TRACE_SCOPE("PLAN_WAVE");
+                // Each parameter after the capacity is one order, its Item names separated by commas. Orders without Item names
+                // are skipped.
+                std::vector<std::vector<std::string> > orders;
+                for(int i = 3; i < (int)parameters.size(); i++){
+                    std::stringstream order(parameters[i]);
+                    std::string item;
+                    std::vector<std::string> names;
+                    while(std::getline(order, item, ',')) if(!item.empty()) names.push_back(item);
+                    if(!names.empty()) orders.push_back(names);
+                }
+                WavePlan wave = w.planWave({std::stoi(parameters[0]), std::stoi(parameters[1])}, orders, std::stoi(parameters[2]));
+                if(wave.distance < 0){
+                    std::cout << "[PLAN_WAVE] The origin is outside of the Warehouse or one of the items could not be found.\n" << std::endl;
+                    continue;
+                }
+                for(int o : wave.split){
+                    std::cout << "[PLAN_WAVE] Order " << o + 1 << " has " << orders[o].size() << " items, more than the capacity of " << parameters[2] << ", and is split over several tours." << std::endl;
+                }
+                for(int t = 0; t < (int)wave.tours.size(); t++){
+                    std::cout << "[PLAN_WAVE] Tour " << t + 1 << " picks order(s)";
+                    for(int o : wave.tours[t].orders) std::cout << " " << o + 1;
+                    std::cout << ": " << wave.tours[t].distance << " units\nStops: ";
+                    for(std::pair<int, int> stop : wave.tours[t].stops) std::cout << "(" << stop.first << "," << stop.second << ") ";
+                    std::cout << std::endl;
+                }
+                std::cout << "[PLAN_WAVE] " << orders.size() << " order(s) in " << wave.tours.size() << " tour(s): " << wave.distance << " units, compared to "
+                          << wave.separate << " units picking each order separately.\n" << std::endl;
+            }
+            else if(command == "PLAN_AGENTS"){
+                bool valid = !parameters.empty() && parameters.size() % 4 == 0;
+                for(int i = 0; valid && i < (int)parameters.size(); i++) valid = std::stoi(parameters[i]) >= 0;
+                if(!valid){
+                    std::cout << "[Command Error] Invalid invocation of PLAN_AGENTS found in the provided TXT file.\nUsage: PLAN_AGENTS <START_XCoord> <START_YCoord> <GOAL_XCoord> <GOAL_YCoord> [<START_XCoord> <START_YCoord> <GOAL_XCoord> <GOAL_YCoord>]...\n" << std::endl;
+                    continue;
+                }
+                METRICS_TIME(CMD_PLAN_AGENTS);
+                TRACE_SCOPE("PLAN_AGENTS");
+                // Each group of four parameters is one agent's start and goal. Planning stops after one second.
+                std::vector<std::pair<std::pair<int, int>, std::pair<int, int> > > agents;
+                for(int i = 0; i < (int)parameters.size(); i += 4){
+                    agents.push_back({{std::stoi(parameters[i]), std::stoi(parameters[i + 1])}, {std::stoi(parameters[i + 2]), std::stoi(parameters[i + 3])}});
+                }
+                AgentPlan plan = w.planAgents(agents, 1000000000LL);
+                if(plan.makespan < 0){
+                    std::cout << "[PLAN_AGENTS] A start or goal is outside of the Warehouse, or two agents share a start or a goal.\n" << std::endl;
+                    continue;
+                }
+                for(int a = 0; a < (int)plan.routes.size(); a++){
+                    const AgentRoute& route = plan.routes[a];
+                    std::cout << "[PLAN_AGENTS] Agent " << a + 1;
+                    if(!route.planned){
+                        std::cout << ": no conflict-free route found." << std::endl;
+                        continue;
+                    }
+                    std::cout << " arrives at time " << route.times.back() << "\nSteps: ";
+                    for(int k = 0; k < (int)route.cells.size(); k++) std::cout << "(" << route.cells[k].first << "," << route.cells[k].second << ")@" << route.times[k] << " ";
+                    std::cout << std::endl;
+                }
+                std::cout << "[PLAN_AGENTS] " << agents.size() - plan.failed << " of " << agents.size() << " agent(s) routed: makespan " << plan.makespan
+                          << ", total cost " << plan.cost << ".\n" << std::endl;
+            }
+            else if(command == "CONSOLIDATE"){
+                if(parameters.size() > 1 || (parameters.size() == 1 && std::stoi(parameters[0]) < 1)){
+                    std::cout << "[Command Error] Invalid invocation of CONSOLIDATE found in the provided TXT file.\nUsage: CONSOLIDATE [Moves]\n" << std::endl;
+                    continue;
+                }
+                METRICS_TIME(CMD_CONSOLIDATE);
+                TRACE_SCOPE("CONSOLIDATE");
+                // Reporting how scattered the Items and free space are before and after the cycle.
+                auto report = [](const std::string& when, const Fragmentation& f){
+                    std::cout << "[CONSOLIDATE] " << when << ": " << f.split_skus << " of " << f.skus << " Item(s) split, " << f.fragments << " placement(s), "
+                              << f.empty_units << " empty StorageUnit(s), " << f.sliver_space << " of " << f.free_space << " free space in partly used StorageUnit(s) ("
+                              << (int)(f.freeFragmentation() * 100 + 0.5) << "%)." << std::endl;
+                };
+                report("Before", w.fragmentation());
+                std::pair<int, int> moves = w.consolidate(parameters.empty() ? 100 : std::stoi(parameters[0]));
+                std::cout << "[CONSOLIDATE] " << moves.first << " move(s) made, " << moves.second << " skipped." << std::endl;
+                report("After", w.fragmentation());
+                std::cout << std::endl;
+            }
+            else if(command == "SET_PLACEMENT"){
+                bool nearest = parameters.size() == 3 && parameters[0] == "NEAREST" && std::stoi(parameters[1]) >= 0 && std::stoi(parameters[2]) >= 0;
+                bool velocity = parameters.size() >= 3 && parameters.size() <= 4 && parameters[0] == "VELOCITY" && std::stoi(parameters[1]) >= 0 && std::stoi(parameters[2]) >= 0;
+                if(!nearest && !velocity && !(parameters.size() == 1 && parameters[0] == "BEST_FIT")){
+                    std::cout << "[Command Error] Invalid invocation of SET_PLACEMENT found in the provided TXT file.\nUsage: SET_PLACEMENT BEST_FIT | SET_PLACEMENT NEAREST <XCoord> <YCoord> | SET_PLACEMENT VELOCITY <DockXCoord> <DockYCoord> [Picks.csv]\n" << std::endl;
+                    continue;
+                }
+                std::pair<int, int> anchor = nearest || velocity ? std::make_pair(std::stoi(parameters[1]), std::stoi(parameters[2])) : std::make_pair(0, 0);
+                if(velocity){
+                    if(parameters.size() == 4 && !w.loadPicks(parameters[3])) std::cout << "[Placement Error] Unable to open the pick counts file " << parameters[3] << "." << std::endl;
+                    w.setPlacement(std::unique_ptr<PlacementPolicy>(new VelocityPolicy(anchor)));
+                }
+                else if(nearest) w.setPlacement(std::unique_ptr<PlacementPolicy>(new NearestFitPolicy(anchor)));
+                else w.setPlacement(std::unique_ptr<PlacementPolicy>(new BestFitPolicy()));
+            }
+            else if(command == "SET_ROUTING"){
+                bool hpa = parameters.size() >= 1 && parameters.size() <= 3 && parameters[0] == "HPA";
+                for(int i = 1; hpa && i < (int)parameters.size(); i++) hpa = std::stoi(parameters[i]) >= 1;
+                bool ch = parameters.size() >= 1 && parameters.size() <= 2 && parameters[0] == "CH";
+                if(!hpa && !ch && !(parameters.size() == 1 && parameters[0] == "FLAT")){
+                    std::cout << "[Command Error] Invalid invocation of SET_ROUTING found in the provided TXT file.\nUsage: SET_ROUTING FLAT | SET_ROUTING HPA [ClusterSize] [Spacing] | SET_ROUTING CH [File]\n" << std::endl;
+                    continue;
+                }
+                if(hpa) w.setRouting(HPA_ROUTING, parameters.size() >= 2 ? std::stoi(parameters[1]) : 16, parameters.size() == 3 ? std::stoi(parameters[2]) : 4);
+                else if(ch){
+                    w.setRouting(CH_ROUTING, 16, 4);
+                    w.preprocessRoutes(parameters.size() == 2 ? parameters[1] : "");
+                }
+                else w.setRouting(FLAT_ROUTING, 16, 4);
+            }
+            else if(command == "SET_PICKING"){
+                if(parameters.size() != 1 || (parameters[0] != "INPUT" && parameters[0] != "OPTIMIZED")){
+                    std::cout << "[Command Error] Invalid invocation of SET_PICKING found in the provided TXT file.\nUsage: SET_PICKING INPUT | SET_PICKING OPTIMIZED\n" << std::endl;
+                    continue;
+                }
+                w.setPicking(parameters[0] == "OPTIMIZED" ? OPTIMIZED_ORDER : INPUT_ORDER);
+            }
+            else if(command == "SET_CONGESTION"){
+                if(parameters.empty() || parameters.size() > 2 || std::stoi(parameters[0]) < 0 || (parameters.size() == 2 && std::stoi(parameters[1]) < 1)){
+                    std::cout << "[Command Error] Invalid invocation of SET_CONGESTION found in the provided TXT file.\nUsage: SET_CONGESTION <Penalty> [HalfLife]\n" << std::endl;
+                    continue;
+                }
+                w.setCongestion(std::stoi(parameters[0]), parameters.size() == 2 ? std::stoi(parameters[1]) : 64);
             } else std::cout << "[Command Error] Invalid command found in the provided TXT file.\n" << std::endl;
         }
     }
@@ -210,5 +506,6 @@ int main(int argc, char*argv[]){
     // Exporting all data relevant to the Warehouse instance. Exports a TXT file containing Warehouse statistics and visualizations,
     // a CSV file for the updated StorageUnit instances, and a CSV file for the updated Item instances.
     w.print();
+    Tracer::flush();
     return 1;
 }
@@ -0,0 +1,191 @@
+//
+// CSC 212 - Data Structures and Abstractions
+// Dominic Tucchio, Jennipher Day, Maya Geva, Thomas Williams
+// Spring 2024 Term Project - consolidation.cpp
+//
+
+#include "consolidation.h"
+#include "metrics/metrics.h"
+#include "metrics/trace.h"
+
+#include <algorithm>
+#include <map>
+#include <set>
+
+//
+// CLASS: Consolidator
+// Plans moves that undo the fragmentation left by splitting Items between StorageUnits, against a snapshot of the floor.
+// Only whole fragments are moved, and an Item is never moved to a StorageUnit holding an Item of the same name with a
+// different size, as a StorageUnit keeps one Item of each name.
+//
+
+// SKU: An Item's name and size per unit. Fragments of the same name but a different size are never merged.
+typedef std::pair<std::string, int> Sku;
+
+// CONSTRUCTOR: Creates a Consolidator with no cycle being planned.
+Consolidator::Consolidator() : done(false) {
+
+}
+
+// DESTRUCTOR: Waits for a cycle still being planned, as its thread writes to the Consolidator.
+Consolidator::~Consolidator(){
+    if(worker.joinable()) worker.join();
+}
+
+// FUNCTION: Measures how fragmented a floor is. Accepts parameter floor, a snapshot of every StorageUnit.
+Fragmentation Consolidator::measure(const std::vector<SnapshotUnit>& floor){
+    Fragmentation f;
+    std::map<std::string, int> holders;
+    for(const SnapshotUnit& u : floor){
+        for(const Item& i : u.items) holders[i.name]++;
+        f.fragments += u.items.size();
+        if(u.used == 0) f.empty_units++;
+        else f.sliver_space += u.capacity - u.used;
+        f.free_space += u.capacity - u.used;
+        f.largest_free = std::max(f.largest_free, u.capacity - u.used);
+    }
+    f.skus = holders.size();
+    for(std::pair<const std::string, int>& h : holders) f.split_skus += h.second > 1;
+    return f;
+}
+
+// FUNCTION: Plans a cycle of at most budget moves. Accepts parameters floor, a snapshot of every StorageUnit that is
+// updated as moves are planned, and budget. First, for every Item stored in more than one StorageUnit, most scattered
+// first, the StorageUnit with the most room for the Item (its free space plus the Item's space already in it) becomes
+// its home and the other fragments are moved there, smallest first, while they fit. Then the StorageUnits holding the
+// least stock are emptied, one at a time and only if every Item in them can be moved: each Item goes to a StorageUnit
+// already holding it if possible and otherwise to the fullest StorageUnit that fits it. Items are only moved into
+// StorageUnits that already hold stock and have less free space than the one being emptied, so free space always ends
+// up in larger pieces. Returns the moves in the order they must be made.
+std::vector<ConsolidationMove> Consolidator::plan(std::vector<SnapshotUnit> floor, int budget){
+    TRACE_SCOPE("consolidation planning");
+    METRICS_TIME(OP_PLAN_CONSOLIDATION);
+    std::vector<ConsolidationMove> moves;
+    int n = floor.size();
+
+    auto free = [&](int u){ return floor[u].capacity - floor[u].used; };
+    auto find = [&](int u, const std::string& name){
+        for(int i = 0; i < (int)floor[u].items.size(); i++) if(floor[u].items[i].name == name) return i;
+        return -1;
+    };
+    auto space = [&](int u, int i){ return floor[u].items[i].quantity * floor[u].items[i].size_per_unit; };
+
+    // HOLDERS: The StorageUnits holding each SKU. FIT: Every StorageUnit ordered by free space, for best fit searches.
+    std::map<Sku, std::vector<int> > holders;
+    std::set<std::pair<int, int> > fit;
+    for(int u = 0; u < n; u++){
+        for(Item& i : floor[u].items) holders[{i.name, i.size_per_unit}].push_back(u);
+        fit.insert({free(u), u});
+    }
+
+    // Moves quantity of Item i of StorageUnit from to StorageUnit to, keeping the snapshot and indexes up to date.
+    auto move = [&](int from, int to, int i, int quantity){
+        Item item = floor[from].items[i];
+        item.quantity = quantity;
+        Sku sku = {item.name, item.size_per_unit};
+        int moved = quantity * item.size_per_unit;
+        fit.erase({free(from), from});
+        fit.erase({free(to), to});
+        floor[from].items[i].quantity -= quantity;
+        if(floor[from].items[i].quantity == 0) floor[from].items.erase(floor[from].items.begin() + i);
+        floor[from].used -= moved;
+        int existing = find(to, item.name);
+        if(existing == -1) floor[to].items.push_back(item);
+        else floor[to].items[existing].quantity += quantity;
+        floor[to].used += moved;
+        fit.insert({free(from), from});
+        fit.insert({free(to), to});
+
+        std::vector<int>& at = holders[sku];
+        if(find(from, item.name) == -1) at.erase(std::find(at.begin(), at.end(), from));
+        if(std::find(at.begin(), at.end(), to) == at.end()) at.push_back(to);
+        moves.push_back({item.name, quantity, item.size_per_unit, floor[from].loc, floor[to].loc});
+    };
+
+    // Merging the fragments of every split SKU into its home.
+    std::vector<Sku> split;
+    for(std::pair<const Sku, std::vector<int> >& h : holders) if(h.second.size() > 1) split.push_back(h.first);
+    std::stable_sort(split.begin(), split.end(), [&](const Sku& a, const Sku& b){ return holders[a].size() > holders[b].size(); });
+    for(const Sku& sku : split){
+        std::vector<int> at = holders[sku];
+        std::stable_sort(at.begin(), at.end(), [&](int a, int b){ return space(a, find(a, sku.first)) < space(b, find(b, sku.first)); });
+        for(int u : at){
+            if((int)moves.size() >= budget) return moves;
+            int i = find(u, sku.first), to = -1;
+            for(int h : holders[sku]){
+                if(h == u || free(h) < space(u, i) || free(h) >= free(u) + space(u, i)) continue;
+                if(to == -1 || floor[h].items[find(h, sku.first)].quantity > floor[to].items[find(to, sku.first)].quantity) to = h;
+            }
+            if(to != -1) move(u, to, i, floor[u].items[i].quantity);
+        }
+    }
+
+    // Emptying the StorageUnits holding the least stock, larger StorageUnits first when they hold the same amount.
+    std::vector<int> order;
+    for(int u = 0; u < n; u++) if(floor[u].used > 0) order.push_back(u);
+    std::stable_sort(order.begin(), order.end(), [&](int a, int b){
+        return floor[a].used != floor[b].used ? floor[a].used < floor[b].used : floor[a].capacity > floor[b].capacity;
+    });
+    std::vector<bool> emptied(n, false);
+    std::map<int, int> planned;
+    std::vector<std::pair<std::pair<std::string, int>, int> > destinations;
+    for(int c : order){
+        if(floor[c].used == 0 || (int)(moves.size() + floor[c].items.size()) > budget) continue;
+
+        // Every Item's destinations are found before any is moved, so the StorageUnit is only emptied if all of them fit.
+        // PLANNED holds the space already promised to each destination.
+        planned.clear();
+        destinations.clear();
+        bool fits = true;
+        for(int i = 0; fits && i < (int)floor[c].items.size(); i++){
+            const Item& item = floor[c].items[i];
+            int left = item.quantity;
+            auto room = [&](int u){
+                if(u == c || floor[u].used == 0 || emptied[u] || free(u) - planned[u] > free(c)) return 0;
+                return (free(u) - planned[u]) / item.size_per_unit;
+            };
+            auto take = [&](int u){
+                int quantity = std::min(left, room(u));
+                if(quantity <= 0) return;
+                planned[u] += quantity * item.size_per_unit;
+                destinations.push_back({{item.name, u}, quantity});
+                left -= quantity;
+            };
+            for(int h : holders[{item.name, item.size_per_unit}]) if(left > 0) take(h);
+            for(std::set<std::pair<int, int> >::iterator it = fit.lower_bound({item.size_per_unit, -1}); left > 0 && it != fit.end() && it->first <= floor[c].capacity; ++it){
+                int existing = find(it->second, item.name);
+                if(existing == -1) take(it->second);
+            }
+            fits = left == 0;
+        }
+        int created = 0;
+        for(std::pair<std::pair<std::string, int>, int>& d : destinations) created += find(d.first.second, d.first.first) == -1;
+        if(!fits || created > (int)floor[c].items.size() || (int)(moves.size() + destinations.size()) > budget) continue;
+
+        for(std::pair<std::pair<std::string, int>, int>& d : destinations) move(c, d.first.second, find(c, d.first.first), d.second);
+        emptied[c] = true;
+    }
+    return moves;
+}
+
+// FUNCTION: Starts planning a cycle on a background thread. Accepts parameters floor, a snapshot of every StorageUnit
+// that the thread takes ownership of, and budget, the most moves to plan. Returns false, and starts nothing, if a cycle
+// is already being planned.
+bool Consolidator::start(std::vector<SnapshotUnit> floor, int budget){
+    if(worker.joinable()) return false;
+    done = false;
+    worker = std::thread([this, budget](std::vector<SnapshotUnit> snapshot){
+        moves = plan(std::move(snapshot), budget);
+        done = true;
+    }, std::move(floor));
+    return true;
+}
+
+// FUNCTION: Waits for the cycle being planned to finish and returns its moves, or no moves if no cycle was started.
+std::vector<ConsolidationMove> Consolidator::finish(){
+    std::vector<ConsolidationMove> result;
+    if(!worker.joinable()) return result;
+    worker.join();
+    result.swap(moves);
+    return result;
+}
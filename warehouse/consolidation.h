@@ -0,0 +1,106 @@
+//
+// CSC 212 - Data Structures and Abstractions
+// Dominic Tucchio, Jennipher Day, Maya Geva, Thomas Williams
+// Spring 2024 Term Project - consolidation.h
+//
+
+#ifndef Consolidation_H
+#define Consolidation_H
+
+#include "container.h"
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+//
+// STRUCTURE: SnapshotUnit
+// A copy of one StorageUnit taken for the Consolidator, so moves can be planned while the Warehouse keeps changing.
+//
+
+struct SnapshotUnit {
+    std::pair<int, int> loc;
+    int capacity = 0;
+    int used = 0;
+    std::vector<Item> items;
+};
+
+//
+// STRUCTURE: Fragmentation
+// How scattered the stock and the free space of a floor are. SKUS is the number of distinct Items stored, SPLIT_SKUS the
+// number stored in more than one StorageUnit, and FRAGMENTS the number of (StorageUnit, Item) pairs. EMPTY_UNITS is the
+// number of StorageUnits holding nothing, FREE_SPACE the total free space, SLIVER_SPACE the part of it in StorageUnits
+// that hold something, and LARGEST_FREE the free space of the emptiest StorageUnit.
+//
+
+struct Fragmentation {
+    int skus = 0;
+    int split_skus = 0;
+    int fragments = 0;
+    int empty_units = 0;
+    long long free_space = 0;
+    long long sliver_space = 0;
+    int largest_free = 0;
+
+    // FUNCTION: Returns the share of free space left in slivers beside stock rather than in empty StorageUnits, from 0 to 1.
+    double freeFragmentation() const { return free_space == 0 ? 0 : (double)sliver_space / free_space; }
+};
+
+//
+// STRUCTURE: ConsolidationMove
+// Moves QUANTITY of the Item NAME, each of size SIZE_PER_UNIT, from the StorageUnit at FROM to the one at TO.
+//
+
+struct ConsolidationMove {
+    std::string name;
+    int quantity;
+    int size_per_unit;
+    std::pair<int, int> from;
+    std::pair<int, int> to;
+};
+
+//
+// CLASS: Consolidator
+// Plans moves that undo the fragmentation left by splitting Items between StorageUnits. A cycle first merges the
+// fragments of Items stored in several StorageUnits into the one with the most room for them, smallest fragments first,
+// and then empties the StorageUnits holding the least stock into the fullest StorageUnits that fit it, turning slivers of
+// free space into whole empty StorageUnits. A cycle makes at most a given number of moves. Moves are planned against a
+// snapshot of the floor, on a background thread when started with start(...), and are committed by the Warehouse, which
+// checks each one against the floor as it is then.
+//
+
+class Consolidator {
+    public:
+        // CONSTRUCTORS
+        Consolidator();
+        // DESTRUCTOR: Waits for a cycle still being planned.
+        ~Consolidator();
+
+        // FUNCTIONS
+
+        // FUNCTION: Returns how fragmented a floor is.
+        static Fragmentation measure(const std::vector<SnapshotUnit>& floor);
+        // FUNCTION: Plans at most budget moves for a floor.
+        static std::vector<ConsolidationMove> plan(std::vector<SnapshotUnit> floor, int budget);
+
+        // FUNCTION: Starts planning a cycle on a background thread. Returns false if a cycle is already being planned.
+        bool start(std::vector<SnapshotUnit> floor, int budget);
+        // FUNCTION: Returns true if a cycle was started and has not been finished.
+        bool running() { return worker.joinable(); }
+        // FUNCTION: Returns true if the cycle being planned is done, so finish() will not wait.
+        bool ready() { return done.load(); }
+        // FUNCTION: Waits for the cycle being planned and returns its moves.
+        std::vector<ConsolidationMove> finish();
+
+    private:
+        // MEMBER VARIABLES
+
+        // WORKER, DONE: The thread planning the current cycle and whether it has finished.
+        std::thread worker;
+        std::atomic<bool> done;
+        // MOVES: The moves planned by the current cycle.
+        std::vector<ConsolidationMove> moves;
+};
+
+#endif
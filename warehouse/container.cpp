@@ -6,6 +6,8 @@
 
 #include "container.h"
 
+#include <algorithm>
+
 //
 // CLASS: Storage Unit
 // Represents a storage unit in a warehouse. Each unit has a capacity, location, and a map of Item values.
@@ -34,50 +36,104 @@ StorageUnit::StorageUnit(int capacity, std::pair<int, int> location, std::vector
     this->capacity = capacity;
     this->location = location;
 
-    for(Item i : items){
+    for(const Item& i : items){
         this->add(i);
     }
 }
 
+// CONSTRUCTOR: Creates an instance of a StorageUnit from Items that are already accounted for, such as a copy of a cell
+// of the Warehouse's Grid. Accepts parameters capacity, location, items, the map of Item instances, and used_capacity,
+// the space those Items consume.
+StorageUnit::StorageUnit(int capacity, std::pair<int, int> location, const std::map<std::string, Item>& items, int used_capacity){
+    this->capacity = capacity;
+    this->location = location;
+    this->items = items;
+    this->used_capacity = used_capacity;
+}
+
 // FUNCTION: Adds an item to the StorageUnit instance. The only parameter is an Item instance.
-void StorageUnit::add(Item i) {
+void StorageUnit::add(const Item& i) {
+    add(items, used_capacity, capacity, i);
+    return;
+}
+
+// FUNCTION: Adds an item to a map of Items. Accepts parameters items, the map to add to, used_capacity, the space already
+// used by the map's Items, which is updated, capacity, the max capacity of the storage the map represents, and i, the
+// Item instance to add. Returns false without changing anything if the Item does not fit. The Warehouse's Grid keeps
+// Items outside of StorageUnit instances and uses this function so both follow the same rules.
+bool StorageUnit::add(std::map<std::string, Item>& items, int& used_capacity, int capacity, const Item& i) {
     // Check if the item exceeds the max capacity of the StorageUnit instance.
     if(i.quantity * i.size_per_unit + used_capacity > capacity) {
         std::cout << "[StorageUnit Add Error] Unable to store " <<  (i.size_per_unit * i.quantity) << " " << i.name << "(s) due to lack of available storage space.";
-        return;
+        return false;
     }
     // If the item exists already in the StorageUnit and the size_per_unit matches, add the new item to the existing
     // item, else create a new entry in the StorageUnit's map.
     if(items[i.name].size_per_unit == i.size_per_unit) items[i.name] += i;
     else items[i.name] = i;
 
-    // Updates the StorageUnit instance variable used_capacity to reflect the additional space that has now been used
-    // by adding this new item.
-    this->used_capacity += i.quantity * i.size_per_unit;
-    return;
+    // Updates used_capacity to reflect the additional space that has now been used by adding this new item.
+    used_capacity += i.quantity * i.size_per_unit;
+    return true;
+}
+
+// FUNCTION: Removes up to a quantity of an Item from the StorageUnit instance. Accepts parameters name, the name of the
+// Item, and quantity, the most to remove. Returns the quantity removed.
+int StorageUnit::remove(const std::string& name, int quantity) {
+    return remove(items, used_capacity, name, quantity);
+}
+
+// FUNCTION: Removes up to a quantity of an Item from a map of Items. Accepts parameters items, the map to remove from,
+// used_capacity, the space used by the map's Items, which is updated, name, the name of the Item, and quantity, the most
+// to remove. The Item is erased from the map once none of it is left. Returns the quantity removed, which is 0 if the map
+// does not hold the Item.
+int StorageUnit::remove(std::map<std::string, Item>& items, int& used_capacity, const std::string& name, int quantity) {
+    std::map<std::string, Item>::iterator found = items.find(name);
+    if(found == items.end() || quantity < 0) return 0;
+    int removed = std::min(quantity, found->second.quantity);
+    found->second.quantity -= removed;
+    used_capacity -= removed * found->second.size_per_unit;
+    if(found->second.quantity == 0) items.erase(found);
+    return removed;
 }
 
 // FUNCTION: Returns the max capacity of the StorageUnit instance as an integer.
-int StorageUnit::getCapacity() {
+int StorageUnit::getCapacity() const {
     return this->capacity;
 }
 
 // FUNCTION: Returns the currently used capacity of the StorageUnit instance as an integer.
-int StorageUnit::getUsedCapacity() {
+int StorageUnit::getUsedCapacity() const {
     return this->used_capacity;
 }
 
 // FUNCTION: Returns the location of the StorageUnit relevant to the Warehouse class' 2D vector as a pair of integers
 // representing cartesian coordinates.
-std::pair<int, int> StorageUnit::getLocation() {
+std::pair<int, int> StorageUnit::getLocation() const {
     return this->location;
 }
 
 // FUNCTION: Returns the map of Items stored in the StorageUnit instance.
-std::map<std::string, Item> StorageUnit::getItems() {
+std::map<std::string, Item> StorageUnit::getItems() const {
     return items;
 }
 
+// FUNCTION: Returns the estimated heap memory owned by the StorageUnit instance's map of Items.
+MemoryUsage StorageUnit::memoryUsage() {
+    return memoryUsage(items);
+}
+
+// FUNCTION: Returns the estimated heap memory owned by a map of Items: the map nodes plus any Item names too long for
+// the small string buffer, both as map keys and inside the Item instances.
+MemoryUsage StorageUnit::memoryUsage(const std::map<std::string, Item>& items) {
+    MemoryUsage m = estimateMap(items);
+    for(const std::pair<const std::string, Item>& i : items){
+        m += estimateString(i.first);
+        m += estimateString(i.second.name);
+    }
+    return m;
+}
+
 //
 // CLASS: Item
 // Represents an item stored in a warehouse. Each instance of Item has a name, quantity, and size per unit. The name
@@ -85,9 +141,11 @@ std::map<std::string, Item> StorageUnit::getItems() {
 // consumes.
 //
 
-// CONSTRUCTOR: Default constructor for the Item class.
+// CONSTRUCTOR: Default constructor for the Item class. The quantity and size are set to 0 so that a new entry in a
+// StorageUnit's map of Items never matches the size of the Item being added.
 Item::Item(){
-
+    this->quantity = 0;
+    this->size_per_unit = 0;
 }
 
 // CONSTRUCTOR: Primary constructor for the Item class. Accepts parameters name, a string, quantity, and size,
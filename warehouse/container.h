@@ -12,6 +12,8 @@
 #include <map>
 #include <iostream>
 
+#include "metrics/memory.h"
+
 //
 // CLASS: Item
 // Represents an item stored in a warehouse. Each instance of Item has a name, quantity, and size per unit. The name
@@ -54,20 +56,31 @@ class StorageUnit{
         StorageUnit();
         StorageUnit(int capacity, std::pair<int, int> location);
         StorageUnit(int capacity, std::pair<int, int> location, std::vector<Item> items);
+        StorageUnit(int capacity, std::pair<int, int> location, const std::map<std::string, Item>& items, int used_capacity);
 
         // PUBLIC METHODS
 
         // FUNCTION: Add an Item to the StorageUnit instance.
-        void add(Item i);
+        void add(const Item& i);
+        // FUNCTION: Add an Item to a map of Items with the given capacity. Shared with storage kept outside of a StorageUnit.
+        static bool add(std::map<std::string, Item>& items, int& used_capacity, int capacity, const Item& i);
+        // FUNCTION: Remove up to a quantity of an Item from the StorageUnit instance. Returns the quantity removed.
+        int remove(const std::string& name, int quantity);
+        // FUNCTION: Remove up to a quantity of an Item from a map of Items. Shared with storage kept outside of a StorageUnit.
+        static int remove(std::map<std::string, Item>& items, int& used_capacity, const std::string& name, int quantity);
 
         // FUNCTION: Return the max capacity of the StorageUnit instance.
-        int getCapacity();
+        int getCapacity() const;
         // FUNCTION: Return the capacity of the StorageUnit instance that is currently in use.
-        int getUsedCapacity();
+        int getUsedCapacity() const;
         // FUNCTION: Return the location of the StorageUnit instance.
-        std::pair<int, int> getLocation();
+        std::pair<int, int> getLocation() const;
         // FUNCTION: Return the StorageUnit instance's map of Items.
-        std::map<std::string, Item> getItems();
+        std::map<std::string, Item> getItems() const;
+        // FUNCTION: Returns the estimated heap memory owned by the StorageUnit instance's map of Items.
+        MemoryUsage memoryUsage();
+        // FUNCTION: Returns the estimated heap memory owned by a map of Items.
+        static MemoryUsage memoryUsage(const std::map<std::string, Item>& items);
 
     private:
         // MEMBER VARIABLES
@@ -0,0 +1,290 @@
+//
+// CSC 212 - Data Structures and Abstractions
+// Dominic Tucchio, Jennipher Day, Maya Geva, Thomas Williams
+// Spring 2024 Term Project - agents.cpp
+//
+
+#include "agents.h"
+#include "../metrics/metrics.h"
+#include "../metrics/trace.h"
+
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <queue>
+
+//
+// CLASS: SpaceTimeSet
+// A set of 64-bit keys, each packing a time step and a cell or edge, kept in one open-addressed array probed linearly.
+// A lookup hashes the key once and then reads consecutive slots, usually within a single cache line, and the table
+// never allocates per key. The table doubles when it is half full.
+//
+
+// CONSTRUCTOR: Creates an empty set with 1024 slots.
+SpaceTimeSet::SpaceTimeSet() : slots(1024, EMPTY), shift(64 - 10) {
+
+}
+
+// FUNCTION: Adds key to the set, doubling the table first if it is half full. Returns false if the key was already in
+// the set.
+bool SpaceTimeSet::insert(uint64_t key){
+    if((count + 1) * 2 > slots.size()) grow();
+    size_t mask = slots.size() - 1;
+    for(size_t s = home(key); ; s = (s + 1) & mask){
+        if(slots[s] == key) return false;
+        if(slots[s] == EMPTY){
+            slots[s] = key;
+            count++;
+            return true;
+        }
+    }
+}
+
+// FUNCTION: Returns true if key is in the set. The probe stops at the first unused slot.
+bool SpaceTimeSet::contains(uint64_t key) const {
+    size_t mask = slots.size() - 1;
+    for(size_t s = home(key); ; s = (s + 1) & mask){
+        if(slots[s] == key) return true;
+        if(slots[s] == EMPTY) return false;
+    }
+}
+
+// FUNCTION: Removes every key. The table keeps its size, so a set cleared between searches of a similar size does not
+// allocate again, unless it is more than eight times larger than its keys needed; one large search then does not make
+// every later clear(...) sweep the large table.
+void SpaceTimeSet::clear(){
+    size_t needed = 1024;
+    while(needed < count * 2) needed *= 2;
+    if(slots.size() > needed * 8){
+        std::vector<uint64_t>(needed, EMPTY).swap(slots);
+        shift = 64;
+        for(size_t s = needed; s > 1; s /= 2) shift--;
+    } else std::fill(slots.begin(), slots.end(), EMPTY);
+    count = 0;
+    return;
+}
+
+// FUNCTION: Doubles the number of slots and inserts every key into its new place.
+void SpaceTimeSet::grow(){
+    std::vector<uint64_t> old(slots.size() * 2, EMPTY);
+    old.swap(slots);
+    shift--;
+    count = 0;
+    for(uint64_t key : old) if(key != EMPTY) insert(key);
+    return;
+}
+
+//
+// CLASS: ReservationTable
+// The cells and edges claimed by the routes planned so far, by time step. Cells are reserved at every time step an
+// agent is in them, edges at every time step an agent is moving along them in either direction, and an agent that has
+// reached its goal parks there from its arrival onward.
+//
+
+// FUNCTION: Reserves cell at time step t and remembers the last time step the cell is reserved at.
+void ReservationTable::reserveCell(int cell, int t){
+    table.insert(key(cell, t, 0));
+    int& last = latest.emplace(cell, t).first->second;
+    last = std::max(last, t);
+    return;
+}
+
+// FUNCTION: Returns true if no agent is in cell at time step t, counting agents parked there.
+bool ReservationTable::cellFree(int cell, int t) const {
+    if(!parked.empty()){
+        std::unordered_map<int, int>::const_iterator p = parked.find(cell);
+        if(p != parked.end() && t >= p->second) return false;
+    }
+    return !table.contains(key(cell, t, 0));
+}
+
+// FUNCTION: Returns the last time step cell is reserved at, INT_MAX if an agent is parked there, or -1 if it is free at
+// every time step.
+int ReservationTable::lastReserved(int cell) const {
+    if(parked.count(cell) != 0) return INT_MAX;
+    std::unordered_map<int, int>::const_iterator l = latest.find(cell);
+    return l == latest.end() ? -1 : l->second;
+}
+
+// FUNCTION: Returns the estimated memory of the reservation table and of the parked agents and last reservations.
+MemoryUsage ReservationTable::memoryUsage() const {
+    MemoryUsage m = table.memoryUsage();
+    for(const std::unordered_map<int, int>* map : {&parked, &latest}){
+        m.bytes += map->size() * (sizeof(void*) + sizeof(std::pair<const int, int>)) + map->bucket_count() * sizeof(void*);
+        m.allocations += map->size() + 1;
+    }
+    return m;
+}
+
+//
+// CLASS: AgentPlanner
+// Plans conflict-free routes for several pickers or robots moving on the same floor at once with prioritized planning.
+// Agents are planned one at a time, those farthest from their goals first, each with a space-time A* search that avoids
+// every cell and edge reserved by the agents planned before it; its route is then reserved in turn. No two agents are
+// ever in the same cell at the same time or on the same edge at the same time, whichever way they move along it, and an
+// agent waits in place when it has to. The heuristic is each agent's shortest path length ignoring the others.
+//
+
+// FUNCTION: Plans a route for every agent. Agents are ordered by the Manhattan distance from their start to their goal,
+// farthest first, as long routes have the fewest ways around others. Each agent may take up to 64 time steps plus two
+// per agent longer than its shortest path, or than the last time another agent passes through its goal if that is
+// later; an agent that cannot reach its goal in that time, or is reached after the budget has run out, is left without
+// a route. Accepts parameters units and graph, the floor and its adjacency lists,
+// agents, the start and goal cell of each agent, which must all be inside the floor with no two starts or two goals
+// alike, and budget_ns, the planning budget in nanoseconds. Returns the AgentPlan.
+AgentPlan AgentPlanner::plan(Grid& units, Graph& graph, const std::vector<std::pair<std::pair<int, int>, std::pair<int, int> > >& agents, long long budget_ns){
+    TRACE_SCOPE("agent planning");
+    METRICS_TIME(OP_PLAN_AGENTS);
+    std::chrono::steady_clock::time_point started = std::chrono::steady_clock::now();
+    long long deadline_ns = budget_ns;
+    reservations = ReservationTable();
+
+    AgentPlan plan;
+    plan.routes.resize(agents.size());
+    std::vector<int> order(agents.size());
+    for(int a = 0; a < (int)agents.size(); a++) order[a] = a;
+    auto manhattan = [&](int a){ return std::abs(agents[a].first.first - agents[a].second.first) + std::abs(agents[a].first.second - agents[a].second.second); };
+    std::stable_sort(order.begin(), order.end(), [&](int a, int b){ return manhattan(a) > manhattan(b); });
+
+    int cols = units.getCols();
+    int slack = 64 + 2 * agents.size();
+    for(int a : order){
+        long long elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - started).count();
+        int start = coordToIndex(agents[a].first, cols), goal = coordToIndex(agents[a].second, cols);
+        AgentRoute& route = plan.routes[a];
+        // The exact distance to the goal from every cell, ignoring the other agents.
+        std::vector<int> h = elapsed < deadline_ns ? WarehousePaths::distances(units, graph, goal) : std::vector<int>();
+        if(h.empty() || h[start] == INT_MAX){
+            plan.failed++;
+            continue;
+        }
+        // An agent may have to wait for the last agent to pass through its goal before it can stop there.
+        int passed = reservations.lastReserved(goal);
+        int horizon = std::max(h[start], passed == INT_MAX ? 0 : passed + 1) + slack;
+        if(!search(units, graph, start, goal, h, horizon, deadline_ns - elapsed, route)){
+            plan.failed++;
+            continue;
+        }
+        reserve(units, route);
+        plan.makespan = std::max(plan.makespan, route.times.back());
+        plan.cost += route.times.back();
+    }
+    plan.reservations = reservations.size();
+    plan.plan_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - started).count();
+    return plan;
+}
+
+// FUNCTION: Finds the route that brings one agent to its goal earliest without using a cell or edge reserved by another
+// agent, with A* over states of a cell at a time step. From each state the agent can wait one time step or move to a
+// neighboring cell, arriving after the edge's weight; while moving, the edge must be free at every time step of the
+// move. The agent may only stop at its goal once no other agent will pass through it later. Accepts parameters units
+// and graph, start and goal, the graph indices of the agent's cells, h, the distance to the goal from every cell,
+// horizon, the last time step the agent may arrive, deadline_ns, the time left for the search, and route, which is
+// filled in. Returns true if a route was found.
+bool AgentPlanner::search(Grid& units, Graph& graph, int start, int goal, const std::vector<int>& h, int horizon, long long deadline_ns, AgentRoute& route){
+    // STATE: A cell at a time step and the state it was reached from, by its position in states.
+    struct State {
+        int cell, t, parent;
+    };
+    // ENTRY: A state waiting in the open list, ordered by estimated arrival time and then by distance left.
+    struct Entry {
+        int f, h, state;
+        bool operator>(const Entry& e) const { return f != e.f ? f > e.f : h > e.h; }
+    };
+
+    std::chrono::steady_clock::time_point started = std::chrono::steady_clock::now();
+    int cols = units.getCols();
+    int last_reserved = reservations.lastReserved(goal);
+    if(last_reserved == INT_MAX) return false;
+    // The estimated arrival time of a state. No route can stop at the goal before the last agent has passed through it.
+    auto estimate = [&](int cell, int t){ return std::max(t + h[cell], last_reserved + 1); };
+    std::vector<State> states;
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry> > open;
+    reached.clear();
+
+    states.push_back({start, 0, -1});
+    open.push({estimate(start, 0), h[start], 0});
+    reached.insert(start);
+    int found = -1;
+    for(int expanded = 0; !open.empty(); expanded++){
+        if((expanded & 255) == 255 && std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - started).count() > deadline_ns) break;
+        State current = states[open.top().state];
+        int index = open.top().state;
+        open.pop();
+        METRICS_COUNT(AGENT_STATES_EXPANDED);
+        if(current.cell == goal && current.t > last_reserved){
+            found = index;
+            break;
+        }
+
+        // Waiting in place for one time step.
+        if(current.t + 1 <= horizon && reservations.cellFree(current.cell, current.t + 1) && reached.insert(((uint64_t)(current.t + 1) << 32) | (uint32_t)current.cell)){
+            states.push_back({current.cell, current.t + 1, index});
+            open.push({estimate(current.cell, current.t + 1), h[current.cell], (int)states.size() - 1});
+        }
+
+        // Moving to each neighboring cell.
+        GraphEdge floor_edges[WarehousePaths::DEGREE];
+        GraphEdge* edges = floor_edges;
+        int n_edges;
+        Graph::iterator stored = graph.find(current.cell);
+        if(stored != graph.end()){
+            edges = stored->second.data();
+            n_edges = stored->second.size();
+        } else n_edges = WarehousePaths::neighbours(units, indexToCoordinates(current.cell, cols), floor_edges);
+        for(int k = 0; k < n_edges; k++){
+            int next = edges[k].dest, arrival = current.t + edges[k].weight;
+            if(arrival > horizon || h[next] == INT_MAX || reached.contains(((uint64_t)arrival << 32) | (uint32_t)next) || !reservations.cellFree(next, arrival)) continue;
+            int e = edge(current.cell, next, cols);
+            bool free = true;
+            for(int t = current.t + 1; free && t <= arrival; t++) free = reservations.edgeFree(e, t);
+            if(!free) continue;
+            reached.insert(((uint64_t)arrival << 32) | (uint32_t)next);
+            states.push_back({next, arrival, index});
+            open.push({estimate(next, arrival), h[next], (int)states.size() - 1});
+        }
+    }
+    if(found < 0) return false;
+
+    // Listing the states from the start, keeping only the arrival at each cell; waits show as gaps between arrivals.
+    std::vector<int> chain;
+    for(int s = found; s != -1; s = states[s].parent) chain.push_back(s);
+    std::reverse(chain.begin(), chain.end());
+    route.cells.clear();
+    route.times.clear();
+    for(int s : chain){
+        if(!route.cells.empty() && coordToIndex(route.cells.back(), cols) == states[s].cell) continue;
+        route.cells.push_back(indexToCoordinates(states[s].cell, cols));
+        route.times.push_back(states[s].t);
+    }
+    route.planned = true;
+    return true;
+}
+
+// FUNCTION: Reserves a planned route: each cell from the agent's arrival until it leaves, each edge at every time step
+// the agent is moving along it, and the goal from the agent's arrival onward. The time a move leaves is its arrival
+// less the edge's weight.
+void AgentPlanner::reserve(Grid& units, const AgentRoute& route){
+    int cols = units.getCols();
+    for(int k = 0; k < (int)route.cells.size(); k++){
+        int cell = coordToIndex(route.cells[k], cols);
+        if(k + 1 == (int)route.cells.size()){
+            reservations.reserveCell(cell, route.times[k]);
+            reservations.park(cell, route.times[k]);
+            break;
+        }
+        int next = coordToIndex(route.cells[k + 1], cols);
+        int leaves = route.times[k + 1] - CapacityWeight::weight(units, route.cells[k], route.cells[k + 1], 1);
+        for(int t = route.times[k]; t <= leaves; t++) reservations.reserveCell(cell, t);
+        for(int t = leaves + 1; t <= route.times[k + 1]; t++) reservations.reserveEdge(edge(cell, next, cols), t);
+    }
+    return;
+}
+
+// FUNCTION: Returns the index of the edge between two neighboring cells, given by their graph indices a and b on a floor
+// cols cells wide. The higher of the two indices is the right or lower neighbor of the other, so each edge is numbered
+// by its lower index and whether it runs along a row (0) or down a column (1).
+int AgentPlanner::edge(int a, int b, int cols){
+    int lo = std::min(a, b), hi = std::max(a, b);
+    return lo * 2 + (indexToCoordinates(lo, cols).first == indexToCoordinates(hi, cols).first ? 0 : 1);
+}
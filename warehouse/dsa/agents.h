@@ -0,0 +1,166 @@
+//
+// CSC 212 - Data Structures and Abstractions
+// Dominic Tucchio, Jennipher Day, Maya Geva, Thomas Williams
+// Spring 2024 Term Project - agents.h
+//
+
+#ifndef AgentPlanner_H
+#define AgentPlanner_H
+
+#include "algorithms.h"
+#include "../metrics/memory.h"
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+//
+// STRUCTURE: AgentRoute
+// The route planned for one picker or robot: the cells it moves through and the time it arrives at each, starting at
+// its start cell at time 0. A step between neighboring cells takes as long as the edge's weight in the Warehouse's
+// graph, and a gap between the arrival at a cell and the departure for the next is spent waiting. PLANNED is false if
+// no route was found within the horizon or the planning budget.
+//
+
+struct AgentRoute {
+    std::vector<std::pair<int, int> > cells;
+    std::vector<int> times;
+    bool planned = false;
+};
+
+//
+// STRUCTURE: AgentPlan
+// The routes planned for every agent, in the order the agents were given, along with the time the last agent reaches
+// its goal (makespan), the sum of every agent's arrival time at its goal (cost), the number of agents without a route,
+// the number of reservations made, and the time spent planning.
+//
+
+struct AgentPlan {
+    std::vector<AgentRoute> routes;
+    int makespan = 0;
+    long long cost = 0;
+    int failed = 0;
+    size_t reservations = 0;
+    long long plan_ns = 0;
+};
+
+//
+// CLASS: SpaceTimeSet
+// A set of 64-bit keys, each packing a time step and a cell or edge, kept in one open-addressed array probed linearly.
+// A lookup hashes the key once and then reads consecutive slots, usually within a single cache line, and the table
+// never allocates per key. The table doubles when it is half full.
+//
+
+class SpaceTimeSet {
+    public:
+        // CONSTRUCTORS
+        SpaceTimeSet();
+
+        // FUNCTIONS
+
+        // FUNCTION: Adds a key. Returns false if it was already in the set.
+        bool insert(uint64_t key);
+        // FUNCTION: Returns true if a key is in the set.
+        bool contains(uint64_t key) const;
+        // FUNCTION: Removes every key, keeping the table's memory unless it is far larger than needed.
+        void clear();
+        // FUNCTION: Returns the number of keys.
+        size_t size() const { return count; }
+        // FUNCTION: Estimates the memory used by the table.
+        MemoryUsage memoryUsage() const { return estimateVector(slots); }
+
+    private:
+        // FUNCTIONS
+
+        // FUNCTION: Returns the first slot to probe for a key.
+        size_t home(uint64_t key) const { return (key * 0x9E3779B97F4A7C15ULL) >> shift; }
+        // FUNCTION: Doubles the table and inserts every key again.
+        void grow();
+
+        // MEMBER VARIABLES
+
+        // EMPTY: The value of an unused slot; no key packs to it.
+        static constexpr uint64_t EMPTY = ~0ULL;
+        // SLOTS, COUNT, SHIFT: The table, the number of keys in it, and 64 minus the log2 of its size.
+        std::vector<uint64_t> slots;
+        size_t count = 0;
+        int shift;
+};
+
+//
+// CLASS: ReservationTable
+// The cells and edges claimed by the routes planned so far, by time step. Cells are reserved at every time step an
+// agent is in them, edges at every time step an agent is moving along them in either direction, and an agent that has
+// reached its goal parks there from its arrival onward.
+//
+
+class ReservationTable {
+    public:
+        // FUNCTIONS
+
+        // FUNCTION: Reserves a cell at a time step.
+        void reserveCell(int cell, int t);
+        // FUNCTION: Reserves the edge between two cells, given by its edge index, at a time step.
+        void reserveEdge(int edge, int t) { table.insert(key(edge, t, 1)); }
+        // FUNCTION: Reserves a cell from a time step onward.
+        void park(int cell, int t) { parked[cell] = t; }
+        // FUNCTION: Returns true if a cell is free at a time step.
+        bool cellFree(int cell, int t) const;
+        // FUNCTION: Returns true if an edge is free at a time step.
+        bool edgeFree(int edge, int t) const { return !table.contains(key(edge, t, 1)); }
+        // FUNCTION: Returns the last time step a cell is reserved at, or -1 if it is never reserved.
+        int lastReserved(int cell) const;
+        // FUNCTION: Returns the number of reservations.
+        size_t size() const { return table.size() + parked.size(); }
+        // FUNCTION: Estimates the memory used by the reservations.
+        MemoryUsage memoryUsage() const;
+
+    private:
+        // FUNCTION: Packs a time step, a cell or edge index, and whether it is an edge into a key.
+        static uint64_t key(int index, int t, int edge) { return ((uint64_t)t << 33) | ((uint64_t)index << 1) | edge; }
+
+        // MEMBER VARIABLES
+
+        // TABLE: The cell and edge reservations.
+        SpaceTimeSet table;
+        // PARKED, LATEST: The time each parked agent reached its goal, and the last time step each cell is reserved at.
+        std::unordered_map<int, int> parked;
+        std::unordered_map<int, int> latest;
+};
+
+//
+// CLASS: AgentPlanner
+// Plans conflict-free routes for several pickers or robots moving on the same floor at once with prioritized planning.
+// Agents are planned one at a time, those farthest from their goals first, each with a space-time A* search that avoids
+// every cell and edge reserved by the agents planned before it; its route is then reserved in turn. No two agents are
+// ever in the same cell at the same time or on the same edge at the same time, whichever way they move along it, and an
+// agent waits in place when it has to. The heuristic is each agent's shortest path length ignoring the others.
+//
+
+class AgentPlanner {
+    public:
+        // FUNCTIONS
+
+        // PLAN: Plans a route from each agent's start to its goal within a time budget.
+        AgentPlan plan(Grid& units, Graph& graph, const std::vector<std::pair<std::pair<int, int>, std::pair<int, int> > >& agents, long long budget_ns);
+
+    private:
+        // FUNCTIONS
+
+        // SEARCH: Finds the earliest conflict-free route for one agent with space-time A*.
+        bool search(Grid& units, Graph& graph, int start, int goal, const std::vector<int>& h, int horizon, long long deadline_ns, AgentRoute& route);
+        // RESERVE: Reserves the cells and edges used by a route.
+        void reserve(Grid& units, const AgentRoute& route);
+        // EDGE: Returns the index of the edge between two neighboring cells on a floor cols cells wide.
+        static int edge(int a, int b, int cols);
+
+        // MEMBER VARIABLES
+
+        // RESERVATIONS: The cells and edges claimed by the routes planned so far.
+        ReservationTable reservations;
+        // REACHED: The states, a cell at a time step, already reached by the current search. A state's time step is the
+        // cost of reaching it, so no state is ever reached more cheaply a second time.
+        SpaceTimeSet reached;
+};
+
+#endif
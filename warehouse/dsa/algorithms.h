@@ -8,21 +8,23 @@
 #define Algorithms_H
 
 #include "../container.h"
+#include "grid.h"
+#include "path_engine.h"
+#include "traffic.h"
 #include <queue>
 #include <algorithm>
 #include <cmath>
 #include <climits>
+#include <functional>
 
 //
-// STRUCTURE: GraphEdge
-// Represents an edge in a graph. Contains the index of the source node, the index of the destination node, and the
-// distance (weight) between nodes. These values are all stored as integers. The index for the source node and destination
-// node are converted from the standard (x,y) coordinates used in the main Warehouse instance.
+// TYPE: WarehousePaths
+// The PathEngine used for the Warehouse's graph: steps to the four cells sharing a side, weighted by their Manhattan
+// length and the size of the StorageUnits at either end. The HierarchicalGraph and the ContractionHierarchy use the same
+// edges, so their paths match dijkstra(...).
 //
 
-struct GraphEdge {
-    int src, dest, weight;
-};
+typedef PathEngine<FourNeighbours, CapacityWeight> WarehousePaths;
 
 //
 // STRUCTURE: ItemRatio
@@ -47,7 +49,8 @@ struct ItemRatio {
 // CLASS: Algorithms
 // This class' primary function is to provide implementations of the required algorithms. The class hosts the
 // implementations of Dijkstra's Algorithm and the solution to the Fractional Knapsack problem. Also included in this
-// class is the function to build the adjacency list used by Dijkstra's Algorithm.
+// class is the function to build the adjacency list used by Dijkstra's Algorithm. The graph functions forward to
+// WarehousePaths, the PathEngine specialized for the Warehouse's neighbourhood and edge weights.
 //
 
 class Algorithms{
@@ -57,12 +60,22 @@ class Algorithms{
 
         // PUBLIC METHODS
 
+        // FUNCTION: Returns the weight a cell with the given capacity adds to each edge that touches it.
+        static int cellWeight(int capacity) { return CapacityWeight::cell(capacity); }
         // FUNCTION: Construct a graph based on Warehouse instance. Resulting graph is to be used with Dijkstra's Algorithm.
-        std::vector<std::vector<GraphEdge> > buildGraph(std::vector<std::vector<StorageUnit> >& units);
+        Graph buildGraph(Grid& units) { return WarehousePaths::buildGraph(units); }
+        // FUNCTION: Update the adjacency lists affected by a change to a single StorageUnit.
+        void updateGraph(Grid& units, Graph& graph, std::pair<int, int> loc) { WarehousePaths::updateGraph(units, graph, loc); }
         // FUNCTION: Find the shortest distance between two nodes in a graph.
-        std::pair<int, std::vector<std::pair<int, int> > > dijkstra(std::vector<std::vector<StorageUnit> >& units, std::vector<std::vector<GraphEdge>>& graph, std::pair<int, int> src_c, std::pair<int, int> dest_c);
-        // FUNCTION: Distributes an Item instance among StorageUnit instances.
-        std::pair<int, std::vector<std::pair<int, int> > > fknapsack(std::vector<std::vector<StorageUnit> >& units, Item i);
+        std::pair<int, std::vector<std::pair<int, int> > > dijkstra(Grid& units, Graph& graph, std::pair<int, int> src_c, std::pair<int, int> dest_c) { return WarehousePaths::dijkstra(units, graph, src_c, dest_c); }
+        // FUNCTION: Find the path between two nodes that is shortest with each edge's traffic added as a penalty.
+        std::pair<int, std::vector<std::pair<int, int> > > dijkstra(Grid& units, Graph& graph, std::pair<int, int> src_c, std::pair<int, int> dest_c, const TrafficMap& traffic) { return WarehousePaths::dijkstra(units, graph, src_c, dest_c, traffic); }
+        // FUNCTION: Find the shortest distance from one node to each of several others with a single search.
+        std::vector<int> distances(Grid& units, Graph& graph, std::pair<int, int> src_c, const std::vector<std::pair<int, int> >& targets);
+        // FUNCTION: Find the shortest distance from one node to every node in the graph.
+        std::vector<int> distances(Grid& units, Graph& graph, std::pair<int, int> src_c);
+        // FUNCTION: Plans how to distribute an Item instance among StorageUnit instances, in order of priority.
+        std::pair<int, std::vector<std::pair<std::pair<int, int>, int> > > fknapsack(Grid& units, Item i, const std::function<double(std::pair<int, int>)>& priority, const std::function<int(std::pair<int, int>)>& held);
 };
 
 #endif
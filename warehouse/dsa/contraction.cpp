@@ -0,0 +1,494 @@
+//
+// CSC 212 - Data Structures and Abstractions
+// Dominic Tucchio, Jennipher Day, Maya Geva, Thomas Williams
+// Spring 2024 Term Project - contraction.cpp
+//
+
+#include "contraction.h"
+#include "../metrics/metrics.h"
+#include "../metrics/trace.h"
+
+#include <chrono>
+#include <fstream>
+#include <unordered_map>
+
+//
+// CLASS: ContractionHierarchy
+// A preprocessed form of the Warehouse graph for exact shortest path queries. Every cell of the floor is contracted in
+// turn, least important first: it is removed from the graph, and a shortcut is added between two of its neighbors
+// whenever the path through it was the only shortest path between them. The order in which cells were contracted is
+// their rank. Every shortest path then has a form that only climbs in rank up to a peak and then only descends, so a
+// query is two small Dijkstra searches that only follow edges to higher ranked cells, one from each end, meeting at the
+// peak. Shortcuts on the path found are unpacked into the cells they skip. Distances are exactly those of
+// Algorithms::dijkstra(...), as edge weights match the graph built by Algorithms::buildGraph(...). Any change to the
+// StorageUnits requires preprocessing again.
+//
+
+// CONTRACT_SETTLE_LIMIT, ESTIMATE_SETTLE_LIMIT: The most cells a witness search settles before giving up, when
+// contracting a cell and when only estimating its priority. A witness search that gives up early only costs an unneeded
+// shortcut, never a wrong distance.
+static const int CONTRACT_SETTLE_LIMIT = 500;
+static const int ESTIMATE_SETTLE_LIMIT = 20;
+// FILE_MAGIC, FILE_VERSION: The first bytes of a saved hierarchy.
+static const char FILE_MAGIC[4] = {'W', 'H', 'C', 'H'};
+static const int FILE_VERSION = 2;
+
+// CONSTRUCTOR: Creates an empty hierarchy. Nothing is built until build(...) or load(...) is called.
+ContractionHierarchy::ContractionHierarchy(){
+
+}
+
+// FUNCTION: Returns a hash of the floor's size and of the weight of every cell, read a row at a time. Two floors with
+// the same fingerprint have the same graph, so a saved hierarchy can be reused.
+unsigned long long ContractionHierarchy::fingerprint(Grid& units){
+    int r = units.getRows(), c = units.getCols();
+    // FNV-1a over the size and the cell weights.
+    unsigned long long h = 14695981039346656037ULL;
+    auto mix = [&](int v){
+        h ^= (unsigned int)v;
+        h *= 1099511628211ULL;
+    };
+    mix(r);
+    mix(c);
+    std::vector<int> row(c);
+    for(int x = 0; x < r; x++){
+        units.block({x, 0}, 1, c, row.data());
+        for(int w : row) mix(Algorithms::cellWeight(w));
+    }
+    return h;
+}
+
+// FUNCTION: Adds an edge between two uncontracted cells to both of their lists in the remaining graph. If the cells
+// are already joined, the shorter of the two edges is kept.
+void ContractionHierarchy::connect(int a, int b, int weight, int middle){
+    for(CHEdge& e : adjacency[a]){
+        if(e.to != b) continue;
+        if(weight < e.weight){
+            e.weight = weight;
+            e.middle = middle;
+            for(CHEdge& r : adjacency[b]){
+                if(r.to == a){
+                    r.weight = weight;
+                    r.middle = middle;
+                }
+            }
+        }
+        return;
+    }
+    adjacency[a].push_back({b, weight, middle});
+    adjacency[b].push_back({a, weight, middle});
+    return;
+}
+
+// FUNCTION: Runs Dijkstra's Algorithm over the remaining graph from source without passing through skip, stopping once
+// every cell closer than limit is settled or settle_limit cells have been settled. Fills witness_dist; cells that were
+// not reached keep INT_MAX.
+void ContractionHierarchy::witness(int source, int skip, int limit, int settle_limit){
+    for(int u : touched) witness_dist[u] = INT_MAX;
+    touched.clear();
+    heap.clear();
+
+    auto later = [](const std::pair<int, int>& a, const std::pair<int, int>& b){ return a.first > b.first; };
+    witness_dist[source] = 0;
+    touched.push_back(source);
+    heap.push_back({0, source});
+    int settled = 0;
+    while(!heap.empty()){
+        std::pair<int, int> top = heap.front();
+        std::pop_heap(heap.begin(), heap.end(), later);
+        heap.pop_back();
+        int u = top.second;
+        if(top.first != witness_dist[u]) continue;
+        if(top.first > limit || ++settled > settle_limit) break;
+
+        for(const CHEdge& e : adjacency[u]){
+            if(e.to == skip) continue;
+            int d = top.first + e.weight;
+            if(d < witness_dist[e.to]){
+                if(witness_dist[e.to] == INT_MAX) touched.push_back(e.to);
+                witness_dist[e.to] = d;
+                heap.push_back({d, e.to});
+                std::push_heap(heap.begin(), heap.end(), later);
+            }
+        }
+    }
+    return;
+}
+
+// FUNCTION: Contracts a cell, or only counts the shortcuts contracting it would need. For every pair of neighbors u and
+// w of the cell, a witness search from u looks for a path to w that avoids the cell and is no longer than the path
+// through it; if none is found, the shortcut u-w is needed. When add is true the shortcuts are added, the cell is removed
+// from its neighbors' lists, and its own list is kept as its upward edges. Returns the number of shortcuts.
+int ContractionHierarchy::contract(int node, bool add){
+    const std::vector<CHEdge>& around = adjacency[node];
+    int n = (int)around.size();
+    int count = 0;
+    for(int i = 0; i + 1 < n; i++){
+        int limit = 0;
+        for(int j = i + 1; j < n; j++) limit = std::max(limit, around[i].weight + around[j].weight);
+        witness(around[i].to, node, limit, add ? CONTRACT_SETTLE_LIMIT : ESTIMATE_SETTLE_LIMIT);
+        for(int j = i + 1; j < n; j++){
+            int via = around[i].weight + around[j].weight;
+            if(witness_dist[around[j].to] <= via) continue;
+            count++;
+            if(add) connect(around[i].to, around[j].to, via, node);
+        }
+    }
+
+    if(add){
+        for(const CHEdge& e : around){
+            std::vector<CHEdge>& list = adjacency[e.to];
+            for(size_t k = 0; k < list.size(); k++){
+                if(list[k].to == node){
+                    list[k] = list.back();
+                    list.pop_back();
+                    break;
+                }
+            }
+            deleted[e.to]++;
+        }
+    }
+    return count;
+}
+
+// FUNCTION: Returns the priority of a cell for contraction: the change in the number of edges contracting it would make,
+// counted twice, plus the number of its neighbors already contracted, which spreads contraction evenly across the floor.
+int ContractionHierarchy::priority(int node){
+    return 2 * (contract(node, false) - (int)adjacency[node].size()) + deleted[node];
+}
+
+// FUNCTION: Preprocesses the floor. Every cell becomes a node, numbered by its graph index, joined to its neighbors by
+// the edges of Algorithms::buildGraph(...); the indices past the floor's edges have no edges and cost nothing to
+// contract. Cells are then contracted in order of priority. Priorities are recalculated lazily: a
+// cell at the front of the queue whose priority has grown past the next cell's is queued again instead of contracted.
+// Finally the upward edges of every cell are packed into one array. Records the time taken and the number of shortcuts
+// added.
+void ContractionHierarchy::build(Grid& units){
+    TRACE_SCOPE("contraction hierarchy build");
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    rows = units.getRows();
+    cols = units.getCols();
+    int n = indexCount(rows, cols);
+    hash = fingerprint(units);
+
+    // The floor's graph.
+    adjacency.assign(n, std::vector<CHEdge>());
+    deleted.assign(n, 0);
+    witness_dist.assign(n, INT_MAX);
+    touched.clear();
+    std::vector<int> weight(cols), below(cols);
+    for(int x = 0; x < rows; x++){
+        units.block({x, 0}, 1, cols, weight.data());
+        if(x + 1 < rows) units.block({x + 1, 0}, 1, cols, below.data());
+        for(int y = 0; y < cols; y++){
+            int u = coordToIndex({x, y}, cols);
+            if(y + 1 < cols) connect(u, coordToIndex({x, y + 1}, cols), 1 + Algorithms::cellWeight(weight[y]) + Algorithms::cellWeight(weight[y + 1]), -1);
+            if(x + 1 < rows) connect(u, coordToIndex({x + 1, y}, cols), 1 + Algorithms::cellWeight(weight[y]) + Algorithms::cellWeight(below[y]), -1);
+        }
+    }
+
+    // Contracting the cells in order of priority.
+    std::vector<std::pair<int, int> > queue;
+    auto later = [](const std::pair<int, int>& a, const std::pair<int, int>& b){ return a.first != b.first ? a.first > b.first : a.second > b.second; };
+    for(int u = 0; u < n; u++) queue.push_back({priority(u), u});
+    std::make_heap(queue.begin(), queue.end(), later);
+
+    rank.assign(n, -1);
+    shortcuts = 0;
+    int order = 0;
+    while(!queue.empty()){
+        std::pair<int, int> top = queue.front();
+        std::pop_heap(queue.begin(), queue.end(), later);
+        queue.pop_back();
+        int u = top.second;
+
+        // Lazy update: the priority may have grown since it was queued.
+        int p = priority(u);
+        if(p > top.first && !queue.empty() && p > queue.front().first){
+            queue.push_back({p, u});
+            std::push_heap(queue.begin(), queue.end(), later);
+            continue;
+        }
+
+        shortcuts += contract(u, true);
+        rank[u] = order++;
+    }
+    METRICS_ADD(CH_SHORTCUTS, shortcuts);
+
+    // Packing the upward edges in rank order. The list left with each cell when it was contracted only holds cells
+    // contracted later.
+    cells.assign(n, 0);
+    for(int u = 0; u < n; u++) cells[rank[u]] = u;
+    first.assign(n + 1, 0);
+    edges.clear();
+    for(int r = 0; r < n; r++){
+        first[r] = (int)edges.size();
+        for(const CHEdge& e : adjacency[cells[r]]) edges.push_back({rank[e.to], e.weight, e.middle == -1 ? -1 : rank[e.middle]});
+    }
+    first[n] = (int)edges.size();
+    edges.shrink_to_fit();
+
+    std::vector<std::vector<CHEdge> >().swap(adjacency);
+    std::vector<int>().swap(deleted);
+    std::vector<int>().swap(witness_dist);
+    std::vector<int>().swap(touched);
+    std::vector<std::pair<int, int> >().swap(heap);
+    for(int d = 0; d < 2; d++) labels[d].assign(n, {0, 0, -1});
+    stamp = 0;
+    current = true;
+    build_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+    return;
+}
+
+// FUNCTION: Writes the hierarchy to a binary file: a header with the floor's size and fingerprint, followed by the ranks,
+// the offsets of each cell's upward edges, and the edges. Accepts parameter path, the file to write. Returns false if
+// the hierarchy is not current or the file could not be written.
+bool ContractionHierarchy::save(const std::string& path){
+    if(!current) return false;
+    std::ofstream out(path, std::ios::binary);
+    if(!out) return false;
+
+    int n = indexCount(rows, cols), m = (int)edges.size();
+    out.write(FILE_MAGIC, sizeof(FILE_MAGIC));
+    out.write((const char*)&FILE_VERSION, sizeof(FILE_VERSION));
+    out.write((const char*)&rows, sizeof(rows));
+    out.write((const char*)&cols, sizeof(cols));
+    out.write((const char*)&hash, sizeof(hash));
+    out.write((const char*)&shortcuts, sizeof(shortcuts));
+    out.write((const char*)&m, sizeof(m));
+    out.write((const char*)rank.data(), n * sizeof(int));
+    out.write((const char*)first.data(), (n + 1) * sizeof(int));
+    out.write((const char*)edges.data(), m * sizeof(CHEdge));
+    return (bool)out;
+}
+
+// FUNCTION: Reads a hierarchy written by save(...). The file is only used if it was built for a floor with the same
+// size and cell weights as units. Accepts parameters units, the Grid, and path, the file to read. Returns false, leaving
+// the hierarchy unchanged, if the file could not be read or does not match the floor.
+bool ContractionHierarchy::load(Grid& units, const std::string& path){
+    TRACE_SCOPE("contraction hierarchy load");
+    std::ifstream in(path, std::ios::binary);
+    if(!in) return false;
+
+    char magic[4];
+    int version, r, c, s, m;
+    unsigned long long h;
+    in.read(magic, sizeof(magic));
+    in.read((char*)&version, sizeof(version));
+    in.read((char*)&r, sizeof(r));
+    in.read((char*)&c, sizeof(c));
+    in.read((char*)&h, sizeof(h));
+    in.read((char*)&s, sizeof(s));
+    in.read((char*)&m, sizeof(m));
+    if(!in || !std::equal(magic, magic + 4, FILE_MAGIC) || version != FILE_VERSION) return false;
+    if(r != units.getRows() || c != units.getCols() || h != fingerprint(units) || m < 0) return false;
+
+    int n = indexCount(r, c);
+    std::vector<int> new_rank(n), new_first(n + 1);
+    std::vector<CHEdge> new_edges(m);
+    in.read((char*)new_rank.data(), n * sizeof(int));
+    in.read((char*)new_first.data(), (n + 1) * sizeof(int));
+    in.read((char*)new_edges.data(), m * sizeof(CHEdge));
+    if(!in || new_first[n] != m) return false;
+    for(int r : new_rank){
+        if(r < 0 || r >= n) return false;
+    }
+    for(const CHEdge& e : new_edges){
+        if(e.to < 0 || e.to >= n || e.middle < -1 || e.middle >= n) return false;
+    }
+
+    rows = r;
+    cols = c;
+    hash = h;
+    shortcuts = s;
+    rank.swap(new_rank);
+    first.swap(new_first);
+    edges.swap(new_edges);
+    cells.assign(n, 0);
+    for(int u = 0; u < n; u++) cells[rank[u]] = u;
+    for(int d = 0; d < 2; d++) labels[d].assign(n, {0, 0, -1});
+    stamp = 0;
+    build_ns = 0;
+    current = true;
+    return true;
+}
+
+// FUNCTION: Returns the upward edge stored with cell from that leads to cell to. Every edge the query or unpacking
+// follows is stored with its lower ranked cell, so the edge always exists.
+const CHEdge& ContractionHierarchy::find(int from, int to){
+    for(int k = first[from]; k < first[from + 1]; k++){
+        if(edges[k].to == to) return edges[k];
+    }
+    return edges[first[from]];
+}
+
+// FUNCTION: Appends the cells of the path an edge from a to b stands for, excluding a, to path. A shortcut stands for the
+// two edges through the cell it skips, which was contracted before both a and b, so both edges are stored with it.
+void ContractionHierarchy::unpack(int a, int b, int middle, std::vector<int>& path){
+    if(middle == -1){
+        path.push_back(b);
+        return;
+    }
+    unpack(a, middle, find(middle, a).middle, path);
+    unpack(middle, b, find(middle, b).middle, path);
+    return;
+}
+
+// FUNCTION: Finds a shortest path between two cells. A forward search from src and a backward search from dest each
+// follow only upward edges, taking turns by whichever has the closer cell queued, and the best path is the smallest sum
+// of the two distances to a cell reached by both. A search stops once its closest queued cell is no closer than the best
+// path. A cell is stalled, and not expanded, if a higher ranked neighbor already reached gives it a shorter distance, as
+// the shortest path cannot pass through it on the way up. The path is then unpacked from src up to the meeting cell and
+// down to dest. Accepts parameters src and dest. Returns the length of the path and its cells from src to dest.
+std::pair<int, std::vector<std::pair<int, int> > > ContractionHierarchy::route(std::pair<int, int> src, std::pair<int, int> dest){
+    TRACE_SCOPE("path search");
+    METRICS_TIME(OP_CH_ROUTE);
+    if(src == dest) return {0, {src}};
+
+    int ends[2] = {rank[coordToIndex(src, cols)], rank[coordToIndex(dest, cols)]};
+    if(++stamp == 0){
+        for(int d = 0; d < 2; d++) labels[d].assign(labels[d].size(), {0, 0, -1});
+        stamp = 1;
+    }
+    auto later = [](const std::pair<int, int>& a, const std::pair<int, int>& b){ return a.first > b.first; };
+    for(int d = 0; d < 2; d++){
+        open[d].clear();
+        labels[d][ends[d]] = {stamp, 0, -1};
+        open[d].push_back({0, ends[d]});
+    }
+
+    int best = INT_MAX, meet = -1;
+    while(true){
+        int d = open[1].empty() || (!open[0].empty() && open[0].front().first <= open[1].front().first) ? 0 : 1;
+        if(open[d].empty() || open[d].front().first >= best) break;
+        std::pair<int, int> top = open[d].front();
+        std::pop_heap(open[d].begin(), open[d].end(), later);
+        open[d].pop_back();
+        int u = top.second;
+        if(top.first != labels[d][u].dist) continue;
+        METRICS_COUNT(CH_NODES_SETTLED);
+
+        std::vector<CHLabel>& label = labels[d];
+        bool stalled = false;
+        for(int k = first[u]; k < first[u + 1] && !stalled; k++){
+            const CHLabel& l = label[edges[k].to];
+            stalled = l.seen == stamp && l.dist + edges[k].weight < top.first;
+        }
+        if(stalled) continue;
+        const CHLabel& other = labels[1 - d][u];
+        if(other.seen == stamp && top.first + other.dist < best){
+            best = top.first + other.dist;
+            meet = u;
+        }
+
+        for(int k = first[u]; k < first[u + 1]; k++){
+            CHLabel& l = label[edges[k].to];
+            int next = top.first + edges[k].weight;
+            if(l.seen == stamp && l.dist <= next) continue;
+            l = {stamp, next, u};
+            open[d].push_back({next, edges[k].to});
+            std::push_heap(open[d].begin(), open[d].end(), later);
+        }
+    }
+    if(meet == -1) return {INT_MAX, {}};
+
+    // Unpacking the path: upward from src to the meeting cell, then downward to dest.
+    std::vector<int> up;
+    for(int u = meet; u != -1; u = labels[0][u].parent) up.push_back(u);
+    std::reverse(up.begin(), up.end());
+    std::vector<int> ranks = {ends[0]};
+    for(size_t k = 0; k + 1 < up.size(); k++) unpack(up[k], up[k + 1], find(up[k], up[k + 1]).middle, ranks);
+    for(int u = meet; labels[1][u].parent != -1; u = labels[1][u].parent) unpack(u, labels[1][u].parent, find(labels[1][u].parent, u).middle, ranks);
+
+    std::vector<std::pair<int, int> > path;
+    path.reserve(ranks.size());
+    for(int r : ranks) path.push_back(indexToCoordinates(cells[r], cols));
+    return {best, path};
+}
+
+// FUNCTION: Runs Dijkstra's Algorithm from the cell of rank source over upward edges only, with the same stalling as
+// route(...), until no upward edge is left to follow. Uses the forward labels. Accepts parameters source and space, a
+// vector that is cleared and filled with the rank and distance of every cell settled without being stalled.
+void ContractionHierarchy::upward(int source, std::vector<std::pair<int, int> >& space){
+    space.clear();
+    if(++stamp == 0){
+        for(int d = 0; d < 2; d++) labels[d].assign(labels[d].size(), {0, 0, -1});
+        stamp = 1;
+    }
+    std::vector<CHLabel>& label = labels[0];
+    auto later = [](const std::pair<int, int>& a, const std::pair<int, int>& b){ return a.first > b.first; };
+    open[0].clear();
+    label[source] = {stamp, 0, -1};
+    open[0].push_back({0, source});
+    while(!open[0].empty()){
+        std::pair<int, int> top = open[0].front();
+        std::pop_heap(open[0].begin(), open[0].end(), later);
+        open[0].pop_back();
+        int u = top.second;
+        if(top.first != label[u].dist) continue;
+        METRICS_COUNT(CH_NODES_SETTLED);
+
+        bool stalled = false;
+        for(int k = first[u]; k < first[u + 1] && !stalled; k++){
+            const CHLabel& l = label[edges[k].to];
+            stalled = l.seen == stamp && l.dist + edges[k].weight < top.first;
+        }
+        if(stalled) continue;
+        space.push_back({u, top.first});
+
+        for(int k = first[u]; k < first[u + 1]; k++){
+            CHLabel& l = label[edges[k].to];
+            int next = top.first + edges[k].weight;
+            if(l.seen == stamp && l.dist <= next) continue;
+            l = {stamp, next, u};
+            open[0].push_back({next, edges[k].to});
+            std::push_heap(open[0].begin(), open[0].end(), later);
+        }
+    }
+    return;
+}
+
+// FUNCTION: Calculates the length of the shortest path between every pair of cells in points with one upward search
+// per cell instead of one query per pair. Each search leaves an entry, the point and its distance, in a bucket at every
+// cell it settles; a later search that settles a cell combines its own distance with every entry already in that
+// cell's bucket. The shortest path between two points peaks at a cell both searches settle, so the smallest sum is
+// their distance. Accepts parameters points and matrix, which is filled with points.size() rows of points.size()
+// distances.
+void ContractionHierarchy::distances(const std::vector<std::pair<int, int> >& points, std::vector<int>& matrix){
+    TRACE_SCOPE("distance matrix");
+    int k = (int)points.size();
+    matrix.assign(k * k, INT_MAX);
+    std::unordered_map<int, std::vector<std::pair<int, int> > > buckets;
+    std::vector<std::pair<int, int> > space;
+    for(int i = 0; i < k; i++){
+        matrix[i * k + i] = 0;
+        upward(rank[coordToIndex(points[i], cols)], space);
+        for(std::pair<int, int>& s : space){
+            std::vector<std::pair<int, int> >& bucket = buckets[s.first];
+            for(std::pair<int, int>& entry : bucket){
+                int d = s.second + entry.second;
+                if(d < matrix[i * k + entry.first]){
+                    matrix[i * k + entry.first] = d;
+                    matrix[entry.first * k + i] = d;
+                }
+            }
+            bucket.push_back({i, s.second});
+        }
+    }
+    return;
+}
+
+// FUNCTION: Returns the estimated heap memory owned by the hierarchy: the ranks, the upward edges and their offsets, and
+// the query buffers.
+MemoryUsage ContractionHierarchy::memoryUsage(){
+    MemoryUsage m;
+    m += estimateVector(rank);
+    m += estimateVector(cells);
+    m += estimateVector(first);
+    m += estimateVector(edges);
+    for(int d = 0; d < 2; d++){
+        m += estimateVector(labels[d]);
+        m += estimateVector(open[d]);
+    }
+    return m;
+}
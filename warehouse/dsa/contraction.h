@@ -0,0 +1,144 @@
+//
+// CSC 212 - Data Structures and Abstractions
+// Dominic Tucchio, Jennipher Day, Maya Geva, Thomas Williams
+// Spring 2024 Term Project - contraction.h
+//
+
+#ifndef ContractionHierarchy_H
+#define ContractionHierarchy_H
+
+#include "algorithms.h"
+
+#include <string>
+
+//
+// STRUCTURE: CHEdge
+// An edge of the ContractionHierarchy. It is stored with the lower ranked of its two cells and leads to the higher
+// ranked one. Cells are referred to by rank. A shortcut replaces the two edges through a contracted cell and remembers that cell, so the cells it skips
+// can be recovered.
+//
+
+struct CHEdge {
+    // TO: The rank of the higher ranked cell.
+    int to;
+    // WEIGHT: The length of the edge, or of the path it replaces.
+    int weight;
+    // MIDDLE: The cell a shortcut skips over, or -1 for an edge between two neighboring cells.
+    int middle;
+};
+
+//
+// STRUCTURE: CHLabel
+// The state of a cell in one direction of a query, kept together so a query touches one place in memory per cell.
+//
+
+struct CHLabel {
+    // SEEN: The stamp of the last query that reached the cell. The other fields are only valid if it is current.
+    unsigned int seen;
+    // DIST, PARENT: The distance to the cell and the cell it was reached from, or -1 for the starting cell.
+    int dist, parent;
+};
+
+//
+// CLASS: ContractionHierarchy
+// A preprocessed form of the Warehouse graph for exact shortest path queries. Every cell of the floor is contracted in
+// turn, least important first: it is removed from the graph, and a shortcut is added between two of its neighbors
+// whenever the path through it was the only shortest path between them. The order in which cells were contracted is
+// their rank. Every shortest path then has a form that only climbs in rank up to a peak and then only descends, so a
+// query is two small Dijkstra searches that only follow edges to higher ranked cells, one from each end, meeting at the
+// peak. Shortcuts on the path found are unpacked into the cells they skip. Distances are exactly those of
+// Algorithms::dijkstra(...), as edge weights match the graph built by Algorithms::buildGraph(...). Any change to the
+// StorageUnits requires preprocessing again.
+//
+
+class ContractionHierarchy {
+    public:
+        // CONSTRUCTORS
+        ContractionHierarchy();
+
+        // FUNCTIONS
+
+        // BUILD: Preprocesses the floor, replacing any previous hierarchy.
+        void build(Grid& units);
+        // INVALIDATE: Marks the hierarchy as out of date after a StorageUnit changed.
+        void invalidate() { current = false; }
+        // ISCURRENT: Returns true if the hierarchy was built for the floor as it is now.
+        bool isCurrent(Grid& units) { return current && rows == units.getRows() && cols == units.getCols(); }
+        // SAVE: Writes the hierarchy to a binary file. Returns false if the file could not be written.
+        bool save(const std::string& path);
+        // LOAD: Reads a hierarchy written by save(...). Returns false if the file could not be read or was built for a
+        // different floor.
+        bool load(Grid& units, const std::string& path);
+        // ROUTE: Finds a shortest path between two cells. Returns its length and the cells along it, like
+        // Algorithms::dijkstra(...). The hierarchy must be current.
+        std::pair<int, std::vector<std::pair<int, int> > > route(std::pair<int, int> src, std::pair<int, int> dest);
+        // DISTANCES: Fills matrix with the length of the shortest path between every pair of cells in points, row by row.
+        // The hierarchy must be current.
+        void distances(const std::vector<std::pair<int, int> >& points, std::vector<int>& matrix);
+
+        // GETBUILDTIME: Returns the time the last build(...) took in nanoseconds, or 0 if the hierarchy was loaded.
+        long long getBuildTime() { return build_ns; }
+        // GETSHORTCUTS: Returns the number of shortcuts added by preprocessing.
+        int getShortcuts() { return shortcuts; }
+        // MEMORYUSAGE: Returns the estimated heap memory owned by the hierarchy.
+        MemoryUsage memoryUsage();
+
+    private:
+        // FUNCTIONS
+
+        // WITNESS: Searches for paths from a cell that avoid the cell being contracted, up to a distance limit.
+        void witness(int source, int skip, int limit, int settle_limit);
+        // CONTRACT: Counts the shortcuts contracting a cell needs. Adds them and removes the cell if add is true.
+        int contract(int node, bool add);
+        // PRIORITY: Returns how early a cell should be contracted. Smaller is earlier.
+        int priority(int node);
+        // CONNECT: Adds an edge between two uncontracted cells, or shortens the edge already between them.
+        void connect(int a, int b, int weight, int middle);
+        // UPWARD: Runs a search from a cell that only follows upward edges until none are left, and lists the cells
+        // reached that were not stalled along with their distances.
+        void upward(int source, std::vector<std::pair<int, int> >& space);
+        // FIND: Returns the edge stored with a cell that leads to another cell, both given by rank.
+        const CHEdge& find(int from, int to);
+        // UNPACK: Appends the ranks of the cells of an edge from a to b, excluding a, to path.
+        void unpack(int a, int b, int middle, std::vector<int>& path);
+        // FINGERPRINT: Returns a hash of the floor's size and cell weights, used to match saved hierarchies to a floor.
+        unsigned long long fingerprint(Grid& units);
+
+        // MEMBER VARIABLES
+
+        // ROWS, COLS: The extent of the floor the hierarchy was built for, or 0 if it has not been built.
+        int rows = 0;
+        int cols = 0;
+        // CURRENT: False if a StorageUnit changed since the hierarchy was built.
+        bool current = false;
+        // HASH: The fingerprint of the floor the hierarchy was built for.
+        unsigned long long hash = 0;
+        // BUILD_NS, SHORTCUTS: Statistics of the last build.
+        long long build_ns = 0;
+        int shortcuts = 0;
+
+        // RANK, CELLS: The position of each cell, by graph index, in the contraction order, and the graph index of the cell
+        // at each rank. Once preprocessing is done cells are stored in rank order, so the few highest ranked cells that
+        // most queries reach sit together in memory.
+        std::vector<int> rank, cells;
+        // FIRST, EDGES: The upward edges of the cell of rank r are edges[first[r]] to edges[first[r + 1] - 1].
+        std::vector<int> first;
+        std::vector<CHEdge> edges;
+
+        // ADJACENCY, DELETED: The remaining graph during preprocessing and the number of contracted neighbors of each
+        // cell. Cleared once preprocessing is done.
+        std::vector<std::vector<CHEdge> > adjacency;
+        std::vector<int> deleted;
+        // WITNESS_DIST, TOUCHED, HEAP: Buffers for the witness searches.
+        std::vector<int> witness_dist, touched;
+        std::vector<std::pair<int, int> > heap;
+
+        // LABELS, STAMP: The labels of the forward (0) and backward (1) query searches, indexed by rank, and the current
+        // query's stamp.
+        std::vector<CHLabel> labels[2];
+        unsigned int stamp = 0;
+        // OPEN: The priority queues of the query searches.
+        std::vector<std::pair<int, int> > open[2];
+};
+
+#endif
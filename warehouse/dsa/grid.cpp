@@ -0,0 +1,296 @@
+//
+// CSC 212 - Data Structures and Abstractions
+// Dominic Tucchio, Jennipher Day, Maya Geva, Thomas Williams
+// Spring 2024 Term Project - grid.cpp
+//
+
+#include "grid.h"
+#include "../parallel.h"
+
+#include <algorithm>
+#include <atomic>
+
+//
+// CLASS: Grid
+// Sparse storage for the StorageUnits of a Warehouse. The floor is divided into GridChunks that are allocated on
+// demand and found through a hash of their chunk coordinates, so memory is proportional to the occupied area rather
+// than to the largest coordinate. The floor is a square whose side is one more than the largest coordinate of any
+// StorageUnit (at least 1x1), as it was when StorageUnits were kept in a 2D vector; cells inside that square without a
+// StorageUnit are open floor space and take no memory. Copies of a Grid share their chunks until
+// they change them.
+//
+
+// CONSTRUCTOR: Creates an empty 1x1 floor. No chunks are allocated until the first StorageUnit is placed.
+Grid::Grid() : directory(std::make_shared<GridDirectory>()) {
+
+}
+
+// FUNCTION: Returns the chunk with the given chunk coordinates, or nullptr if it has not been allocated.
+const GridChunk* Grid::chunk(int cx, int cy){
+    std::unordered_map<long long, std::shared_ptr<GridChunk> >::const_iterator it = directory->chunks.find(key(cx, cy));
+    return it == directory->chunks.end() ? nullptr : it->second.get();
+}
+
+// FUNCTION: Returns the chunk containing a location, or nullptr if the location is negative or its chunk has not been
+// allocated. Sets cell to the index of the location within the chunk's arrays.
+const GridChunk* Grid::chunk(std::pair<int, int> loc, int& cell){
+    if(loc.first < 0 || loc.second < 0) return nullptr;
+    cell = (loc.first & (GridChunk::SIZE - 1)) * GridChunk::SIZE + (loc.second & (GridChunk::SIZE - 1));
+    return chunk(loc.first >> GridChunk::BITS, loc.second >> GridChunk::BITS);
+}
+
+// FUNCTION: Returns the chunk containing a location so it can be changed, or nullptr if the location is negative or its
+// chunk has not been allocated. If the directory or the chunk is shared with a copy of the Grid, this Grid is given its
+// own copy of it first: a copy of the directory holds one pointer per chunk, and a copy of the chunk shares its Item
+// maps. Sets cell to the index of the location within the chunk's arrays.
+GridChunk* Grid::edit(std::pair<int, int> loc, int& cell){
+    if(chunk(loc, cell) == nullptr) return nullptr;
+    return &own(own(directory).chunks[key(loc.first >> GridChunk::BITS, loc.second >> GridChunk::BITS)]);
+}
+
+// FUNCTION: Places a StorageUnit at its location, allocating the chunk that contains it if needed and growing the
+// square floor to include it. Any StorageUnit already at the location is replaced. The StorageUnit's capacity and used capacity
+// are written to the chunk's arrays and its Items, if it has any, are copied to the side. Coordinates must not be
+// negative.
+void Grid::set(const StorageUnit& unit){
+    std::pair<int, int> loc = unit.getLocation();
+    int cx = loc.first >> GridChunk::BITS, cy = loc.second >> GridChunk::BITS;
+    int x = loc.first & (GridChunk::SIZE - 1), y = loc.second & (GridChunk::SIZE - 1);
+    int cell = x * GridChunk::SIZE + y;
+
+    GridChunk* c = edit(loc, cell);
+    if(c == nullptr){
+        GridDirectory& d = own(directory);
+        d.chunks[key(cx, cy)] = std::make_shared<GridChunk>();
+        c = d.chunks[key(cx, cy)].get();
+        // Keep the chunk YCoords of each chunk row sorted for row-major traversal.
+        std::vector<int>& row = d.chunk_rows[cx];
+        row.insert(std::upper_bound(row.begin(), row.end(), cy), cy);
+    }
+
+    if(!(c->occupied[x] & (1 << y))){
+        c->occupied[x] |= (1 << y);
+        c->count++;
+        count++;
+    }
+    c->capacity[cell] = unit.getCapacity();
+    c->used[cell] = unit.getUsedCapacity();
+
+    std::map<std::string, Item> unit_items = unit.getItems();
+    if(unit_items.empty()) c->items[cell].reset();
+    else c->items[cell] = std::make_shared<std::map<std::string, Item> >(std::move(unit_items));
+
+    rows = std::max(rows, std::max(loc.first, loc.second) + 1);
+    cols = rows;
+    return;
+}
+
+// FUNCTION: Adds an Item to the StorageUnit at a location following the same rules as StorageUnit::add(...). The cell's
+// map of Items is allocated on the first call, and copied first if it is shared with a copy of the Grid. Returns false
+// if the cell is empty or the Item does not fit.
+bool Grid::add(std::pair<int, int> loc, const Item& i){
+    int cell;
+    const GridChunk* found = chunk(loc, cell);
+    if(found == nullptr || !(found->occupied[cell / GridChunk::SIZE] & (1 << (cell % GridChunk::SIZE)))) return false;
+
+    GridChunk* c = edit(loc, cell);
+    if(!c->items[cell]) c->items[cell] = std::make_shared<std::map<std::string, Item> >();
+    return StorageUnit::add(own(c->items[cell]), c->used[cell], c->capacity[cell], i);
+}
+
+// FUNCTION: Removes up to a quantity of the Item with the given name from the StorageUnit at a location, freeing the
+// space it used. The Item is erased once none of it is left. Returns the quantity removed, which is 0 if the cell is
+// empty or does not hold the Item.
+int Grid::remove(std::pair<int, int> loc, const std::string& name, int quantity){
+    int cell;
+    const GridChunk* found = chunk(loc, cell);
+    if(found == nullptr || !found->items[cell] || found->items[cell]->count(name) == 0) return 0;
+
+    GridChunk* c = edit(loc, cell);
+    return StorageUnit::remove(own(c->items[cell]), c->used[cell], name, quantity);
+}
+
+// FUNCTION: Returns a copy of the StorageUnit at a location, including its Items. Empty cells and locations outside of
+// the floor return a StorageUnit with a capacity of 0.
+StorageUnit Grid::unit(std::pair<int, int> loc){
+    int cell;
+    const GridChunk* c = chunk(loc, cell);
+    if(c == nullptr || !(c->occupied[cell / GridChunk::SIZE] & (1 << (cell % GridChunk::SIZE)))) return StorageUnit(0, loc);
+    if(!c->items[cell]) return StorageUnit(c->capacity[cell], loc, std::map<std::string, Item>(), c->used[cell]);
+    return StorageUnit(c->capacity[cell], loc, *c->items[cell], c->used[cell]);
+}
+
+// FUNCTION: Returns the map of Items stored at a location, or nullptr if the cell is empty or has never stored an Item.
+const std::map<std::string, Item>* Grid::items(std::pair<int, int> loc){
+    int cell;
+    const GridChunk* c = chunk(loc, cell);
+    return c == nullptr ? nullptr : c->items[cell].get();
+}
+
+// FUNCTION: Returns true if a StorageUnit occupies the given cell.
+bool Grid::occupied(std::pair<int, int> loc){
+    int cell;
+    const GridChunk* c = chunk(loc, cell);
+    return c != nullptr && (c->occupied[cell / GridChunk::SIZE] & (1 << (cell % GridChunk::SIZE)));
+}
+
+// FUNCTION: Returns the capacity of the StorageUnit at the given location. Empty cells have a capacity of 0.
+int Grid::capacityAt(std::pair<int, int> loc){
+    int cell;
+    const GridChunk* c = chunk(loc, cell);
+    return c == nullptr ? 0 : c->capacity[cell];
+}
+
+// FUNCTION: Returns the used capacity of the StorageUnit at the given location. Empty cells have a used capacity of 0.
+int Grid::usedAt(std::pair<int, int> loc){
+    int cell;
+    const GridChunk* c = chunk(loc, cell);
+    return c == nullptr ? 0 : c->used[cell];
+}
+
+// FUNCTION: Returns the first empty cell of the floor in row-major order, or (-1,-1) if every cell is
+// occupied. The first chunk row is searched on the calling thread, as the first empty cell is usually there. The rest of
+// a large floor is split into bands of chunk rows searched in parallel; a band after one where an empty cell was found
+// is skipped, and the empty cell of the earliest band is returned, so the result is the same as a search row by row.
+std::pair<int, int> Grid::firstEmpty(){
+    std::pair<int, int> found = firstEmpty(0, std::min(rows, GridChunk::SIZE));
+    if(found.first != -1 || rows <= GridChunk::SIZE) return found;
+
+    int bands = (rows - 1) / GridChunk::SIZE;
+    std::vector<std::pair<int, int> > band_found(bands, {-1, -1});
+    std::atomic<int> earliest(bands);
+    parallelRows(rows - GridChunk::SIZE, cols, GridChunk::SIZE, [&](int band, int first, int last){
+        if(band > earliest.load(std::memory_order_relaxed)) return;
+        band_found[band] = firstEmpty(first + GridChunk::SIZE, last + GridChunk::SIZE);
+        if(band_found[band].first == -1) return;
+        int current = earliest.load(std::memory_order_relaxed);
+        while(band < current && !earliest.compare_exchange_weak(current, band, std::memory_order_relaxed));
+    });
+    return earliest.load() < bands ? band_found[earliest.load()] : std::make_pair(-1, -1);
+}
+
+// FUNCTION: Returns the first empty cell in rows first to last - 1 in row-major order, or (-1,-1) if every cell of those
+// rows is occupied. Each row is scanned one chunk-width at a time: a missing chunk is entirely empty and an allocated
+// chunk is checked with its row bitmap, so full chunks are skipped without touching their cells.
+std::pair<int, int> Grid::firstEmpty(int first, int last){
+    for(int x = first; x < last; x++){
+        int cx = x >> GridChunk::BITS, lx = x & (GridChunk::SIZE - 1);
+        for(int y0 = 0; y0 < cols; y0 += GridChunk::SIZE){
+            const GridChunk* c = chunk(cx, y0 >> GridChunk::BITS);
+            if(c == nullptr) return {x, y0};
+
+            unsigned int free_bits = ~(unsigned int)c->occupied[lx] & 0xFFFF;
+            if(free_bits != 0){
+                int y = y0 + __builtin_ctz(free_bits);
+                if(y < cols) return {x, y};
+            }
+        }
+    }
+    return {-1, -1};
+}
+
+// FUNCTION: Returns the location of the first StorageUnit in row-major order with at least k free capacity, or (-1,-1)
+// if there is none. Each chunk row is tested 16 cells at a time with freeMask(...).
+std::pair<int, int> Grid::firstFree(int k){
+    std::pair<int, int> found = {-1, -1};
+    scan([k](const GridChunk& c, int x){ return freeMask(c, x, k); }, [&](const GridCell& cell){ found = cell.loc; return true; });
+    return found;
+}
+
+// FUNCTION: Fills capacity and used with the capacity and used capacity of every cell in row x, resizing both to the
+// width of the floor. Values are copied a chunk-width at a time; open floor cells are 0.
+void Grid::row(int x, std::vector<int>& capacity, std::vector<int>& used){
+    capacity.assign(cols, 0);
+    used.assign(cols, 0);
+    int cx = x >> GridChunk::BITS, lx = x & (GridChunk::SIZE - 1);
+    for(int y0 = 0; y0 < cols; y0 += GridChunk::SIZE){
+        const GridChunk* c = chunk(cx, y0 >> GridChunk::BITS);
+        if(c == nullptr) continue;
+        int n = std::min(GridChunk::SIZE, cols - y0);
+        std::copy(c->capacity + lx * GridChunk::SIZE, c->capacity + lx * GridChunk::SIZE + n, capacity.begin() + y0);
+        std::copy(c->used + lx * GridChunk::SIZE, c->used + lx * GridChunk::SIZE + n, used.begin() + y0);
+    }
+}
+
+// FUNCTION: Copies the capacities of the rows x cols rectangle of cells starting at origin into out, row by row. Each
+// row of the rectangle is copied a chunk-width at a time, so only one chunk lookup is made per chunk row it overlaps;
+// open floor cells are 0. Coordinates must not be negative.
+void Grid::block(std::pair<int, int> origin, int rows, int cols, int* out){
+    for(int x = 0; x < rows; x++){
+        int cx = (origin.first + x) >> GridChunk::BITS, lx = (origin.first + x) & (GridChunk::SIZE - 1);
+        for(int y = 0; y < cols;){
+            int ly = (origin.second + y) & (GridChunk::SIZE - 1);
+            int n = std::min(GridChunk::SIZE - ly, cols - y);
+            const GridChunk* c = chunk(cx, (origin.second + y) >> GridChunk::BITS);
+            int* dest = out + x * cols + y;
+            if(c == nullptr) std::fill(dest, dest + n, 0);
+            else std::copy(c->capacity + lx * GridChunk::SIZE + ly, c->capacity + lx * GridChunk::SIZE + ly + n, dest);
+            y += n;
+        }
+    }
+}
+
+// FUNCTION: Returns the sum of the GridChunk::CELLS values of a chunk array. Values are added in 32-bit vector lanes, so
+// a chunk's total must fit in an int, as the Warehouse's own counters already require.
+long long Grid::sum(const int* values){
+#if defined(__AVX2__)
+    __m256i total = _mm256_setzero_si256();
+    for(int i = 0; i < GridChunk::CELLS; i += 8) total = _mm256_add_epi32(total, _mm256_load_si256((const __m256i*)(values + i)));
+    alignas(32) int lanes[8];
+    _mm256_store_si256((__m256i*)lanes, total);
+    return (long long)lanes[0] + lanes[1] + lanes[2] + lanes[3] + lanes[4] + lanes[5] + lanes[6] + lanes[7];
+#elif defined(__SSE2__)
+    __m128i total = _mm_setzero_si128();
+    for(int i = 0; i < GridChunk::CELLS; i += 4) total = _mm_add_epi32(total, _mm_load_si128((const __m128i*)(values + i)));
+    alignas(16) int lanes[4];
+    _mm_store_si128((__m128i*)lanes, total);
+    return (long long)lanes[0] + lanes[1] + lanes[2] + lanes[3];
+#else
+    long long total = 0;
+    for(int i = 0; i < GridChunk::CELLS; i++) total += values[i];
+    return total;
+#endif
+}
+
+// FUNCTION: Returns the total capacity of every StorageUnit. Empty cells hold 0, so whole chunk arrays are summed.
+long long Grid::totalCapacity(){
+    long long total = 0;
+    for(const std::pair<const long long, std::shared_ptr<GridChunk> >& c : directory->chunks) total += sum(c.second->capacity);
+    return total;
+}
+
+// FUNCTION: Returns the total used capacity of every StorageUnit. Empty cells hold 0, so whole chunk arrays are summed.
+long long Grid::totalUsed(){
+    long long total = 0;
+    for(const std::pair<const long long, std::shared_ptr<GridChunk> >& c : directory->chunks) total += sum(c.second->used);
+    return total;
+}
+
+// FUNCTION: Returns the estimated heap memory owned by the grid: the chunks, the hash table that indexes them, and the
+// sorted chunk rows. The cells' maps of Items are reported separately by itemMemoryUsage(). Chunks shared with copies of
+// the Grid are counted in full.
+MemoryUsage Grid::memoryUsage(){
+    const GridDirectory& d = *directory;
+    MemoryUsage m = estimateShared<GridDirectory>(1);
+    m += estimateShared<GridChunk>(d.chunks.size());
+
+    // Hash table: one node per chunk plus the bucket array.
+    m.bytes += d.chunks.size() * (sizeof(void*) + sizeof(std::pair<const long long, std::shared_ptr<GridChunk> >)) + d.chunks.bucket_count() * sizeof(void*);
+    m.allocations += d.chunks.size() + 1;
+
+    m += estimateMap(d.chunk_rows);
+    for(const std::pair<const int, std::vector<int> >& row : d.chunk_rows) m += estimateVector(row.second);
+    return m;
+}
+
+// FUNCTION: Returns the estimated heap memory owned by the cells' maps of Items, including the maps themselves, which are
+// allocated separately from their chunks.
+MemoryUsage Grid::itemMemoryUsage(){
+    MemoryUsage m;
+    forEach([&](const GridCell& cell){
+        if(cell.items == nullptr) return;
+        m += estimateShared<std::map<std::string, Item> >(1);
+        m += StorageUnit::memoryUsage(*cell.items);
+    });
+    return m;
+}
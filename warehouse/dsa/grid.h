@@ -0,0 +1,260 @@
+//
+// CSC 212 - Data Structures and Abstractions
+// Dominic Tucchio, Jennipher Day, Maya Geva, Thomas Williams
+// Spring 2024 Term Project - grid.h
+//
+
+#ifndef Grid_H
+#define Grid_H
+
+#include "../container.h"
+#include "persistent.h"
+
+#include <climits>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <unordered_map>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+//
+// STRUCTURE: GridChunk
+// A fixed-size square block of grid cells stored as a structure of arrays. The capacity and used capacity of every cell
+// are kept in contiguous arrays so scans over free space read only those values, and each row of the chunk has a bitmap
+// marking which of its cells hold a StorageUnit. Item maps are kept on the side and only allocated once an Item is stored
+// in the cell. Chunks are only allocated once a StorageUnit is placed inside them. Chunks and Item maps may be shared by
+// copies of a Grid and are only changed once the Grid owns them.
+//
+
+struct GridChunk {
+    static constexpr int BITS = 4;
+    static constexpr int SIZE = 1 << BITS;
+    static constexpr int CELLS = SIZE * SIZE;
+
+    // CAPACITY: The max capacity of each cell, stored row by row. Empty cells have a capacity of 0.
+    alignas(32) int capacity[CELLS] = {};
+    // USED: The capacity in use in each cell, stored row by row. Empty cells have a used capacity of 0.
+    alignas(32) int used[CELLS] = {};
+    // OCCUPIED: One bitmap per chunk row. Bit y of occupied[x] is set if cell (x, y) of the chunk holds a StorageUnit.
+    uint16_t occupied[SIZE] = {};
+    // COUNT: The number of occupied cells in the chunk.
+    int count = 0;
+    // ITEMS: The map of Items of each cell, or nullptr if no Item has been stored in the cell.
+    std::shared_ptr<std::map<std::string, Item> > items[CELLS];
+};
+
+//
+// STRUCTURE: GridDirectory
+// The chunks of a Grid: every allocated chunk keyed by its chunk coordinates, and the sorted chunk YCoords allocated in
+// each chunk row, used to visit cells in row-major order.
+//
+
+struct GridDirectory {
+    std::unordered_map<long long, std::shared_ptr<GridChunk> > chunks;
+    std::map<int, std::vector<int> > chunk_rows;
+};
+
+//
+// STRUCTURE: GridCell
+// A read-only view of an occupied cell passed to the Grid's traversal functions.
+//
+
+struct GridCell {
+    std::pair<int, int> loc;
+    int capacity;
+    int used;
+    // ITEMS: The cell's map of Items, or nullptr if no Item has been stored in the cell.
+    const std::map<std::string, Item>* items;
+};
+
+//
+// CLASS: Grid
+// Sparse storage for the StorageUnits of a Warehouse. The floor is divided into GridChunks that are allocated on
+// demand and found through a hash of their chunk coordinates, so memory is proportional to the occupied area rather
+// than to the largest coordinate. The floor is a square whose side is one more than the largest coordinate of any
+// StorageUnit (at least 1x1), as it was when StorageUnits were kept in a 2D vector; cells inside that square without a
+// StorageUnit are open floor space and take no memory. Copying a Grid is O(1): the copies share the
+// directory and every chunk, and a copy only copies the directory and a chunk when it first changes a cell in it, so
+// its own memory is proportional to the chunks it changed.
+//
+
+class Grid {
+    public:
+        // CONSTRUCTORS
+        Grid();
+
+        // FUNCTIONS
+
+        // FUNCTION: Places a StorageUnit at its location, replacing any StorageUnit already there.
+        void set(const StorageUnit& unit);
+        // FUNCTION: Adds an Item to the StorageUnit at a location. Returns false if the Item could not be stored.
+        bool add(std::pair<int, int> loc, const Item& i);
+        // FUNCTION: Removes up to a quantity of an Item from the StorageUnit at a location. Returns the quantity removed.
+        int remove(std::pair<int, int> loc, const std::string& name, int quantity);
+        // FUNCTION: Returns a copy of the StorageUnit at a location, or a StorageUnit with a capacity of 0 if the cell is empty.
+        StorageUnit unit(std::pair<int, int> loc);
+        // FUNCTION: Returns the map of Items stored at a location, or nullptr if there are none.
+        const std::map<std::string, Item>* items(std::pair<int, int> loc);
+
+        // FUNCTION: Returns true if a StorageUnit occupies the given cell.
+        bool occupied(std::pair<int, int> loc);
+        // FUNCTION: Returns the capacity of the StorageUnit at a location, or 0 if the cell is empty.
+        int capacityAt(std::pair<int, int> loc);
+        // FUNCTION: Returns the used capacity of the StorageUnit at a location, or 0 if the cell is empty.
+        int usedAt(std::pair<int, int> loc);
+        // FUNCTION: Returns true if a location is inside the floor.
+        bool inBounds(std::pair<int, int> loc) { return loc.first >= 0 && loc.first < rows && loc.second >= 0 && loc.second < cols; }
+        // FUNCTION: Returns the first empty cell of the floor in row-major order, or (-1,-1) if every cell is occupied.
+        std::pair<int, int> firstEmpty();
+        // FUNCTION: Returns the first StorageUnit in row-major order with at least k free capacity, or (-1,-1).
+        std::pair<int, int> firstFree(int k);
+        // FUNCTION: Fills capacity and used with the values of every cell in row x of the floor.
+        void row(int x, std::vector<int>& capacity, std::vector<int>& used);
+        // FUNCTION: Copies the capacities of a rectangle of cells into out, row by row.
+        void block(std::pair<int, int> origin, int rows, int cols, int* out);
+
+        // FUNCTION: Returns the total capacity of every StorageUnit.
+        long long totalCapacity();
+        // FUNCTION: Returns the total used capacity of every StorageUnit.
+        long long totalUsed();
+
+        // FUNCTION: Returns the number of rows (XCoord extent) of the floor.
+        int getRows() { return rows; }
+        // FUNCTION: Returns the number of columns (YCoord extent) of the floor.
+        int getCols() { return cols; }
+        // FUNCTION: Returns the number of occupied cells.
+        int size() { return count; }
+
+        // FUNCTION: Calls f(const GridCell&) for every occupied cell in row-major order.
+        template<typename F>
+        void forEach(F f);
+        // FUNCTION: Calls f(const GridCell&) for every occupied cell in rows first to last - 1, in row-major order. first
+        // and last must be multiples of GridChunk::SIZE, except that last may be the floor's number of rows.
+        template<typename F>
+        void forEachInRows(int first, int last, F f);
+        // FUNCTION: Calls f(const GridCell&) for every StorageUnit with at least k free capacity in row-major order.
+        template<typename F>
+        void forEachFree(int k, F f);
+
+        // FUNCTION: Returns the estimated heap memory owned by the grid, excluding the Item maps.
+        MemoryUsage memoryUsage();
+        // FUNCTION: Returns the estimated heap memory owned by the Item maps of every cell.
+        MemoryUsage itemMemoryUsage();
+
+    private:
+        // FUNCTION: Returns the chunk with the given chunk coordinates, or nullptr if it has not been allocated.
+        const GridChunk* chunk(int cx, int cy);
+        // FUNCTION: Returns the chunk containing a location and sets cell to the location's index within it.
+        const GridChunk* chunk(std::pair<int, int> loc, int& cell);
+        // FUNCTION: Returns the chunk containing a location so it can be changed, and sets cell to the location's index
+        // within it. Returns nullptr if the chunk has not been allocated.
+        GridChunk* edit(std::pair<int, int> loc, int& cell);
+        // FUNCTION: Returns the hash key of a chunk.
+        static long long key(int cx, int cy) { return ((long long)cx << 32) | (unsigned int)cy; }
+
+        // FUNCTION: Returns a bitmap of the occupied cells in row x of a chunk with at least k free capacity.
+        static unsigned int freeMask(const GridChunk& c, int x, int k);
+        // FUNCTION: Returns the sum of an array of GridChunk::CELLS values.
+        static long long sum(const int* values);
+
+        // FUNCTION: Returns the first empty cell in rows first to last - 1 in row-major order, or (-1,-1).
+        std::pair<int, int> firstEmpty(int first, int last);
+        // FUNCTION: Visits the cells selected by mask(chunk, x) in the chunk rows first to last - 1 in row-major order
+        // until f returns true.
+        template<typename M, typename F>
+        bool scan(M mask, F f, int first = 0, int last = INT_MAX);
+
+        // MEMBER VARIABLES
+
+        // DIRECTORY: The allocated chunks, shared with copies of the Grid until one of them adds a chunk or changes a cell.
+        std::shared_ptr<GridDirectory> directory;
+
+        // ROWS, COLS: The extent of the floor. The floor is square, so they are always equal.
+        int rows = 1;
+        int cols = 1;
+        // COUNT: The number of occupied cells.
+        int count = 0;
+};
+
+// FUNCTION: Returns a bitmap with bit y set if cell (x, y) of the chunk is occupied and has at least k free capacity.
+// The free capacity of the row's 16 cells is compared against k with two AVX2 or four SSE2 instructions when the
+// compiler targets them, and one cell at a time otherwise.
+inline unsigned int Grid::freeMask(const GridChunk& c, int x, int k){
+    const int* capacity = c.capacity + x * GridChunk::SIZE;
+    const int* used = c.used + x * GridChunk::SIZE;
+    unsigned int mask = 0;
+#if defined(__AVX2__)
+    __m256i min = _mm256_set1_epi32(k - 1);
+    for(int i = 0; i < GridChunk::SIZE; i += 8){
+        __m256i free = _mm256_sub_epi32(_mm256_load_si256((const __m256i*)(capacity + i)), _mm256_load_si256((const __m256i*)(used + i)));
+        mask |= (unsigned int)_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(free, min))) << i;
+    }
+#elif defined(__SSE2__)
+    __m128i min = _mm_set1_epi32(k - 1);
+    for(int i = 0; i < GridChunk::SIZE; i += 4){
+        __m128i free = _mm_sub_epi32(_mm_load_si128((const __m128i*)(capacity + i)), _mm_load_si128((const __m128i*)(used + i)));
+        mask |= (unsigned int)_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpgt_epi32(free, min))) << i;
+    }
+#else
+    for(int i = 0; i < GridChunk::SIZE; i++){
+        if(capacity[i] - used[i] >= k) mask |= 1u << i;
+    }
+#endif
+    return mask & c.occupied[x];
+}
+
+// FUNCTION: Visits cells in row-major order. Only allocated chunks are visited, and within a chunk only the bits set in
+// mask(chunk, x) for each row x, so the cost is proportional to the occupied area of the floor. Only the chunk rows
+// first to last - 1 are visited. Stops early and returns true as soon as f returns true.
+template<typename M, typename F>
+bool Grid::scan(M mask, F f, int first, int last){
+    std::vector<std::pair<int, const GridChunk*> > row_chunks;
+    for(std::map<int, std::vector<int> >::const_iterator it = directory->chunk_rows.lower_bound(first); it != directory->chunk_rows.end() && it->first < last; ++it){
+        const std::pair<const int, std::vector<int> >& row = *it;
+        row_chunks.clear();
+        for(int cy : row.second) row_chunks.push_back({cy, chunk(row.first, cy)});
+
+        for(int x = 0; x < GridChunk::SIZE; x++){
+            for(std::pair<int, const GridChunk*>& rc : row_chunks){
+                const GridChunk& c = *rc.second;
+                unsigned int bits = mask(c, x);
+                while(bits != 0){
+                    int y = __builtin_ctz(bits);
+                    bits &= bits - 1;
+                    int cell = x * GridChunk::SIZE + y;
+                    GridCell view = {{(row.first << GridChunk::BITS) + x, (rc.first << GridChunk::BITS) + y}, c.capacity[cell], c.used[cell], c.items[cell].get()};
+                    if(f(view)) return true;
+                }
+            }
+        }
+    }
+    return false;
+}
+
+// FUNCTION: Calls f for every occupied cell in row-major order.
+template<typename F>
+void Grid::forEach(F f){
+    scan([](const GridChunk& c, int x){ return (unsigned int)c.occupied[x]; }, [&](const GridCell& cell){ f(cell); return false; });
+}
+
+// FUNCTION: Calls f for every occupied cell in rows first to last - 1 in row-major order. The rows are whole chunk rows,
+// so several threads can each visit their own band of rows of the same Grid at once.
+template<typename F>
+void Grid::forEachInRows(int first, int last, F f){
+    int last_chunk_row = (last + GridChunk::SIZE - 1) >> GridChunk::BITS;
+    scan([](const GridChunk& c, int x){ return (unsigned int)c.occupied[x]; }, [&](const GridCell& cell){ f(cell); return false; }, first >> GridChunk::BITS, last_chunk_row);
+}
+
+// FUNCTION: Calls f for every StorageUnit with at least k free capacity in row-major order. Rows are filtered with
+// freeMask(...), so StorageUnits without enough space are skipped without building a GridCell.
+template<typename F>
+void Grid::forEachFree(int k, F f){
+    scan([k](const GridChunk& c, int x){ return freeMask(c, x, k); }, [&](const GridCell& cell){ f(cell); return false; });
+}
+
+#endif
@@ -0,0 +1,542 @@
+//
+// CSC 212 - Data Structures and Abstractions
+// Dominic Tucchio, Jennipher Day, Maya Geva, Thomas Williams
+// Spring 2024 Term Project - hpa.cpp
+//
+
+#include "hpa.h"
+#include "../metrics/metrics.h"
+#include "../metrics/trace.h"
+
+//
+// CLASS: HierarchicalGraph
+// A two-level view of the Warehouse graph for hierarchical pathfinding (HPA*). The floor is divided into square
+// clusters, and every spacing-th cell along each border between two clusters is an entrance. A query first searches
+// the small abstract graph of entrances, using the precalculated distances inside each cluster, and then refines only
+// the clusters along the abstract path into a path of cells. Edge weights match the graph built by
+// Algorithms::buildGraph(...). With a spacing of 1 every border cell is an entrance and distances are exact; with a
+// larger spacing a path may be forced to detour to an entrance each time it crosses a border, so a route is longer than
+// the shortest path by at most (2 * (spacing / 2) + 1) * (1 + 2 * sqrt(largest capacity)) per border crossed. With a
+// larger spacing the clusters are also grouped into regions, and only every REGION_STRIDE-th entrance along a border
+// between two regions is an entrance of the regions, so a route between distant cells searches the clusters near
+// either end and only the entrances of the regions in between. A route may then also detour to a region's entrance each
+// time it crosses a border between regions, by at most (2 * (spacing * REGION_STRIDE / 2) + 1) times the same weight.
+//
+
+// COORDINATE SHIFTS: Offsets from a cell to each of its neighboring cells.
+static const int dx[] = {0, 0, 1, -1};
+static const int dy[] = {1, -1, 0, 0};
+
+// CONSTRUCTOR: Creates an empty hierarchy with 16x16 clusters and an entrance every 4 cells. Nothing is built until the
+// first query.
+HierarchicalGraph::HierarchicalGraph(){
+
+}
+
+// FUNCTION: Sets the side length of the clusters and the distance between entrances along their borders, then discards
+// the hierarchy so it is rebuilt with the new layout on the next query. Values below 1 are treated as 1.
+void HierarchicalGraph::configure(int cluster_size, int spacing){
+    this->cluster_size = std::max(1, cluster_size);
+    this->spacing = std::max(1, spacing);
+    reset();
+    return;
+}
+
+// FUNCTION: Marks the cluster containing loc as out of date after the StorageUnit there changed. Only edges touching the
+// StorageUnit change weight; the ones inside its cluster are part of the cluster's distances, and the ones crossing a
+// border are weighed when they are used, so no other cluster is affected. A location outside of the floor the hierarchy
+// was built for discards the hierarchy.
+void HierarchicalGraph::invalidate(std::pair<int, int> loc){
+    if(rows == 0) return;
+    if(loc.first < 0 || loc.first >= rows || loc.second < 0 || loc.second >= cols){
+        reset();
+        return;
+    }
+    int c = clusterOf(loc);
+    if(!clusters[c].dirty){
+        clusters[c].dirty = true;
+        dirty.push_back(c);
+    }
+    return;
+}
+
+// FUNCTION: Discards the clusters and portals. The layout depends on the floor's extent, so this is called
+// when the floor grows.
+void HierarchicalGraph::reset(){
+    rows = 0;
+    cols = 0;
+    clusters.clear();
+    portals.clear();
+    regions.clear();
+    region_rows = 1;
+    region_cols = 1;
+    dirty.clear();
+    return;
+}
+
+// FUNCTION: Returns the portal at a cell, creating it in the cell's cluster if the cell is not an entrance yet. Accepts
+// parameters loc, the cell, and ids, the portals created so far keyed by cell.
+int HierarchicalGraph::portal(std::pair<int, int> loc, std::unordered_map<long long, int>& ids){
+    long long key = (long long)loc.first * cols + loc.second;
+    std::unordered_map<long long, int>::iterator it = ids.find(key);
+    if(it != ids.end()) return it->second;
+
+    int id = (int)portals.size();
+    int c = clusterOf(loc);
+    portals.push_back({loc, c, (int)clusters[c].portals.size(), {-1, -1, -1, -1}, -1});
+    clusters[c].portals.push_back(id);
+    ids[key] = id;
+    return id;
+}
+
+// FUNCTION: Lays out the clusters of the floor and the entrances along every border between two clusters. Along a
+// border of length L the entrances are the cells at spacing / 2, spacing + spacing / 2, ..., the last one moved onto
+// the border if it would fall past its end. With a spacing above 1 on a floor wider than a region, every
+// REGION_STRIDE-th pair of entrances along each border between two regions, starting half a stride in, is also an
+// entrance of both regions. Every cluster and region starts out of date.
+void HierarchicalGraph::build(Grid& units){
+    TRACE_SCOPE("hierarchy build");
+    reset();
+    rows = units.getRows();
+    cols = units.getCols();
+    cluster_rows = (rows + cluster_size - 1) / cluster_size;
+    cluster_cols = (cols + cluster_size - 1) / cluster_size;
+
+    clusters.assign(cluster_rows * cluster_cols, HPACluster());
+    for(int cx = 0; cx < cluster_rows; cx++){
+        for(int cy = 0; cy < cluster_cols; cy++){
+            HPACluster& c = clusters[cx * cluster_cols + cy];
+            c.origin = {cx * cluster_size, cy * cluster_size};
+            c.rows = std::min(cluster_size, rows - c.origin.first);
+            c.cols = std::min(cluster_size, cols - c.origin.second);
+            c.dirty = true;
+            dirty.push_back(cx * cluster_cols + cy);
+        }
+    }
+
+    std::unordered_map<long long, int> ids;
+    // Joins the entrance on each side of a border.
+    auto link = [&](std::pair<int, int> a, std::pair<int, int> b){
+        int pa = portal(a, ids);
+        int pb = portal(b, ids);
+        *std::find(portals[pa].across, portals[pa].across + 4, -1) = pb;
+        *std::find(portals[pb].across, portals[pb].across + 4, -1) = pa;
+    };
+
+    for(int cx = 0; cx < cluster_rows; cx++){
+        for(int cy = 0; cy < cluster_cols; cy++){
+            HPACluster c = clusters[cx * cluster_cols + cy];
+            // Border with the cluster to the right.
+            if(cy + 1 < cluster_cols){
+                for(int i = 0; i * spacing < c.rows; i++){
+                    int p = std::min(i * spacing + spacing / 2, c.rows - 1);
+                    link({c.origin.first + p, c.origin.second + c.cols - 1}, {c.origin.first + p, c.origin.second + c.cols});
+                }
+            }
+            // Border with the cluster below.
+            if(cx + 1 < cluster_rows){
+                for(int i = 0; i * spacing < c.cols; i++){
+                    int p = std::min(i * spacing + spacing / 2, c.cols - 1);
+                    link({c.origin.first + c.rows - 1, c.origin.second + p}, {c.origin.first + c.rows, c.origin.second + p});
+                }
+            }
+        }
+    }
+
+    // Regions are left out with a spacing of 1, so its paths stay exact.
+    if(spacing > 1 && (cluster_rows > REGION_CLUSTERS || cluster_cols > REGION_CLUSTERS)){
+        region_rows = (cluster_rows + REGION_CLUSTERS - 1) / REGION_CLUSTERS;
+        region_cols = (cluster_cols + REGION_CLUSTERS - 1) / REGION_CLUSTERS;
+        regions.assign(region_rows * region_cols, HPARegion());
+        for(HPARegion& r : regions) r.dirty = true;
+
+        // Makes both portals of every REGION_STRIDE-th pair along a border entrances of their regions.
+        std::vector<std::pair<int, int> > pairs;
+        auto enter = [&](){
+            for(int i = std::min(REGION_STRIDE / 2, (int)pairs.size() - 1); i >= 0 && i < (int)pairs.size(); i += REGION_STRIDE){
+                for(int p : {pairs[i].first, pairs[i].second}){
+                    if(portals[p].entrance != -1) continue;
+                    HPARegion& r = regions[regionOf(portals[p].cluster)];
+                    portals[p].entrance = (int)r.entrances.size();
+                    r.entrances.push_back(p);
+                }
+            }
+            pairs.clear();
+        };
+        // Adds the portals joining a and b, if there are any.
+        auto pair = [&](std::pair<int, int> a, std::pair<int, int> b){
+            std::unordered_map<long long, int>::iterator pa = ids.find((long long)a.first * cols + a.second);
+            std::unordered_map<long long, int>::iterator pb = ids.find((long long)b.first * cols + b.second);
+            if(pa == ids.end() || pb == ids.end()) return;
+            const int* across = portals[pa->second].across;
+            if(std::find(across, across + 4, pb->second) != across + 4) pairs.push_back({pa->second, pb->second});
+        };
+
+        int side = REGION_CLUSTERS * cluster_size;
+        for(int rx = 0; rx < region_rows; rx++){
+            for(int ry = 0; ry < region_cols; ry++){
+                int top = rx * side, left = ry * side, bottom = std::min(rows, top + side), right = std::min(cols, left + side);
+                // Border with the region to the right.
+                if(right < cols){
+                    for(int x = top; x < bottom; x++) pair({x, right - 1}, {x, right});
+                    enter();
+                }
+                // Border with the region below.
+                if(bottom < rows){
+                    for(int y = left; y < right; y++) pair({bottom - 1, y}, {bottom, y});
+                    enter();
+                }
+            }
+        }
+    }
+
+    g.assign(portals.size(), 0);
+    parent.assign(portals.size(), -1);
+    seen.assign(portals.size(), 0);
+    shortcut.assign(portals.size(), 0);
+    stamp = 0;
+    min_weight.assign(clusters.size(), 0);
+    return;
+}
+
+// FUNCTION: Recalculates the distances between the portals of every out of date cluster with one search inside the
+// cluster per portal, keeping the direction each cell was reached from as the portal's tree, then updates the smallest edge weight on the floor and refreshes the regions of those clusters.
+void HierarchicalGraph::refresh(Grid& units){
+    if(dirty.empty()) return;
+    TRACE_SCOPE("hierarchy refresh");
+    for(int id : dirty){
+        HPACluster& c = clusters[id];
+        if(!c.dirty) continue;
+        METRICS_COUNT(HPA_CLUSTER_REBUILDS);
+
+        load(units, c);
+        int n = (int)c.portals.size(), cells = c.rows * c.cols, stride = (cells + 3) / 4;
+        c.distances.assign(n * n, 0);
+        c.trees.assign(n * stride, 0);
+        for(int i = 0; i < n; i++){
+            search(c, localIndex(c, portals[c.portals[i]].loc), -1);
+            for(int j = 0; j < n; j++) c.distances[i * n + j] = dist[localIndex(c, portals[c.portals[j]].loc)];
+            unsigned char* tree = c.trees.data() + i * stride;
+            for(int u = 0; u < cells; u++){
+                if(prev[u] == -1) continue;
+                int k = prev[u] == u + 1 ? 0 : prev[u] == u - 1 ? 1 : prev[u] == u + c.cols ? 2 : 3;
+                tree[u >> 2] |= k << ((u & 3) * 2);
+            }
+        }
+        min_weight[id] = *std::min_element(cost.begin(), cost.end());
+        c.dirty = false;
+        if(!regions.empty()) regions[regionOf(id)].dirty = true;
+    }
+    dirty.clear();
+    min_step = 1 + 2 * *std::min_element(min_weight.begin(), min_weight.end());
+    refreshRegions(units);
+    return;
+}
+
+// FUNCTION: Recalculates the distances and routes between the entrances of every out of date region with one search
+// from each entrance over the portals of the region's clusters, using the distances inside each cluster and the edges
+// across the borders between them.
+void HierarchicalGraph::refreshRegions(Grid& units){
+    for(int id = 0; id < (int)regions.size(); id++){
+        HPARegion& r = regions[id];
+        if(!r.dirty) continue;
+
+        int n = (int)r.entrances.size();
+        r.distances.assign(n * n, 0);
+        r.route_start.assign(n * n + 1, 0);
+        r.routes.clear();
+        for(int i = 0; i < n; i++){
+            restart();
+            relax(r.entrances[i], 0, -1, false, 0);
+            while(!open.empty()){
+                std::pair<long long, int> top = open.front();
+                std::pop_heap(open.begin(), open.end(), [](const std::pair<long long, int>& a, const std::pair<long long, int>& b){ return a.first > b.first; });
+                open.pop_back();
+                int p = top.second;
+                if(top.first != key(g[p], g[p])) continue;
+
+                const HPAPortal& current = portals[p];
+                const HPACluster& c = clusters[current.cluster];
+                int m = (int)c.portals.size();
+                for(int j = 0; j < m; j++){
+                    if(j != current.local) relax(c.portals[j], g[p] + c.distances[current.local * m + j], p, false, 0);
+                }
+                for(int k = 0; k < 4; k++){
+                    int q = current.across[k];
+                    if(q != -1 && regionOf(portals[q].cluster) == id) relax(q, g[p] + step(units, current.loc, portals[q].loc), p, false, 0);
+                }
+            }
+            for(int j = 0; j < n; j++){
+                r.distances[i * n + j] = g[r.entrances[j]];
+                r.route_start[i * n + j] = (int)r.routes.size();
+                if(j <= i) continue;
+                for(int p = r.entrances[j]; p != r.entrances[i]; p = parent[p]) r.routes.push_back(p);
+                std::reverse(r.routes.begin() + r.route_start[i * n + j], r.routes.end());
+            }
+        }
+        r.route_start[n * n] = (int)r.routes.size();
+        r.dirty = false;
+    }
+    return;
+}
+
+// FUNCTION: Fills the cost buffer with the weight of every cell in a cluster, row by row, so searches inside the cluster
+// do not have to look up the Grid. The capacities are copied from the Grid a chunk-width at a time.
+void HierarchicalGraph::load(Grid& units, const HPACluster& c){
+    cost.resize(c.rows * c.cols);
+    units.block(c.origin, c.rows, c.cols, cost.data());
+    for(int& w : cost) w = Algorithms::cellWeight(w);
+    return;
+}
+
+// FUNCTION: Runs Dijkstra's Algorithm over the cells of the loaded cluster without leaving it. Accepts parameters c, the
+// cluster, source, the local index of the starting cell, and target, the local index of a cell to stop at, or -1 to
+// reach every cell. With a target the search becomes A*, ordering cells by their distance plus the lower bound on the
+// rest of the way, with ties going to the cell farther along, so only the cells near the shortest path are explored.
+// Fills the dist and prev buffers.
+void HierarchicalGraph::search(const HPACluster& c, int source, int target){
+    int n = c.rows * c.cols;
+    dist.assign(n, INT_MAX);
+    prev.assign(n, -1);
+    heap.clear();
+
+    int tx = target == -1 ? 0 : target / c.cols, ty = target == -1 ? 0 : target % c.cols;
+    auto estimate = [&](int u){ return target == -1 ? 0 : (std::abs(u / c.cols - tx) + std::abs(u % c.cols - ty)) * min_step; };
+    auto later = [](const std::pair<long long, int>& a, const std::pair<long long, int>& b){ return a.first > b.first; };
+    dist[source] = 0;
+    heap.push_back({key(estimate(source), 0), source});
+    while(!heap.empty()){
+        std::pair<long long, int> top = heap.front();
+        std::pop_heap(heap.begin(), heap.end(), later);
+        heap.pop_back();
+        int u = top.second;
+        if(top.first != key(dist[u] + estimate(u), dist[u])) continue;
+        if(u == target) break;
+
+        int x = u / c.cols, y = u % c.cols;
+        for(int k = 0; k < 4; k++){
+            int nx = x + dx[k], ny = y + dy[k];
+            if(nx < 0 || nx >= c.rows || ny < 0 || ny >= c.cols) continue;
+            int v = nx * c.cols + ny;
+            int d = dist[u] + 1 + cost[u] + cost[v];
+            if(d < dist[v]){
+                dist[v] = d;
+                prev[v] = u;
+                heap.push_back({key(d + estimate(v), d), v});
+                std::push_heap(heap.begin(), heap.end(), later);
+            }
+        }
+    }
+    return;
+}
+
+// FUNCTION: Appends the shortest path inside a cluster from one of its cells to another, excluding the first cell, to
+// path. Accepts parameters units, the Grid, cluster, the index of the cluster, from and to, the two cells, and path.
+void HierarchicalGraph::refine(Grid& units, int cluster, std::pair<int, int> from, std::pair<int, int> to, std::vector<std::pair<int, int> >& path){
+    const HPACluster& c = clusters[cluster];
+    load(units, c);
+    int source = localIndex(c, from);
+    search(c, source, localIndex(c, to));
+
+    size_t start = path.size();
+    for(int u = localIndex(c, to); u != source; u = prev[u]) path.push_back({c.origin.first + u / c.cols, c.origin.second + u % c.cols});
+    std::reverse(path.begin() + start, path.end());
+    return;
+}
+
+// FUNCTION: Appends the shortest path inside a cluster between one of its portals and one of its cells, excluding the
+// first cell, to path. The path is read from the portal's tree by following the directions from the cell back to the
+// portal. Accepts parameters portal, the index of the portal, loc, the cell, back, true for the path from the cell to
+// the portal rather than from the portal to the cell, and path.
+void HierarchicalGraph::follow(int portal, std::pair<int, int> loc, bool back, std::vector<std::pair<int, int> >& path){
+    const HPACluster& c = clusters[portals[portal].cluster];
+    const unsigned char* tree = c.trees.data() + portals[portal].local * ((c.rows * c.cols + 3) / 4);
+    int root = localIndex(c, portals[portal].loc);
+
+    size_t start = path.size();
+    int u = localIndex(c, loc);
+    if(!back && u != root) path.push_back(loc);
+    while(u != root){
+        int k = (tree[u >> 2] >> ((u & 3) * 2)) & 3;
+        u += dx[k] * c.cols + dy[k];
+        if(back || u != root) path.push_back({c.origin.first + u / c.cols, c.origin.second + u % c.cols});
+    }
+    if(!back) std::reverse(path.begin() + start, path.end());
+    return;
+}
+
+// FUNCTION: Returns the weight of the edge between two neighboring cells, calculated the same way as the edges built
+// by Algorithms::buildGraph(...).
+int HierarchicalGraph::step(Grid& units, std::pair<int, int> a, std::pair<int, int> b){
+    return CapacityWeight::weight(units, a, b, 1);
+}
+
+// FUNCTION: Starts a new search of the portals. Entries of g, parent, and shortcut are only valid while their seen stamp
+// matches the current stamp, so nothing has to be cleared unless the stamp wraps around.
+void HierarchicalGraph::restart(){
+    if(++stamp == 0){
+        std::fill(seen.begin(), seen.end(), 0);
+        stamp = 1;
+    }
+    open.clear();
+    return;
+}
+
+// FUNCTION: Opens portal p at distance, reached from portal from, unless it was already reached at no greater distance.
+// jump is true if p was reached along the route between two entrances of a region, and estimate is the lower bound on
+// the rest of the way, added to the distance to order the open portals.
+void HierarchicalGraph::relax(int p, int distance, int from, bool jump, int estimate){
+    if(seen[p] == stamp && g[p] <= distance) return;
+    seen[p] = stamp;
+    g[p] = distance;
+    parent[p] = from;
+    shortcut[p] = jump;
+    open.push_back({key(distance + estimate, distance), p});
+    std::push_heap(open.begin(), open.end(), [](const std::pair<long long, int>& a, const std::pair<long long, int>& b){ return a.first > b.first; });
+    return;
+}
+
+// FUNCTION: Finds a path between two cells of the floor. The hierarchy is built if the floor changed size and out of
+// date clusters are refreshed. The source and destination are joined to the portals of their clusters with one search
+// inside each cluster, and the abstract graph of portals is searched with A*, bounding the remaining distance by the
+// Manhattan Distance times the smallest edge weight. Inside the regions of the source and destination every portal is
+// searched; in the regions between them only the entrances are, along the routes between them. The search stops once no unexplored route can be shorter than the
+// best found, which may also be the direct path when both cells share a cluster. Only the clusters along the chosen
+// route are then searched again to recover its cells. Accepts parameters units, the Grid, src, and dest. Returns the
+// length of the path and its cells from src to dest, in the same form as Algorithms::dijkstra(...).
+std::pair<int, std::vector<std::pair<int, int> > > HierarchicalGraph::route(Grid& units, std::pair<int, int> src, std::pair<int, int> dest){
+    TRACE_SCOPE("path search");
+    METRICS_TIME(OP_HPA_ROUTE);
+    if(rows != units.getRows() || cols != units.getCols()) build(units);
+    refresh(units);
+    if(src == dest) return {0, {src}};
+
+    int cs = clusterOf(src), cd = clusterOf(dest);
+    const HPACluster& source = clusters[cs];
+    const HPACluster& target = clusters[cd];
+
+    // Distances from the source to the portals of its cluster, and to the destination if it shares the cluster.
+    int best = INT_MAX, best_portal = -1;
+    load(units, source);
+    search(source, localIndex(source, src), -1);
+    src_dist.resize(source.portals.size());
+    for(int i = 0; i < (int)source.portals.size(); i++) src_dist[i] = dist[localIndex(source, portals[source.portals[i]].loc)];
+    if(cs == cd) best = dist[localIndex(source, dest)];
+
+    // Distances from the portals of the destination's cluster to the destination. Edges are undirected, so these are
+    // found with a search from the destination.
+    load(units, target);
+    search(target, localIndex(target, dest), -1);
+    dest_dist.resize(target.portals.size());
+    for(int i = 0; i < (int)target.portals.size(); i++) dest_dist[i] = dist[localIndex(target, portals[target.portals[i]].loc)];
+
+    // A* over the portals. Open entries are keyed by distance + lower bound, with ties going to the portal with the
+    // larger distance, which is closer to the destination; on open floor many portals share the same key.
+    auto later = [](const std::pair<long long, int>& a, const std::pair<long long, int>& b){ return a.first > b.first; };
+    restart();
+    auto reach = [&](int p, int distance, int from, bool jump){ relax(p, distance, from, jump, lowerBound(portals[p].loc, dest)); };
+    for(int i = 0; i < (int)source.portals.size(); i++) reach(source.portals[i], src_dist[i], -1, false);
+    int rs = regions.empty() ? 0 : regionOf(cs), rd = regions.empty() ? 0 : regionOf(cd);
+
+    while(!open.empty()){
+        std::pair<long long, int> top = open.front();
+        std::pop_heap(open.begin(), open.end(), later);
+        open.pop_back();
+        if((int)(top.first >> 32) >= best) break;
+        int p = top.second;
+        if(top.first != key(g[p] + lowerBound(portals[p].loc, dest), g[p])) continue;
+        METRICS_COUNT(HPA_NODES_VISITED);
+
+        const HPAPortal& current = portals[p];
+        if(current.cluster == cd && g[p] + dest_dist[current.local] < best){
+            best = g[p] + dest_dist[current.local];
+            best_portal = p;
+        }
+
+        int r = regions.empty() ? 0 : regionOf(current.cluster);
+        if(r == rs || r == rd){
+            const HPACluster& c = clusters[current.cluster];
+            int n = (int)c.portals.size();
+            for(int j = 0; j < n; j++){
+                if(j != current.local) reach(c.portals[j], g[p] + c.distances[current.local * n + j], p, false);
+            }
+        }
+        else{
+            const HPARegion& region = regions[r];
+            int n = (int)region.entrances.size();
+            for(int j = 0; j < n; j++){
+                if(j != current.entrance) reach(region.entrances[j], g[p] + region.distances[current.entrance * n + j], p, true);
+            }
+        }
+        // Only the entrances of the regions between the source's and the destination's are searched.
+        for(int k = 0; k < 4; k++){
+            int q = current.across[k];
+            if(q == -1) continue;
+            int to = regions.empty() ? 0 : regionOf(portals[q].cluster);
+            if(portals[q].entrance != -1 || to == rs || to == rd) reach(q, g[p] + step(units, current.loc, portals[q].loc), p, false);
+        }
+    }
+
+    // Refining the route: the route between two entrances of a region is replaced by its portals, consecutive cells in
+    // the same cluster are joined along the tree of the portal among them, and a portal followed by the portal across
+    // its border is a single step. Only a route that never leaves its cluster is searched again.
+    std::vector<std::pair<int, int> > path = {src};
+    if(best_portal == -1){
+        refine(units, cs, src, dest, path);
+        return {best, path};
+    }
+
+    std::vector<int> chain;
+    for(int p = best_portal; p != -1; p = parent[p]){
+        if(!shortcut[p]){
+            chain.push_back(p);
+            continue;
+        }
+        // The chain is built backwards, so the route from the parent's entrance i to p's entrance j is added from p.
+        const HPARegion& region = regions[regionOf(portals[p].cluster)];
+        int n = (int)region.entrances.size(), i = portals[parent[p]].entrance, j = portals[p].entrance;
+        if(i < j) chain.insert(chain.end(), region.routes.rend() - region.route_start[i * n + j + 1], region.routes.rend() - region.route_start[i * n + j]);
+        else{
+            chain.push_back(p);
+            chain.insert(chain.end(), region.routes.begin() + region.route_start[j * n + i], region.routes.begin() + region.route_start[j * n + i + 1] - 1);
+        }
+    }
+    std::reverse(chain.begin(), chain.end());
+
+    follow(chain[0], src, true, path);
+    for(int k = 1; k < (int)chain.size(); k++){
+        int p = chain[k], last = chain[k - 1];
+        if(portals[p].cluster == portals[last].cluster) follow(last, portals[p].loc, false, path);
+        else path.push_back(portals[p].loc);
+    }
+    follow(chain.back(), dest, false, path);
+    return {best, path};
+}
+
+// FUNCTION: Returns the estimated heap memory owned by the hierarchy: the clusters and their portal lists, distance
+// tables, and trees, the portals, the regions and their routes, and the search buffers.
+MemoryUsage HierarchicalGraph::memoryUsage(){
+    MemoryUsage m;
+    m += estimateVector(clusters);
+    for(HPACluster& c : clusters){
+        m += estimateVector(c.portals);
+        m += estimateVector(c.distances);
+        m += estimateVector(c.trees);
+    }
+    m += estimateVector(portals);
+    m += estimateVector(regions);
+    for(HPARegion& r : regions){
+        m += estimateVector(r.entrances);
+        m += estimateVector(r.distances);
+        m += estimateVector(r.routes);
+        m += estimateVector(r.route_start);
+    }
+    m += estimateVector(min_weight);
+    m += estimateVector(dirty);
+    for(std::vector<int>* buffer : {&cost, &dist, &prev, &src_dist, &dest_dist, &g, &parent}) m += estimateVector(*buffer);
+    m += estimateVector(heap);
+    m += estimateVector(open);
+    m += estimateVector(seen);
+    m += estimateVector(shortcut);
+    return m;
+}
@@ -0,0 +1,198 @@
+//
+// CSC 212 - Data Structures and Abstractions
+// Dominic Tucchio, Jennipher Day, Maya Geva, Thomas Williams
+// Spring 2024 Term Project - hpa.h
+//
+
+#ifndef HierarchicalGraph_H
+#define HierarchicalGraph_H
+
+#include "algorithms.h"
+
+#include <unordered_map>
+
+//
+// STRUCTURE: HPAPortal
+// An entrance of a cluster: a cell on the cluster's border that paths may use to cross into a neighboring cluster.
+// Entrances come in pairs, one on each side of the border, joined by the single edge between the two cells.
+//
+
+struct HPAPortal {
+    // LOC: The coordinates of the cell.
+    std::pair<int, int> loc;
+    // CLUSTER, LOCAL: The index of the portal's cluster and the portal's position in that cluster's list of portals.
+    int cluster, local;
+    // ACROSS: The portals on the other side of each border the cell is an entrance of, or -1. A corner cell can be an
+    // entrance on two borders, and every border of a cluster that is a single cell.
+    int across[4];
+    // ENTRANCE: The portal's position in its region's list of entrances, or -1 if it is not an entrance of its region.
+    int entrance;
+};
+
+//
+// STRUCTURE: HPACluster
+// A rectangle of the floor along with the distances between its portals and the shortest paths to each portal.
+// Distances are measured along paths that stay inside the cluster and are recalculated when a StorageUnit inside the
+// cluster changes.
+//
+
+struct HPACluster {
+    // ORIGIN, ROWS, COLS: The top-left cell of the cluster and its extent. Clusters on the far edges may be smaller.
+    std::pair<int, int> origin;
+    int rows, cols;
+    // PORTALS: The indices of the cluster's portals.
+    std::vector<int> portals;
+    // DISTANCES: The distance from portal i to portal j of the cluster is stored at i * portals.size() + j.
+    std::vector<int> distances;
+    // TREES: For each portal, the direction from every cell of the cluster toward the portal along a shortest path inside
+    // the cluster, two bits per cell, a quarter of a byte per cell.
+    std::vector<unsigned char> trees;
+    // DIRTY: True if distances and trees are out of date.
+    bool dirty;
+};
+
+//
+// STRUCTURE: HPARegion
+// A square of REGION_CLUSTERS x REGION_CLUSTERS clusters along with the routes between its entrances, a few of the
+// portals on its border. Routes are measured over the portals of the region's clusters without leaving the region,
+// and are recalculated when one of its clusters changes.
+//
+
+struct HPARegion {
+    // ENTRANCES: The indices of the portals that are entrances of the region.
+    std::vector<int> entrances;
+    // DISTANCES: The distance from entrance i to entrance j of the region is stored at i * entrances.size() + j.
+    std::vector<int> distances;
+    // ROUTES, ROUTE_START: For i < j, the portals after entrance i up to entrance j along the route between them are
+    // stored in routes from route_start[i * entrances.size() + j] up to the next pair's start. The route from j to i is
+    // the same route backwards.
+    std::vector<int> routes;
+    std::vector<int> route_start;
+    // DIRTY: True if distances and routes are out of date.
+    bool dirty;
+};
+
+//
+// CLASS: HierarchicalGraph
+// A two-level view of the Warehouse graph for hierarchical pathfinding (HPA*). The floor is divided into square
+// clusters, and every spacing-th cell along each border between two clusters is an entrance. A query first searches
+// the small abstract graph of entrances, using the precalculated distances inside each cluster, and then refines only
+// the clusters along the abstract path into a path of cells. Edge weights match the graph built by
+// Algorithms::buildGraph(...). With a spacing of 1 every border cell is an entrance and distances are exact; with a
+// larger spacing a path may be forced to detour to an entrance each time it crosses a border, so a route is longer than
+// the shortest path by at most (2 * (spacing / 2) + 1) * (1 + 2 * sqrt(largest capacity)) per border crossed. With a
+// larger spacing the clusters are also grouped into regions, and only every REGION_STRIDE-th entrance along a border
+// between two regions is an entrance of the regions, so a route between distant cells searches the clusters near
+// either end and only the entrances of the regions in between. A route may then also detour to a region's entrance each
+// time it crosses a border between regions, by at most (2 * (spacing * REGION_STRIDE / 2) + 1) times the same weight.
+//
+
+class HierarchicalGraph {
+    public:
+        // CONSTRUCTORS
+        HierarchicalGraph();
+
+        // FUNCTIONS
+
+        // CONFIGURE: Sets the cluster size and entrance spacing. The hierarchy is rebuilt on the next query.
+        void configure(int cluster_size, int spacing);
+        // INVALIDATE: Marks the cluster containing a changed StorageUnit as out of date.
+        void invalidate(std::pair<int, int> loc);
+        // RESET: Discards the hierarchy, for example after the floor's extent changed.
+        void reset();
+        // ROUTE: Finds a path between two cells. Returns its length and the cells along it, like Algorithms::dijkstra(...).
+        std::pair<int, std::vector<std::pair<int, int> > > route(Grid& units, std::pair<int, int> src, std::pair<int, int> dest);
+
+        // GETCLUSTERSIZE, GETSPACING: Return the configuration of the hierarchy.
+        int getClusterSize() { return cluster_size; }
+        int getSpacing() { return spacing; }
+        // MEMORYUSAGE: Returns the estimated heap memory owned by the hierarchy.
+        MemoryUsage memoryUsage();
+
+    private:
+        // FUNCTIONS
+
+        // BUILD: Lays out the clusters and portals of a floor.
+        void build(Grid& units);
+        // PORTAL: Returns the portal at a cell, creating it if needed.
+        int portal(std::pair<int, int> loc, std::unordered_map<long long, int>& ids);
+        // REFRESH: Recalculates the distances of every out of date cluster.
+        void refresh(Grid& units);
+        // LOAD: Fills cost with the cell weight of every cell in a cluster.
+        void load(Grid& units, const HPACluster& c);
+        // SEARCH: Runs Dijkstra's Algorithm inside the loaded cluster from a cell, or A* towards target if one is given.
+        void search(const HPACluster& c, int source, int target);
+        // REFRESHREGIONS: Recalculates the routes between the entrances of every out of date region.
+        void refreshRegions(Grid& units);
+        // REFINE: Appends the cells of the shortest path inside a cluster between two of its cells, excluding the first.
+        void refine(Grid& units, int cluster, std::pair<int, int> from, std::pair<int, int> to, std::vector<std::pair<int, int> >& path);
+        // FOLLOW: Appends the cells of the shortest path inside a cluster between a portal and a cell, excluding the first,
+        // read from the portal's tree.
+        void follow(int portal, std::pair<int, int> loc, bool back, std::vector<std::pair<int, int> >& path);
+        // CLUSTEROF: Returns the index of the cluster containing a cell.
+        int clusterOf(std::pair<int, int> loc) { return (loc.first / cluster_size) * cluster_cols + loc.second / cluster_size; }
+        // REGIONOF: Returns the index of the region containing a cluster.
+        int regionOf(int cluster) { return (cluster / cluster_cols / REGION_CLUSTERS) * region_cols + cluster % cluster_cols / REGION_CLUSTERS; }
+        // LOCALINDEX: Returns the index of a cell within its cluster.
+        static int localIndex(const HPACluster& c, std::pair<int, int> loc) { return (loc.first - c.origin.first) * c.cols + loc.second - c.origin.second; }
+        // STEP: Returns the weight of the edge between two neighboring cells.
+        int step(Grid& units, std::pair<int, int> a, std::pair<int, int> b);
+        // RESTART: Starts a new search of the portals, invalidating the entries of the last one.
+        void restart();
+        // RELAX: Opens a portal at a distance if it is shorter than its current distance.
+        void relax(int p, int distance, int from, bool jump, int estimate);
+        // KEY: Returns the priority of an open portal or cell: its estimated total distance f, then its larger distance g
+        // first.
+        static long long key(int f, int g) { return ((long long)f << 32) | (unsigned int)(INT_MAX - g); }
+        // LOWERBOUND: Returns a lower bound on the length of any path between two cells.
+        int lowerBound(std::pair<int, int> a, std::pair<int, int> b) { return (std::abs(a.first - b.first) + std::abs(a.second - b.second)) * min_step; }
+
+        // MEMBER VARIABLES
+
+        // REGION_CLUSTERS, REGION_STRIDE: The side length of a region in clusters, and the number of portals along a
+        // border between two regions for each entrance of the regions.
+        static const int REGION_CLUSTERS = 8;
+        static const int REGION_STRIDE = 4;
+
+        // CLUSTER_SIZE, SPACING: The side length of a cluster and the distance between entrances along a border.
+        int cluster_size = 16;
+        int spacing = 4;
+        // ROWS, COLS: The extent of the floor the hierarchy was built for, or 0 if it has not been built.
+        int rows = 0;
+        int cols = 0;
+        // CLUSTER_ROWS, CLUSTER_COLS: The number of clusters along each axis.
+        int cluster_rows = 0;
+        int cluster_cols = 0;
+        // REGION_ROWS, REGION_COLS: The number of regions along each axis. Both are 1 if regions are not used.
+        int region_rows = 1;
+        int region_cols = 1;
+        // MIN_STEP: The smallest edge weight on the floor, used to bound the remaining distance of the abstract search.
+        int min_step = 1;
+
+        // CLUSTERS, PORTALS: The clusters of the floor in row-major order and every portal.
+        std::vector<HPACluster> clusters;
+        std::vector<HPAPortal> portals;
+        // REGIONS: The regions of the floor in row-major order.
+        std::vector<HPARegion> regions;
+        // MIN_WEIGHT: The smallest cell weight inside each cluster.
+        std::vector<int> min_weight;
+        // DIRTY: The indices of the out of date clusters.
+        std::vector<int> dirty;
+
+        // COST, DIST, PREV, HEAP: Buffers for searches inside a cluster, reused between searches.
+        std::vector<int> cost, dist, prev;
+        std::vector<std::pair<long long, int> > heap;
+        // SRC_DIST, DEST_DIST: Distances from the source and to the destination of a query to the portals of their clusters.
+        std::vector<int> src_dist, dest_dist;
+        // G, PARENT, SEEN: Buffers for the abstract search, indexed by portal. An entry is only valid if its seen stamp
+        // matches the current query's stamp, so the buffers never have to be cleared.
+        std::vector<int> g, parent;
+        // SHORTCUT: Set for a portal reached along the route between two entrances of a region rather than a single edge.
+        std::vector<char> shortcut;
+        // OPEN: The priority queue of the abstract search, reused between queries.
+        std::vector<std::pair<long long, int> > open;
+        std::vector<unsigned int> seen;
+        unsigned int stamp = 0;
+};
+
+#endif
@@ -0,0 +1,306 @@
+//
+// CSC 212 - Data Structures and Abstractions
+// Dominic Tucchio, Jennipher Day, Maya Geva, Thomas Williams
+// Spring 2024 Term Project - item_index.cpp
+//
+
+#include "item_index.h"
+
+#include <algorithm>
+
+//
+// CLASS: ItemIndex
+// Maps the name of every Item in the Warehouse to the StorageUnits holding it and the quantity stored. Kept up to date by
+// the Warehouse whenever an Item is stored in or removed from a StorageUnit.
+//
+
+// CONSTRUCTOR: Creates an empty index, holding only the root of the tree.
+ItemIndex::ItemIndex() : root(std::make_shared<TrieNode>()) {
+
+}
+
+// FUNCTION: Returns the position of the child of node whose label starts with c, or the position where such a child
+// would be inserted if there is none. Only the node's own string of first characters is searched, so no child is read.
+// Children are ordered as std::string orders characters, so names are visited in the same order as they sort.
+size_t ItemIndex::child(const TrieNode& node, char c){
+    return std::lower_bound(node.keys.begin(), node.keys.end(), c, [](char k, char c){ return (unsigned char)k < (unsigned char)c; }) - node.keys.begin();
+}
+
+// FUNCTION: Returns the node where name ends, or nullptr if name ends partway along a label or leaves the tree. Accepts
+// parameter name.
+const TrieNode* ItemIndex::node(const std::string& name) const {
+    const TrieNode* at = root.get();
+    for(size_t pos = 0; pos < name.size(); ){
+        size_t k = child(*at, name[pos]);
+        if(k == at->keys.size() || at->keys[k] != name[pos]) return nullptr;
+        const std::string& label = at->children[k]->label;
+        if(name.compare(pos, label.size(), label) != 0) return nullptr;
+        pos += label.size();
+        at = at->children[k].get();
+    }
+    return at;
+}
+
+// FUNCTION: Returns the node where name ends, which only this index refers to and may be changed. Every node along name
+// is owned on the way down, a label that name leaves partway is split in two, and a new leaf holds whatever is left of
+// name once no child matches. items and quantity are added to the totals of every node passed, the root and the last
+// node included. Accepts parameters name, items, and quantity. Makes no heap allocations if every node along name
+// already exists and is not shared.
+TrieNode& ItemIndex::reach(const std::string& name, int items, long long quantity){
+    TrieNode* at = &own(root);
+    size_t pos = 0;
+    while(true){
+        at->items += items;
+        at->total += quantity;
+        if(pos == name.size()) return *at;
+
+        size_t k = child(*at, name[pos]);
+        if(k == at->keys.size() || at->keys[k] != name[pos]){
+            Link leaf = std::make_shared<TrieNode>();
+            leaf->label = name.substr(pos);
+            at->children.insert(at->children.begin() + k, leaf);
+            at->keys.insert(at->keys.begin() + k, name[pos]);
+            at = leaf.get();
+            pos = name.size();
+            continue;
+        }
+        Link& next = at->children[k];
+        TrieNode& below = own(next);
+        size_t common = 1;
+        while(common < below.label.size() && pos + common < name.size() && below.label[common] == name[pos + common]) common++;
+        if(common < below.label.size()){
+            // Splitting the label: a new node takes the shared characters and keeps the old node as its only child.
+            Link middle = std::make_shared<TrieNode>();
+            middle->label = below.label.substr(0, common);
+            middle->items = below.items;
+            middle->total = below.total;
+            below.label.erase(0, common);
+            middle->children.push_back(next);
+            middle->keys.push_back(below.label[0]);
+            next = middle;
+            at = middle.get();
+        } else at = &below;
+        pos += common;
+    }
+}
+
+// FUNCTION: Drops the named Item, which must be stored, from the tree. Its count and quantity are taken off the totals
+// of every node along its name. A leaf left holding no Item is removed, and a node other than the root that is left
+// without an Item and with a single child is merged with the child, so the tree stays compact. Accepts parameter name.
+void ItemIndex::remove(const std::string& name){
+    long long quantity = node(name)->locations.quantity;
+    // The links followed from the root down to the node where name ends.
+    std::vector<Link*> path = {&root};
+    TrieNode* at = &own(root);
+    for(size_t pos = 0; ; ){
+        at->items--;
+        at->total -= quantity;
+        if(pos == name.size()) break;
+        Link& next = at->children[child(*at, name[pos])];
+        pos += next->label.size();
+        path.push_back(&next);
+        at = &own(next);
+    }
+    at->stored = false;
+    at->locations = ItemLocations();
+
+    // Compacting the nodes left behind, from the bottom up.
+    for(int d = path.size() - 1; d > 0; d--){
+        TrieNode& n = **path[d];
+        TrieNode& parent = **path[d - 1];
+        if(n.stored || n.children.size() > 1) break;
+        if(n.children.empty()){
+            size_t k = child(parent, n.label[0]);
+            parent.children.erase(parent.children.begin() + k);
+            parent.keys.erase(k, 1);
+            continue;
+        }
+        // One child left: the child's label is appended to this node's and the child takes the node's place.
+        Link only = std::move(n.children[0]);
+        std::string label = n.label + only->label;
+        if(exclusive(only)) *path[d] = only;
+        else *path[d] = std::make_shared<TrieNode>(*only);
+        (*path[d])->label = label;
+        break;
+    }
+    return;
+}
+
+// FUNCTION: Records that the StorageUnit at loc holds the named Item. A location keeps the age it was first recorded
+// with until it is erased. Accepts parameters name and loc. Looking up a location that is already recorded makes no heap
+// allocations.
+void ItemIndex::insert(const std::string& name, std::pair<int, int> loc){
+    const TrieNode* found = node(name);
+    if(found != nullptr && found->stored && found->locations.by_location.find(loc) != nullptr) return;
+    bool fresh = found == nullptr || !found->stored;
+    TrieNode& at = reach(name, fresh ? 1 : 0, 0);
+    at.stored = true;
+    at.locations.by_location.set(loc, stocked);
+    at.locations.by_age.set(stocked, loc);
+    stocked++;
+    return;
+}
+
+// FUNCTION: Records that the StorageUnit at loc no longer holds the named Item. The Item is dropped from the index once
+// no StorageUnit holds it. Accepts parameters name and loc.
+void ItemIndex::erase(const std::string& name, std::pair<int, int> loc){
+    const ItemLocations* found = find(name);
+    if(found == nullptr || found->by_location.find(loc) == nullptr) return;
+    if(found->by_location.size() == 1){
+        remove(name);
+        return;
+    }
+    ItemLocations& at = reach(name, 0, 0).locations;
+    at.by_age.erase(*at.by_location.find(loc));
+    at.by_location.erase(loc);
+    return;
+}
+
+// FUNCTION: Adds quantity, which may be negative, to the quantity stored of the named Item and to the totals of every
+// prefix of its name. Does nothing if the Item is not indexed. Accepts parameters name and quantity. Makes no heap
+// allocations unless nodes along the name are shared with a copy of the index.
+void ItemIndex::adjust(const std::string& name, long long quantity){
+    const ItemLocations* found = find(name);
+    if(found == nullptr || quantity == 0) return;
+    reach(name, 0, quantity).locations.quantity += quantity;
+    return;
+}
+
+// FUNCTION: Returns the locations of the named Item, or nullptr if no StorageUnit holds it. Accepts parameter name.
+const ItemLocations* ItemIndex::find(const std::string& name) const {
+    const TrieNode* found = node(name);
+    return found != nullptr && found->stored ? &found->locations : nullptr;
+}
+
+// FUNCTION: Returns the number of Items whose names start with prefix and the quantity stored of all of them, read from
+// the totals of the node where prefix ends, or of the node whose label it ends partway along. Takes O(prefix length)
+// however many Items match. Accepts parameter prefix.
+ItemTotals ItemIndex::totals(const std::string& prefix) const {
+    ItemTotals totals;
+    const TrieNode* at = root.get();
+    for(size_t pos = 0; pos < prefix.size(); ){
+        size_t k = child(*at, prefix[pos]);
+        if(k == at->keys.size() || at->keys[k] != prefix[pos]) return totals;
+        const std::string& label = at->children[k]->label;
+        size_t length = std::min(label.size(), prefix.size() - pos);
+        if(prefix.compare(pos, length, label, 0, length) != 0) return totals;
+        pos += length;
+        at = at->children[k].get();
+    }
+    totals.items = at->items;
+    totals.quantity = at->total;
+    return totals;
+}
+
+// FUNCTION: Calls f for the Item stored at node, if any, and then for every Item below it in name order. name holds the
+// characters from the root to node. Returns false once f has returned false.
+bool ItemIndex::visit(const TrieNode& node, std::string& name, int& calls, const std::function<bool(const std::string&, const ItemLocations&)>& f){
+    if(node.stored){
+        calls++;
+        if(!f(name, node.locations)) return false;
+    }
+    for(const Link& next : node.children){
+        name += next->label;
+        bool more = visit(*next, name, calls, f);
+        name.resize(name.size() - next->label.size());
+        if(!more) return false;
+    }
+    return true;
+}
+
+// FUNCTION: Calls f(name, locations) for every Item whose name starts with prefix, in name order, until f returns false.
+// The walk to the end of prefix follows a single path, and every node below it holds a match. Accepts parameters prefix
+// and f. Returns the number of calls made.
+int ItemIndex::forEachPrefix(const std::string& prefix, const std::function<bool(const std::string&, const ItemLocations&)>& f) const {
+    int calls = 0;
+    const TrieNode* at = root.get();
+    std::string name;
+    for(size_t pos = 0; pos < prefix.size(); ){
+        size_t k = child(*at, prefix[pos]);
+        if(k == at->keys.size() || at->keys[k] != prefix[pos]) return 0;
+        const std::string& label = at->children[k]->label;
+        size_t length = std::min(label.size(), prefix.size() - pos);
+        if(prefix.compare(pos, length, label, 0, length) != 0) return 0;
+        name += label;
+        pos += length;
+        at = at->children[k].get();
+    }
+    visit(*at, name, calls, f);
+    return calls;
+}
+
+// FUNCTION: Returns states, a set of positions in pattern with bit p set if the first p characters of pattern have been
+// matched, along with every position reached from them by letting a * match nothing.
+uint64_t ItemIndex::close(const std::string& pattern, uint64_t states){
+    for(size_t p = 0; p < pattern.size(); p++){
+        if((states >> p & 1) && pattern[p] == '*') states |= 1ULL << (p + 1);
+    }
+    return states;
+}
+
+// FUNCTION: Returns the positions in pattern reached from states by reading the character c: a * stays where it is, and
+// a ? or the same character moves on by one.
+uint64_t ItemIndex::step(const std::string& pattern, uint64_t states, char c){
+    uint64_t next = 0;
+    for(size_t p = 0; p < pattern.size(); p++){
+        if(!(states >> p & 1)) continue;
+        if(pattern[p] == '*') next |= 1ULL << p;
+        else if(pattern[p] == '?' || pattern[p] == c) next |= 1ULL << (p + 1);
+    }
+    return close(pattern, next);
+}
+
+// FUNCTION: Reads the label of node, calls f if node stores an Item and the whole pattern has been matched, and moves on
+// to the children. A branch is left as soon as no position of the pattern can be reached, so a pattern starting with
+// literal characters only visits the nodes below them. Returns false once f has returned false.
+bool ItemIndex::match(const TrieNode& node, const std::string& pattern, uint64_t states, std::string& name, int& calls, const std::function<bool(const std::string&, const ItemLocations&)>& f){
+    for(char c : node.label){
+        states = step(pattern, states, c);
+        if(states == 0) return true;
+    }
+    if(node.stored && (states >> pattern.size() & 1)){
+        calls++;
+        if(!f(name, node.locations)) return false;
+    }
+    for(const Link& next : node.children){
+        name += next->label;
+        bool more = match(*next, pattern, states, name, calls, f);
+        name.resize(name.size() - next->label.size());
+        if(!more) return false;
+    }
+    return true;
+}
+
+// FUNCTION: Calls f(name, locations) for every Item whose whole name matches pattern, where * stands for any run of
+// characters, including none, and ? for any single character, in name order, until f returns false. The pattern is
+// matched by tracking the set of pattern positions reachable after each character as a bitmask, so each node is read
+// once however many *s the pattern has. Accepts parameters pattern, of at most 63 characters, and f. Returns the number
+// of calls made, or -1 if the pattern is too long.
+int ItemIndex::forEachMatch(const std::string& pattern, const std::function<bool(const std::string&, const ItemLocations&)>& f) const {
+    if(pattern.size() > 63) return -1;
+    int calls = 0;
+    std::string name;
+    match(*root, pattern, close(pattern, 1), name, calls, f);
+    return calls;
+}
+
+// FUNCTION: Estimates the heap memory owned by the index: each node of the tree with its label and list of children, and
+// two PersistentMap nodes per location. Nodes shared with copies of the index are counted in full.
+MemoryUsage ItemIndex::memoryUsage(){
+    MemoryUsage usage;
+    std::vector<const TrieNode*> stack = {root.get()};
+    int nodes = 0;
+    while(!stack.empty()){
+        const TrieNode* at = stack.back();
+        stack.pop_back();
+        nodes++;
+        usage += estimateString(at->label);
+        usage += estimateVector(at->children);
+        usage += estimateString(at->keys);
+        usage += at->locations.by_location.memoryUsage();
+        usage += at->locations.by_age.memoryUsage();
+        for(const Link& next : at->children) stack.push_back(next.get());
+    }
+    usage += estimateShared<TrieNode>(nodes);
+    return usage;
+}
@@ -0,0 +1,132 @@
+//
+// CSC 212 - Data Structures and Abstractions
+// Dominic Tucchio, Jennipher Day, Maya Geva, Thomas Williams
+// Spring 2024 Term Project - item_index.h
+//
+
+#ifndef ItemIndex_H
+#define ItemIndex_H
+
+#include "../metrics/memory.h"
+#include "persistent.h"
+
+#include <cstdint>
+#include <functional>
+#include <string>
+
+//
+// STRUCTURE: ItemLocations
+// The StorageUnits holding one Item and the quantity of it stored across them. BY_LOCATION maps each location to the
+// order it was first stocked in, so the locations can be listed in row-major order, and BY_AGE maps that order back to
+// the location, oldest first.
+//
+
+struct ItemLocations {
+    PersistentMap<std::pair<int, int>, unsigned long long> by_location;
+    PersistentMap<unsigned long long, std::pair<int, int> > by_age;
+    long long quantity = 0;
+};
+
+//
+// STRUCTURE: ItemTotals
+// The number of distinct Items whose names match a prefix and the quantity stored of all of them.
+//
+
+struct ItemTotals {
+    int items = 0;
+    long long quantity = 0;
+};
+
+//
+// STRUCTURE: TrieNode
+// A node of the ItemIndex's radix tree. LABEL is the run of characters on the edge from its parent, so a chain of nodes
+// with a single child each is kept as one node. CHILDREN are ordered by the first character of their labels, and KEYS
+// holds those first characters in the same order, so a child is chosen without reading the others. STORED is true if
+// the characters from the root down to this node name an Item, whose StorageUnits are in LOCATIONS. ITEMS and TOTAL
+// count the Items and their quantity in the node's subtree, itself included.
+//
+
+struct TrieNode {
+    std::string label;
+    std::vector<std::shared_ptr<TrieNode> > children;
+    std::string keys;
+    bool stored = false;
+    ItemLocations locations;
+    int items = 0;
+    long long total = 0;
+};
+
+//
+// CLASS: ItemIndex
+// Maps the name of every Item in the Warehouse to the StorageUnits holding it and the quantity stored, so an Item is
+// found without scanning the floor. Names are kept in a radix tree of shared nodes: a lookup follows one node per
+// branching point of the name, every node counts the Items and quantity below it, so the totals of every name starting
+// with a prefix are read at the end of the prefix, and the Items matching a prefix or a pattern are listed by visiting
+// only the branches that can still match. Like a PersistentMap, the tree is copied in O(1) and a change copies only the
+// nodes along its name that are still shared. Each Item's locations are kept in PersistentMaps, so adding or removing a
+// location is O(log n) and the locations can be visited in row-major or first-in first-out order.
+//
+
+class ItemIndex {
+    public:
+        // CONSTRUCTORS
+        ItemIndex();
+
+        // FUNCTIONS
+
+        // FUNCTION: Records that the StorageUnit at loc holds the named Item. Does nothing if it was already recorded.
+        void insert(const std::string& name, std::pair<int, int> loc);
+        // FUNCTION: Records that the StorageUnit at loc no longer holds the named Item.
+        void erase(const std::string& name, std::pair<int, int> loc);
+        // FUNCTION: Adds to the quantity stored of an Item that is indexed.
+        void adjust(const std::string& name, long long quantity);
+        // FUNCTION: Returns the locations of the named Item, or nullptr if no StorageUnit holds it.
+        const ItemLocations* find(const std::string& name) const;
+        // FUNCTION: Returns the number of distinct Items indexed.
+        int size() const { return root->items; }
+
+        // FUNCTION: Returns the number of Items whose names start with a prefix and their total quantity.
+        ItemTotals totals(const std::string& prefix) const;
+        // FUNCTION: Calls f(name, locations) for every Item whose name starts with a prefix, in name order, until f
+        // returns false. Returns the number of calls.
+        int forEachPrefix(const std::string& prefix, const std::function<bool(const std::string&, const ItemLocations&)>& f) const;
+        // FUNCTION: Calls f(name, locations) for every Item whose name matches a pattern, where * stands for any run of
+        // characters and ? for any one character, in name order, until f returns false. Returns the number of calls, or
+        // -1 if the pattern is longer than 63 characters.
+        int forEachMatch(const std::string& pattern, const std::function<bool(const std::string&, const ItemLocations&)>& f) const;
+
+        // FUNCTION: Returns the estimated heap memory owned by the index.
+        MemoryUsage memoryUsage();
+
+    private:
+        typedef std::shared_ptr<TrieNode> Link;
+
+        // FUNCTIONS
+
+        // FUNCTION: Returns the node named by a string, or nullptr if no node ends exactly there.
+        const TrieNode* node(const std::string& name) const;
+        // FUNCTION: Returns the node named by a string, owning and creating nodes along the way and adding items and
+        // quantity to the totals of every node passed.
+        TrieNode& reach(const std::string& name, int items, long long quantity);
+        // FUNCTION: Drops an Item from the tree, merging nodes left with a single child.
+        void remove(const std::string& name);
+        // FUNCTION: Returns the position of the child of a node whose label starts with a character, or the position to
+        // insert it at.
+        static size_t child(const TrieNode& node, char c);
+        // FUNCTION: Recursive helpers for forEachPrefix(...) and forEachMatch(...). name holds the characters from the
+        // root to the node, and states the positions of the pattern that can be reached after them.
+        static bool visit(const TrieNode& node, std::string& name, int& calls, const std::function<bool(const std::string&, const ItemLocations&)>& f);
+        static bool match(const TrieNode& node, const std::string& pattern, uint64_t states, std::string& name, int& calls, const std::function<bool(const std::string&, const ItemLocations&)>& f);
+        // FUNCTION: Returns the pattern positions reached from states after reading a character, or before any.
+        static uint64_t step(const std::string& pattern, uint64_t states, char c);
+        static uint64_t close(const std::string& pattern, uint64_t states);
+
+        // MEMBER VARIABLES
+
+        // ROOT: The node of the empty name, whose totals cover every Item.
+        Link root;
+        // STOCKED: The number of locations recorded so far, used to order locations by age.
+        unsigned long long stocked = 0;
+};
+
+#endif
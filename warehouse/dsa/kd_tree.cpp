@@ -0,0 +1,245 @@
+//
+// CSC 212 - Data Structures and Abstractions
+// Dominic Tucchio, Jennipher Day, Maya Geva, Thomas Williams
+// Spring 2024 Term Project - kd_tree.cpp
+//
+
+#include "kd_tree.h"
+#include "../metrics/metrics.h"
+#include "../metrics/trace.h"
+
+#include <algorithm>
+#include <cmath>
+
+//
+// CLASS: KDTree
+// A 2D tree over the locations of the Warehouse's StorageUnits, augmented with the largest free capacity of each subtree.
+// Subtrees without enough free capacity are skipped, so queries for "free space in this rectangle" and "the nearest
+// StorageUnit that fits" only visit the part of the floor that can answer them. The tree is kept balanced by rebuilding
+// the smallest unbalanced subtree after an insertion makes it too deep. Nodes are read through nodes[...] and changed
+// through nodes.edit(...), which copies a page first if it is shared with a copy of the tree.
+//
+
+// ALPHA: The largest fraction of a subtree allowed in one of its children before the subtree is rebuilt.
+static const double ALPHA = 0.7;
+
+// CONSTRUCTOR: Creates an empty tree.
+KDTree::KDTree(){
+
+}
+
+// FUNCTION: Adds a StorageUnit to the tree. The new node is placed by descending the tree as in a binary search tree,
+// updating the size and max_free of every node on the way. If the new node is deeper than a tree balanced to within ALPHA
+// could be, the lowest ancestor with an oversized child is rebuilt. A StorageUnit whose location is already in the tree
+// replaces the old one's free capacity.
+void KDTree::insert(const UnitHandle& unit){
+    if(index.find(key(unit.loc)) != nullptr){
+        update(unit.loc, unit.free);
+        return;
+    }
+
+    int id = nodes.size();
+    nodes.push_back({unit, unit.free, 1, 0, -1, -1, -1});
+    index.set(key(unit.loc), id);
+    if(root == -1){
+        root = id;
+        return;
+    }
+
+    int node = root, depth = 1;
+    while(true){
+        KDNode& n = nodes.edit(node);
+        n.size++;
+        n.max_free = std::max(n.max_free, unit.free);
+
+        int& child = coord(unit.loc, n.axis) < coord(n.data.loc, n.axis) ? n.left : n.right;
+        if(child == -1){
+            child = id;
+            nodes.edit(id).parent = node;
+            nodes.edit(id).axis = 1 - n.axis;
+            break;
+        }
+        node = child;
+        depth++;
+    }
+
+    // Checking the depth of the new node against the height of a tree balanced to within ALPHA.
+    if(depth > std::log((double)nodes.size()) / std::log(1.0 / ALPHA) + 1){
+        for(int a = nodes[id].parent; a != -1; a = nodes[a].parent){
+            int l = nodes[a].left == -1 ? 0 : nodes[nodes[a].left].size;
+            int r = nodes[a].right == -1 ? 0 : nodes[nodes[a].right].size;
+            if(std::max(l, r) > ALPHA * nodes[a].size){
+                rebuild(a);
+                break;
+            }
+        }
+    }
+    return;
+}
+
+// FUNCTION: Updates the free capacity of the StorageUnit at a location and the max_free of its ancestors. Locations that
+// are not in the tree are ignored.
+void KDTree::update(std::pair<int, int> loc, int free){
+    const int* found = index.find(key(loc));
+    if(found == nullptr) return;
+
+    nodes.edit(*found).data.free = free;
+    for(int n = *found; n != -1; n = nodes[n].parent) pull(n);
+    return;
+}
+
+// FUNCTION: Recalculates a node's size and max_free from its own StorageUnit and its children.
+void KDTree::pull(int node){
+    KDNode& n = nodes.edit(node);
+    n.size = 1;
+    n.max_free = n.data.free;
+    if(n.left != -1){
+        n.size += nodes[n.left].size;
+        n.max_free = std::max(n.max_free, nodes[n.left].max_free);
+    }
+    if(n.right != -1){
+        n.size += nodes[n.right].size;
+        n.max_free = std::max(n.max_free, nodes[n.right].max_free);
+    }
+    return;
+}
+
+// FUNCTION: Appends the index of every node in a subtree to ids.
+void KDTree::collect(int node, std::vector<int>& ids){
+    if(node == -1) return;
+    ids.push_back(node);
+    collect(nodes[node].left, ids);
+    collect(nodes[node].right, ids);
+    return;
+}
+
+// FUNCTION: Builds a balanced subtree from ids[begin, end). The median along axis becomes the subtree's root, the nodes
+// before it its left subtree, and the nodes after it its right subtree, alternating axes at each level. Returns the index
+// of the root, or -1 if the range is empty.
+int KDTree::build(std::vector<int>& ids, int begin, int end, int axis, int parent){
+    if(begin >= end) return -1;
+    int mid = (begin + end) / 2;
+    std::nth_element(ids.begin() + begin, ids.begin() + mid, ids.begin() + end, [&](int a, int b){
+        int ca = coord(nodes[a].data.loc, axis), cb = coord(nodes[b].data.loc, axis);
+        return ca != cb ? ca < cb : coord(nodes[a].data.loc, 1 - axis) < coord(nodes[b].data.loc, 1 - axis);
+    });
+
+    int node = ids[mid];
+    nodes.edit(node).axis = axis;
+    nodes.edit(node).parent = parent;
+    int left = build(ids, begin, mid, 1 - axis, node);
+    int right = build(ids, mid + 1, end, 1 - axis, node);
+    nodes.edit(node).left = left;
+    nodes.edit(node).right = right;
+    pull(node);
+    return node;
+}
+
+// FUNCTION: Rebuilds the subtree rooted at a node into a balanced subtree that starts on the same axis, and attaches it
+// where the old subtree was. Every StorageUnit in the subtree lies inside the region its ancestors split off, so the rest
+// of the tree is unaffected.
+void KDTree::rebuild(int node){
+    METRICS_COUNT(SPATIAL_REBUILDS);
+    int parent = nodes[node].parent;
+    std::vector<int> ids;
+    collect(node, ids);
+
+    int subtree = build(ids, 0, (int)ids.size(), nodes[node].axis, parent);
+    if(parent == -1) root = subtree;
+    else if(nodes[parent].left == node) nodes.edit(parent).left = subtree;
+    else nodes.edit(parent).right = subtree;
+    return;
+}
+
+// FUNCTION: Public-facing function to find every StorageUnit with at least k free capacity inside the rectangle from
+// low to high, inclusive. Accepts parameters low and high, the opposite corners of the rectangle, k, the free capacity
+// required, and results, a vector that is cleared and filled with the matching StorageUnits in row-major order.
+void KDTree::rectangle(std::pair<int, int> low, std::pair<int, int> high, int k, std::vector<UnitHandle>& results){
+    TRACE_SCOPE("spatial query");
+    METRICS_COUNT(SPATIAL_QUERIES);
+    results.clear();
+    rectangle(root, low, high, k, results);
+    std::sort(results.begin(), results.end(), [](const UnitHandle& a, const UnitHandle& b){ return a.loc < b.loc; });
+    return;
+}
+
+// FUNCTION: Private recursive helper function for rectangle(...). Subtrees whose max_free is below k are skipped, and a
+// child is only visited if the rectangle reaches its side of the node's splitting line.
+void KDTree::rectangle(int node, std::pair<int, int> low, std::pair<int, int> high, int k, std::vector<UnitHandle>& results){
+    if(node == -1 || nodes[node].max_free < k) return;
+    METRICS_COUNT(SPATIAL_NODES_VISITED);
+    const KDNode& n = nodes[node];
+
+    std::pair<int, int> loc = n.data.loc;
+    if(n.data.free >= k && loc.first >= low.first && loc.first <= high.first && loc.second >= low.second && loc.second <= high.second) results.push_back(n.data);
+
+    int split = coord(loc, n.axis);
+    if(coord(low, n.axis) <= split) rectangle(n.left, low, high, k, results);
+    if(coord(high, n.axis) >= split) rectangle(n.right, low, high, k, results);
+    return;
+}
+
+// FUNCTION: Public-facing function to find the count StorageUnits closest to a location that have at least k free
+// capacity. Distance is measured with the Manhattan Distance, matching travel on the Warehouse floor; ties are broken by
+// location. Accepts parameters loc, the location to search from, k, the free capacity required, count, the number of
+// StorageUnits to find, and results, a vector that is cleared and filled with the StorageUnits found, nearest first.
+void KDTree::nearest(std::pair<int, int> loc, int k, int count, std::vector<UnitHandle>& results){
+    TRACE_SCOPE("spatial query");
+    METRICS_COUNT(SPATIAL_QUERIES);
+    results.clear();
+    if(count <= 0) return;
+
+    // BEST: A max-heap of (distance, node) pairs holding the closest StorageUnits found so far, farthest on top.
+    std::vector<std::pair<int, int> > best;
+    nearest(root, loc, k, count, best);
+
+    std::sort_heap(best.begin(), best.end(), [this](const std::pair<int, int>& a, const std::pair<int, int>& b){ return closer(a, b); });
+    for(std::pair<int, int>& b : best) results.push_back(nodes[b.second].data);
+    return;
+}
+
+// FUNCTION: Returns true if the (distance, node) pair a is closer than b. Equal distances are ordered by location so
+// results do not depend on the shape of the tree.
+bool KDTree::closer(const std::pair<int, int>& a, const std::pair<int, int>& b){
+    return a.first != b.first ? a.first < b.first : nodes[a.second].data.loc < nodes[b.second].data.loc;
+}
+
+// FUNCTION: Private recursive helper function for nearest(...). The side of the splitting line containing loc is searched
+// first. The other side is only searched if fewer than count StorageUnits have been found or if the distance to the
+// splitting line is no more than the farthest StorageUnit kept, since every StorageUnit across the line is at least that
+// far away. Subtrees whose max_free is below k are skipped.
+void KDTree::nearest(int node, std::pair<int, int> loc, int k, int count, std::vector<std::pair<int, int> >& best){
+    if(node == -1 || nodes[node].max_free < k) return;
+    METRICS_COUNT(SPATIAL_NODES_VISITED);
+
+    auto closer = [this](const std::pair<int, int>& a, const std::pair<int, int>& b){ return this->closer(a, b); };
+
+    const KDNode& n = nodes[node];
+    if(n.data.free >= k){
+        std::pair<int, int> candidate = {std::abs(n.data.loc.first - loc.first) + std::abs(n.data.loc.second - loc.second), node};
+        if((int)best.size() < count){
+            best.push_back(candidate);
+            std::push_heap(best.begin(), best.end(), closer);
+        } else if(closer(candidate, best.front())){
+            std::pop_heap(best.begin(), best.end(), closer);
+            best.back() = candidate;
+            std::push_heap(best.begin(), best.end(), closer);
+        }
+    }
+
+    int diff = coord(loc, n.axis) - coord(n.data.loc, n.axis);
+    int near = diff < 0 ? n.left : n.right;
+    int far = diff < 0 ? n.right : n.left;
+    nearest(near, loc, k, count, best);
+    if((int)best.size() < count || std::abs(diff) <= best.front().first) nearest(far, loc, k, count, best);
+    return;
+}
+
+// FUNCTION: Estimates the heap memory owned by the tree: the pages of nodes and their table, and the location index, with
+// one allocation per StorageUnit. Pages shared with copies of the tree are counted in full. Accepts two MemoryUsage
+// references that the estimates are added to.
+void KDTree::memoryUsage(MemoryUsage& nodes, MemoryUsage& index){
+    nodes += this->nodes.memoryUsage();
+    index += this->index.memoryUsage();
+    return;
+}
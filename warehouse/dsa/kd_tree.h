@@ -0,0 +1,94 @@
+//
+// CSC 212 - Data Structures and Abstractions
+// Dominic Tucchio, Jennipher Day, Maya Geva, Thomas Williams
+// Spring 2024 Term Project - kd_tree.h
+//
+
+#ifndef KDTree_H
+#define KDTree_H
+
+#include "range_tree.h"
+#include "persistent.h"
+
+//
+// STRUCTURE: KDNode
+// A node of the KDTree. Each node holds the UnitHandle of one StorageUnit and splits its subtree on the node's XCoord
+// (axis 0) or YCoord (axis 1). Nodes are stored in a PagedVector and refer to each other by index.
+//
+
+struct KDNode {
+    // DATA: The location and free capacity of the node's StorageUnit.
+    UnitHandle data;
+    // MAX_FREE: The largest free capacity in the node's subtree.
+    int max_free;
+    // SIZE: The number of nodes in the node's subtree.
+    int size;
+    // AXIS: The coordinate the node splits on. Left descendants have a coordinate <= the node's, right descendants >=.
+    int axis;
+    // LEFT, RIGHT, PARENT: Indices of the node's children and parent, or -1.
+    int left, right, parent;
+};
+
+//
+// CLASS: KDTree
+// A 2D tree over the locations of the Warehouse's StorageUnits, augmented with the largest free capacity of each subtree.
+// Subtrees without enough free capacity are skipped, so queries for "free space in this rectangle" and "the nearest
+// StorageUnit that fits" only visit the part of the floor that can answer them. The tree is kept balanced by rebuilding
+// the smallest unbalanced subtree after an insertion makes it too deep. Copying a KDTree is O(1): the copies share the
+// pages of nodes and the location index, and a change copies only the pages it writes to.
+//
+
+class KDTree {
+    public:
+        // CONSTRUCTORS
+        KDTree();
+
+        // FUNCTIONS
+
+        // INSERT: Add a StorageUnit to the tree, or update its free capacity if its location is already in the tree.
+        void insert(const UnitHandle& unit);
+        // UPDATE: Update the free capacity of the StorageUnit at a location.
+        void update(std::pair<int, int> loc, int free);
+        // RECTANGLE: Find every StorageUnit inside a rectangle with at least k free capacity.
+        void rectangle(std::pair<int, int> low, std::pair<int, int> high, int k, std::vector<UnitHandle>& results);
+        // NEAREST: Find the count StorageUnits closest to a location with at least k free capacity.
+        void nearest(std::pair<int, int> loc, int k, int count, std::vector<UnitHandle>& results);
+
+        // SIZE: Returns the number of StorageUnits in the tree.
+        int size() { return nodes.size(); }
+        // MEMORYUSAGE: Estimate the memory owned by the tree's nodes and by its location index.
+        void memoryUsage(MemoryUsage& nodes, MemoryUsage& index);
+
+    private:
+        // FUNCTIONS
+
+        // BUILD: Builds a balanced subtree from a list of nodes and returns its root.
+        int build(std::vector<int>& ids, int begin, int end, int axis, int parent);
+        // REBUILD: Rebuilds the subtree rooted at a node.
+        void rebuild(int node);
+        // COLLECT: Appends the nodes of a subtree to ids.
+        void collect(int node, std::vector<int>& ids);
+        // PULL: Recalculates a node's size and max_free from its children.
+        void pull(int node);
+        // RECTANGLE: Private recursive helper function for rectangle(...).
+        void rectangle(int node, std::pair<int, int> low, std::pair<int, int> high, int k, std::vector<UnitHandle>& results);
+        // NEAREST: Private recursive helper function for nearest(...).
+        void nearest(int node, std::pair<int, int> loc, int k, int count, std::vector<std::pair<int, int> >& best);
+        // CLOSER: Returns true if the (distance, node) pair a is closer than b.
+        bool closer(const std::pair<int, int>& a, const std::pair<int, int>& b);
+        // KEY: Returns the index key of a location.
+        static long long key(std::pair<int, int> loc) { return ((long long)loc.first << 32) | (unsigned int)loc.second; }
+        // COORD: Returns the XCoord (axis 0) or YCoord (axis 1) of a location.
+        static int coord(std::pair<int, int> loc, int axis) { return axis == 0 ? loc.first : loc.second; }
+
+        // MEMBER VARIABLES
+
+        // NODES: Every node of the tree, in pages shared with copies of the tree until they change.
+        PagedVector<KDNode> nodes;
+        // ROOT: The index of the root node, or -1 if the tree is empty.
+        int root = -1;
+        // INDEX: The index of each StorageUnit's node, keyed by its location.
+        PersistentMap<long long, int> index;
+};
+
+#endif
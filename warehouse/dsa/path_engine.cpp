@@ -0,0 +1,301 @@
+//
+// CSC 212 - Data Structures and Abstractions
+// Dominic Tucchio, Jennipher Day, Maya Geva, Thomas Williams
+// Spring 2024 Term Project - path_engine.cpp
+//
+
+#include "path_engine.h"
+#include "traffic.h"
+#include "../parallel.h"
+#include "../metrics/metrics.h"
+#include "../metrics/trace.h"
+
+#include <algorithm>
+#include <climits>
+#include <functional>
+#include <queue>
+
+//
+// CLASS: PathEngine
+// The graph builder and Dijkstra's Algorithm, specialized at compile time for a neighbourhood and an edge weight so
+// variants cost nothing at run time. Instantiated below for every combination of FourNeighbours or EightNeighbours with
+// CapacityWeight or ManhattanWeight; Algorithms uses FourNeighbours and CapacityWeight. The graph it builds and the graph
+// it searches must come from the same instantiation.
+//
+
+// FUNCTION: Builds a graph representing the Warehouse instance's layout. Each cell represents a node in the graph and
+// the edges represent the connections between neighboring cells. Adjacency lists are only stored for occupied cells; the
+// edges of open floor cells are calculated by dijkstra(...) as it reaches them. The adjacency lists of a large floor are
+// calculated in parallel, one band of chunk rows at a time, and added to the graph in band order, so the graph is the
+// same as one built row by row. The parameter is the Grid of StorageUnits. The function returns a Graph; the GraphEdge
+// structure and Graph type are defined in "path_engine.h".
+template<typename Neighbourhood, typename Weight>
+Graph PathEngine<Neighbourhood, Weight>::buildGraph(Grid& units) {
+    TRACE_SCOPE("graph rebuild");
+    METRICS_TIME(OP_BUILD_GRAPH);
+    METRICS_COUNT(GRAPH_REBUILDS);
+    Graph graph;
+    graph.reserve(units.size());
+
+    // Calculating the adjacency list of each StorageUnit within the Warehouse, along with its graph index.
+    int cols = units.getCols();
+    std::vector<std::vector<std::pair<int, std::vector<GraphEdge> > > > bands((units.getRows() + GridChunk::SIZE - 1) / GridChunk::SIZE);
+    parallelRows(units.getRows(), cols, GridChunk::SIZE, [&](int band, int first, int last){
+        units.forEachInRows(first, last, [&](const GridCell& u){
+            GraphEdge edges[DEGREE];
+            int n = neighbours(units, u.loc, edges);
+            bands[band].push_back({coordToIndex(u.loc, cols), std::vector<GraphEdge>(edges, edges + n)});
+            METRICS_ADD(GRAPH_EDGES_BUILT, n);
+        });
+    });
+    // Storing the adjacency lists in the graph.
+    for(std::vector<std::pair<int, std::vector<GraphEdge> > >& band : bands){
+        for(std::pair<int, std::vector<GraphEdge> >& node : band) graph.emplace(node.first, std::move(node.second));
+    }
+    // Returns the completed graph.
+    return graph;
+}
+
+// FUNCTION: Updates the graph after the StorageUnit at loc has changed. Edge weights may depend on both cells, so the
+// adjacency lists of the cell and of its occupied neighbors are recalculated; as the neighbourhood is symmetric, those
+// are the only cells with an edge to loc. The floor's extent must not have changed since the graph was
+// built, as that changes every graph index.
+template<typename Neighbourhood, typename Weight>
+void PathEngine<Neighbourhood, Weight>::updateGraph(Grid& units, Graph& graph, std::pair<int, int> loc) {
+    TRACE_SCOPE("graph update");
+    for(int k = -1; k < DEGREE; k++){
+        std::pair<int, int> cell = k < 0 ? loc : std::make_pair(loc.first + Neighbourhood::dx[k], loc.second + Neighbourhood::dy[k]);
+        if(!units.occupied(cell)) continue;
+
+        GraphEdge edges[DEGREE];
+        int n = neighbours(units, cell, edges);
+        graph[coordToIndex(cell, units.getCols())].assign(edges, edges + n);
+        METRICS_ADD(GRAPH_EDGES_BUILT, n);
+    }
+    return;
+}
+
+// REQUIRED ALGORITHM: Calculates the shortest path between two graph nodes using Dijkstra's Algorithm. Accepts parameters
+// units, the Grid of StorageUnit instances representing the warehouse, graph, the stored adjacency lists of the
+// occupied cells in the Warehouse instance, src_c, a pair of integers representing
+// the starting coordinates to search from, and dest_c, another pair of integers representing the destination's
+// coordinates. The function returns a pair consisting of an integer and a vector of integer pairs; the lone integer
+// represents the shortest distance between the two given graph nodes and the vector of integer pairs represents the
+// respective coordinates along the shortest path. The penalty is added to the weight of every edge the search relaxes;
+// with an ACTIVE penalty the length returned is that of the path found without its penalties. The search stops as soon
+// as the destination is visited, and only the tiles of SearchNodes it touches are allocated, so a short path on a large,
+// mostly open floor costs as much as it would on a small one.
+template<typename Neighbourhood, typename Weight>
+template<typename Penalty>
+std::pair<int, std::vector<std::pair<int, int> > > PathEngine<Neighbourhood, Weight>::dijkstra(Grid& units, Graph& graph, std::pair<int, int> src_c, std::pair<int, int> dest_c, const Penalty& penalty) {
+    TRACE_SCOPE("path search");
+    METRICS_TIME(OP_DIJKSTRA);
+    METRICS_COUNT(DIJKSTRA_RUNS);
+    // Converting the Warehouse coordinates to their respective graph index. Every cell of the floor's extent
+    // is a node of the graph.
+    int cols = units.getCols();
+    int src = coordToIndex(src_c, cols);
+    int dest = coordToIndex(dest_c, cols);
+    // The distance from the source node, the previous node in the shortest path, and whether the node has been visited,
+    // for each node the search touches.
+    SearchNodes nodes;
+
+    // Priority queue to store the graph edges, prioritized based on their weights. The edge with the smallest weight
+    // will be at the top of the queue.
+    std::priority_queue<GraphEdge, std::vector<GraphEdge>, std::greater<GraphEdge> > p_queue;
+
+    // Marking the distance from the source node to itself as 0 and pushing the source node to the queue to begin traversal.
+    nodes[src].distance = 0;
+    p_queue.push(GraphEdge({src, src, 0}));
+    METRICS_COUNT(HEAP_PUSHES);
+
+    // Primary loop for Dijkstra's Algorithm.
+    while(!p_queue.empty()){
+        GraphEdge current = p_queue.top();
+        p_queue.pop();
+        METRICS_COUNT(HEAP_POPS);
+
+        // Checking if the current node has already been visited and marking it as visited if not. Once the destination
+        // is visited its distance is final.
+        SearchNode& at = nodes[current.dest];
+        if(at.visited) continue;
+        at.visited = true;
+        if(current.dest == dest) break;
+        int at_distance = at.distance;
+
+        // Finding the edges leaving the current node. Occupied cells use their stored adjacency list and open floor
+        // cells have their edges calculated from the Grid.
+        GraphEdge floor_edges[DEGREE];
+        GraphEdge* edges = floor_edges;
+        int n_edges;
+        Graph::iterator stored = graph.find(current.dest);
+        if(stored != graph.end()){
+            edges = stored->second.data();
+            n_edges = stored->second.size();
+        } else n_edges = neighbours(units, indexToCoordinates(current.dest, cols), floor_edges);
+
+        // Traversing the nodes connected to the current node.
+        for(int k = 0; k < n_edges; k++){
+            GraphEdge& e = edges[k];
+            int weight = e.weight + penalty(current.dest, e.dest);
+            SearchNode& next = nodes[e.dest];
+            // If the neighboring node has not been visited and the distance to that node through the current edge is
+            // less than the previously recorded distance, the distance to that node is updated with the shorter distance.
+            if(!next.visited && at_distance + weight < next.distance) {
+                // Update the distance to the next node with the new shorter distance.
+                next.distance = at_distance + weight;
+                // Update the previous node.
+                next.previous = current.dest;
+                // The GraphEdge is added to the queue.
+                p_queue.push(GraphEdge({current.dest, e.dest, next.distance}));
+                METRICS_COUNT(EDGES_RELAXED);
+                METRICS_COUNT(HEAP_PUSHES);
+            }
+        }
+    }
+
+    // Reconstructing the shortest path between the two given points.
+    std::vector<std::pair<int, int> > shortest_path;
+    int index = dest;
+
+    // Traverse the vector containing previous nodes backward.
+    while(index != src){
+        // Convert the index back to Warehouse coordinates.
+        std::pair<int, int> loc = indexToCoordinates(index, cols);
+
+        shortest_path.push_back({loc.first, loc.second});
+        index = nodes[index].previous;
+    }
+
+    // Adding the coordinates for the source StorageUnit to the vector.
+    shortest_path.push_back({src_c.first, src_c.second});
+    // Reverse the order of coordinates to return the correct order.
+    std::reverse(shortest_path.begin(), shortest_path.end());
+
+    // Without penalties the distance found is the path's length; otherwise the length is added up step by step.
+    int length = nodes[dest].distance;
+    if(Penalty::ACTIVE){
+        length = 0;
+        for(int s = 1; s < (int)shortest_path.size(); s++){
+            std::pair<int, int> a = shortest_path[s - 1], b = shortest_path[s];
+            length += Weight::weight(units, a, b, std::abs(a.first - b.first) + std::abs(a.second - b.second));
+        }
+    }
+
+    // Returning the int for the distance of the shortest path and the vector of nodes traversed.
+    return {length, shortest_path};
+}
+
+// FUNCTION: Runs Dijkstra's Algorithm from src over the whole floor. Accepts parameters units, graph, and src, the graph
+// index of the starting cell. Returns the distance to every cell by graph index; cells not reached are at distance
+// INT_MAX. The result covers every cell of the floor, so it is only used where every cell is needed.
+template<typename Neighbourhood, typename Weight>
+std::vector<int> PathEngine<Neighbourhood, Weight>::distances(Grid& units, Graph& graph, int src) {
+    TRACE_SCOPE("path search");
+    METRICS_COUNT(DIJKSTRA_RUNS);
+    int cols = units.getCols();
+    int nodes = indexCount(units.getRows(), cols);
+    std::vector<int> distance(nodes, INT_MAX);
+    std::vector<bool> visited(nodes, false);
+
+    std::priority_queue<GraphEdge, std::vector<GraphEdge>, std::greater<GraphEdge> > p_queue;
+    distance[src] = 0;
+    p_queue.push(GraphEdge({src, src, 0}));
+    while(!p_queue.empty()){
+        GraphEdge current = p_queue.top();
+        p_queue.pop();
+        METRICS_COUNT(HEAP_POPS);
+        if(visited[current.dest]) continue;
+        visited[current.dest] = true;
+
+        GraphEdge floor_edges[DEGREE];
+        GraphEdge* edges = floor_edges;
+        int n_edges;
+        Graph::iterator stored = graph.find(current.dest);
+        if(stored != graph.end()){
+            edges = stored->second.data();
+            n_edges = stored->second.size();
+        } else n_edges = neighbours(units, indexToCoordinates(current.dest, cols), floor_edges);
+
+        for(int k = 0; k < n_edges; k++){
+            GraphEdge& e = edges[k];
+            if(!visited[e.dest] && distance[current.dest] + e.weight < distance[e.dest]) {
+                distance[e.dest] = distance[current.dest] + e.weight;
+                p_queue.push(GraphEdge({current.dest, e.dest, distance[e.dest]}));
+                METRICS_COUNT(EDGES_RELAXED);
+                METRICS_COUNT(HEAP_PUSHES);
+            }
+        }
+    }
+    return distance;
+}
+
+// FUNCTION: Runs Dijkstra's Algorithm from src_c until every target has been visited. Only the tiles of SearchNodes the
+// search touches are allocated, as in dijkstra(...). Accepts parameters units, graph, src_c, the starting cell, and
+// targets, the cells to measure to. Returns the distance to each target in the same order; a target that cannot be
+// reached is at distance INT_MAX.
+template<typename Neighbourhood, typename Weight>
+std::vector<int> PathEngine<Neighbourhood, Weight>::distances(Grid& units, Graph& graph, std::pair<int, int> src_c, const std::vector<std::pair<int, int> >& targets) {
+    TRACE_SCOPE("path search");
+    METRICS_COUNT(DIJKSTRA_RUNS);
+    int cols = units.getCols();
+    SearchNodes nodes;
+    // Counting the targets still to be reached; a cell listed more than once only counts once.
+    std::vector<int> wanted;
+    for(std::pair<int, int> t : targets) wanted.push_back(coordToIndex(t, cols));
+    std::sort(wanted.begin(), wanted.end());
+    wanted.erase(std::unique(wanted.begin(), wanted.end()), wanted.end());
+    int remaining = wanted.size();
+
+    std::priority_queue<GraphEdge, std::vector<GraphEdge>, std::greater<GraphEdge> > p_queue;
+    int src = coordToIndex(src_c, cols);
+    nodes[src].distance = 0;
+    p_queue.push(GraphEdge({src, src, 0}));
+    while(!p_queue.empty() && remaining != 0){
+        GraphEdge current = p_queue.top();
+        p_queue.pop();
+        METRICS_COUNT(HEAP_POPS);
+        SearchNode& at = nodes[current.dest];
+        if(at.visited) continue;
+        at.visited = true;
+        if(std::binary_search(wanted.begin(), wanted.end(), current.dest)) remaining--;
+        int at_distance = at.distance;
+
+        GraphEdge floor_edges[DEGREE];
+        GraphEdge* edges = floor_edges;
+        int n_edges;
+        Graph::iterator stored = graph.find(current.dest);
+        if(stored != graph.end()){
+            edges = stored->second.data();
+            n_edges = stored->second.size();
+        } else n_edges = neighbours(units, indexToCoordinates(current.dest, cols), floor_edges);
+
+        for(int k = 0; k < n_edges; k++){
+            GraphEdge& e = edges[k];
+            SearchNode& next = nodes[e.dest];
+            if(!next.visited && at_distance + e.weight < next.distance) {
+                next.distance = at_distance + e.weight;
+                p_queue.push(GraphEdge({current.dest, e.dest, next.distance}));
+                METRICS_COUNT(EDGES_RELAXED);
+                METRICS_COUNT(HEAP_PUSHES);
+            }
+        }
+    }
+
+    std::vector<int> results;
+    for(std::pair<int, int> t : targets) results.push_back(nodes.distance(coordToIndex(t, cols)));
+    return results;
+}
+
+// EXPLICIT INSTANTIATIONS: The neighbourhood and weight combinations compiled into the library.
+template class PathEngine<FourNeighbours, CapacityWeight>;
+template class PathEngine<FourNeighbours, ManhattanWeight>;
+template class PathEngine<EightNeighbours, CapacityWeight>;
+template class PathEngine<EightNeighbours, ManhattanWeight>;
+
+// EXPLICIT INSTANTIATIONS: The searches with a penalty. Traffic is only counted on the Warehouse's own graph.
+template std::pair<int, std::vector<std::pair<int, int> > > PathEngine<FourNeighbours, CapacityWeight>::dijkstra<NoPenalty>(Grid&, Graph&, std::pair<int, int>, std::pair<int, int>, const NoPenalty&);
+template std::pair<int, std::vector<std::pair<int, int> > > PathEngine<FourNeighbours, ManhattanWeight>::dijkstra<NoPenalty>(Grid&, Graph&, std::pair<int, int>, std::pair<int, int>, const NoPenalty&);
+template std::pair<int, std::vector<std::pair<int, int> > > PathEngine<EightNeighbours, CapacityWeight>::dijkstra<NoPenalty>(Grid&, Graph&, std::pair<int, int>, std::pair<int, int>, const NoPenalty&);
+template std::pair<int, std::vector<std::pair<int, int> > > PathEngine<EightNeighbours, ManhattanWeight>::dijkstra<NoPenalty>(Grid&, Graph&, std::pair<int, int>, std::pair<int, int>, const NoPenalty&);
+template std::pair<int, std::vector<std::pair<int, int> > > PathEngine<FourNeighbours, CapacityWeight>::dijkstra<TrafficMap>(Grid&, Graph&, std::pair<int, int>, std::pair<int, int>, const TrafficMap&);
@@ -0,0 +1,255 @@
+//
+// CSC 212 - Data Structures and Abstractions
+// Dominic Tucchio, Jennipher Day, Maya Geva, Thomas Williams
+// Spring 2024 Term Project - path_engine.h
+//
+
+#ifndef PathEngine_H
+#define PathEngine_H
+
+#include "grid.h"
+
+#include <climits>
+#include <cmath>
+#include <cstdlib>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+//
+// STRUCTURE: GraphEdge
+// Represents an edge in a graph. Contains the index of the source node, the index of the destination node, and the
+// distance (weight) between nodes. These values are all stored as integers. The index for the source node and destination
+// node are converted from the standard (x,y) coordinates used in the main Warehouse instance.
+//
+
+struct GraphEdge {
+    int src, dest, weight;
+};
+
+// OPERATOR OVERLOAD: Allows the usage of the ">" operator on GraphEdge structures. Compares the two instances based on
+// their weights.
+inline bool operator>(const GraphEdge& a, const GraphEdge& b) {
+    return a.weight > b.weight;
+}
+
+//
+// TYPE: Graph
+// Adjacency lists of the Warehouse graph, keyed by graph index. Only occupied cells have stored adjacency lists; the
+// edges of open floor cells are derived from the Grid when they are needed, so the graph's size is proportional to the
+// number of StorageUnits rather than to the area of the floor.
+//
+
+typedef std::unordered_map<int, std::vector<GraphEdge> > Graph;
+
+//
+// CELL LAYOUT
+// Graph indices number the floor tile by tile, in the same 16 x 16 tiles as the Grid's GridChunks, with tiles in
+// row-major order and the cells of a tile in Z-order: a cell's position within its tile interleaves the bits of its row
+// and column. Cells that are close on the floor get close indices whichever way they are apart, so the arrays a search
+// indexes by graph index are read a few tiles at a time around its frontier instead of one cache line per row the
+// frontier spans. The right and lower neighbors of a cell always have larger indices than the cell. The indices cover
+// the floor rounded up to whole tiles; those of cells past its edges are never reached.
+//
+
+// FUNCTION: Spreads the 4 low bits of v to the even bits of a byte.
+inline int spreadTileBits(int v){
+    v = (v | (v << 2)) & 0x33;
+    return (v | (v << 1)) & 0x55;
+}
+
+// FUNCTION: Gathers the even bits of a byte into its 4 low bits.
+inline int gatherTileBits(int v){
+    v &= 0x55;
+    v = (v | (v >> 1)) & 0x33;
+    return (v | (v >> 2)) & 0x0F;
+}
+
+// FUNCTION: Returns the number of tiles in a row of tiles of a floor cols cells wide.
+inline int tileColumns(int cols){
+    return (cols + GridChunk::SIZE - 1) >> GridChunk::BITS;
+}
+
+// FUNCTION: Converts the coordinates of a cell to its graph index on a floor cols cells wide.
+inline int coordToIndex(std::pair<int, int> loc, int cols){
+    int tile = (loc.first >> GridChunk::BITS) * tileColumns(cols) + (loc.second >> GridChunk::BITS);
+    int within = (spreadTileBits(loc.first & (GridChunk::SIZE - 1)) << 1) | spreadTileBits(loc.second & (GridChunk::SIZE - 1));
+    return tile * GridChunk::CELLS + within;
+}
+
+// FUNCTION: Converts a graph index back to the coordinates of its cell on a floor cols cells wide.
+inline std::pair<int, int> indexToCoordinates(int idx, int cols){
+    int tile = idx / GridChunk::CELLS, within = idx % GridChunk::CELLS;
+    int tile_cols = tileColumns(cols);
+    return {((tile / tile_cols) << GridChunk::BITS) | gatherTileBits(within >> 1), ((tile % tile_cols) << GridChunk::BITS) | gatherTileBits(within)};
+}
+
+// FUNCTION: Returns the number of graph indices of a floor of rows x cols cells, the size of an array indexed by them.
+inline int indexCount(int rows, int cols){
+    return ((rows + GridChunk::SIZE - 1) >> GridChunk::BITS) * tileColumns(cols) * GridChunk::CELLS;
+}
+
+//
+// STRUCTURE: SearchNode
+// What a search knows about one graph node: its distance from the source, the node it was reached from, and whether it
+// has been visited.
+//
+
+struct SearchNode {
+    int distance = INT_MAX;
+    int previous = -1;
+    bool visited = false;
+};
+
+//
+// CLASS: SearchNodes
+// The SearchNodes of the cells a single search has touched, allocated one tile of GridChunk::CELLS nodes at a time.
+// Graph indices number the floor tile by tile, so a tile's nodes are contiguous and a search around its frontier finds
+// them in a few tiles. Memory grows with the area the search reaches rather than with the floor.
+//
+
+class SearchNodes {
+    public:
+        // FUNCTION: Returns the SearchNode of a graph index, allocating its tile the first time it is touched.
+        SearchNode& operator[](int index){
+            int tile = index / GridChunk::CELLS;
+            if(tile != last_tile){
+                std::unique_ptr<SearchNode[]>& nodes = tiles[tile];
+                if(!nodes) nodes.reset(new SearchNode[GridChunk::CELLS]);
+                last_tile = tile;
+                last_nodes = nodes.get();
+            }
+            return last_nodes[index % GridChunk::CELLS];
+        }
+        // FUNCTION: Returns the distance of a graph index, or INT_MAX if the search has not reached it.
+        int distance(int index) const {
+            std::unordered_map<int, std::unique_ptr<SearchNode[]> >::const_iterator found = tiles.find(index / GridChunk::CELLS);
+            return found == tiles.end() ? INT_MAX : found->second[index % GridChunk::CELLS].distance;
+        }
+
+    private:
+        // TILES: The allocated tiles, keyed by graph index divided by GridChunk::CELLS.
+        std::unordered_map<int, std::unique_ptr<SearchNode[]> > tiles;
+        // LAST_TILE, LAST_NODES: The tile touched last, as consecutive lookups are usually in the same tile.
+        int last_tile = -1;
+        SearchNode* last_nodes = nullptr;
+};
+
+//
+// NEIGHBOURHOOD POLICIES
+// The cells a path may step to from a cell, as a table of offsets known at compile time so the loops over them can be
+// unrolled. Every neighbourhood must be symmetric: if (dx, dy) is a step, so is (-dx, -dy).
+//
+
+// STRUCTURE: FourNeighbours
+// Steps to the four cells sharing a side. The Warehouse's own graph, the HierarchicalGraph, and the ContractionHierarchy
+// all use this neighbourhood.
+struct FourNeighbours {
+    static constexpr int COUNT = 4;
+    static constexpr int dx[COUNT] = {0, 0, 1, -1};
+    static constexpr int dy[COUNT] = {1, -1, 0, 0};
+};
+
+// STRUCTURE: EightNeighbours
+// Steps to the four cells sharing a side and to the four diagonal cells.
+struct EightNeighbours {
+    static constexpr int COUNT = 8;
+    static constexpr int dx[COUNT] = {0, 0, 1, -1, 1, 1, -1, -1};
+    static constexpr int dy[COUNT] = {1, -1, 0, 0, 1, -1, 1, -1};
+};
+
+//
+// WEIGHT POLICIES
+// The weight of a step between two neighboring cells. weight(...) is given the Grid, both cells, and the Manhattan
+// length of the step (1 for a side, 2 for a diagonal), and is inlined into the graph builder and the searches.
+//
+
+// STRUCTURE: CapacityWeight
+// The Manhattan length of the step plus the side length of the StorageUnit in each cell. Assuming the theoretical
+// StorageUnit takes the shape of a square, the length of a side can be found by taking the square root of the capacity,
+// or area. Open floor cells count as a capacity of 0.
+struct CapacityWeight {
+    // FUNCTION: Returns the weight a cell with the given capacity adds to each edge that touches it.
+    static int cell(int capacity) { return (int)std::sqrt(capacity); }
+    // FUNCTION: Returns the weight of a step from a to b.
+    static int weight(Grid& units, std::pair<int, int> a, std::pair<int, int> b, int step){
+        return step + cell(units.capacityAt(a)) + cell(units.capacityAt(b));
+    }
+};
+
+// STRUCTURE: ManhattanWeight
+// The Manhattan length of the step alone; StorageUnits cost nothing to pass.
+struct ManhattanWeight {
+    // FUNCTION: Returns the weight of a step from a to b.
+    static int weight(Grid&, std::pair<int, int>, std::pair<int, int>, int step) { return step; }
+};
+
+//
+// PENALTY POLICIES
+// Weight added to an edge at search time, on top of the weight stored in the graph, given the graph indices of both
+// cells. ACTIVE is false if the penalty is always 0, so the search can skip working out the path's own length.
+//
+
+// STRUCTURE: NoPenalty
+// Leaves every edge at its stored weight.
+struct NoPenalty {
+    static constexpr bool ACTIVE = false;
+    int operator()(int, int) const { return 0; }
+};
+
+//
+// CLASS: PathEngine
+// The graph builder and Dijkstra's Algorithm, specialized at compile time for a neighbourhood and an edge weight so
+// variants cost nothing at run time. Instantiated in path_engine.cpp for every combination of FourNeighbours or
+// EightNeighbours with CapacityWeight or ManhattanWeight; Algorithms uses FourNeighbours and CapacityWeight. The graph
+// it builds and the graph it searches must come from the same instantiation.
+//
+
+template<typename Neighbourhood, typename Weight>
+class PathEngine {
+    public:
+        // DEGREE: The most edges leaving a cell.
+        static constexpr int DEGREE = Neighbourhood::COUNT;
+
+        // FUNCTIONS
+
+        // FUNCTION: Fills edges with the edges leaving a cell and returns their number.
+        static int neighbours(Grid& units, std::pair<int, int> loc, GraphEdge edges[DEGREE]);
+        // FUNCTION: Construct the adjacency lists of the occupied cells of the floor.
+        static Graph buildGraph(Grid& units);
+        // FUNCTION: Update the adjacency lists affected by a change to a single StorageUnit.
+        static void updateGraph(Grid& units, Graph& graph, std::pair<int, int> loc);
+        // FUNCTION: Find the shortest distance between two cells and the cells along the path.
+        static std::pair<int, std::vector<std::pair<int, int> > > dijkstra(Grid& units, Graph& graph, std::pair<int, int> src_c, std::pair<int, int> dest_c) { return dijkstra(units, graph, src_c, dest_c, NoPenalty()); }
+        // FUNCTION: Find the path between two cells that is shortest with a penalty added to each edge, and its length
+        // without the penalty. Instantiated for NoPenalty and TrafficMap.
+        template<typename Penalty>
+        static std::pair<int, std::vector<std::pair<int, int> > > dijkstra(Grid& units, Graph& graph, std::pair<int, int> src_c, std::pair<int, int> dest_c, const Penalty& penalty);
+        // FUNCTION: Find the shortest distance from one cell to every cell of the floor.
+        static std::vector<int> distances(Grid& units, Graph& graph, int src);
+        // FUNCTION: Find the shortest distance from one cell to each of several others, stopping once all are reached.
+        static std::vector<int> distances(Grid& units, Graph& graph, std::pair<int, int> src_c, const std::vector<std::pair<int, int> >& targets);
+};
+
+// FUNCTION: Calculates the edges leaving a single cell. Each neighboring cell inside the floor's extent gets
+// an edge weighted by the weight policy. The loop runs over a constant table, so the compiler unrolls it.
+template<typename Neighbourhood, typename Weight>
+inline int PathEngine<Neighbourhood, Weight>::neighbours(Grid& units, std::pair<int, int> loc, GraphEdge edges[DEGREE]){
+    int cols = units.getCols();
+    int src = coordToIndex(loc, cols);
+    int n = 0;
+    for(int k = 0; k < DEGREE; k++){
+        std::pair<int, int> next = {loc.first + Neighbourhood::dx[k], loc.second + Neighbourhood::dy[k]};
+        int step = std::abs(Neighbourhood::dx[k]) + std::abs(Neighbourhood::dy[k]);
+        if(units.inBounds(next)) edges[n++] = {src, coordToIndex(next, cols), Weight::weight(units, loc, next, step)};
+    }
+    return n;
+}
+
+// EXPLICIT INSTANTIATIONS: Compiled once in path_engine.cpp.
+extern template class PathEngine<FourNeighbours, CapacityWeight>;
+extern template class PathEngine<FourNeighbours, ManhattanWeight>;
+extern template class PathEngine<EightNeighbours, CapacityWeight>;
+extern template class PathEngine<EightNeighbours, ManhattanWeight>;
+
+#endif
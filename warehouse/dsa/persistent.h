@@ -0,0 +1,368 @@
+//
+// CSC 212 - Data Structures and Abstractions
+// Dominic Tucchio, Jennipher Day, Maya Geva, Thomas Williams
+// Spring 2024 Term Project - persistent.h
+//
+
+#ifndef Persistent_H
+#define Persistent_H
+
+#include "../metrics/memory.h"
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <vector>
+
+//
+// COPY ON WRITE
+// Structures built from shared_ptr links can be copied in O(1) by copying their root links; the copies then share every
+// node. Before a node is changed, own(...) gives the link its own copy of the node if any other link still refers to
+// it, so changes never show through another copy. A node held by a single link is changed in place, so a structure
+// that was never copied allocates no more than it did before.
+//
+
+// FUNCTION: Returns true if link is the only reference to its object, so the object can be changed in place. Another
+// copy may have dropped its reference on another thread just before; the fence orders that copy's reads before the
+// change. ThreadSanitizer does not model fences, so its builds take and drop a reference instead, which synchronizes
+// with the other copy's release through the reference count itself.
+template<typename T>
+inline bool exclusive(const std::shared_ptr<T>& link){
+    if(link.use_count() != 1) return false;
+#if defined(__SANITIZE_THREAD__)
+    { std::shared_ptr<T> probe = link; }
+#else
+    std::atomic_thread_fence(std::memory_order_acquire);
+#endif
+    return true;
+}
+
+// FUNCTION: Gives link its own copy of its object if the object is shared, and returns the object. link must not be null.
+template<typename T>
+inline T& own(std::shared_ptr<T>& link){
+    if(!exclusive(link)) link = std::make_shared<T>(*link);
+    return *link;
+}
+
+// FUNCTION: Estimates the heap memory of n objects of type T allocated by std::make_shared, each in one block with its
+// reference counts.
+template<typename T>
+inline MemoryUsage estimateShared(size_t n){
+    MemoryUsage m;
+    m.bytes = n * (sizeof(T) + SHARED_BLOCK_OVERHEAD);
+    m.allocations = n;
+    return m;
+}
+
+//
+// CLASS: PersistentMap
+// An ordered map kept as an AVL tree of shared nodes. Copying a PersistentMap is O(1) and the copies share their nodes;
+// a change copies only the O(log n) nodes on the path to the key it touches (path copying) that are still shared, and
+// changes nodes that are not shared in place. Keys are ordered by Less.
+//
+
+template<typename K, typename V, typename Less = std::less<K> >
+class PersistentMap {
+    public:
+        // FUNCTIONS
+
+        // FUNCTION: Returns the value stored under key, or nullptr if there is none.
+        const V* find(const K& key) const;
+        // FUNCTION: Returns the value stored under key, which only this map refers to and may be changed, or nullptr.
+        V* edit(const K& key);
+        // FUNCTION: Returns the value stored under key, which may be changed, inserting a default value if there is none.
+        V& emplace(const K& key);
+        // FUNCTION: Stores value under key.
+        void set(const K& key, const V& value) { emplace(key) = value; }
+        // FUNCTION: Removes key and its value. Returns false if the key was not in the map.
+        bool erase(const K& key);
+        // FUNCTION: Returns the value of the smallest key, or nullptr if the map is empty.
+        const V* first() const;
+
+        // FUNCTION: Calls f(key, value) for every entry in key order.
+        template<typename F>
+        void forEach(F f) const { forEach(root.get(), f); }
+
+        // FUNCTION: Returns the number of entries.
+        int size() const { return root == nullptr ? 0 : root->count; }
+        // FUNCTION: Returns true if the map has no entries.
+        bool empty() const { return root == nullptr; }
+        // FUNCTION: Returns the estimated heap memory of the map's nodes, counting nodes shared with other copies.
+        MemoryUsage memoryUsage() const { return estimateShared<Node>(size()); }
+
+    private:
+        // STRUCTURE: Node
+        // An entry of the map, with the height of its subtree and the number of entries in it.
+        struct Node {
+            K key;
+            V value;
+            std::shared_ptr<Node> left, right;
+            int height = 1;
+            int count = 1;
+        };
+        typedef std::shared_ptr<Node> Link;
+
+        // FUNCTION: Recursive helpers for emplace(...) and erase(...). Each takes the link to a subtree, owns the nodes
+        // it changes, and rebalances the subtree on the way back up.
+        V& emplace(Link& node, const K& key);
+        bool erase(Link& node, const K& key);
+        // FUNCTION: Unlinks the smallest node of a subtree into min.
+        void removeMin(Link& node, Link& min);
+        // FUNCTION: Recalculates a node's height and count from its children.
+        static void pull(Node& node);
+        // FUNCTION: Restores the AVL property at a node after one of its subtrees changed.
+        static void balance(Link& node);
+        // FUNCTION: Rotate a subtree, making the node's right (left) child the subtree's root.
+        static void rotateLeft(Link& node);
+        static void rotateRight(Link& node);
+        // FUNCTION: Returns the height of a subtree.
+        static int height(const Link& node) { return node == nullptr ? 0 : node->height; }
+        // FUNCTION: Recursive helper for forEach(...).
+        template<typename F>
+        static void forEach(const Node* node, F& f);
+
+        // MEMBER VARIABLES
+
+        // ROOT: The root of the tree, or null if the map is empty.
+        Link root;
+        // LESS: The ordering of the keys.
+        Less less;
+};
+
+// FUNCTION: Returns the value stored under key by descending the tree, or nullptr if there is none.
+template<typename K, typename V, typename Less>
+const V* PersistentMap<K, V, Less>::find(const K& key) const {
+    for(const Node* node = root.get(); node != nullptr;){
+        if(less(key, node->key)) node = node->left.get();
+        else if(less(node->key, key)) node = node->right.get();
+        else return &node->value;
+    }
+    return nullptr;
+}
+
+// FUNCTION: Returns the value stored under key so it can be changed. Every node on the path to it that is shared with
+// another copy is copied first. Returns nullptr, copying nothing, if the key is not in the map.
+template<typename K, typename V, typename Less>
+V* PersistentMap<K, V, Less>::edit(const K& key){
+    if(find(key) == nullptr) return nullptr;
+    Link* node = &root;
+    while(true){
+        Node& n = own(*node);
+        if(less(key, n.key)) node = &n.left;
+        else if(less(n.key, key)) node = &n.right;
+        else return &n.value;
+    }
+}
+
+// FUNCTION: Returns the value stored under key so it can be changed, inserting a default value first if there is none.
+// A key already in the map is found with edit(...), so no node is allocated unless one is shared or the key is new.
+template<typename K, typename V, typename Less>
+V& PersistentMap<K, V, Less>::emplace(const K& key){
+    V* found = edit(key);
+    return found != nullptr ? *found : emplace(root, key);
+}
+
+// FUNCTION: Inserts a new key below node and returns its value. The new node's value is found again after rebalancing,
+// as rotations move nodes but never copy them.
+template<typename K, typename V, typename Less>
+V& PersistentMap<K, V, Less>::emplace(Link& node, const K& key){
+    if(node == nullptr){
+        node = std::make_shared<Node>();
+        node->key = key;
+        return node->value;
+    }
+    Node& n = own(node);
+    V& value = emplace(less(key, n.key) ? n.left : n.right, key);
+    balance(node);
+    return value;
+}
+
+// FUNCTION: Removes key and its value. Returns false, changing nothing, if the key is not in the map.
+template<typename K, typename V, typename Less>
+bool PersistentMap<K, V, Less>::erase(const K& key){
+    if(find(key) == nullptr) return false;
+    return erase(root, key);
+}
+
+// FUNCTION: Removes key from the subtree below node. A node with two children is replaced by the smallest node of its
+// right subtree. A node with one child is replaced by that subtree as it is; it may be shared, so it is not rebalanced.
+template<typename K, typename V, typename Less>
+bool PersistentMap<K, V, Less>::erase(Link& node, const K& key){
+    Node& n = own(node);
+    if(less(key, n.key)) erase(n.left, key);
+    else if(less(n.key, key)) erase(n.right, key);
+    else if(n.left == nullptr){
+        node = Link(n.right);
+        return true;
+    }
+    else if(n.right == nullptr){
+        node = Link(n.left);
+        return true;
+    }
+    else {
+        Link min;
+        removeMin(n.right, min);
+        min->left = std::move(n.left);
+        min->right = std::move(n.right);
+        node = std::move(min);
+    }
+    balance(node);
+    return true;
+}
+
+// FUNCTION: Unlinks the smallest node of the subtree below node into min, which then only min refers to.
+template<typename K, typename V, typename Less>
+void PersistentMap<K, V, Less>::removeMin(Link& node, Link& min){
+    Node& n = own(node);
+    if(n.left == nullptr){
+        min = node;
+        node = std::move(n.right);
+        return;
+    }
+    removeMin(n.left, min);
+    balance(node);
+    return;
+}
+
+// FUNCTION: Returns the value of the smallest key, or nullptr if the map is empty.
+template<typename K, typename V, typename Less>
+const V* PersistentMap<K, V, Less>::first() const {
+    const Node* node = root.get();
+    if(node == nullptr) return nullptr;
+    while(node->left != nullptr) node = node->left.get();
+    return &node->value;
+}
+
+// FUNCTION: Recalculates a node's height and count from its children.
+template<typename K, typename V, typename Less>
+void PersistentMap<K, V, Less>::pull(Node& node){
+    node.height = 1 + std::max(height(node.left), height(node.right));
+    node.count = 1 + (node.left == nullptr ? 0 : node.left->count) + (node.right == nullptr ? 0 : node.right->count);
+    return;
+}
+
+// FUNCTION: Rotates a subtree to the left. Both nodes that change are owned first.
+template<typename K, typename V, typename Less>
+void PersistentMap<K, V, Less>::rotateLeft(Link& node){
+    Node& n = own(node);
+    own(n.right);
+    Link right = n.right;
+    n.right = right->left;
+    pull(n);
+    right->left = node;
+    node = right;
+    pull(*node);
+    return;
+}
+
+// FUNCTION: Rotates a subtree to the right. Both nodes that change are owned first.
+template<typename K, typename V, typename Less>
+void PersistentMap<K, V, Less>::rotateRight(Link& node){
+    Node& n = own(node);
+    own(n.left);
+    Link left = n.left;
+    n.left = left->right;
+    pull(n);
+    left->right = node;
+    node = left;
+    pull(*node);
+    return;
+}
+
+// FUNCTION: Recalculates an owned node and rotates its subtree if the heights of its children differ by more than one.
+template<typename K, typename V, typename Less>
+void PersistentMap<K, V, Less>::balance(Link& node){
+    Node& n = *node;
+    pull(n);
+    if(height(n.left) > height(n.right) + 1){
+        if(height(n.left->left) < height(n.left->right)) rotateLeft(n.left);
+        rotateRight(node);
+    } else if(height(n.right) > height(n.left) + 1){
+        if(height(n.right->right) < height(n.right->left)) rotateRight(n.right);
+        rotateLeft(node);
+    }
+    return;
+}
+
+// FUNCTION: Calls f(key, value) for every entry of a subtree in key order.
+template<typename K, typename V, typename Less>
+template<typename F>
+void PersistentMap<K, V, Less>::forEach(const Node* node, F& f){
+    if(node == nullptr) return;
+    forEach(node->left.get(), f);
+    f(node->key, node->value);
+    forEach(node->right.get(), f);
+    return;
+}
+
+//
+// CLASS: PagedVector
+// A vector whose elements are stored in fixed-size pages reached through a shared page table. Copying a PagedVector is
+// O(1) and the copies share the table and every page; changing an element through edit(...) copies the table and the
+// element's page first if they are still shared, so a copy that changes k elements owns at most k pages of its own.
+// Elements must be default constructible.
+//
+
+template<typename T, int BITS = 6>
+class PagedVector {
+    public:
+        static constexpr int PAGE = 1 << BITS;
+
+        // FUNCTIONS
+
+        // FUNCTION: Returns element i.
+        const T& operator[](int i) const { return (*table)[i >> BITS]->values[i & (PAGE - 1)]; }
+        // FUNCTION: Returns element i so it can be changed, copying its page if the page is shared.
+        T& edit(int i) { return own(own(table)[i >> BITS]).values[i & (PAGE - 1)]; }
+        // FUNCTION: Appends an element.
+        void push_back(const T& value);
+        // FUNCTION: Removes every element.
+        void clear();
+
+        // FUNCTION: Returns the number of elements.
+        int size() const { return count; }
+        // FUNCTION: Returns the estimated heap memory of the page table and the pages, counting pages shared with other copies.
+        MemoryUsage memoryUsage() const;
+
+    private:
+        // STRUCTURE: Page
+        // PAGE consecutive elements.
+        struct Page {
+            T values[PAGE];
+        };
+        typedef std::vector<std::shared_ptr<Page> > Table;
+
+        // MEMBER VARIABLES
+
+        // TABLE: The pages in order.
+        std::shared_ptr<Table> table = std::make_shared<Table>();
+        // COUNT: The number of elements.
+        int count = 0;
+};
+
+// FUNCTION: Appends an element, adding a page when the last one is full.
+template<typename T, int BITS>
+void PagedVector<T, BITS>::push_back(const T& value){
+    if((count & (PAGE - 1)) == 0 && (count >> BITS) == (int)table->size()) own(table).push_back(std::make_shared<Page>());
+    edit(count++) = value;
+    return;
+}
+
+// FUNCTION: Removes every element. Pages shared with other copies are left to them.
+template<typename T, int BITS>
+void PagedVector<T, BITS>::clear(){
+    table = std::make_shared<Table>();
+    count = 0;
+    return;
+}
+
+// FUNCTION: Returns the estimated heap memory of the page table and the pages.
+template<typename T, int BITS>
+MemoryUsage PagedVector<T, BITS>::memoryUsage() const {
+    MemoryUsage m = estimateShared<Table>(1);
+    m += estimateVector(*table);
+    m += estimateShared<Page>(table->size());
+    return m;
+}
+
+#endif
@@ -5,139 +5,373 @@
 //
 
 #include "range_tree.h"
+#include "../metrics/metrics.h"
+#include "../metrics/trace.h"
+
+#include <algorithm>
 
 //
 // CLASS: RTNode
-// Represents a node stored in RangeTree. Each node contains a StorageUnit object and pointers to its left and right
-// child nodes. The range is calculated using values stored within the StorageUnit instance. The range of each node is
-// defined as the free capacity within a StorageUnit instance to the max capacity of a StorageUnit instance.
+// Represents a node stored in RangeTree. Each node contains a UnitHandle and pointers to its left and right child nodes,
+// along with the height of its subtree and the number of StorageUnits and total free capacity inside it, so questions
+// about the free space of every StorageUnit above a threshold can be answered from O(log n) nodes. Nodes may be shared by
+// copies of a RangeTree.
 //
 
-// CONSTRUCTOR: Default constructor for the RTNode class. The StorageUnit value is not defined and the pointers for the node's
+// CONSTRUCTOR: Default constructor for the RTNode class. The UnitHandle value is not defined and the pointers for the node's
 // children are set to null. This constructor is not often used.
 RTNode::RTNode(){
     this->left = nullptr;
     this->right = nullptr;
+    this->height = 1;
+    this->count = 1;
+    this->free = 0;
 }
 
-// CONSTRUCTOR: Creates an instance of RTNode that contains a StorageUnit instance. The pointers for the node's children
-// are still set to null.
-RTNode::RTNode(StorageUnit data){
+// CONSTRUCTOR: Creates an instance of RTNode that contains the handle of a StorageUnit instance. The pointers for the
+// node's children are still set to null, so the node's subtree holds only its own StorageUnit.
+RTNode::RTNode(const UnitHandle& data){
     this->data = data;
     this->left = nullptr;
     this->right = nullptr;
+    this->height = 1;
+    this->count = 1;
+    this->free = data.free;
 }
 
 //
 // REQUIRED DATA STRUCTURE: RangeTree
 // Represents a Range Tree data structure. Contains methods to insert new StorageUnit instances, update existing nodes,
-// perform range queries, and other operations.
+// perform range queries, and answer aggregate questions about free capacity without visiting the Grid. StorageUnits are
+// ordered by free capacity, with ties broken by location, and the tree is kept balanced as an AVL tree. Copying a
+// RangeTree is O(1): the copies share every node, and a change copies only the shared nodes on the paths it rewrites.
 //
 
 // CONSTRUCTOR: Default constructor for the RangeTree class. Sets the root of the tree to be null.
 RangeTree::RangeTree(){
-    this->root = nullptr;
+
 }
 
 // CONSTRUCTOR: Creates an instance of a RangeTree that contains StorageUnit instances at the time of creation. Constructor
 // requires parameter units_in, a vector of StorageUnit instances to be added as nodes into the range tree.
-RangeTree::RangeTree(std::vector<StorageUnit> units_in){
-    for(StorageUnit i : units_in){
+RangeTree::RangeTree(const std::vector<StorageUnit>& units_in){
+    for(const StorageUnit& i : units_in){
         insert(i);
     }
 }
 
-// DESTRUCTOR: Destroys the RangeTree instance. Recursively deletes all RTNodes.
-RangeTree::~RangeTree(){
-    destroy(this->root);
+// FUNCTION: Public-facing function to insert a StorageUnit instance into the RangeTree. Accepts a StorageUnit instance
+// as a parameter; only its location and free capacity are stored. The new node is also added to the location index. A
+// StorageUnit whose location is already in the tree replaces the old one's free capacity instead.
+void RangeTree::insert(const StorageUnit& value){
+    int free = value.getCapacity() - value.getUsedCapacity();
+    if(findFree(value.getLocation()) != nullptr){
+        updateNode(value.getLocation(), free);
+        return;
+    }
+
+    TRACE_SCOPE("tree update");
+    METRICS_COUNT(TREE_INSERTS);
+    index.set(key(value.getLocation()), free);
+    RTLink node = std::make_shared<RTNode>(UnitHandle({value.getLocation(), free}));
+    insert(this->root, node);
+    return;
 }
 
-// FUNCTION: Recursive function responsible for deleting a RangeTree instance. The only parameter is node, a RTNode pointer.
-// After calling this function, node and all its children are deleted.
-void RangeTree::destroy(RTNode *node) {
-    if(node != nullptr){
-        destroy(node->left);
-        destroy(node->right);
-        delete node;
+// FUNCTION: Private helper function to recursively insert a node into the range tree. Accepts parameters node, the link
+// to a subtree, which is set to the subtree's new root, and value, the RTNode to insert, which must not have any
+// children and is moved into the tree. Every node on the path is owned before it changes, so trees sharing it are not
+// affected.
+void RangeTree::insert(RTLink& node, RTLink& value){
+    // If the provided node is null, assign the new node to that position.
+    if(node == nullptr){
+        pull(value.get());
+        node = std::move(value);
+        return;
     }
+    METRICS_COUNT(TREE_NODES_VISITED);
+
+    // Comparing the remaining capacity of the respective StorageUnit instances.
+    RTNode& n = own(node);
+    if(less(value->data, n.data)) insert(n.left, value);
+    else insert(n.right, value);
+
+    balance(node);
     return;
 }
 
-// FUNCTION: Public-facing function to insert a StorageUnit instance into the RangeTree. Accepts a StorageUnit instance
-// as a parameter.
-void RangeTree::insert(StorageUnit value){
-    // Checks if the root is null. If so, the new node is assigned to the root value. If not, the recursive helper function
-    // is called.
-    if(this->root == nullptr) this->root = new RTNode(value);
-    else insert(this->root, value);
+// FUNCTION: Private helper function to recursively unlink a node from the range tree. The node is found by descending
+// with its current key, so it must be removed before its free capacity changes. The node itself is not deleted and is
+// left without children. Accepts parameters node, the link to a subtree, which is set to the subtree's new root, value,
+// the handle of the StorageUnit to unlink, and removed, which is set to the unlinked node.
+void RangeTree::remove(RTLink& node, const UnitHandle& value, RTLink& removed){
+    if(node == nullptr) return;
+    METRICS_COUNT(TREE_NODES_VISITED);
+
+    RTNode& n = own(node);
+    if(less(value, n.data) || less(n.data, value)){
+        remove(less(value, n.data) ? n.left : n.right, value, removed);
+        balance(node);
+        return;
+    }
+
+    // The node is replaced by the leftmost node of its right subtree, or by its only child.
+    // Children are moved rather than copied, so the nodes stay unshared and are not copied by later rotations.
+    removed = node;
+    if(n.left == nullptr) node = std::move(n.right);
+    else if(n.right == nullptr) node = std::move(n.left);
+    else {
+        RTLink min;
+        removeMin(n.right, min);
+        min->left = std::move(n.left);
+        min->right = std::move(n.right);
+        node = std::move(min);
+        balance(node);
+    }
     return;
 }
 
-// FUNCTION: Private helper function to recursively insert a new StorageUnit into the range tree. Accepts parameters node,
-// a RTNode pointer, and value, an instance of StorageUnit. Returns a RTNode pointer.
-RTNode* RangeTree::insert(RTNode *node, StorageUnit value){
-    // If the provided node is null, assign a new node with the provided input to that position.
-    if(node == nullptr) return new RTNode(value);
+// FUNCTION: Private helper function to recursively unlink the leftmost node of a subtree. Accepts parameters node, the
+// link to the subtree, which is set to its new root, and min, which is set to the unlinked node.
+void RangeTree::removeMin(RTLink& node, RTLink& min){
+    RTNode& n = own(node);
+    if(n.left == nullptr){
+        min = node;
+        node = std::move(n.right);
+        return;
+    }
+    removeMin(n.left, min);
+    balance(node);
+    return;
+}
 
-    // Calculating the remaining capacity of the respective StorageUnit instances.
-    int capacity = node->data.getCapacity() - node->data.getUsedCapacity();
-    int new_unit_capacity = value.getCapacity() - value.getUsedCapacity();
+// FUNCTION: Recalculates the height of a node's subtree, the number of StorageUnits in it, and their total free
+// capacity from the node's own StorageUnit and its children.
+void RangeTree::pull(RTNode* node){
+    node->height = 1;
+    node->count = 1;
+    node->free = node->data.free;
+    for(const RTNode* child : {node->left.get(), node->right.get()}){
+        if(child == nullptr) continue;
+        node->height = std::max(node->height, child->height + 1);
+        node->count += child->count;
+        node->free += child->free;
+    }
+    return;
+}
 
-    if(new_unit_capacity < capacity) node->right = insert(node->right, value);
-    else node->left = insert(node->left, value);
+// FUNCTION: Rotates a subtree to the left, making the node's right child the new root of the subtree. Both nodes are
+// owned before they change.
+void RangeTree::rotateLeft(RTLink& node){
+    RTNode& n = own(node);
+    own(n.right);
+    RTLink right = n.right;
+    n.right = right->left;
+    right->left = node;
+    pull(&n);
+    pull(right.get());
+    node = right;
+    return;
+}
 
-    return node;
+// FUNCTION: Rotates a subtree to the right, making the node's left child the new root of the subtree. Both nodes are
+// owned before they change.
+void RangeTree::rotateRight(RTLink& node){
+    RTNode& n = own(node);
+    own(n.left);
+    RTLink left = n.left;
+    n.left = left->right;
+    left->right = node;
+    pull(&n);
+    pull(left.get());
+    node = left;
+    return;
 }
 
-// FUNCTION: Locates and updates the StorageUnit in the range tree when new items are added to the StorageUnit. Parameters
-// include loc, a pair of integers representing cartesian coordinates, and new_unit, a updated instance of StorageUnit.
-void RangeTree::updateNode(std::pair<int, int> loc, StorageUnit new_unit) {
-    RTNode* found = findNode(this->root, loc);
-    if(found != nullptr) found->data = new_unit;
+// FUNCTION: Recalculates a node after one of its subtrees changed and rotates the subtree if the heights of its children
+// differ by more than one. The node must already be owned.
+void RangeTree::balance(RTLink& node){
+    pull(node.get());
+    int l = node->left == nullptr ? 0 : node->left->height;
+    int r = node->right == nullptr ? 0 : node->right->height;
+    if(l > r + 1){
+        const RTNode* left = node->left.get();
+        if((left->left == nullptr ? 0 : left->left->height) < (left->right == nullptr ? 0 : left->right->height)) rotateLeft(node->left);
+        rotateRight(node);
+    } else if(r > l + 1){
+        const RTNode* right = node->right.get();
+        if((right->right == nullptr ? 0 : right->right->height) < (right->left == nullptr ? 0 : right->left->height)) rotateRight(node->right);
+        rotateLeft(node);
+    }
     return;
 }
 
-// FUNCTION: Recursive helper function for updateNode(...). Given a pair of coordinates, this function locates the respective StorageUnit
-// instance in the range tree. Returns a RTNode pointer.
-RTNode* RangeTree::findNode(RTNode *node, std::pair<int, int> loc) {
-    // If the node is null, the StorageUnit does not exist in the range tree.
-    if(node == nullptr) return nullptr;
-    // Checking if the current node in the traversal is the requested node.
-    if(node->data.getLocation() == loc) return node;
+// FUNCTION: Locates and updates the StorageUnit in the range tree when new items are added to the StorageUnit. Parameters
+// include loc, a pair of integers representing cartesian coordinates, and free, the StorageUnit's new free capacity. The
+// node is unlinked, given its new free capacity, and linked back in. A node no other tree shares is reused, so no memory
+// is allocated; a shared one is copied along with the nodes on its path.
+void RangeTree::updateNode(std::pair<int, int> loc, int free) {
+    TRACE_SCOPE("tree update");
+    METRICS_COUNT(TREE_UPDATES);
+    const int* found = findFree(loc);
+    if(found == nullptr || *found == free) return;
 
-    RTNode* l = findNode(node->left, loc);
-    if(l != nullptr) return l;
-    RTNode* r = findNode(node->right, loc);
-    if(r != nullptr) return r;
+    RTLink node;
+    remove(this->root, UnitHandle({loc, *found}), node);
+    *index.edit(key(loc)) = free;
+    own(node).data.free = free;
+    insert(this->root, node);
+    return;
+}
 
-    return nullptr;
+// FUNCTION: Helper function for updateNode(...). Given a pair of coordinates, this function looks up the respective
+// StorageUnit instance's free capacity in the location index, which with its location is the node's key. Returns a
+// pointer to the free capacity, or nullptr if the StorageUnit does not exist in the range tree.
+const int* RangeTree::findFree(std::pair<int, int> loc) {
+    METRICS_COUNT(TREE_NODES_VISITED);
+    return index.find(key(loc));
 }
 
-// FUNCTION: Public-facing function to perform a range query on the range tree. Accepts parameter size_range, a pair of integers
-// representing the range of values to search for within the tree. Returns a vector of StorageUnit instances that match
-// the search parameters.
-std::vector<StorageUnit> RangeTree::rangeQuery(std::pair<int, int> size_range){
-    std::vector<StorageUnit> results;
-    rangeQuery(this->root, size_range, results);
-    return results;
+// FUNCTION: Public-facing function to perform a range query on the range tree. Accepts parameters size_range, a pair of
+// integers representing the range of values to search for within the tree, and results, a vector that is cleared and
+// filled with the handles of every StorageUnit with at least as much free capacity as both ends of the range, least free
+// capacity first. Callers keep results between queries so its buffer is reused.
+void RangeTree::rangeQuery(std::pair<int, int> size_range, std::vector<UnitHandle>& results){
+    TRACE_SCOPE("tree query");
+    METRICS_TIME(OP_RANGE_QUERY);
+    METRICS_COUNT(RANGE_QUERIES);
+    results.clear();
+    rangeQuery(this->root.get(), std::max(size_range.first, size_range.second), results);
+    return;
 }
 
 // FUNCTION: Private helper function to recursively perform a range query on the tree. Accepts parameters node, a RTNode
-// pointer, size_range, a pair of integers representing the search range, and a reference to results, a vector of StorageUnit
-// instances to be returned upon completion of the recursive function.
-void RangeTree::rangeQuery(RTNode *node, std::pair<int, int> size_range, std::vector<StorageUnit>& results){
+// pointer, space, the free capacity required, and a reference to results, a vector of UnitHandle instances to be returned
+// upon completion of the recursive function. Left subtrees are only visited if the node itself satisfies the query.
+void RangeTree::rangeQuery(const RTNode* node, int space, std::vector<UnitHandle>& results){
     if(!node) return;
+    METRICS_COUNT(TREE_NODES_VISITED);
 
-    // Calculating the remaining space in the current node.
-    int capacity = node->data.getCapacity() - node->data.getUsedCapacity();
-    // Checking the bounds of the search compared to the node.
-    if(capacity >= size_range.first && capacity >= size_range.second) {
-        // If the node satisfies the range query, push the node's StorageUnit instance to the results vector.
+    if(node->data.free >= space){
+        rangeQuery(node->left.get(), space, results);
         results.push_back(node->data);
-    }else{
-        // If not satisfactory, recursively call this function again with the current node's children.
-        rangeQuery(node->left, size_range, results);
-        rangeQuery(node->right, size_range, results);
     }
+    rangeQuery(node->right.get(), space, results);
+    return;
+}
+
+// FUNCTION: Finds the StorageUnit with the least free capacity that is at least space, breaking ties by location, by
+// descending a single path of the tree. Accepts parameters space, the free capacity required, and result, which is set to
+// the StorageUnit found. Returns false if no StorageUnit has enough free capacity.
+bool RangeTree::bestFit(int space, UnitHandle& result){
+    TRACE_SCOPE("tree query");
+    METRICS_TIME(OP_RANGE_QUERY);
+    METRICS_COUNT(RANGE_QUERIES);
+    const RTNode* found = nullptr;
+    for(const RTNode* node = this->root.get(); node != nullptr;){
+        METRICS_COUNT(TREE_NODES_VISITED);
+        if(node->data.free >= space){
+            found = node;
+            node = node->left.get();
+        } else node = node->right.get();
+    }
+    if(found == nullptr) return false;
+    result = found->data;
+    return true;
+}
+
+// FUNCTION: Counts the StorageUnits with at least space free capacity and totals their free capacity by descending a
+// single path of the tree. Whenever a node has enough free capacity, so does its whole right subtree, whose count and
+// free capacity are added without visiting it. Accepts parameters space, count, and free; count and free are overwritten.
+void RangeTree::atLeast(int space, int& count, long long& free){
+    count = 0;
+    free = 0;
+    for(const RTNode* node = this->root.get(); node != nullptr;){
+        METRICS_COUNT(TREE_NODES_VISITED);
+        if(node->data.free >= space){
+            count += 1;
+            free += node->data.free;
+            if(node->right != nullptr){
+                count += node->right->count;
+                free += node->right->free;
+            }
+            node = node->left.get();
+        } else node = node->right.get();
+    }
+    return;
+}
+
+// FUNCTION: Returns the largest free capacity of any StorageUnit, the rightmost node of the tree, or 0 if the tree is empty.
+int RangeTree::maxFree(){
+    if(this->root == nullptr) return 0;
+    const RTNode* node = this->root.get();
+    while(node->right != nullptr) node = node->right.get();
+    return node->data.free;
+}
+
+// FUNCTION: Returns the number of StorageUnits with at least space free capacity, in O(log n).
+int RangeTree::count(int space){
+    int count;
+    long long free;
+    atLeast(space, count, free);
+    return count;
+}
+
+// FUNCTION: Returns the total free capacity of the StorageUnits with at least space free capacity, in O(log n).
+long long RangeTree::freeSpace(int space){
+    int count;
+    long long free;
+    atLeast(space, count, free);
+    return free;
+}
+
+// FUNCTION: Returns the largest quantity of an Item with the given positive size per unit that the tree's StorageUnits
+// can hold when the Item may be split between them, the sum of each StorageUnit's free capacity divided by the size per
+// unit. That sum is also the number of StorageUnits with at least size_per_unit free, plus the number with at least
+// 2 * size_per_unit, and so on, so it is answered with one count(...) per multiple up to the largest free capacity. When
+// that would visit more nodes than the tree holds, the StorageUnits with enough space are visited directly instead.
+long long RangeTree::maxPlaceable(int size_per_unit){
+    if(size_per_unit <= 0 || this->root == nullptr) return 0;
+    long long multiples = maxFree() / size_per_unit;
+    long long total = 0;
+    if(multiples * this->root->height <= count(size_per_unit)){
+        for(long long k = 1; k <= multiples; k++) total += count((int)(k * size_per_unit));
+    } else {
+        std::vector<const RTNode*> stack = {this->root.get()};
+        while(!stack.empty()){
+            const RTNode* node = stack.back();
+            stack.pop_back();
+            if(node == nullptr) continue;
+            METRICS_COUNT(TREE_NODES_VISITED);
+            if(node->data.free >= size_per_unit){
+                total += node->data.free / size_per_unit;
+                stack.push_back(node->left.get());
+            }
+            stack.push_back(node->right.get());
+        }
+    }
+    return total;
+}
+
+// FUNCTION: Counts the StorageUnits in each bucket of free capacity with one count(...) per bucket. Accepts parameters
+// width, the positive width of each bucket, and buckets, whose size is the number of buckets. Bucket i counts the
+// StorageUnits with free capacity from i * width up to but not including (i + 1) * width; the last bucket also counts
+// every StorageUnit with more free capacity.
+void RangeTree::histogram(int width, std::vector<int>& buckets){
+    int above = size();
+    for(int i = 0; i < (int)buckets.size(); i++){
+        int next = i + 1 == (int)buckets.size() ? 0 : count((i + 1) * width);
+        buckets[i] = above - next;
+        above = next;
+    }
+    return;
+}
+
+// FUNCTION: Public-facing function to estimate the heap memory owned by the range tree. Each node is a separate
+// allocation, as is each node of the location index. Nodes shared with copies of the tree are counted in full. Accepts
+// two MemoryUsage references that the estimates are added to.
+void RangeTree::memoryUsage(MemoryUsage& nodes, MemoryUsage& index){
+    nodes += estimateShared<RTNode>(size());
+    index += this->index.memoryUsage();
     return;
 }
@@ -10,29 +10,53 @@
 #define RangeTree_H
 
 #include "../container.h"
+#include "persistent.h"
+
+#include <memory>
+
+//
+// STRUCTURE: UnitHandle
+// Identifies a StorageUnit stored in the Warehouse's Grid by its location, along with the free capacity the RangeTree
+// and KDTree query it by. The StorageUnit itself, including its Items, stays in the Grid.
+//
+
+struct UnitHandle {
+    std::pair<int, int> loc;
+    int free;
+};
 
 //
 // CLASS: RTNode
-// Represents a node stored in RangeTree. Each node contains a StorageUnit object and pointers to its left and right
-// child nodes. The range is calculated using values stored within the StorageUnit instance. The range of each node is
-// defined as the free capacity within a StorageUnit instance to the max capacity of a StorageUnit instance.
+// Represents a node stored in RangeTree. Each node contains a UnitHandle and pointers to its left and right child nodes,
+// along with the height of its subtree and the number of StorageUnits and total free capacity inside it, so questions
+// about the free space of every StorageUnit above a threshold can be answered from O(log n) nodes. Nodes may be shared by
+// copies of a RangeTree.
 //
 
+class RTNode;
+typedef std::shared_ptr<RTNode> RTLink;
+
 class RTNode{
     public:
         // CONSTRUCTORS
         RTNode();
-        RTNode(StorageUnit data);
+        RTNode(const UnitHandle& data);
 
     private:
         // MEMBER VARIABLES
 
-        // DATA: The node's instance of StorageUnit.
-        StorageUnit data;
-        // LEFT: A pointer to the node's left child.
-        RTNode* left;
-        // RIGHT: A pointer to the node's right child.
-        RTNode* right;
+        // DATA: The handle of the node's StorageUnit.
+        UnitHandle data;
+        // LEFT: A pointer to the node's left child. Every StorageUnit in the left subtree has less free capacity.
+        RTLink left;
+        // RIGHT: A pointer to the node's right child. Every StorageUnit in the right subtree has more free capacity.
+        RTLink right;
+        // HEIGHT: The height of the node's subtree.
+        int height;
+        // COUNT: The number of StorageUnits in the node's subtree.
+        int count;
+        // FREE: The total free capacity of the StorageUnits in the node's subtree.
+        long long free;
 
     // FRIEND CLASS: Declaring RangeTree as a friend class so that private member variables can be accessed from the class.
     friend class RangeTree;
@@ -41,7 +65,9 @@ class RTNode{
 //
 // REQUIRED DATA STRUCTURE: RangeTree
 // Represents a Range Tree data structure. Contains methods to insert new StorageUnit instances, update existing nodes,
-// perform range queries, and other operations.
+// perform range queries, and answer aggregate questions about free capacity without visiting the Grid. StorageUnits are
+// ordered by free capacity, with ties broken by location, and the tree is kept balanced as an AVL tree. Copying a
+// RangeTree is O(1): the copies share every node, and a change copies only the shared nodes on the paths it rewrites.
 //
 
 class RangeTree {
@@ -49,33 +75,95 @@ class RangeTree {
         // MEMBER VARIABLES
 
         // ROOT: The root node of the RangeTree.
-        RTNode* root;
+        RTLink root;
+        // INDEX: The free capacity of each StorageUnit, keyed by its location, so updates can find its node with a single
+        // descent of the tree.
+        PersistentMap<long long, int> index;
 
         // FUNCTIONS
 
-        // DESTROY: Private recursive helper function to destroy the RangeTree. Called by the class destructor.
-        void destroy(RTNode* node);
         // INSERT: Private recursive helper function to insert a node into the RangeTree.
-        RTNode* insert(RTNode* node, StorageUnit data);
-        // FINDNODE: Private recursive helper function to locate a StorageUnit instance within the RangeTree.
-        RTNode* findNode(RTNode* node, std::pair<int, int> loc);
+        void insert(RTLink& node, RTLink& value);
+        // REMOVE: Private recursive helper function to unlink a node from the RangeTree without deleting it.
+        void remove(RTLink& node, const UnitHandle& value, RTLink& removed);
+        // REMOVEMIN: Private recursive helper function to unlink the leftmost node of a subtree.
+        void removeMin(RTLink& node, RTLink& min);
+        // BALANCE: Private helper function to restore the AVL property at a node after one of its subtrees changed.
+        void balance(RTLink& node);
+        // ROTATELEFT, ROTATERIGHT: Private helper functions to rotate a subtree.
+        void rotateLeft(RTLink& node);
+        void rotateRight(RTLink& node);
+        // PULL: Private helper function to recalculate a node's height, count, and free from its children.
+        void pull(RTNode* node);
+        // FINDFREE: Private helper function to look up the free capacity of a StorageUnit within the RangeTree.
+        const int* findFree(std::pair<int, int> loc);
+        // ATLEAST: Private helper function to count the StorageUnits with at least a given free capacity and total their
+        // free capacity.
+        void atLeast(int space, int& count, long long& free);
         // RANGEQUERY: Private recursive helper function to perform a range query on the tree.
-        void rangeQuery(RTNode *node, std::pair<int, int> size_range, std::vector<StorageUnit>& results);
+        void rangeQuery(const RTNode* node, int space, std::vector<UnitHandle>& results);
+        // LESS: Returns true if StorageUnit a is ordered before b: by free capacity, then by location.
+        static bool less(const UnitHandle& a, const UnitHandle& b) { return a.free != b.free ? a.free < b.free : a.loc < b.loc; }
+        // KEY: Returns the index key of a location.
+        static long long key(std::pair<int, int> loc) { return ((long long)loc.first << 32) | (unsigned int)loc.second; }
 
     public:
         // CONSTRUCTORS
         RangeTree();
-        RangeTree(std::vector<StorageUnit> units_in);
-        ~RangeTree();
+        RangeTree(const std::vector<StorageUnit>& units_in);
 
         // FUNCTIONS
 
-        // INSERT: Add a new node to the range tree.
-        void insert(StorageUnit data);
-        // UPDATENODE: Update an existing node in the range tree. The node is found by its StorageUnit coordinates.
-        void updateNode(std::pair<int, int> loc, StorageUnit new_unit);
-        // RANGEQUERY: Perform a range query on the tree.
-        std::vector<StorageUnit> rangeQuery(std::pair<int, int> size_range);
+        // INSERT: Add a new node to the range tree, or update the node of a StorageUnit already in the tree.
+        void insert(const StorageUnit& data);
+        // UPDATENODE: Update the free capacity of an existing node in the range tree. The node is found by its StorageUnit coordinates.
+        void updateNode(std::pair<int, int> loc, int free);
+        // RANGEQUERY: Perform a range query on the tree, replacing the contents of results.
+        void rangeQuery(std::pair<int, int> size_range, std::vector<UnitHandle>& results);
+        // BESTFIT: Find the StorageUnit with the least free capacity that is at least space.
+        bool bestFit(int space, UnitHandle& result);
+        // FOREACHFIT: Calls f(handle) for every StorageUnit with at least space free capacity, least free capacity first,
+        // until f returns true. Returns true if f did.
+        template<typename F>
+        bool forEachFit(int space, F f) const;
+
+        // SIZE: Returns the number of StorageUnits in the tree.
+        int size() { return root == nullptr ? 0 : root->count; }
+        // MAXFREE: Returns the largest free capacity of any StorageUnit, or 0 if the tree is empty.
+        int maxFree();
+        // COUNT: Returns the number of StorageUnits with at least space free capacity.
+        int count(int space);
+        // FREESPACE: Returns the total free capacity of the StorageUnits with at least space free capacity.
+        long long freeSpace(int space);
+        // MAXPLACEABLE: Returns the largest quantity of an Item with the given size per unit that fits in the tree's StorageUnits.
+        long long maxPlaceable(int size_per_unit);
+        // HISTOGRAM: Counts the StorageUnits in each bucket of free capacity.
+        void histogram(int width, std::vector<int>& buckets);
+
+        // MEMORYUSAGE: Estimate the memory owned by the tree's nodes and by its location index.
+        void memoryUsage(MemoryUsage& nodes, MemoryUsage& index);
 };
 
+// FUNCTION: Visits the StorageUnits with at least space free capacity in order of free capacity with an in-order walk
+// that starts from the best fit: subtrees whose StorageUnits all have too little free capacity are never entered, so
+// the walk costs O(log n) plus the number of StorageUnits visited. The tree is only read, so several threads may walk
+// it at once as long as none changes it.
+template<typename F>
+bool RangeTree::forEachFit(int space, F f) const {
+    std::vector<const RTNode*> stack;
+    for(const RTNode* node = root.get(); node != nullptr;){
+        if(node->data.free >= space){
+            stack.push_back(node);
+            node = node->left.get();
+        } else node = node->right.get();
+    }
+    while(!stack.empty()){
+        const RTNode* node = stack.back();
+        stack.pop_back();
+        if(f(node->data)) return true;
+        for(const RTNode* next = node->right.get(); next != nullptr; next = next->left.get()) stack.push_back(next);
+    }
+    return false;
+}
+
 #endif
@@ -0,0 +1,237 @@
+//
+// CSC 212 - Data Structures and Abstractions
+// Dominic Tucchio, Jennipher Day, Maya Geva, Thomas Williams
+// Spring 2024 Term Project - tour.cpp
+//
+
+#include "tour.h"
+#include "../metrics/metrics.h"
+#include "../metrics/trace.h"
+
+#include <algorithm>
+#include <climits>
+
+//
+// CLASS: TourPlanner
+// Orders the stops of a pick list into a short tour. Each stop can be made at any one of several candidate points, such
+// as the StorageUnits holding an Item, and the tour starts at a fixed point and either ends at its last stop or returns
+// to where it started. Distances between
+// points come from a matrix, so the planner does not depend on how paths are found. The tour is built greedily from the
+// nearest stop and then improved until no move helps: choosing a different candidate for a stop, reversing a run of
+// stops (2-opt), and moving a run of up to three stops elsewhere in the tour (Or-opt). A tour no single move improves can
+// still be far from the shortest, so the best tour is then repeatedly cut into four runs that are reconnected in another
+// order (a double bridge) and improved again, keeping the result whenever it is shorter.
+//
+
+// MAX_ROUNDS: The most rounds of improving moves made by each call to improve().
+static const int MAX_ROUNDS = 100;
+// KICKS: The number of times the best tour found is shaken up and improved again to escape a local optimum.
+static const int KICKS = 50;
+
+// CONSTRUCTOR: Creates a planner. The planner holds no state between calls to plan(...).
+TourPlanner::TourPlanner(){
+
+}
+
+// FUNCTION: Returns the length of a tour: the distance from start to the first point and between each pair of
+// consecutive points, plus the distance back to start for a round trip. Accepts parameters matrix and points, the
+// distance matrix and its width, start, tour, the points in visiting order, and round_trip.
+long long TourPlanner::length(const std::vector<int>& matrix, int points, int start, const std::vector<int>& tour, bool round_trip){
+    long long total = 0;
+    int at = start;
+    for(int p : tour){
+        total += matrix[at * points + p];
+        at = p;
+    }
+    if(round_trip) total += matrix[at * points + start];
+    return total;
+}
+
+// FUNCTION: Plans a tour. Accepts parameters matrix, the distances between every pair of points stored row by row,
+// points, the number of points, start, the point the tour starts from, stops, the candidate points of each stop, and
+// round_trip, true if the tour returns to start after the last stop. Every stop must have at least one candidate.
+// Returns the chosen point of each stop in visiting order.
+std::vector<int> TourPlanner::plan(const std::vector<int>& matrix, int points, int start, const std::vector<std::vector<int> >& stops, bool round_trip){
+    TRACE_SCOPE("tour planning");
+    METRICS_TIME(OP_PLAN_TOUR);
+    this->matrix = &matrix;
+    this->points = points;
+    this->start = start;
+    this->stops = &stops;
+    this->round_trip = round_trip;
+
+    nearest();
+    improve();
+
+    // The same seed every time, so the same pick list is always planned the same way.
+    random.seed(212);
+    std::vector<int> best_order = order, best_pick = pick;
+    long long best = total();
+    for(int kick = 0; kick < KICKS && order.size() >= 8; kick++){
+        int n = order.size();
+        std::uniform_int_distribution<int> cut(1, n - 1);
+        int cuts[3] = {cut(random), cut(random), cut(random)};
+        std::sort(cuts, cuts + 3);
+        if(cuts[0] == cuts[1] || cuts[1] == cuts[2]) continue;
+        std::vector<int> shaken(order.begin(), order.begin() + cuts[0]);
+        shaken.insert(shaken.end(), order.begin() + cuts[2], order.end());
+        shaken.insert(shaken.end(), order.begin() + cuts[1], order.begin() + cuts[2]);
+        shaken.insert(shaken.end(), order.begin() + cuts[0], order.begin() + cuts[1]);
+        order.swap(shaken);
+        improve();
+
+        long long length = total();
+        if(length < best){
+            best = length;
+            best_order = order;
+            best_pick = pick;
+        } else {
+            order = best_order;
+            pick = best_pick;
+        }
+    }
+
+    std::vector<int> tour;
+    for(int s : order) tour.push_back(pick[s]);
+    return tour;
+}
+
+// FUNCTION: Applies improving moves until none is left or MAX_ROUNDS rounds have been made.
+void TourPlanner::improve(){
+    bool changed = true;
+    for(int round = 0; changed && round < MAX_ROUNDS; round++){
+        changed = reselect();
+        changed = twoOpt() || changed;
+        changed = orOpt() || changed;
+    }
+    return;
+}
+
+// FUNCTION: Returns the length of the current tour.
+long long TourPlanner::total(){
+    long long length = 0;
+    for(int i = 0; i < (int)order.size(); i++) length += dist(at(i - 1), at(i));
+    if(!order.empty()) length += leg(at(order.size() - 1), -1);
+    return length;
+}
+
+// FUNCTION: Builds the first tour. Starting from start, the closest candidate of any stop not yet visited is visited next.
+void TourPlanner::nearest(){
+    int n = (int)stops->size();
+    order.clear();
+    pick.assign(n, -1);
+    std::vector<bool> visited(n, false);
+    int at = start;
+    for(int step = 0; step < n; step++){
+        int best_stop = -1, best_point = -1;
+        long long best = LLONG_MAX;
+        for(int s = 0; s < n; s++){
+            if(visited[s]) continue;
+            for(int c : (*stops)[s]){
+                if(dist(at, c) < best){
+                    best = dist(at, c);
+                    best_stop = s;
+                    best_point = c;
+                }
+            }
+        }
+        visited[best_stop] = true;
+        order.push_back(best_stop);
+        pick[best_stop] = best_point;
+        at = best_point;
+    }
+    return;
+}
+
+// FUNCTION: Moves each stop to the candidate closest to its neighbors in the tour. Returns true if any stop moved.
+bool TourPlanner::reselect(){
+    bool changed = false;
+    for(int i = 0; i < (int)order.size(); i++){
+        int s = order[i], before = at(i - 1), after = at(i + 1);
+        long long best = dist(before, pick[s]) + leg(pick[s], after);
+        for(int c : (*stops)[s]){
+            long long cost = dist(before, c) + leg(c, after);
+            if(cost < best){
+                best = cost;
+                pick[s] = c;
+                changed = true;
+            }
+        }
+    }
+    return changed;
+}
+
+// FUNCTION: Reverses every run of stops whose reversal shortens the tour. Distances are symmetric, so only the two legs at
+// the ends of the run change. Returns true if the tour changed.
+bool TourPlanner::twoOpt(){
+    bool changed = false;
+    int n = (int)order.size();
+    for(int i = 0; i < n; i++){
+        for(int j = i + 1; j < n; j++){
+            long long delta = dist(at(i - 1), at(j)) + leg(at(i), at(j + 1)) - dist(at(i - 1), at(i)) - leg(at(j), at(j + 1));
+            if(delta < 0){
+                std::reverse(order.begin() + i, order.begin() + j + 1);
+                changed = true;
+            }
+        }
+    }
+    return changed;
+}
+
+// FUNCTION: Moves every run of one to three stops to the place in the rest of the tour, in either direction, where it
+// shortens the tour the most. Returns true if the tour changed.
+bool TourPlanner::orOpt(){
+    bool changed = false;
+    std::vector<int> rest;
+    for(int len = 1; len <= 3; len++){
+        for(int i = 0; i + len <= (int)order.size(); i++){
+            int first = at(i), last = at(i + len - 1), before = at(i - 1), after = at(i + len);
+            long long gain = dist(before, first) + leg(last, after) - leg(before, after);
+
+            rest.clear();
+            rest.insert(rest.end(), order.begin(), order.begin() + i);
+            rest.insert(rest.end(), order.begin() + i + len, order.end());
+            long long best = 0;
+            int best_t = -1, best_point = -1;
+            bool best_reversed = false;
+            for(int t = 0; t <= (int)rest.size(); t++){
+                int p = t == 0 ? start : pick[rest[t - 1]];
+                int q = t == (int)rest.size() ? -1 : pick[rest[t]];
+                long long forward = dist(p, first) + leg(last, q) - leg(p, q) - gain;
+                long long reversed = dist(p, last) + leg(first, q) - leg(p, q) - gain;
+                if(forward < best){
+                    best = forward;
+                    best_t = t;
+                    best_reversed = false;
+                    best_point = -1;
+                }
+                if(reversed < best){
+                    best = reversed;
+                    best_t = t;
+                    best_reversed = true;
+                    best_point = -1;
+                }
+                // A single stop may fit its new neighbors better at another of its candidates.
+                for(int c = 0; len == 1 && c < (int)(*stops)[order[i]].size(); c++){
+                    int point = (*stops)[order[i]][c];
+                    long long moved = dist(p, point) + leg(point, q) - leg(p, q) - gain;
+                    if(moved < best){
+                        best = moved;
+                        best_t = t;
+                        best_reversed = false;
+                        best_point = point;
+                    }
+                }
+            }
+            if(best_t == -1) continue;
+
+            if(best_point != -1) pick[order[i]] = best_point;
+            std::vector<int> segment(order.begin() + i, order.begin() + i + len);
+            if(best_reversed) std::reverse(segment.begin(), segment.end());
+            rest.insert(rest.begin() + best_t, segment.begin(), segment.end());
+            order.swap(rest);
+            changed = true;
+        }
+    }
+    return changed;
+}
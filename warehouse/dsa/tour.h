@@ -0,0 +1,71 @@
+//
+// CSC 212 - Data Structures and Abstractions
+// Dominic Tucchio, Jennipher Day, Maya Geva, Thomas Williams
+// Spring 2024 Term Project - tour.h
+//
+
+#ifndef TourPlanner_H
+#define TourPlanner_H
+
+#include <random>
+#include <vector>
+
+//
+// CLASS: TourPlanner
+// Orders the stops of a pick list into a short tour. Each stop can be made at any one of several candidate points, such
+// as the StorageUnits holding an Item, and the tour starts at a fixed point and either ends at its last stop or returns
+// to where it started. Distances between
+// points come from a matrix, so the planner does not depend on how paths are found. The tour is built greedily from the
+// nearest stop and then improved until no move helps: choosing a different candidate for a stop, reversing a run of
+// stops (2-opt), and moving a run of up to three stops elsewhere in the tour (Or-opt). The best tour is then shaken up
+// and improved again a fixed number of times to escape local optima.
+//
+
+class TourPlanner {
+    public:
+        // CONSTRUCTORS
+        TourPlanner();
+
+        // FUNCTIONS
+
+        // PLAN: Chooses a candidate for every stop and the order to visit them in. Returns the chosen points in order.
+        std::vector<int> plan(const std::vector<int>& matrix, int points, int start, const std::vector<std::vector<int> >& stops, bool round_trip);
+        // LENGTH: Returns the length of a tour of points from start.
+        static long long length(const std::vector<int>& matrix, int points, int start, const std::vector<int>& tour, bool round_trip);
+
+    private:
+        // FUNCTIONS
+
+        // DIST: Returns the distance between two points.
+        long long dist(int a, int b) { return (*matrix)[a * points + b]; }
+        // AT: Returns the point visited at a position of the tour, or -1 past its end.
+        int at(int position) { return position < 0 ? start : position >= (int)order.size() ? -1 : pick[order[position]]; }
+        // LEG: Returns the distance between two points. If b is past the end of the tour, returns the distance back to
+        // start for a round trip and 0 otherwise.
+        long long leg(int a, int b) { return b != -1 ? dist(a, b) : round_trip ? dist(a, start) : 0; }
+        // NEAREST: Builds the first tour by always visiting the closest remaining stop next.
+        void nearest();
+        // IMPROVE: Applies improving moves until none is left.
+        void improve();
+        // TOTAL: Returns the length of the current tour.
+        long long total();
+        // RESELECT, TWOOPT, OROPT: Apply every improving move of one kind. Return true if the tour changed.
+        bool reselect();
+        bool twoOpt();
+        bool orOpt();
+
+        // MEMBER VARIABLES
+
+        // MATRIX, POINTS, START, STOPS, ROUND_TRIP: The problem being planned.
+        const std::vector<int>* matrix = nullptr;
+        int points = 0;
+        int start = 0;
+        const std::vector<std::vector<int> >* stops = nullptr;
+        bool round_trip = false;
+        // ORDER, PICK: The stops in visiting order and the candidate point chosen for each stop.
+        std::vector<int> order, pick;
+        // RANDOM: Chooses where the tour is cut when it is shaken up.
+        std::mt19937 random;
+};
+
+#endif
@@ -0,0 +1,149 @@
+//
+// CSC 212 - Data Structures and Abstractions
+// Dominic Tucchio, Jennipher Day, Maya Geva, Thomas Williams
+// Spring 2024 Term Project - traffic.cpp
+//
+
+#include "traffic.h"
+#include "path_engine.h"
+
+#include <algorithm>
+#include <climits>
+
+//
+// CLASS: TrafficMap
+// Counts how many routes issued on a floor crossed each edge between neighboring cells, with older routes counting for
+// less: counts are halved every half_life routes. Counters are updated with atomic operations and decayed lazily when
+// they are next read or updated, so recording a route never locks or rebuilds the graph and routes can be recorded from
+// several threads at once. Blocks of counters are only allocated once a route crosses them.
+//
+
+// CONSTRUCTOR: Creates a TrafficMap without traffic for a floor of rows x cols cells. Only the table of blocks is
+// allocated.
+TrafficMap::TrafficMap(int rows, int cols) : rows(rows), cols(cols), issued(0) {
+    block_cols = (cols + GridChunk::SIZE - 1) >> GridChunk::BITS;
+    block_count = ((rows + GridChunk::SIZE - 1) >> GridChunk::BITS) * block_cols;
+    blocks.reset(new std::atomic<TrafficBlock*>[block_count]);
+    for(int b = 0; b < block_count; b++) blocks[b].store(nullptr, std::memory_order_relaxed);
+}
+
+// CONSTRUCTOR: Copies the traffic of map, used by a Warehouse made by fork() before it changes a TrafficMap it shares.
+TrafficMap::TrafficMap(const TrafficMap& map) : TrafficMap(map, map.rows, map.cols) {
+
+}
+
+// CONSTRUCTOR: Copies the traffic of map into a TrafficMap for a floor of rows x cols cells, used when the floor grows
+// and every graph index changes. The floor must be at least as large as map's.
+TrafficMap::TrafficMap(const TrafficMap& map, int rows, int cols) : TrafficMap(rows, cols) {
+    issued.store(map.issued.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    penalty = map.penalty;
+    half_life = map.half_life;
+    for(int b = 0; b < map.block_count; b++){
+        TrafficBlock* block = map.blocks[b].load(std::memory_order_acquire);
+        if(block == nullptr) continue;
+        for(int k = 0; k < GridChunk::CELLS * 2; k++){
+            uint64_t value = block->edges[k].load(std::memory_order_relaxed);
+            if(value == 0) continue;
+            // Finding the cell the counter belongs to and the cell its edge leads to on the new floor.
+            int within = k / 2;
+            int x = ((b / map.block_cols) << GridChunk::BITS) + (within >> GridChunk::BITS);
+            int y = ((b % map.block_cols) << GridChunk::BITS) + (within & (GridChunk::SIZE - 1));
+            slot({x, y}, k % 2 == 0 ? std::make_pair(x, y + 1) : std::make_pair(x + 1, y), true)->store(value, std::memory_order_relaxed);
+        }
+    }
+}
+
+// DESTRUCTOR: Frees every allocated block.
+TrafficMap::~TrafficMap(){
+    for(int b = 0; b < block_count; b++) delete blocks[b].load(std::memory_order_relaxed);
+}
+
+// FUNCTION: Sets how traffic is weighed. Accepts parameters penalty, the weight added to an edge per unit of traffic
+// (0 leaves weights unchanged), and half_life, the number of routes after which traffic counts half, at least 1.
+void TrafficMap::configure(int penalty, int half_life){
+    this->penalty = std::max(0, penalty);
+    this->half_life = std::max(1, half_life);
+    return;
+}
+
+// FUNCTION: Returns the counter of the edge between cells a and b. Only the steps to the next cell of a row and to the
+// next row have counters; any other pair of cells returns nullptr. The block holding the counter is allocated if create
+// is true, with a compare-and-swap so threads recording at once agree on a single block.
+std::atomic<uint64_t>* TrafficMap::slot(std::pair<int, int> a, std::pair<int, int> b, bool create) const {
+    std::pair<int, int> lo = std::min(a, b), hi = std::max(a, b);
+    int direction;
+    if(hi.first == lo.first && hi.second - lo.second == 1) direction = 0;
+    else if(hi.second == lo.second && hi.first - lo.first == 1) direction = 1;
+    else return nullptr;
+
+    int x = lo.first, y = lo.second;
+    int b_index = (x >> GridChunk::BITS) * block_cols + (y >> GridChunk::BITS);
+    TrafficBlock* block = blocks[b_index].load(std::memory_order_acquire);
+    if(block == nullptr){
+        if(!create) return nullptr;
+        TrafficBlock* fresh = new TrafficBlock();
+        if(blocks[b_index].compare_exchange_strong(block, fresh, std::memory_order_acq_rel)) block = fresh;
+        else delete fresh;
+    }
+    int within = ((x & (GridChunk::SIZE - 1)) << GridChunk::BITS) | (y & (GridChunk::SIZE - 1));
+    return &block->edges[within * 2 + direction];
+}
+
+// FUNCTION: Returns the traffic stored in value, halved once for every epoch between the epoch it was stored in and
+// epoch.
+uint32_t TrafficMap::decay(uint64_t value, uint32_t epoch){
+    uint32_t stored = value >> 32;
+    uint32_t count = (uint32_t)value;
+    if(stored >= epoch) return count;
+    uint32_t age = epoch - stored;
+    return age >= 32 ? 0 : count >> age;
+}
+
+// FUNCTION: Records a route. Each edge between consecutive cells of path has its traffic decayed to the current epoch
+// and increased by one in a single compare-and-swap. Accepts parameter path, the cells along the route.
+void TrafficMap::record(const std::vector<std::pair<int, int> >& path){
+    issued.fetch_add(1, std::memory_order_relaxed);
+    uint32_t now = epoch();
+    for(int s = 1; s < (int)path.size(); s++){
+        std::atomic<uint64_t>* counter = slot(path[s - 1], path[s], true);
+        if(counter == nullptr) continue;
+        uint64_t value = counter->load(std::memory_order_relaxed);
+        uint64_t next;
+        do {
+            uint32_t stored = value >> 32;
+            uint32_t count = decay(value, now);
+            if(count < UINT32_MAX) count++;
+            next = ((uint64_t)std::max(stored, now) << 32) | count;
+        } while(!counter->compare_exchange_weak(value, next, std::memory_order_relaxed));
+    }
+    return;
+}
+
+// FUNCTION: Returns the current traffic of the edge between neighboring cells a and b, or 0 if no route crossed it.
+int TrafficMap::count(std::pair<int, int> a, std::pair<int, int> b) const {
+    std::atomic<uint64_t>* counter = slot(a, b, false);
+    if(counter == nullptr) return 0;
+    return std::min<uint32_t>(INT_MAX, decay(counter->load(std::memory_order_relaxed), epoch()));
+}
+
+// FUNCTION: Returns the weight added to the edge between graph indices a and b: penalty times the edge's current
+// traffic, limited so that sums of penalties along a path cannot overflow.
+int TrafficMap::operator()(int a, int b) const {
+    if(penalty == 0) return 0;
+    std::atomic<uint64_t>* counter = slot(indexToCoordinates(a, cols), indexToCoordinates(b, cols), false);
+    if(counter == nullptr) return 0;
+    return std::min<long long>(1 << 20, (long long)penalty * decay(counter->load(std::memory_order_relaxed), epoch()));
+}
+
+// FUNCTION: Returns the estimated memory of the table of blocks and of every allocated block.
+MemoryUsage TrafficMap::memoryUsage() const {
+    MemoryUsage m;
+    m.bytes = block_count * sizeof(std::atomic<TrafficBlock*>);
+    m.allocations = 1;
+    for(int b = 0; b < block_count; b++){
+        if(blocks[b].load(std::memory_order_relaxed) == nullptr) continue;
+        m.bytes += sizeof(TrafficBlock);
+        m.allocations++;
+    }
+    return m;
+}
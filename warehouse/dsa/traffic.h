@@ -0,0 +1,121 @@
+//
+// CSC 212 - Data Structures and Abstractions
+// Dominic Tucchio, Jennipher Day, Maya Geva, Thomas Williams
+// Spring 2024 Term Project - traffic.h
+//
+
+#ifndef Traffic_H
+#define Traffic_H
+
+#include "grid.h"
+#include "../metrics/memory.h"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+//
+// STRUCTURE: TrafficBlock
+// The traffic counters of the edges leaving a GridChunk-sized square of the floor toward larger graph indices: the step
+// to the next cell of the row and the step to the next row, for each cell. Each counter packs the epoch it was last
+// updated in into its upper 32 bits and the number of routes that crossed the edge into its lower 32 bits.
+//
+
+struct TrafficBlock {
+    std::atomic<uint64_t> edges[GridChunk::CELLS * 2];
+
+    // CONSTRUCTOR: Every edge starts without traffic.
+    TrafficBlock() { for(std::atomic<uint64_t>& e : edges) e.store(0, std::memory_order_relaxed); }
+};
+
+//
+// CLASS: TrafficMap
+// Counts how many routes issued on a floor crossed each edge between neighboring cells, with older routes counting for
+// less: counts are halved every half_life routes. Counters are updated with atomic operations and decayed lazily when
+// they are next read or updated, so recording a route never locks or rebuilds the graph and routes can be recorded from
+// several threads at once. Blocks of counters are only allocated once a route crosses them. As a penalty for
+// PathEngine::dijkstra(...), a TrafficMap adds penalty times the traffic of each edge to its weight.
+//
+
+class TrafficMap {
+    public:
+        // ACTIVE: Tells PathEngine::dijkstra(...) that the penalty changes edge weights.
+        static constexpr bool ACTIVE = true;
+
+        // CONSTRUCTORS
+        TrafficMap(int rows, int cols);
+        TrafficMap(const TrafficMap& map);
+        TrafficMap(const TrafficMap& map, int rows, int cols);
+        ~TrafficMap();
+
+        // FUNCTIONS
+
+        // FUNCTION: Sets the penalty per unit of traffic and the number of routes after which traffic counts half.
+        void configure(int penalty, int half_life);
+        // FUNCTION: Returns the penalty per unit of traffic.
+        int getPenalty() const { return penalty; }
+        // FUNCTION: Returns the number of routes after which traffic counts half.
+        int getHalfLife() const { return half_life; }
+        // FUNCTION: Returns the number of routes recorded.
+        unsigned long long getRoutes() const { return issued.load(std::memory_order_relaxed); }
+
+        // FUNCTION: Records a route, adding one to the traffic of every edge along it.
+        void record(const std::vector<std::pair<int, int> >& path);
+        // FUNCTION: Returns the current traffic of the edge between two neighboring cells.
+        int count(std::pair<int, int> a, std::pair<int, int> b) const;
+        // FUNCTION: Returns the penalty added to the edge between two graph indices.
+        int operator()(int a, int b) const;
+        // FUNCTION: Calls f(a, b, count) for every edge with traffic, block by block.
+        template <typename F>
+        void forEachEdge(F f) const;
+
+        // FUNCTION: Estimates the memory used by the allocated blocks of counters.
+        MemoryUsage memoryUsage() const;
+
+    private:
+        // FUNCTIONS
+
+        // FUNCTION: Returns the counter of the edge between two cells, allocating its block if create is true, or
+        // nullptr if the cells are not neighbors or the block does not exist.
+        std::atomic<uint64_t>* slot(std::pair<int, int> a, std::pair<int, int> b, bool create) const;
+        // FUNCTION: Returns the traffic stored in a counter, decayed to the given epoch.
+        static uint32_t decay(uint64_t value, uint32_t epoch);
+        // FUNCTION: Returns the current epoch.
+        uint32_t epoch() const { return issued.load(std::memory_order_relaxed) / half_life; }
+
+        // MEMBER VARIABLES
+
+        // ROWS, COLS, BLOCK_COLS: The extent of the floor and the number of blocks in a row of blocks.
+        int rows, cols, block_cols;
+        // BLOCKS: The blocks of counters in row-major order, each allocated by the first route to cross it.
+        std::unique_ptr<std::atomic<TrafficBlock*>[]> blocks;
+        int block_count;
+        // ISSUED: The number of routes recorded, which sets the epoch.
+        std::atomic<unsigned long long> issued;
+        // PENALTY, HALF_LIFE: The weight added per unit of traffic and the number of routes per epoch.
+        int penalty = 0;
+        int half_life = 64;
+};
+
+// FUNCTION: Calls f(a, b, count) for every edge between neighboring cells a and b with traffic, where b is the next cell
+// of a's row or the next row. Only allocated blocks are read, so the cost follows the traffic, not the floor.
+template <typename F>
+void TrafficMap::forEachEdge(F f) const {
+    uint32_t now = epoch();
+    for(int b = 0; b < block_count; b++){
+        TrafficBlock* block = blocks[b].load(std::memory_order_acquire);
+        if(block == nullptr) continue;
+        for(int k = 0; k < GridChunk::CELLS * 2; k++){
+            uint32_t count = decay(block->edges[k].load(std::memory_order_relaxed), now);
+            if(count == 0) continue;
+            int within = k / 2;
+            int x = ((b / block_cols) << GridChunk::BITS) + (within >> GridChunk::BITS);
+            int y = ((b % block_cols) << GridChunk::BITS) + (within & (GridChunk::SIZE - 1));
+            f(std::make_pair(x, y), k % 2 == 0 ? std::make_pair(x, y + 1) : std::make_pair(x + 1, y), (int) count);
+        }
+    }
+    return;
+}
+
+#endif
@@ -0,0 +1,89 @@
+//
+// CSC 212 - Data Structures and Abstractions
+// Dominic Tucchio, Jennipher Day, Maya Geva, Thomas Williams
+// Spring 2024 Term Project - memory.cpp
+//
+
+#include "memory.h"
+
+#include <algorithm>
+#include <fstream>
+#include <limits>
+#include <sys/resource.h>
+#include <unistd.h>
+
+//
+// CLASS: MemoryReport
+// A list of named subsystems and their estimated heap footprints, along with the resident set size of the process.
+// Included in the statistics export and the benchmark results so memory regressions can be tracked.
+//
+
+// FUNCTION: Adds a subsystem to the report. Accepts parameters subsystem, the display name, and usage, its footprint.
+void MemoryReport::add(std::string subsystem, MemoryUsage usage){
+    subsystems.push_back({subsystem, usage});
+}
+
+// FUNCTION: Returns the combined footprint of every subsystem in the report.
+MemoryUsage MemoryReport::total(){
+    MemoryUsage m;
+    for(std::pair<std::string, MemoryUsage>& s : subsystems) m += s.second;
+    return m;
+}
+
+// FUNCTION: Returns the peak resident set size of the process in bytes, read from VmHWM in /proc/self/status, which the
+// kernel keeps alongside the current size. ru_maxrss, in kilobytes, is used where the file is not available. Both are
+// sampled separately from /proc/self/statm, so the result is never reported below currentRSS().
+size_t MemoryReport::peakRSS(){
+    size_t peak = 0;
+    std::ifstream status("/proc/self/status");
+    std::string field;
+    while(status >> field){
+        if(field == "VmHWM:"){
+            status >> peak;
+            peak *= 1024;
+            break;
+        }
+        status.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+    }
+    struct rusage usage;
+    if(peak == 0 && getrusage(RUSAGE_SELF, &usage) == 0) peak = (size_t)usage.ru_maxrss * 1024;
+    return std::max(peak, currentRSS());
+}
+
+// FUNCTION: Returns the current resident set size of the process in bytes, read from /proc/self/statm. Returns 0 if
+// the file is not available.
+size_t MemoryReport::currentRSS(){
+    std::ifstream statm("/proc/self/statm");
+    size_t pages = 0, resident = 0;
+    if(!(statm >> pages >> resident)) return 0;
+    return resident * (size_t)sysconf(_SC_PAGESIZE);
+}
+
+// FUNCTION: Writes the report as a section of the statistics export. Accepts parameters out, the stream to write to,
+// and indent, the prefix written before each line.
+void MemoryReport::print(std::ostream& out, std::string indent){
+    out << indent << "Memory {" << std::endl;
+    for(std::pair<std::string, MemoryUsage>& s : subsystems){
+        out << indent << "\t" << s.first << ": " << s.second.bytes << " bytes in " << s.second.allocations << " allocations" << std::endl;
+    }
+    MemoryUsage t = total();
+    out << indent << "\tTotal: " << t.bytes << " bytes in " << t.allocations << " allocations" << std::endl;
+    out << std::endl;
+    out << indent << "\tCurrent RSS: " << currentRSS() << " bytes" << std::endl;
+    out << indent << "\tPeak RSS: " << peakRSS() << " bytes" << std::endl;
+    out << indent << "}" << std::endl;
+}
+
+// FUNCTION: Writes the report as a JSON object with one entry per subsystem plus the totals and resident set sizes.
+// indent is written before each line after the opening brace.
+void MemoryReport::printJSON(std::ostream& out, std::string indent){
+    out << "{";
+    for(std::pair<std::string, MemoryUsage>& s : subsystems){
+        out << "\n" << indent << "  \"" << s.first << "\": {\"bytes\": " << s.second.bytes << ", \"allocations\": " << s.second.allocations << "},";
+    }
+    MemoryUsage t = total();
+    out << "\n" << indent << "  \"total\": {\"bytes\": " << t.bytes << ", \"allocations\": " << t.allocations << "},";
+    out << "\n" << indent << "  \"current_rss_bytes\": " << currentRSS() << ",";
+    out << "\n" << indent << "  \"peak_rss_bytes\": " << peakRSS();
+    out << "\n" << indent << "}";
+}
@@ -0,0 +1,106 @@
+//
+// CSC 212 - Data Structures and Abstractions
+// Dominic Tucchio, Jennipher Day, Maya Geva, Thomas Williams
+// Spring 2024 Term Project - memory.h
+//
+
+#ifndef Memory_H
+#define Memory_H
+
+#include <cstddef>
+#include <map>
+#include <ostream>
+#include <string>
+#include <vector>
+
+//
+// STRUCTURE: MemoryUsage
+// The estimated heap footprint of a data structure: the number of bytes it owns and the number of heap allocations
+// those bytes are spread over.
+//
+
+struct MemoryUsage {
+    size_t bytes = 0;
+    size_t allocations = 0;
+
+    // OPERATOR +=: Adds the footprint of another structure.
+    MemoryUsage& operator+=(const MemoryUsage& m){
+        bytes += m.bytes;
+        allocations += m.allocations;
+        return *this;
+    }
+};
+
+//
+// MEMORY ESTIMATION
+// Helpers that estimate the heap memory owned by standard containers from their size and capacity. Estimates follow
+// the libstdc++ layout (15 character small string buffer, 32 byte red-black tree node header, 16 byte shared_ptr control
+// block) and do not include the allocator's own per-allocation bookkeeping.
+//
+
+// CONSTANTS: Implementation details used by the estimates.
+const size_t SSO_CAPACITY = 15;
+const size_t MAP_NODE_OVERHEAD = 4 * sizeof(void*);
+const size_t SHARED_BLOCK_OVERHEAD = sizeof(void*) + 2 * sizeof(int);
+
+// FUNCTION: Estimates the heap memory owned by a string. Strings that fit in the small string buffer own none.
+inline MemoryUsage estimateString(const std::string& s){
+    MemoryUsage m;
+    if(s.capacity() > SSO_CAPACITY){
+        m.bytes = s.capacity() + 1;
+        m.allocations = 1;
+    }
+    return m;
+}
+
+// FUNCTION: Estimates the heap memory owned by a vector's buffer. The memory owned by its elements is not included.
+template<typename T>
+MemoryUsage estimateVector(const std::vector<T>& v){
+    MemoryUsage m;
+    if(v.capacity() > 0){
+        m.bytes = v.capacity() * sizeof(T);
+        m.allocations = 1;
+    }
+    return m;
+}
+
+// FUNCTION: Estimates the heap memory owned by a map's nodes. The memory owned by the keys and values themselves
+// (such as long strings) is not included.
+template<typename K, typename V>
+MemoryUsage estimateMap(const std::map<K, V>& map){
+    MemoryUsage m;
+    m.bytes = map.size() * (MAP_NODE_OVERHEAD + sizeof(typename std::map<K, V>::value_type));
+    m.allocations = map.size();
+    return m;
+}
+
+//
+// CLASS: MemoryReport
+// A list of named subsystems and their estimated heap footprints, along with the resident set size of the process.
+// Included in the statistics export and the benchmark results so memory regressions can be tracked.
+//
+
+class MemoryReport {
+    public:
+        // FUNCTIONS
+
+        // FUNCTION: Adds a subsystem to the report.
+        void add(std::string subsystem, MemoryUsage usage);
+        // FUNCTION: Returns the combined footprint of every subsystem.
+        MemoryUsage total();
+
+        // FUNCTION: Writes the report as a section of the statistics export.
+        void print(std::ostream& out, std::string indent);
+        // FUNCTION: Writes the report as a JSON object.
+        void printJSON(std::ostream& out, std::string indent);
+
+        // FUNCTION: Returns the peak resident set size of the process in bytes.
+        static size_t peakRSS();
+        // FUNCTION: Returns the current resident set size of the process in bytes.
+        static size_t currentRSS();
+
+        // SUBSYSTEMS: The subsystems in the order they were added.
+        std::vector<std::pair<std::string, MemoryUsage> > subsystems;
+};
+
+#endif
@@ -0,0 +1,172 @@
+//
+// CSC 212 - Data Structures and Abstractions
+// Dominic Tucchio, Jennipher Day, Maya Geva, Thomas Williams
+// Spring 2024 Term Project - metrics.cpp
+//
+
+#include "metrics.h"
+
+#include <algorithm>
+
+// The registry is only compiled when instrumentation is enabled. See the instrumentation macros in "metrics.h".
+#ifdef WAREHOUSE_METRICS
+
+//
+// CLASS: LatencyHistogram
+// A fixed-size, HDR-style histogram of latencies in nanoseconds. Values are bucketed by their power of two and then into
+// 16 linear sub-buckets, so every recorded value is accurate to within 1/16 (about 6%) of its magnitude. Recording is a
+// handful of relaxed atomic increments and never allocates.
+//
+
+// CONSTRUCTOR: Creates an empty histogram.
+LatencyHistogram::LatencyHistogram() : count(0), sum(0), max(0) {
+    for(int i = 0; i < BUCKETS; i++) counts[i].store(0, std::memory_order_relaxed);
+}
+
+// FUNCTION: Returns the bucket a value is counted in. Values smaller than the number of sub-buckets have a bucket each.
+// Larger values are placed by the position of their highest set bit and the SUB_BUCKET_BITS bits that follow it.
+int LatencyHistogram::bucketIndex(uint64_t ns){
+    if(ns < (uint64_t)SUB_BUCKETS) return (int)ns;
+    int magnitude = 63 - __builtin_clzll(ns);
+    int sub = (int)((ns >> (magnitude - SUB_BUCKET_BITS)) & (SUB_BUCKETS - 1));
+    return (magnitude - SUB_BUCKET_BITS + 1) * SUB_BUCKETS + sub;
+}
+
+// FUNCTION: Returns the largest value that is counted in the given bucket. This is the inverse of bucketIndex(...).
+uint64_t LatencyHistogram::bucketValue(int index){
+    if(index < SUB_BUCKETS) return index;
+    int magnitude = index / SUB_BUCKETS + SUB_BUCKET_BITS - 1;
+    uint64_t sub = index % SUB_BUCKETS;
+    uint64_t width = 1ULL << (magnitude - SUB_BUCKET_BITS);
+    return ((SUB_BUCKETS + sub) << (magnitude - SUB_BUCKET_BITS)) + width - 1;
+}
+
+// FUNCTION: Records a single latency sample.
+void LatencyHistogram::record(uint64_t ns){
+    counts[bucketIndex(ns)].fetch_add(1, std::memory_order_relaxed);
+    count.fetch_add(1, std::memory_order_relaxed);
+    sum.fetch_add(ns, std::memory_order_relaxed);
+    uint64_t current = max.load(std::memory_order_relaxed);
+    while(ns > current && !max.compare_exchange_weak(current, ns, std::memory_order_relaxed));
+}
+
+// FUNCTION: Returns the number of samples recorded.
+uint64_t LatencyHistogram::getCount() const {
+    return count.load(std::memory_order_relaxed);
+}
+
+// FUNCTION: Returns the mean of all recorded samples, or 0 if there are none.
+uint64_t LatencyHistogram::getMean() const {
+    uint64_t n = getCount();
+    return n == 0 ? 0 : sum.load(std::memory_order_relaxed) / n;
+}
+
+// FUNCTION: Returns the largest recorded sample.
+uint64_t LatencyHistogram::getMax() const {
+    return max.load(std::memory_order_relaxed);
+}
+
+// FUNCTION: Returns the p-th percentile (0-100) of the recorded samples. The result is the upper bound of the bucket
+// containing the sample of that rank, capped at the largest recorded sample.
+uint64_t LatencyHistogram::percentile(double p) const {
+    uint64_t n = getCount();
+    if(n == 0) return 0;
+    uint64_t rank = (uint64_t)(p / 100.0 * n + 0.5);
+    if(rank == 0) rank = 1;
+
+    uint64_t seen = 0;
+    for(int i = 0; i < BUCKETS; i++){
+        seen += counts[i].load(std::memory_order_relaxed);
+        if(seen >= rank) return std::min(bucketValue(i), getMax());
+    }
+    return getMax();
+}
+
+//
+// CLASS: Metrics
+// Process-wide registry of latency histograms and hot-path counters. Histograms cover each command type in the commands
+// file as well as the internal operations that dominate their cost. Counters track the work done inside the data
+// structures and algorithms. The registry is exported as a section of warehouse_statistics.txt and as JSON.
+//
+
+// NAMES: Display names for each histogram and counter, in enum order.
+const char* Metrics::histogram_names[Metrics::HISTOGRAM_COUNT] = {
+    "ADD_UNIT", "ADD_ITEM", "FIND_ITEM", "FIND_PATH_UNITS", "FIND_PATH_ITEMS",
+    "FIND_SPACE", "FIND_NEAREST_SPACE", "CAN_STORE", "FREE_SPACE", "PLAN_WAVE",
+    "CONSOLIDATE", "REMOVE_ITEM", "PICK", "PLAN_AGENTS", "RESERVE",
+    "RangeTree::rangeQuery", "Algorithms::fknapsack", "Algorithms::buildGraph", "Algorithms::dijkstra", "HierarchicalGraph::route",
+    "ContractionHierarchy::route", "Warehouse::distanceMatrix", "TourPlanner::plan", "Consolidator::plan", "AgentPlanner::plan",
+    "Warehouse::reserve"
+};
+const char* Metrics::counter_names[Metrics::COUNTER_COUNT] = {
+    "tree_inserts", "tree_updates", "tree_nodes_visited", "range_queries",
+    "dijkstra_runs", "heap_pushes", "heap_pops", "edges_relaxed",
+    "knapsack_runs", "knapsack_splits",
+    "graph_rebuilds", "graph_edges_built",
+    "spatial_queries", "spatial_nodes_visited", "spatial_rebuilds",
+    "hpa_nodes_visited", "hpa_cluster_rebuilds",
+    "ch_nodes_settled", "ch_shortcuts",
+    "consolidation_moves", "consolidation_skipped",
+    "withdrawals",
+    "agent_states_expanded",
+    "reservation_conflicts", "reservations_expired"
+};
+
+// CONSTRUCTOR: Creates a registry with every counter set to zero.
+Metrics::Metrics(){
+    for(int i = 0; i < COUNTER_COUNT; i++) counters[i].store(0, std::memory_order_relaxed);
+}
+
+// FUNCTION: Returns the process-wide registry. The instance is created on first use.
+Metrics& Metrics::instance(){
+    static Metrics metrics;
+    return metrics;
+}
+
+// FUNCTION: Writes the metrics as a section of the statistics export. Only histograms with samples are listed. Accepts
+// parameters out, the stream to write to, and indent, the prefix written before each line.
+void Metrics::print(std::ostream& out, std::string indent){
+    out << indent << "Metrics {" << std::endl;
+
+    out << indent << "\tLatency (ns) {" << std::endl;
+    for(int h = 0; h < HISTOGRAM_COUNT; h++){
+        LatencyHistogram& hist = histograms[h];
+        if(hist.getCount() == 0) continue;
+        out << indent << "\t\t" << histogram_names[h] << ": count=" << hist.getCount() << " mean=" << hist.getMean()
+            << " p50=" << hist.percentile(50) << " p90=" << hist.percentile(90) << " p99=" << hist.percentile(99)
+            << " max=" << hist.getMax() << std::endl;
+    }
+    out << indent << "\t}" << std::endl;
+
+    out << std::endl;
+
+    out << indent << "\tCounters {" << std::endl;
+    for(int c = 0; c < COUNTER_COUNT; c++){
+        out << indent << "\t\t" << counter_names[c] << ": " << counters[c].load(std::memory_order_relaxed) << std::endl;
+    }
+    out << indent << "\t}" << std::endl;
+
+    out << indent << "}" << std::endl;
+}
+
+// FUNCTION: Writes the metrics as a JSON document with a "latency_ns" object keyed by histogram name and a "counters"
+// object keyed by counter name.
+void Metrics::printJSON(std::ostream& out){
+    out << "{\n  \"latency_ns\": {";
+    bool first = true;
+    for(int h = 0; h < HISTOGRAM_COUNT; h++){
+        LatencyHistogram& hist = histograms[h];
+        if(hist.getCount() == 0) continue;
+        out << (first ? "\n" : ",\n") << "    \"" << histogram_names[h] << "\": {\"count\": " << hist.getCount()
+            << ", \"mean\": " << hist.getMean() << ", \"p50\": " << hist.percentile(50) << ", \"p90\": " << hist.percentile(90)
+            << ", \"p99\": " << hist.percentile(99) << ", \"max\": " << hist.getMax() << "}";
+        first = false;
+    }
+    out << "\n  },\n  \"counters\": {";
+    for(int c = 0; c < COUNTER_COUNT; c++){
+        out << (c == 0 ? "\n" : ",\n") << "    \"" << counter_names[c] << "\": " << counters[c].load(std::memory_order_relaxed);
+    }
+    out << "\n  }\n}" << std::endl;
+}
+
+#endif
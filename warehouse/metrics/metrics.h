@@ -0,0 +1,170 @@
+//
+// CSC 212 - Data Structures and Abstractions
+// Dominic Tucchio, Jennipher Day, Maya Geva, Thomas Williams
+// Spring 2024 Term Project - metrics.h
+//
+
+#ifndef Metrics_H
+#define Metrics_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+//
+// INSTRUMENTATION MACROS
+// The metrics layer is only compiled in when WAREHOUSE_METRICS is defined (e.g. -DWAREHOUSE_METRICS). Without it every
+// macro expands to nothing, so the instrumented code is identical to the uninstrumented code.
+//
+//   METRICS_COUNT(c)      Increments counter c by one.
+//   METRICS_ADD(c, n)     Increments counter c by n.
+//   METRICS_TIME(h)       Records the latency of the enclosing scope in histogram h.
+//
+
+#ifdef WAREHOUSE_METRICS
+    #define METRICS_CONCAT_INNER(a, b) a##b
+    #define METRICS_CONCAT(a, b) METRICS_CONCAT_INNER(a, b)
+    #define METRICS_COUNT(c) Metrics::instance().count(Metrics::c, 1)
+    #define METRICS_ADD(c, n) Metrics::instance().count(Metrics::c, (n))
+    #define METRICS_TIME(h) MetricsTimer METRICS_CONCAT(metrics_timer_, __LINE__)(Metrics::h)
+#else
+    #define METRICS_COUNT(c) ((void)0)
+    #define METRICS_ADD(c, n) ((void)0)
+    #define METRICS_TIME(h) ((void)0)
+#endif
+
+//
+// CLASS: LatencyHistogram
+// A fixed-size, HDR-style histogram of latencies in nanoseconds. Values are bucketed by their power of two and then into
+// 16 linear sub-buckets, so every recorded value is accurate to within 1/16 (about 6%) of its magnitude. Recording is a
+// handful of relaxed atomic increments and never allocates.
+//
+
+class LatencyHistogram {
+    public:
+        // CONSTANTS
+        static const int SUB_BUCKET_BITS = 4;
+        static const int SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+        static const int BUCKETS = (64 - SUB_BUCKET_BITS + 1) * SUB_BUCKETS;
+
+        // CONSTRUCTORS
+        LatencyHistogram();
+
+        // FUNCTIONS
+
+        // FUNCTION: Records a single latency sample.
+        void record(uint64_t ns);
+        // FUNCTION: Returns the number of samples recorded.
+        uint64_t getCount() const;
+        // FUNCTION: Returns the mean of all recorded samples.
+        uint64_t getMean() const;
+        // FUNCTION: Returns the largest recorded sample.
+        uint64_t getMax() const;
+        // FUNCTION: Returns the p-th percentile (0-100) of the recorded samples.
+        uint64_t percentile(double p) const;
+
+    private:
+        // FUNCTION: Returns the bucket a value is counted in.
+        static int bucketIndex(uint64_t ns);
+        // FUNCTION: Returns the largest value counted in a bucket.
+        static uint64_t bucketValue(int index);
+
+        // MEMBER VARIABLES
+
+        // COUNTS: The number of samples in each bucket.
+        std::atomic<uint64_t> counts[BUCKETS];
+        // COUNT, SUM, MAX: Running totals used for the mean and maximum.
+        std::atomic<uint64_t> count;
+        std::atomic<uint64_t> sum;
+        std::atomic<uint64_t> max;
+};
+
+//
+// CLASS: Metrics
+// Process-wide registry of latency histograms and hot-path counters. Histograms cover each command type in the commands
+// file as well as the internal operations that dominate their cost. Counters track the work done inside the data
+// structures and algorithms. The registry is exported as a section of warehouse_statistics.txt and as JSON.
+//
+
+class Metrics {
+    public:
+        // HISTOGRAMS: One latency histogram per command type and internal operation.
+        enum Histogram {
+            CMD_ADD_UNIT, CMD_ADD_ITEM, CMD_FIND_ITEM, CMD_FIND_PATH_UNITS, CMD_FIND_PATH_ITEMS,
+            CMD_FIND_SPACE, CMD_FIND_NEAREST_SPACE, CMD_CAN_STORE, CMD_FREE_SPACE, CMD_PLAN_WAVE,
+            CMD_CONSOLIDATE, CMD_REMOVE_ITEM, CMD_PICK, CMD_PLAN_AGENTS, CMD_RESERVE,
+            OP_RANGE_QUERY, OP_FKNAPSACK, OP_BUILD_GRAPH, OP_DIJKSTRA, OP_HPA_ROUTE, OP_CH_ROUTE,
+            OP_DISTANCE_MATRIX, OP_PLAN_TOUR, OP_PLAN_CONSOLIDATION, OP_PLAN_AGENTS,
+            OP_RESERVE,
+            HISTOGRAM_COUNT
+        };
+
+        // COUNTERS: Work counters incremented on the hot paths.
+        enum Counter {
+            TREE_INSERTS, TREE_UPDATES, TREE_NODES_VISITED, RANGE_QUERIES,
+            DIJKSTRA_RUNS, HEAP_PUSHES, HEAP_POPS, EDGES_RELAXED,
+            KNAPSACK_RUNS, KNAPSACK_SPLITS,
+            GRAPH_REBUILDS, GRAPH_EDGES_BUILT,
+            SPATIAL_QUERIES, SPATIAL_NODES_VISITED, SPATIAL_REBUILDS,
+            HPA_NODES_VISITED, HPA_CLUSTER_REBUILDS,
+            CH_NODES_SETTLED, CH_SHORTCUTS,
+            CONSOLIDATION_MOVES, CONSOLIDATION_SKIPPED,
+            WITHDRAWALS,
+            AGENT_STATES_EXPANDED,
+            RESERVATION_CONFLICTS, RESERVATIONS_EXPIRED,
+            COUNTER_COUNT
+        };
+
+        // FUNCTION: Returns the process-wide registry.
+        static Metrics& instance();
+
+        // FUNCTION: Increments a counter.
+        void count(Counter c, uint64_t n) { counters[c].fetch_add(n, std::memory_order_relaxed); }
+        // FUNCTION: Records a latency sample in a histogram.
+        void record(Histogram h, uint64_t ns) { histograms[h].record(ns); }
+
+        // FUNCTION: Writes the metrics as a section of the statistics export.
+        void print(std::ostream& out, std::string indent);
+        // FUNCTION: Writes the metrics as a JSON document.
+        void printJSON(std::ostream& out);
+
+    private:
+        // CONSTRUCTORS
+        Metrics();
+
+        // MEMBER VARIABLES
+
+        // HISTOGRAMS: The latency histograms, indexed by Histogram.
+        LatencyHistogram histograms[HISTOGRAM_COUNT];
+        // COUNTERS: The work counters, indexed by Counter.
+        std::atomic<uint64_t> counters[COUNTER_COUNT];
+
+        // NAMES: Display names used by the exports.
+        static const char* histogram_names[HISTOGRAM_COUNT];
+        static const char* counter_names[COUNTER_COUNT];
+};
+
+//
+// CLASS: MetricsTimer
+// Scoped timer that records the lifetime of the object in a Metrics histogram. Used through METRICS_TIME(...).
+//
+
+class MetricsTimer {
+    public:
+        // CONSTRUCTOR: Starts timing.
+        MetricsTimer(Metrics::Histogram h) : histogram(h), start(std::chrono::steady_clock::now()) {}
+        // DESTRUCTOR: Stops timing and records the elapsed time.
+        ~MetricsTimer(){
+            Metrics::instance().record(histogram, std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+        }
+
+    private:
+        // HISTOGRAM: The histogram the elapsed time is recorded in.
+        Metrics::Histogram histogram;
+        // START: The time the timer was created.
+        std::chrono::steady_clock::time_point start;
+};
+
+#endif
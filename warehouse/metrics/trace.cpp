@@ -0,0 +1,101 @@
+//
+// CSC 212 - Data Structures and Abstractions
+// Dominic Tucchio, Jennipher Day, Maya Geva, Thomas Williams
+// Spring 2024 Term Project - trace.cpp
+//
+
+#include "trace.h"
+
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+
+//
+// CLASS: TraceBuffer
+// Fixed-size ring buffer of TraceEvents owned by a single thread. Only the owning thread writes to the buffer, so
+// recording needs no locks; when the buffer is full the oldest events are overwritten. Buffers are linked into a global
+// list when they are created and live until the process exits so they can be flushed after their thread has finished.
+//
+
+// CONSTRUCTOR: Creates an empty buffer for the thread with the given id.
+TraceBuffer::TraceBuffer(int thread_id) : head(0) {
+    this->thread_id = thread_id;
+    this->next = nullptr;
+}
+
+//
+// CLASS: Tracer
+// Records spans into per-thread TraceBuffers and writes them in the Chrome Trace Event format, which can be opened in
+// chrome://tracing or Perfetto. Tracing starts disabled; Tracer::start(...) enables it and arranges for the buffers to be
+// flushed to the given file when the process exits.
+//
+
+// STATIC MEMBERS
+std::atomic<bool> Tracer::active(false);
+std::atomic<TraceBuffer*> Tracer::buffers(nullptr);
+std::atomic<int> Tracer::threads(0);
+std::chrono::steady_clock::time_point Tracer::epoch;
+std::string Tracer::file_name;
+
+// FUNCTION: Enables tracing and registers flush() to run when the process exits. Accepts parameter file_name, the path
+// of the Chrome trace JSON file to write.
+void Tracer::start(std::string file_name){
+    Tracer::file_name = file_name;
+    epoch = std::chrono::steady_clock::now();
+    active.store(true, std::memory_order_release);
+    std::atexit(Tracer::flush);
+}
+
+// FUNCTION: Returns the number of nanoseconds since tracing started.
+uint64_t Tracer::now(){
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch).count();
+}
+
+// FUNCTION: Returns the calling thread's buffer. The first call on each thread creates the buffer and pushes it onto
+// the global list with a compare-and-swap, so threads never block each other.
+TraceBuffer* Tracer::buffer(){
+    thread_local TraceBuffer* local = nullptr;
+    if(local == nullptr){
+        local = new TraceBuffer(threads.fetch_add(1, std::memory_order_relaxed) + 1);
+        TraceBuffer* head = buffers.load(std::memory_order_relaxed);
+        do {
+            local->next = head;
+        } while(!buffers.compare_exchange_weak(head, local, std::memory_order_release, std::memory_order_relaxed));
+    }
+    return local;
+}
+
+// FUNCTION: Records a completed span on the calling thread's buffer. Accepts parameters name, the span's name, and
+// start and end, the span's bounds as returned by now().
+void Tracer::record(const char* name, uint64_t start, uint64_t end){
+    buffer()->push({name, start, end - start});
+}
+
+// FUNCTION: Writes every buffered event as a Chrome Trace Event "complete" (ph "X") event, with timestamps and
+// durations in microseconds, preceded by a thread name for each buffer. Tracing is disabled before the file is written
+// so this function only runs once even if it is also called explicitly.
+void Tracer::flush(){
+    if(!active.exchange(false)) return;
+
+    std::ofstream out(file_name);
+    out << std::fixed << std::setprecision(3);
+    out << "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [";
+
+    bool first = true;
+    for(TraceBuffer* b = buffers.load(std::memory_order_acquire); b != nullptr; b = b->next){
+        uint64_t head = b->head.load(std::memory_order_acquire);
+        uint64_t begin = head > TraceBuffer::CAPACITY ? head - TraceBuffer::CAPACITY : 0;
+
+        out << (first ? "\n" : ",\n") << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": " << b->thread_id
+            << ", \"args\": {\"name\": \"thread " << b->thread_id << "\"}}";
+        first = false;
+
+        for(uint64_t i = begin; i < head; i++){
+            const TraceEvent& e = b->events[i % TraceBuffer::CAPACITY];
+            out << ",\n{\"name\": \"" << e.name << "\", \"cat\": \"warehouse\", \"ph\": \"X\", \"pid\": 1, \"tid\": " << b->thread_id
+                << ", \"ts\": " << e.start / 1000.0 << ", \"dur\": " << e.duration / 1000.0 << "}";
+        }
+    }
+
+    out << "\n]}" << std::endl;
+}
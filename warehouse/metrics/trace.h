@@ -0,0 +1,143 @@
+//
+// CSC 212 - Data Structures and Abstractions
+// Dominic Tucchio, Jennipher Day, Maya Geva, Thomas Williams
+// Spring 2024 Term Project - trace.h
+//
+
+#ifndef Trace_H
+#define Trace_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+//
+// TRACING MACROS
+// Tracing is enabled at runtime by Tracer::start(...) (the --trace command line option). While it is disabled a span
+// costs a single relaxed atomic load.
+//
+//   TRACE_SCOPE(name)     Records a span named name covering the enclosing scope. name must be a string literal.
+//
+
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+#define TRACE_SCOPE(name) TraceScope TRACE_CONCAT(trace_scope_, __LINE__)(name)
+
+//
+// STRUCTURE: TraceEvent
+// A completed span: the name of the span and its start time and duration in nanoseconds since the trace began.
+//
+
+struct TraceEvent {
+    const char* name;
+    uint64_t start;
+    uint64_t duration;
+};
+
+//
+// CLASS: TraceBuffer
+// Fixed-size ring buffer of TraceEvents owned by a single thread. Only the owning thread writes to the buffer, so
+// recording needs no locks; when the buffer is full the oldest events are overwritten. Buffers are linked into a global
+// list when they are created and live until the process exits so they can be flushed after their thread has finished.
+//
+
+class TraceBuffer {
+    public:
+        // CONSTANTS
+        static const uint64_t CAPACITY = 1 << 16;
+
+        // CONSTRUCTORS
+        TraceBuffer(int thread_id);
+
+        // FUNCTION: Appends an event, overwriting the oldest event if the buffer is full.
+        void push(const TraceEvent& e){
+            uint64_t h = head.load(std::memory_order_relaxed);
+            events[h % CAPACITY] = e;
+            head.store(h + 1, std::memory_order_release);
+        }
+
+    private:
+        // MEMBER VARIABLES
+
+        // EVENTS: The ring of recorded events.
+        TraceEvent events[CAPACITY];
+        // HEAD: The total number of events ever pushed. The next event is written at head % CAPACITY.
+        std::atomic<uint64_t> head;
+        // THREAD_ID: Sequential id of the owning thread, used as the "tid" of its events.
+        int thread_id;
+        // NEXT: The next buffer in the global list of buffers.
+        TraceBuffer* next;
+
+    // FRIEND CLASS: Declaring Tracer as a friend class so that it can link and flush buffers.
+    friend class Tracer;
+};
+
+//
+// CLASS: Tracer
+// Records spans into per-thread TraceBuffers and writes them in the Chrome Trace Event format, which can be opened in
+// chrome://tracing or Perfetto. Tracing starts disabled; Tracer::start(...) enables it and arranges for the buffers to be
+// flushed to the given file when the process exits.
+//
+
+class Tracer {
+    public:
+        // FUNCTION: Enables tracing. The trace is written to file_name at exit.
+        static void start(std::string file_name);
+        // FUNCTION: Returns true if tracing is enabled.
+        static bool enabled() { return active.load(std::memory_order_relaxed); }
+        // FUNCTION: Returns the number of nanoseconds since tracing started.
+        static uint64_t now();
+        // FUNCTION: Records a completed span on the calling thread's buffer.
+        static void record(const char* name, uint64_t start, uint64_t end);
+        // FUNCTION: Writes every buffered event to the trace file and disables tracing.
+        static void flush();
+
+    private:
+        // FUNCTION: Returns the calling thread's buffer, creating and linking it on first use.
+        static TraceBuffer* buffer();
+
+        // MEMBER VARIABLES
+
+        // ACTIVE: Whether spans are currently recorded.
+        static std::atomic<bool> active;
+        // BUFFERS: Head of the lock-free list of every thread's buffer.
+        static std::atomic<TraceBuffer*> buffers;
+        // THREADS: The number of buffers created, used to assign thread ids.
+        static std::atomic<int> threads;
+        // EPOCH: The time tracing started.
+        static std::chrono::steady_clock::time_point epoch;
+        // FILE_NAME: The file the trace is written to.
+        static std::string file_name;
+};
+
+//
+// CLASS: TraceScope
+// Records a span from its construction until end() is called or it goes out of scope. Used through TRACE_SCOPE(...)
+// or directly when a span does not line up with a C++ scope.
+//
+
+class TraceScope {
+    public:
+        // CONSTRUCTOR: Starts the span if tracing is enabled.
+        TraceScope(const char* name) : name(name), start(0), open(Tracer::enabled()) {
+            if(open) start = Tracer::now();
+        }
+        // DESTRUCTOR: Ends the span if it is still open.
+        ~TraceScope() { end(); }
+
+        // FUNCTION: Ends the span early.
+        void end(){
+            if(open) Tracer::record(name, start, Tracer::now());
+            open = false;
+        }
+
+    private:
+        // NAME, START: The span's name and start time.
+        const char* name;
+        uint64_t start;
+        // OPEN: Whether the span still needs to be recorded.
+        bool open;
+};
+
+#endif
@@ -0,0 +1,172 @@
+//
+// CSC 212 - Data Structures and Abstractions
+// Dominic Tucchio, Jennipher Day, Maya Geva, Thomas Williams
+// Spring 2024 Term Project - parallel.h
+//
+
+#ifndef Parallel_H
+#define Parallel_H
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// FUNCTION: Returns the number of threads parallel loops are limited to, or 0 for one thread per core.
+inline std::atomic<int>& parallelismLimit(){
+    static std::atomic<int> limit(0);
+    return limit;
+}
+
+// FUNCTION: Limits parallel loops to a number of threads, or lets them use one thread per core if threads is 0 or less.
+inline void setParallelism(int threads){
+    parallelismLimit().store(std::max(0, threads));
+}
+
+// FUNCTION: Returns the number of threads parallel loops use.
+inline int parallelism(){
+    int limit = parallelismLimit().load();
+    return limit > 0 ? limit : std::max(1u, std::thread::hardware_concurrency());
+}
+
+// FUNCTION: Returns true while the calling thread is running an index of a parallelFor(...) call.
+inline bool& parallelNested(){
+    static thread_local bool nested = false;
+    return nested;
+}
+
+//
+// CLASS: WorkerPool
+// The threads that run parallelFor(...) loops alongside the calling thread. Workers are started the first time a loop
+// needs them and then wait for the next loop, so a loop costs a wake-up rather than starting and joining threads, and
+// per-thread state such as trace buffers is made once per worker rather than once per loop. The pool grows to the most
+// threads a loop has asked for and its workers are joined when the program exits. It runs one loop at a time.
+//
+
+class WorkerPool {
+    public:
+        // FUNCTION: Returns the pool shared by every parallelFor(...) call.
+        static WorkerPool& instance(){
+            static WorkerPool pool;
+            return pool;
+        }
+
+        // FUNCTION: Calls f(0) to f(count - 1) on the calling thread and up to helpers workers, each taking the next index
+        // as it finishes the last, and returns once every index has finished. Returns false without calling f if the pool
+        // is running another loop.
+        bool run(int count, int helpers, const std::function<void(int)>& f){
+            std::unique_lock<std::mutex> running(busy, std::try_to_lock);
+            if(!running.owns_lock()) return false;
+            {
+                std::lock_guard<std::mutex> guard(lock);
+                while((int)workers.size() < helpers) workers.emplace_back([this](){ work(); });
+                job = &f;
+                job_count = count;
+                next = 0;
+                slots = helpers;
+            }
+            wake.notify_all();
+            take(f, count);
+            // Workers that have not joined by now are not needed; the caller waits for those that did.
+            std::unique_lock<std::mutex> guard(lock);
+            slots = 0;
+            done.wait(guard, [this](){ return active == 0; });
+            job = nullptr;
+            return true;
+        }
+
+        ~WorkerPool(){
+            {
+                std::lock_guard<std::mutex> guard(lock);
+                stopping = true;
+            }
+            wake.notify_all();
+            for(std::thread& worker : workers) worker.join();
+        }
+
+    private:
+        WorkerPool() {}
+
+        // FUNCTION: Runs the indices of a loop until none are left.
+        void take(const std::function<void(int)>& f, int count){
+            parallelNested() = true;
+            for(int i = next++; i < count; i = next++) f(i);
+            parallelNested() = false;
+        }
+
+        // FUNCTION: The loop of each worker: waits for a loop with a free slot, helps run it, and waits again.
+        void work(){
+            std::unique_lock<std::mutex> guard(lock);
+            while(true){
+                wake.wait(guard, [this](){ return stopping || slots > 0; });
+                if(stopping) return;
+                slots--;
+                active++;
+                const std::function<void(int)>& f = *job;
+                int count = job_count;
+                guard.unlock();
+                take(f, count);
+                guard.lock();
+                if(--active == 0) done.notify_all();
+            }
+        }
+
+        // MEMBER VARIABLES
+
+        // BUSY: Held by the thread whose loop the pool is running.
+        std::mutex busy;
+        // LOCK, WAKE, DONE: Guard the loop's state below, wake workers for a loop, and wake the caller once the workers
+        // that joined it are finished.
+        std::mutex lock;
+        std::condition_variable wake;
+        std::condition_variable done;
+        std::vector<std::thread> workers;
+        // JOB, JOB_COUNT, NEXT: The loop being run, its number of indices, and the next index to take.
+        const std::function<void(int)>* job = nullptr;
+        int job_count = 0;
+        std::atomic<int> next{0};
+        // SLOTS, ACTIVE: The number of workers that may still join the loop and the number running it.
+        int slots = 0;
+        int active = 0;
+        bool stopping = false;
+};
+
+// FUNCTION: Calls f(0) to f(count - 1) spread over one thread per core, or over the number of threads set with
+// setParallelism(...), each thread taking the next index as it finishes the last. The calling thread takes part and the
+// others come from the WorkerPool, so nothing is started for a single index or on a single core, and threads are only
+// started the first time they are needed. A call made from inside f, or while the pool is running a loop for another
+// thread, runs on the calling thread alone, so nested loops, such as the distance rows of every floor of a Site, do not
+// ask for a thread per core for each outer index. f must be safe to call from several threads at once.
+inline void parallelFor(int count, const std::function<void(int)>& f){
+    int threads = std::min<int>(count, parallelism());
+    if(parallelNested() || threads <= 1 || !WorkerPool::instance().run(count, threads - 1, f)){
+        bool nested = parallelNested();
+        parallelNested() = true;
+        for(int i = 0; i < count; i++) f(i);
+        parallelNested() = nested;
+    }
+    return;
+}
+
+// PARALLEL_MIN_CELLS: The smallest floor whose rows are split over threads; waking workers costs more than a loop over
+// a smaller floor.
+static constexpr long long PARALLEL_MIN_CELLS = 1 << 16;
+
+// FUNCTION: Splits the rows of a floor of rows x cols cells into bands of band_rows rows and calls f(band, first, last)
+// for each band, where first and last are the band's first row and the row after its last, spread over threads with
+// parallelFor(...). Floors of fewer than PARALLEL_MIN_CELLS cells are split the same way but run on the calling thread.
+// The bands are the same whatever the number of threads, so a caller that keeps one result per band and merges them in
+// band order gets the same result as a loop over the rows. Returns the number of bands.
+inline int parallelRows(int rows, int cols, int band_rows, const std::function<void(int, int, int)>& f){
+    int bands = (rows + band_rows - 1) / band_rows;
+    auto band = [&](int b){ f(b, b * band_rows, std::min(rows, (b + 1) * band_rows)); };
+    if((long long)rows * cols < PARALLEL_MIN_CELLS){
+        for(int b = 0; b < bands; b++) band(b);
+    } else parallelFor(bands, band);
+    return bands;
+}
+
+#endif
@@ -0,0 +1,132 @@
+//
+// CSC 212 - Data Structures and Abstractions
+// Dominic Tucchio, Jennipher Day, Maya Geva, Thomas Williams
+// Spring 2024 Term Project - placement.cpp
+//
+
+#include "placement.h"
+#include "metrics/trace.h"
+
+#include <cstdlib>
+
+//
+// CLASS: PlacementPolicy
+// Decides where Warehouse::add(...) stores an Item. choose(...) picks the StorageUnit for an Item that fits in a single
+// StorageUnit, and priority(...) orders the StorageUnits an Item is split over by Algorithms::fknapsack(...) when none
+// does. invalidate() is called whenever a StorageUnit is added, so a policy can drop anything it precomputed about the
+// floor, and clone() copies the policy for a Warehouse made by Warehouse::fork().
+//
+
+// CLASS INSTANTIATION: The algorithms used to measure distances from the dock.
+static Algorithms alg;
+
+// HEADROOM: How much more capacity than is already used the nearest StorageUnits must have to make up the region Items
+// are ranked over. Without it the slowest movers would be sent to the far end of a mostly empty floor.
+static const double HEADROOM = 1.5;
+
+// FUNCTION: Finds the StorageUnit with the least free space that still has at least space free. Accepts parameters floor,
+// i, the Item being stored, space, the space it needs, and target, which is set to the StorageUnit found. Returns false
+// if no StorageUnit fits.
+bool BestFitPolicy::choose(PlacementContext& floor, const Item& i, int space, UnitHandle& target){
+    return floor.tree.bestFit(space, target);
+}
+
+// CONSTRUCTOR: Creates a policy that places Items as close as possible to anchor.
+NearestFitPolicy::NearestFitPolicy(std::pair<int, int> anchor){
+    this->anchor = anchor;
+}
+
+// FUNCTION: Finds the StorageUnit closest to the anchor with at least space free. Accepts parameters floor, i, the Item
+// being stored, space, the space it needs, and target, which is set to the StorageUnit found. Returns false if no
+// StorageUnit fits. The query reuses the candidates buffer, so it makes no heap allocations once the buffer has grown.
+bool NearestFitPolicy::choose(PlacementContext& floor, const Item& i, int space, UnitHandle& target){
+    floor.spatial.nearest(anchor, space, 1, candidates);
+    if(candidates.empty()) return false;
+    target = candidates[0];
+    return true;
+}
+
+// CONSTRUCTOR: Creates a policy that ranks StorageUnits by their distance from dock.
+VelocityPolicy::VelocityPolicy(std::pair<int, int> dock){
+    this->dock = dock;
+}
+
+// FUNCTION: Recalculates what the policy knows about the floor and the pick counts, but only the parts that changed. The
+// length of the shortest path from the dock to every cell is found with a single run of Dijkstra's Algorithm whenever
+// a StorageUnit was added, and the StorageUnits are sorted by it. The pick counts are sorted whenever they changed. A
+// dock outside of the floor is moved to the closest cell inside it. Both are built anew rather than changed in place, as
+// clones of the policy may still share the old ones.
+void VelocityPolicy::refresh(PlacementContext& floor){
+    if(!current || layout->rows != floor.units.getRows() || layout->cols != floor.units.getCols()){
+        TRACE_SCOPE("velocity slots");
+        std::pair<int, int> from = {std::min(std::max(dock.first, 0), floor.units.getRows() - 1), std::min(std::max(dock.second, 0), floor.units.getCols() - 1)};
+        std::shared_ptr<VelocityLayout> next = std::make_shared<VelocityLayout>();
+        next->rows = floor.units.getRows();
+        next->cols = floor.units.getCols();
+        next->distance = alg.distances(floor.units, floor.graph, from);
+        floor.units.forEach([&](const GridCell& u){
+            next->slots.push_back({next->distance[coordToIndex(u.loc, next->cols)], u.loc});
+        });
+        std::sort(next->slots.begin(), next->slots.end());
+        for(std::pair<int, std::pair<int, int> >& slot : next->slots) next->reach.push_back((next->reach.empty() ? 0 : next->reach.back()) + floor.units.capacityAt(slot.second));
+        layout = next;
+        current = true;
+    }
+    if(version != floor.version){
+        std::shared_ptr<std::vector<long long> > next = std::make_shared<std::vector<long long> >();
+        for(const std::pair<const std::string, long long>& p : floor.picks){
+            if(p.second > 0) next->push_back(p.second);
+        }
+        std::sort(next->begin(), next->end(), std::greater<long long>());
+        ranking = next;
+        version = floor.version;
+    }
+    return;
+}
+
+// FUNCTION: Returns the position in slots that matches how often an Item is picked: the share of picked Items that are
+// picked more often than it, scaled to the region of the nearest StorageUnits that hold HEADROOM times the space used
+// once the Item's space is stored. Items never picked rank last.
+int VelocityPolicy::target(PlacementContext& floor, const Item& i, int space){
+    std::unordered_map<std::string, long long>::const_iterator found = floor.picks.find(i.name);
+    long long picks = found == floor.picks.end() ? 0 : found->second;
+    const std::vector<long long>& reach = layout->reach;
+    long long faster = std::lower_bound(ranking->begin(), ranking->end(), picks, std::greater<long long>()) - ranking->begin();
+    int region = std::lower_bound(reach.begin(), reach.end(), (long long)(HEADROOM * (floor.used + space))) - reach.begin();
+    region = std::min(region, (int)layout->slots.size() - 1);
+    return (int)(faster * (double)region / ranking->size());
+}
+
+// FUNCTION: Finds the StorageUnit with at least space free whose dock distance rank is closest to the rank of Item i,
+// searching outward from that rank in both directions. Accepts parameters floor, i, space, the space the Item needs,
+// and target, which is set to the StorageUnit found. Returns false if no StorageUnit fits. Falls back to the best fit
+// until any Item has been picked.
+bool VelocityPolicy::choose(PlacementContext& floor, const Item& i, int space, UnitHandle& target){
+    refresh(floor);
+    const std::vector<std::pair<int, std::pair<int, int> > >& slots = layout->slots;
+    if(ranking->empty() || slots.empty()) return floor.tree.bestFit(space, target);
+
+    int start = this->target(floor, i, space);
+    for(int d = 0; start + d < (int)slots.size() || start - d >= 0; d++){
+        for(int side = 0; side < (d == 0 ? 1 : 2); side++){
+            int position = side == 0 ? start + d : start - d;
+            if(position < 0 || position >= (int)slots.size()) continue;
+            std::pair<int, int> loc = slots[position].second;
+            int free = floor.units.capacityAt(loc) - floor.units.usedAt(loc) - floor.reserved.held(loc);
+            if(free >= space){
+                target = {loc, free};
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+// FUNCTION: Ranks a StorageUnit for a split Item by how far its dock distance is from that of the StorageUnit matching
+// the Item's rank, so the Item is spread outward from where choose(...) would have put it. Accepts parameters floor, i,
+// and loc, the location of the StorageUnit.
+double VelocityPolicy::priority(PlacementContext& floor, const Item& i, std::pair<int, int> loc){
+    refresh(floor);
+    if(ranking->empty() || layout->slots.empty()) return 0;
+    return std::abs(layout->distance[coordToIndex(loc, layout->cols)] - layout->slots[target(floor, i, i.size_per_unit * i.quantity)].first);
+}
@@ -0,0 +1,155 @@
+//
+// CSC 212 - Data Structures and Abstractions
+// Dominic Tucchio, Jennipher Day, Maya Geva, Thomas Williams
+// Spring 2024 Term Project - placement.h
+//
+
+#ifndef Placement_H
+#define Placement_H
+
+#include "container.h"
+#include "reservation.h"
+#include "dsa/range_tree.h"
+#include "dsa/algorithms.h"
+#include "dsa/grid.h"
+#include "dsa/kd_tree.h"
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+//
+// STRUCTURE: PlacementContext
+// The parts of a Warehouse a PlacementPolicy can consult: the floor, its graph, the indexes of free space, the space held
+// by reservations, and how often each Item has been picked. The indexes of free space already leave out held space, but
+// the Grid does not. USED is the space already used on the floor and VERSION changes whenever the pick counts do.
+//
+
+struct PlacementContext {
+    Grid& units;
+    Graph& graph;
+    RangeTree& tree;
+    KDTree& spatial;
+    const ReservationBook& reserved;
+    const std::unordered_map<std::string, long long>& picks;
+    int used;
+    unsigned long long version;
+};
+
+//
+// CLASS: PlacementPolicy
+// Decides where Warehouse::add(...) stores an Item. choose(...) picks the StorageUnit for an Item that fits in a single
+// StorageUnit, and priority(...) orders the StorageUnits an Item is split over by Algorithms::fknapsack(...) when none
+// does. invalidate() is called whenever a StorageUnit is added, so a policy can drop anything it precomputed about the
+// floor, and clone() copies the policy for a Warehouse made by Warehouse::fork().
+//
+
+class PlacementPolicy {
+    public:
+        // DESTRUCTOR
+        virtual ~PlacementPolicy() {}
+
+        // FUNCTIONS
+
+        // CHOOSE: Finds a StorageUnit with at least space free for Item i. Returns false if none fits.
+        virtual bool choose(PlacementContext& floor, const Item& i, int space, UnitHandle& target) = 0;
+        // PRIORITY: Returns the rank of a StorageUnit when Item i is split, lowest first. By default every StorageUnit
+        // ranks the same, so the Item is split in row-major order.
+        virtual double priority(PlacementContext& floor, const Item& i, std::pair<int, int> loc) { return 0; }
+        // INVALIDATE: Called after a StorageUnit is added to the floor.
+        virtual void invalidate() {}
+        // CLONE: Returns a copy of the policy, including anything it precomputed about the floor.
+        virtual std::unique_ptr<PlacementPolicy> clone() = 0;
+};
+
+//
+// CLASS: BestFitPolicy
+// Stores an Item in the StorageUnit with the least free space that fits it, found by a single descent of the RangeTree.
+// The default policy.
+//
+
+class BestFitPolicy : public PlacementPolicy {
+    public:
+        bool choose(PlacementContext& floor, const Item& i, int space, UnitHandle& target) override;
+        std::unique_ptr<PlacementPolicy> clone() override { return std::unique_ptr<PlacementPolicy>(new BestFitPolicy(*this)); }
+};
+
+//
+// CLASS: NearestFitPolicy
+// Stores an Item in the StorageUnit that fits it closest to an anchor location such as a loading dock, found by a
+// nearest neighbor query on the KDTree.
+//
+
+class NearestFitPolicy : public PlacementPolicy {
+    public:
+        // CONSTRUCTORS
+        NearestFitPolicy(std::pair<int, int> anchor);
+
+        bool choose(PlacementContext& floor, const Item& i, int space, UnitHandle& target) override;
+        std::unique_ptr<PlacementPolicy> clone() override { return std::unique_ptr<PlacementPolicy>(new NearestFitPolicy(anchor)); }
+
+    private:
+        // ANCHOR: The location distance is measured from.
+        std::pair<int, int> anchor;
+        // CANDIDATES: The results of the last nearest neighbor query. Kept between calls so its buffer is reused.
+        std::vector<UnitHandle> candidates;
+};
+
+//
+// STRUCTURE: VelocityLayout
+// What a VelocityPolicy knows about the floor. ROWS, COLS, and DISTANCE are the size of the floor and the length of the
+// shortest path from the dock to every cell, by graph index. SLOTS holds the dock distance and location of every
+// StorageUnit, nearest first, and REACH the total capacity of the StorageUnits up to and including each one.
+//
+
+struct VelocityLayout {
+    int rows = 0, cols = 0;
+    std::vector<int> distance;
+    std::vector<std::pair<int, std::pair<int, int> > > slots;
+    std::vector<long long> reach;
+};
+
+//
+// CLASS: VelocityPolicy
+// Slots Items by how often they are picked. Every StorageUnit is ranked by the length of the shortest path to it from the
+// dock, and every Item by its pick count. An Item is stored in the StorageUnit that fits it whose rank is closest to the
+// Item's own among the StorageUnits nearest the dock with room for the stock: the most picked Items go nearest to the
+// dock and rarely picked ones furthest away, leaving the near StorageUnits free for the fast movers that follow. Items
+// split over several StorageUnits are spread outward from the same rank. Until any Item has been picked this is the same as BestFitPolicy.
+// The slots and the ranking are replaced rather than changed when they are recalculated, so clones share them.
+//
+
+class VelocityPolicy : public PlacementPolicy {
+    public:
+        // CONSTRUCTORS
+        VelocityPolicy(std::pair<int, int> dock);
+
+        bool choose(PlacementContext& floor, const Item& i, int space, UnitHandle& target) override;
+        double priority(PlacementContext& floor, const Item& i, std::pair<int, int> loc) override;
+        void invalidate() override { current = false; }
+        std::unique_ptr<PlacementPolicy> clone() override { return std::unique_ptr<PlacementPolicy>(new VelocityPolicy(*this)); }
+
+    private:
+        // FUNCTIONS
+
+        // REFRESH: Recalculates the dock distances and the rankings if the floor or the pick counts changed.
+        void refresh(PlacementContext& floor);
+        // TARGET: Returns the position in slots that matches how often an Item is picked.
+        int target(PlacementContext& floor, const Item& i, int space);
+
+        // MEMBER VARIABLES
+
+        // DOCK: The location paths are measured from.
+        std::pair<int, int> dock;
+        // CURRENT, VERSION: False if a StorageUnit was added since the distances were calculated, and the version of the
+        // pick counts the ranking was built from.
+        bool current = false;
+        unsigned long long version = 0;
+        // LAYOUT: The dock distances and slots of the floor, shared with clones of the policy.
+        std::shared_ptr<const VelocityLayout> layout = std::make_shared<VelocityLayout>();
+        // RANKING: The pick count of every Item that has been picked, most picked first, shared with clones of the policy.
+        std::shared_ptr<const std::vector<long long> > ranking = std::make_shared<std::vector<long long> >();
+};
+
+#endif
@@ -0,0 +1,239 @@
+//
+// CSC 212 - Data Structures and Abstractions
+// Dominic Tucchio, Jennipher Day, Maya Geva, Thomas Williams
+// Spring 2024 Term Project - reservation.cpp
+//
+
+#include "reservation.h"
+
+#include <algorithm>
+
+//
+// CLASS: ReservationBook
+// The space held in each StorageUnit by open Reservations, and the Reservations themselves, spread over stripes that
+// each have their own lock. A thread never holds two stripe locks at once, so threads cannot deadlock on them.
+//
+
+// CONSTRUCTOR: Creates a ReservationBook with nothing held.
+ReservationBook::ReservationBook() : stripes(new Stripe[STRIPES]), next_id(1), holding(0), reservations(0), changes(0) {
+
+}
+
+// FUNCTION: Holds space for an Item at a StorageUnit. The space already held there, and the size any other hold for the
+// same name is held at, are read and changed under the stripe's lock, so two threads holding space at the same
+// StorageUnit at once never hold more than it has free or hold the same name at two sizes. Accepts parameters loc, i,
+// the Item, whose size per unit is used, quantity, the most units to hold space for, free, the StorageUnit's capacity
+// less its used capacity, and all, which holds nothing unless the whole quantity fits. Returns the quantity held.
+int ReservationBook::hold(std::pair<int, int> loc, const Item& i, int quantity, int free, bool all){
+    int size_per_unit = i.size_per_unit;
+    if(size_per_unit <= 0 || quantity <= 0) return 0;
+    Stripe& s = stripe(key(loc));
+    std::lock_guard<std::mutex> guard(s.lock);
+    std::unordered_map<long long, HeldSpace>::iterator found = s.held.find(key(loc));
+    int taken = found == s.held.end() ? 0 : found->second.space;
+    if(found != s.held.end()){
+        std::map<std::string, std::pair<int, int> >::const_iterator same = found->second.items.find(i.name);
+        if(same != found->second.items.end() && same->second.first != size_per_unit) return 0;
+    }
+    int fits = std::min(std::max(free - taken, 0) / size_per_unit, quantity);
+    if(fits == 0 || (all && fits < quantity)) return 0;
+    HeldSpace& h = found == s.held.end() ? s.held[key(loc)] : found->second;
+    h.space += fits * size_per_unit;
+    std::pair<int, int>& item = h.items[i.name];
+    item.first = size_per_unit;
+    item.second += fits * size_per_unit;
+    s.changed.push_back(loc);
+    holding.fetch_add(fits * size_per_unit, std::memory_order_release);
+    changes.fetch_add(1, std::memory_order_release);
+    return fits;
+}
+
+// FUNCTION: Releases space held for an Item name at a StorageUnit, forgetting the name once nothing is held for it and
+// the StorageUnit once nothing is held there. Accepts parameters loc, name, and space.
+void ReservationBook::release(std::pair<int, int> loc, const std::string& name, int space){
+    Stripe& s = stripe(key(loc));
+    std::lock_guard<std::mutex> guard(s.lock);
+    std::unordered_map<long long, HeldSpace>::iterator found = s.held.find(key(loc));
+    if(found == s.held.end()) return;
+    std::map<std::string, std::pair<int, int> >::iterator item = found->second.items.find(name);
+    if(item == found->second.items.end()) return;
+    space = std::min(space, item->second.second);
+    item->second.second -= space;
+    if(item->second.second == 0) found->second.items.erase(item);
+    found->second.space -= space;
+    if(found->second.space == 0) s.held.erase(found);
+    s.changed.push_back(loc);
+    holding.fetch_sub(space, std::memory_order_release);
+    changes.fetch_add(1, std::memory_order_release);
+    return;
+}
+
+// FUNCTION: Releases every hold of a Reservation. Called with no stripe locked.
+void ReservationBook::release(const Reservation& reservation){
+    for(const std::pair<std::pair<int, int>, int>& h : reservation.holds) release(h.first, reservation.item.name, h.second * reservation.item.size_per_unit);
+    return;
+}
+
+// FUNCTION: Returns the space held at a StorageUnit. While nothing is held anywhere, which is the common case, no lock is
+// taken. Accepts parameter loc.
+int ReservationBook::held(std::pair<int, int> loc) const {
+    if(holding.load(std::memory_order_acquire) == 0) return 0;
+    Stripe& s = stripe(key(loc));
+    std::lock_guard<std::mutex> guard(s.lock);
+    std::unordered_map<long long, HeldSpace>::const_iterator found = s.held.find(key(loc));
+    return found == s.held.end() ? 0 : found->second.space;
+}
+
+// FUNCTION: Records a Reservation whose space has already been held with hold(...). Accepts parameter reservation.
+// Returns the id it was given.
+long long ReservationBook::open(Reservation reservation){
+    reservation.id = next_id.fetch_add(1);
+    reservation.state = RESERVATION_HELD;
+    long long id = reservation.id;
+    Stripe& s = stripe(id);
+    std::lock_guard<std::mutex> guard(s.lock);
+    s.open.emplace(id, std::move(reservation));
+    reservations.fetch_add(1, std::memory_order_relaxed);
+    return id;
+}
+
+// FUNCTION: Commits a held Reservation, so its Items are stored the next time the Warehouse settles its reservations.
+// A Reservation past its deadline is expired instead and its space released. Committing a Reservation twice does
+// nothing. Accepts parameters id and now_ns, the current steady clock time. Returns the Reservation's state afterwards.
+ReservationState ReservationBook::commit(long long id, long long now_ns){
+    Reservation expired;
+    {
+        Stripe& s = stripe(id);
+        std::lock_guard<std::mutex> guard(s.lock);
+        std::unordered_map<long long, Reservation>::iterator found = s.open.find(id);
+        if(found == s.open.end()) return RESERVATION_UNKNOWN;
+        if(found->second.state == RESERVATION_COMMITTED) return RESERVATION_COMMITTED;
+        if(found->second.state == RESERVATION_CANCELLED){
+            s.open.erase(found);
+            return RESERVATION_CANCELLED;
+        }
+        if(now_ns < found->second.deadline_ns){
+            found->second.state = RESERVATION_COMMITTED;
+            changes.fetch_add(1, std::memory_order_release);
+            return RESERVATION_COMMITTED;
+        }
+        expired = std::move(found->second);
+        s.open.erase(found);
+    }
+    reservations.fetch_sub(1, std::memory_order_relaxed);
+    release(expired);
+    return RESERVATION_EXPIRED;
+}
+
+// FUNCTION: Aborts a held Reservation and releases its space. A committed Reservation can no longer be aborted. Accepts
+// parameter id. Returns the Reservation's state afterwards.
+ReservationState ReservationBook::abort(long long id){
+    Reservation aborted;
+    {
+        Stripe& s = stripe(id);
+        std::lock_guard<std::mutex> guard(s.lock);
+        std::unordered_map<long long, Reservation>::iterator found = s.open.find(id);
+        if(found == s.open.end()) return RESERVATION_UNKNOWN;
+        if(found->second.state == RESERVATION_COMMITTED) return RESERVATION_COMMITTED;
+        if(found->second.state == RESERVATION_CANCELLED){
+            s.open.erase(found);
+            return RESERVATION_CANCELLED;
+        }
+        aborted = std::move(found->second);
+        s.open.erase(found);
+    }
+    reservations.fetch_sub(1, std::memory_order_relaxed);
+    release(aborted);
+    return RESERVATION_ABORTED;
+}
+
+// FUNCTION: Cancels every open Reservation with a hold at a StorageUnit, for example because the StorageUnit was replaced,
+// and releases all of its holds. A cancelled Reservation stays in the book with no holds until it is next committed or
+// aborted, which reports it as cancelled, or until its deadline. Accepts parameters loc and cancelled, to which copies of
+// the cancelled Reservations are appended with their holds. Returns the number cancelled.
+int ReservationBook::cancel(std::pair<int, int> loc, std::vector<Reservation>& cancelled){
+    int count = 0;
+    for(int k = 0; k < STRIPES; k++){
+        Stripe& s = stripes[k];
+        std::lock_guard<std::mutex> guard(s.lock);
+        for(std::pair<const long long, Reservation>& r : s.open){
+            if(r.second.state == RESERVATION_CANCELLED) continue;
+            bool holds = false;
+            for(const std::pair<std::pair<int, int>, int>& h : r.second.holds) holds = holds || h.first == loc;
+            if(!holds) continue;
+            cancelled.push_back(r.second);
+            r.second.state = RESERVATION_CANCELLED;
+            r.second.holds.clear();
+            reservations.fetch_sub(1, std::memory_order_relaxed);
+            count++;
+        }
+    }
+    for(int r = cancelled.size() - count; r < (int)cancelled.size(); r++) release(cancelled[r]);
+    return count;
+}
+
+// FUNCTION: Takes every committed Reservation out of the book, appending it to committed with its space still held, and
+// expires every held Reservation past its deadline, releasing its space. Cancelled Reservations past their deadline are
+// forgotten. Accepts parameters now_ns, the current steady clock time, and committed. Returns the number of Reservations
+// expired.
+int ReservationBook::sweep(long long now_ns, std::vector<Reservation>& committed){
+    std::vector<Reservation> expired;
+    for(int k = 0; k < STRIPES; k++){
+        Stripe& s = stripes[k];
+        std::lock_guard<std::mutex> guard(s.lock);
+        for(std::unordered_map<long long, Reservation>::iterator it = s.open.begin(); it != s.open.end(); ){
+            if(it->second.state == RESERVATION_CANCELLED){
+                if(now_ns >= it->second.deadline_ns) it = s.open.erase(it);
+                else ++it;
+                continue;
+            }
+            if(it->second.state == RESERVATION_COMMITTED) committed.push_back(std::move(it->second));
+            else if(now_ns >= it->second.deadline_ns) expired.push_back(std::move(it->second));
+            else {
+                ++it;
+                continue;
+            }
+            it = s.open.erase(it);
+            reservations.fetch_sub(1, std::memory_order_relaxed);
+        }
+    }
+    for(const Reservation& r : expired) release(r);
+    return expired.size();
+}
+
+// FUNCTION: Moves the locations of the StorageUnits whose holds changed since the last call into changed, each once.
+// Accepts parameter changed, which is overwritten.
+void ReservationBook::drainChanged(std::vector<std::pair<int, int> >& changed){
+    changed.clear();
+    changes.store(0, std::memory_order_release);
+    for(int k = 0; k < STRIPES; k++){
+        Stripe& s = stripes[k];
+        std::lock_guard<std::mutex> guard(s.lock);
+        changed.insert(changed.end(), s.changed.begin(), s.changed.end());
+        s.changed.clear();
+    }
+    std::sort(changed.begin(), changed.end());
+    changed.erase(std::unique(changed.begin(), changed.end()), changed.end());
+    return;
+}
+
+// FUNCTION: Estimates the memory used by every stripe's hash tables and lists, and by the Reservations' holds.
+MemoryUsage ReservationBook::memoryUsage() const {
+    MemoryUsage m;
+    m.bytes = STRIPES * sizeof(Stripe);
+    m.allocations = 1;
+    for(int k = 0; k < STRIPES; k++){
+        const Stripe& s = stripes[k];
+        std::lock_guard<std::mutex> guard(s.lock);
+        m.bytes += s.held.size() * (sizeof(void*) + sizeof(std::pair<const long long, HeldSpace>)) + s.held.bucket_count() * sizeof(void*);
+        m.bytes += s.open.size() * (sizeof(void*) + sizeof(std::pair<const long long, Reservation>)) + s.open.bucket_count() * sizeof(void*);
+        m.allocations += s.held.size() + s.open.size() + 2;
+        for(const std::pair<const long long, HeldSpace>& h : s.held) m += estimateMap(h.second.items);
+        m += estimateVector(s.changed);
+        for(const std::pair<const long long, Reservation>& r : s.open){
+            m += estimateString(r.second.item.name);
+            m += estimateVector(r.second.holds);
+        }
+    }
+    return m;
+}
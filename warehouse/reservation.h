@@ -0,0 +1,152 @@
+//
+// CSC 212 - Data Structures and Abstractions
+// Dominic Tucchio, Jennipher Day, Maya Geva, Thomas Williams
+// Spring 2024 Term Project - reservation.h
+//
+
+#ifndef Reservation_H
+#define Reservation_H
+
+#include "container.h"
+
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+//
+// ENUM: ReservationState
+// Where a Reservation is in its life. HELD reservations hold their space until they are committed, aborted, or reach
+// their deadline. COMMITTED reservations keep holding it until the Warehouse stores their Items. ABORTED and EXPIRED
+// reservations have released their space. CANCELLED reservations released their space because a StorageUnit they held
+// space in was replaced. UNKNOWN is returned for an id the ReservationBook no longer holds.
+//
+
+enum ReservationState { RESERVATION_HELD, RESERVATION_COMMITTED, RESERVATION_ABORTED, RESERVATION_EXPIRED, RESERVATION_CANCELLED, RESERVATION_UNKNOWN };
+
+//
+// STRUCTURE: Reservation
+// Space held for an inbound Item before it is stored. HOLDS lists each StorageUnit holding space for part of the Item
+// and the quantity of the Item it holds space for. DEADLINE_NS is the steady clock time, in nanoseconds, after which the
+// reservation expires unless it was committed.
+//
+
+struct Reservation {
+    long long id = 0;
+    Item item;
+    std::vector<std::pair<std::pair<int, int>, int> > holds;
+    long long deadline_ns = 0;
+    ReservationState state = RESERVATION_HELD;
+};
+
+//
+// STRUCTURE: HeldSpace
+// The space held at one StorageUnit: SPACE in total, and for each Item name the size per unit it is held at and the
+// space held for it. A StorageUnit keeps one Item of each name, so every hold for a name at a StorageUnit has one size.
+//
+
+struct HeldSpace {
+    int space = 0;
+    std::map<std::string, std::pair<int, int> > items;
+};
+
+//
+// CLASS: ReservationBook
+// The space held in each StorageUnit by open Reservations, and the Reservations themselves. Several threads can hold
+// space, commit, and abort at once without a global lock: StorageUnits and Reservations are spread over stripes by a
+// hash of their location or id, and each stripe has its own lock, so two threads only wait for each other when they
+// touch the same stripe, and only for the few instructions that check and change a hold. Checking that a StorageUnit
+// has room and holding it happen under the same lock, so space is never held twice. The book also records which
+// StorageUnits' holds changed, so the Warehouse can refresh their free space in the RangeTree and KDTree afterwards.
+//
+
+class ReservationBook {
+    public:
+        // CONSTRUCTORS
+        ReservationBook();
+
+        // FUNCTIONS
+
+        // FUNCTION: Holds space for up to quantity units of an Item at a StorageUnit with free space before any holds, or
+        // for all of them or none if all is true. Nothing is held if space is held there for the same name at another
+        // size. Returns the quantity held space for.
+        int hold(std::pair<int, int> loc, const Item& i, int quantity, int free, bool all);
+        // FUNCTION: Releases space held for an Item name at a StorageUnit.
+        void release(std::pair<int, int> loc, const std::string& name, int space);
+        // FUNCTION: Returns the space held at a StorageUnit.
+        int held(std::pair<int, int> loc) const;
+        // FUNCTION: Calls f(loc, space) for every StorageUnit with space held.
+        template<typename F>
+        void forEachHeld(F f) const;
+
+        // FUNCTION: Records a Reservation whose space is already held and returns its id.
+        long long open(Reservation reservation);
+        // FUNCTION: Commits a Reservation unless it has reached its deadline, which expires it. Returns its new state.
+        ReservationState commit(long long id, long long now_ns);
+        // FUNCTION: Aborts a Reservation that has not been committed, releasing its space. Returns its new state.
+        ReservationState abort(long long id);
+        // FUNCTION: Cancels every Reservation, held or committed, with space held at a StorageUnit and releases all of its
+        // space. The cancelled Reservations are appended to cancelled. Returns the number cancelled.
+        int cancel(std::pair<int, int> loc, std::vector<Reservation>& cancelled);
+        // FUNCTION: Expires the held Reservations past their deadline, releasing their space, and moves the committed
+        // ones into committed. Returns the number expired.
+        int sweep(long long now_ns, std::vector<Reservation>& committed);
+        // FUNCTION: Moves the StorageUnits whose holds changed since the last call into changed.
+        void drainChanged(std::vector<std::pair<int, int> >& changed);
+
+        // FUNCTION: Returns true if holds changed or a Reservation was committed since the last drainChanged(...).
+        bool dirty() const { return changes.load(std::memory_order_acquire) != 0; }
+        // FUNCTION: Returns the number of Reservations held or committed and not yet stored.
+        long long size() const { return reservations.load(std::memory_order_relaxed); }
+        // FUNCTION: Estimates the memory used by the holds and Reservations.
+        MemoryUsage memoryUsage() const;
+
+    private:
+        // STRUCTURE: Stripe
+        // One lock and the holds and Reservations hashed to it. Each stripe sits in its own cache line, so threads
+        // locking neighboring stripes do not slow each other down.
+        struct alignas(64) Stripe {
+            mutable std::mutex lock;
+            std::unordered_map<long long, HeldSpace> held;
+            std::unordered_map<long long, Reservation> open;
+            std::vector<std::pair<int, int> > changed;
+        };
+
+        // FUNCTIONS
+
+        // FUNCTION: Returns the stripe of a location or id.
+        Stripe& stripe(long long key) const { return stripes[(unsigned long long)(key * 0x9E3779B97F4A7C15ULL) >> 58]; }
+        // FUNCTION: Returns the key of a location.
+        static long long key(std::pair<int, int> loc) { return ((long long)loc.first << 32) | (unsigned int)loc.second; }
+        // FUNCTION: Releases the space held by a Reservation's holds.
+        void release(const Reservation& reservation);
+
+        // MEMBER VARIABLES
+
+        // STRIPES: The 64 stripes, chosen by the top 6 bits of a key's hash.
+        static constexpr int STRIPES = 64;
+        std::unique_ptr<Stripe[]> stripes;
+        // NEXT_ID: The id given to the next Reservation.
+        std::atomic<long long> next_id;
+        // HOLDING, RESERVATIONS: The total space held and the number of Reservations open, so held(...) answers without
+        // locking while nothing is held.
+        std::atomic<long long> holding;
+        std::atomic<long long> reservations;
+        // CHANGES: The number of holds changed and Reservations committed since the last drainChanged(...).
+        std::atomic<long long> changes;
+};
+
+// FUNCTION: Calls f(loc, space) for every StorageUnit with space held, one stripe at a time. f is called with the
+// stripe locked, so it must not use the ReservationBook.
+template<typename F>
+void ReservationBook::forEachHeld(F f) const {
+    if(holding.load(std::memory_order_acquire) == 0) return;
+    for(int s = 0; s < STRIPES; s++){
+        std::lock_guard<std::mutex> guard(stripes[s].lock);
+        for(const std::pair<const long long, HeldSpace>& h : stripes[s].held) f(std::make_pair((int)(h.first >> 32), (int)(unsigned int)h.first), h.second.space);
+    }
+}
+
+#endif
@@ -0,0 +1,304 @@
+//
+// CSC 212 - Data Structures and Abstractions
+// Dominic Tucchio, Jennipher Day, Maya Geva, Thomas Williams
+// Spring 2024 Term Project - site.cpp
+//
+
+#include "site.h"
+#include "parallel.h"
+#include "metrics/trace.h"
+
+#include <algorithm>
+#include <climits>
+#include <functional>
+#include <iostream>
+#include <queue>
+
+//
+// CLASS: Site
+// A warehouse of several floors, or several buildings, joined by Transfers. Each floor is its own Warehouse with its own
+// Grid, graph, RangeTree, and routing mode, and floors are built in parallel. Paths between floors search only the
+// portals, the cells at the ends of the Transfers, with the distances between the portals of each floor measured in
+// advance, and are then filled in with a path on each floor they cross. Items are stored on a preferred floor, falling
+// through to the floors nearest to it by Transfer cost when it is full.
+//
+
+// CONSTRUCTOR: Default constructor for the Site class. The Site starts without floors.
+Site::Site(){
+
+}
+
+// CONSTRUCTOR: Creates a Site with a floor for each vector of StorageUnits. The floors share nothing, so each is built
+// on its own thread. Accepts parameter floors_in, the StorageUnits of each floor.
+Site::Site(const std::vector<std::vector<StorageUnit> >& floors_in){
+    TRACE_SCOPE("site build");
+    levels.resize(floors_in.size());
+    portals.resize(floors_in.size());
+    parallelFor(floors_in.size(), [&](int f){
+        levels[f] = std::unique_ptr<Warehouse>(new Warehouse(floors_in[f]));
+    });
+}
+
+// FUNCTION: Adds a floor to the Site. Accepts parameter units, the StorageUnits on the new floor. Returns the index of
+// the new floor.
+int Site::addFloor(const std::vector<StorageUnit>& units){
+    levels.push_back(std::unique_ptr<Warehouse>(new Warehouse(units)));
+    portals.push_back(FloorPortals());
+    return levels.size() - 1;
+}
+
+// FUNCTION: Returns true if loc names a floor of the Site and a cell inside that floor.
+bool Site::contains(SiteLocation loc){
+    return loc.floor >= 0 && loc.floor < (int)levels.size() && levels[loc.floor]->inBounds(loc.loc);
+}
+
+// FUNCTION: Returns the node of the portal at loc, adding loc to its floor's portals if it is not one yet. A new portal
+// makes its floor's distances out of date.
+int Site::portal(SiteLocation loc){
+    FloorPortals& floor = portals[loc.floor];
+    for(int k = 0; k < (int)floor.cells.size(); k++){
+        if(floor.cells[k] == loc.loc) return floor.nodes[k];
+    }
+    floor.cells.push_back(loc.loc);
+    floor.nodes.push_back(nodes.size());
+    floor.current = false;
+    nodes.push_back(loc);
+    links.push_back(std::vector<GraphEdge>());
+    return nodes.size() - 1;
+}
+
+// FUNCTION: Connects two cells with a Transfer that can be taken in either direction. Both cells must be inside their
+// floors, so a Transfer should be added after the StorageUnits that give a floor its size. Accepts parameters a and b,
+// the cells, and cost, the cost of taking the Transfer. Returns false if the Transfer could not be added.
+bool Site::addTransfer(SiteLocation a, SiteLocation b, int cost){
+    if(!contains(a) || !contains(b)){
+        std::cout << "[Transfer Error] Unable to connect (" << a.floor << ": " << a.loc.first << "," << a.loc.second << ") and (" << b.floor << ": " << b.loc.first << "," << b.loc.second << ") as both must be inside a floor of the Site." << std::endl;
+        return false;
+    }
+    if(cost < 0){
+        std::cout << "[Transfer Error] Unable to add a Transfer with a negative cost of " << cost << "." << std::endl;
+        return false;
+    }
+    int from = portal(a);
+    int to = portal(b);
+    links[from].push_back(GraphEdge({from, to, cost}));
+    links[to].push_back(GraphEdge({to, from, cost}));
+    transfers.push_back({a, b, cost});
+    return true;
+}
+
+// FUNCTION: Lists every floor of the Site by the cost of the cheapest chain of Transfers from floor from, itself first.
+// Walking between the Transfers on each floor is not counted. Floors no Transfer reaches come last, in order.
+std::vector<int> Site::floorOrder(int from){
+    int n = levels.size();
+    std::vector<int> cost(n, INT_MAX);
+    std::vector<bool> visited(n, false);
+    std::vector<int> order;
+
+    std::priority_queue<GraphEdge, std::vector<GraphEdge>, std::greater<GraphEdge> > p_queue;
+    cost[from] = 0;
+    p_queue.push(GraphEdge({from, from, 0}));
+    while(!p_queue.empty()){
+        GraphEdge current = p_queue.top();
+        p_queue.pop();
+        if(visited[current.dest]) continue;
+        visited[current.dest] = true;
+        order.push_back(current.dest);
+        for(const Transfer& t : transfers){
+            int next;
+            if(t.a.floor == current.dest) next = t.b.floor;
+            else if(t.b.floor == current.dest) next = t.a.floor;
+            else continue;
+            if(!visited[next] && cost[current.dest] + t.cost < cost[next]){
+                cost[next] = cost[current.dest] + t.cost;
+                p_queue.push(GraphEdge({current.dest, next, cost[next]}));
+            }
+        }
+    }
+    for(int f = 0; f < n; f++) if(!visited[f]) order.push_back(f);
+    return order;
+}
+
+// FUNCTION: Adds an Item to the Site. The Item is stored on the first floor, nearest to the preferred floor by
+// Transfer cost, that can store all of it, placed by that floor's PlacementPolicy. If no floor can, it is split between
+// floors in the same order, each taking as much as it can still store. Accepts parameters i, an instance of Item, and
+// preferred, the index of the floor to try first.
+void Site::add(const Item& i, int preferred){
+    TRACE_SCOPE("placement");
+    if(preferred < 0 || preferred >= (int)levels.size()){
+        std::cout << "[Add Error] Unable to store " << i.name << " on floor " << preferred << " as the Site has " << levels.size() << " floors." << std::endl;
+        return;
+    }
+    std::vector<int> order = floorOrder(preferred);
+    for(int f : order){
+        if(levels[f]->canStore(i)){
+            levels[f]->add(i);
+            return;
+        }
+    }
+
+    // No floor can store all of the Item, so each floor takes what it can.
+    int remaining = i.quantity;
+    for(int f : order){
+        if(remaining == 0) break;
+        long long fits = levels[f]->maxPlaceable(i.size_per_unit);
+        if(fits <= 0) continue;
+        Item part = i;
+        part.quantity = std::min<long long>(remaining, fits);
+        levels[f]->add(part);
+        remaining -= part.quantity;
+    }
+    if(remaining > 0) std::cout << "[Add Error] Unable to store " << remaining * i.size_per_unit << " " << i.name << "(s) due to lack of available storage space." << std::endl;
+    return;
+}
+
+// FUNCTION: Locates all instances of an Item on every floor of the Site. Accepts parameter i_name, the name of the Item.
+// Returns the location of every StorageUnit holding it, floor by floor.
+std::vector<SiteLocation> Site::findItem(const std::string& i_name){
+    std::vector<SiteLocation> found;
+    for(int f = 0; f < (int)levels.size(); f++){
+        for(std::pair<int, int> loc : levels[f]->findItem(i_name)) found.push_back({f, loc});
+    }
+    return found;
+}
+
+// FUNCTION: Measures the length of the shortest path between every pair of portals on each floor that gained a portal
+// or a StorageUnit since its portals were last measured, with the floor's own RoutingMode. The floors are measured in
+// parallel; the rows of each floor run on the same thread as the floor.
+void Site::preprocessPortals(){
+    TRACE_SCOPE("portal distances");
+    std::vector<int> stale;
+    for(int f = 0; f < (int)levels.size(); f++){
+        if(!portals[f].current || portals[f].version != levels[f]->layoutVersion()) stale.push_back(f);
+    }
+    parallelFor(stale.size(), [&](int s){
+        int f = stale[s];
+        if(!portals[f].cells.empty()) portals[f].distances = levels[f]->distanceMatrix(portals[f].cells);
+        portals[f].version = levels[f]->layoutVersion();
+        portals[f].current = true;
+    });
+    return;
+}
+
+// FUNCTION: Finds the shortest path between two cells of the Site. The path is found with Dijkstra's Algorithm over the
+// portals of every floor plus the two cells: the portals of a floor are joined by the distances measured by
+// preprocessPortals(...), the ends of a Transfer by its cost, and each cell by a single search on its own floor to that
+// floor's portals and, if both cells are on the same floor, to the other cell. The walk on each floor along the chosen
+// route is then found with that floor's route(...). Accepts parameters src and dest, the cells. Returns the length of
+// the path, including the cost of its Transfers, and the cells along it; the length is -1 if no path exists.
+std::pair<int, std::vector<SiteLocation> > Site::route(SiteLocation src, SiteLocation dest){
+    TRACE_SCOPE("path search");
+    for(SiteLocation loc : {src, dest}){
+        if(!contains(loc)){
+            std::cout << "[Routing Error] The location (" << loc.floor << ": " << loc.loc.first << "," << loc.loc.second << ") is outside of the Site." << std::endl;
+            return {-1, std::vector<SiteLocation>()};
+        }
+    }
+    preprocessPortals();
+
+    // The portals are nodes 0 to n - 1, followed by the two cells.
+    int n = nodes.size();
+    int source = n, target = n + 1;
+    bool same_floor = src.floor == dest.floor;
+    std::vector<std::pair<int, int> > targets = portals[src.floor].cells;
+    if(same_floor) targets.push_back(dest.loc);
+    std::vector<int> from_src = levels[src.floor]->distances(src.loc, targets);
+    std::vector<int> to_dest = levels[dest.floor]->distances(dest.loc, portals[dest.floor].cells);
+
+    std::vector<int> distance(n + 2, INT_MAX);
+    std::vector<int> previous(n + 2, -1);
+    // VIA_TRANSFER: Whether each node was reached by taking a Transfer rather than by walking across a floor.
+    std::vector<bool> via_transfer(n + 2, false);
+    std::vector<bool> visited(n + 2, false);
+    std::priority_queue<GraphEdge, std::vector<GraphEdge>, std::greater<GraphEdge> > p_queue;
+
+    // Relaxes the edge from node u to node v, walked or taken as a Transfer.
+    auto relax = [&](int u, int v, int weight, bool transfer){
+        if(weight == INT_MAX || visited[v] || distance[u] + weight >= distance[v]) return;
+        distance[v] = distance[u] + weight;
+        previous[v] = u;
+        via_transfer[v] = transfer;
+        p_queue.push(GraphEdge({u, v, distance[v]}));
+    };
+
+    distance[source] = 0;
+    p_queue.push(GraphEdge({source, source, 0}));
+    while(!p_queue.empty()){
+        GraphEdge current = p_queue.top();
+        p_queue.pop();
+        int u = current.dest;
+        if(visited[u]) continue;
+        visited[u] = true;
+        if(u == target) break;
+
+        if(u == source){
+            const FloorPortals& floor = portals[src.floor];
+            for(int k = 0; k < (int)floor.cells.size(); k++) relax(u, floor.nodes[k], from_src[k], false);
+            if(same_floor) relax(u, target, from_src.back(), false);
+            continue;
+        }
+
+        // Walking to the other portals of the node's floor, and to the destination if it is on the same floor.
+        const FloorPortals& floor = portals[nodes[u].floor];
+        int k = floor.cells.size();
+        int row = 0;
+        while(floor.nodes[row] != u) row++;
+        for(int c = 0; c < k; c++) relax(u, floor.nodes[c], floor.distances[row * k + c], false);
+        if(nodes[u].floor == dest.floor) relax(u, target, to_dest[row], false);
+        // Taking each Transfer from the node.
+        for(const GraphEdge& e : links[u]) relax(u, e.dest, e.weight, true);
+    }
+    if(distance[target] == INT_MAX){
+        std::cout << "[Routing Error] No Transfers connect floor " << src.floor << " to floor " << dest.floor << "." << std::endl;
+        return {-1, std::vector<SiteLocation>()};
+    }
+
+    // Listing the nodes along the route, from the source.
+    std::vector<int> chain;
+    for(int v = target; v != -1; v = previous[v]) chain.push_back(v);
+    std::reverse(chain.begin(), chain.end());
+
+    // Filling in the walk on each floor between consecutive nodes. With HPA_ROUTING a walk can be longer than the
+    // distance searched, so the length returned is that of the path itself.
+    int total = 0;
+    std::vector<SiteLocation> path(1, src);
+    for(int c = 1; c < (int)chain.size(); c++){
+        SiteLocation next = chain[c] == target ? dest : nodes[chain[c]];
+        if(via_transfer[chain[c]]){
+            total += distance[chain[c]] - distance[chain[c - 1]];
+            path.push_back(next);
+            continue;
+        }
+        std::pair<int, std::vector<std::pair<int, int> > > walk = levels[next.floor]->route(path.back().loc, next.loc);
+        total += walk.first;
+        for(int s = 1; s < (int)walk.second.size(); s++) path.push_back({next.floor, walk.second[s]});
+    }
+    return {total, path};
+}
+
+// FUNCTION: Returns a MemoryReport with each of the Warehouse's data structures totalled over every floor, followed by
+// the portals and their distances.
+MemoryReport Site::memoryUsage(){
+    MemoryReport report;
+    for(int f = 0; f < (int)levels.size(); f++){
+        MemoryReport floor = levels[f]->memoryUsage();
+        for(int s = 0; s < (int)floor.subsystems.size(); s++){
+            if(f == 0) report.add(floor.subsystems[s].first, floor.subsystems[s].second);
+            else report.subsystems[s].second += floor.subsystems[s].second;
+        }
+    }
+
+    MemoryUsage site;
+    site += estimateVector(transfers);
+    site += estimateVector(portals);
+    site += estimateVector(nodes);
+    site += estimateVector(links);
+    for(const FloorPortals& floor : portals){
+        site += estimateVector(floor.cells);
+        site += estimateVector(floor.nodes);
+        site += estimateVector(floor.distances);
+    }
+    for(const std::vector<GraphEdge>& edges : links) site += estimateVector(edges);
+    report.add("site portals", site);
+    return report;
+}
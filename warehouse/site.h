@@ -0,0 +1,117 @@
+//
+// CSC 212 - Data Structures and Abstractions
+// Dominic Tucchio, Jennipher Day, Maya Geva, Thomas Williams
+// Spring 2024 Term Project - site.h
+//
+
+#ifndef Site_H
+#define Site_H
+
+#include "warehouse.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+//
+// STRUCTURE: SiteLocation
+// A cell of a Site: the index of its floor and its coordinates on that floor.
+//
+
+struct SiteLocation {
+    int floor;
+    std::pair<int, int> loc;
+};
+
+//
+// STRUCTURE: Transfer
+// A connection between cells of two floors, such as a lift, a stairwell, or a walkway between buildings, and the cost
+// of taking it. Transfers can be taken in either direction.
+//
+
+struct Transfer {
+    SiteLocation a, b;
+    int cost;
+};
+
+//
+// STRUCTURE: FloorPortals
+// The cells of a floor that are the end of at least one Transfer, the node each is given in the Site's search, and the
+// length of the shortest path between every pair of them on their floor, row by row. The distances are measured for the
+// floor's layout version in VERSION and measured again once the floor changes.
+//
+
+struct FloorPortals {
+    std::vector<std::pair<int, int> > cells;
+    std::vector<int> nodes;
+    std::vector<int> distances;
+    unsigned long long version = 0;
+    bool current = false;
+};
+
+//
+// CLASS: Site
+// A warehouse of several floors, or several buildings, joined by Transfers. Each floor is its own Warehouse with its own
+// Grid, graph, RangeTree, and routing mode, and floors are built in parallel. Paths between floors search only the
+// portals, the cells at the ends of the Transfers, with the distances between the portals of each floor measured in
+// advance, and are then filled in with a path on each floor they cross. Items are stored on a preferred floor, falling
+// through to the floors nearest to it by Transfer cost when it is full.
+//
+
+class Site {
+    public:
+        // CONSTRUCTORS
+        Site();
+        Site(const std::vector<std::vector<StorageUnit> >& floors);
+
+        // FUNCTIONS
+
+        // FUNCTION: Adds a floor holding the given StorageUnits. Returns the index of the new floor.
+        int addFloor(const std::vector<StorageUnit>& units);
+        // FUNCTION: Returns the number of floors.
+        int floors() { return levels.size(); }
+        // FUNCTION: Returns a floor, to add StorageUnits to, query, or set the routing mode of.
+        Warehouse& floor(int f) { return *levels[f]; }
+
+        // FUNCTION: Connects two cells, on the same or different floors, with a Transfer of the given cost.
+        bool addTransfer(SiteLocation a, SiteLocation b, int cost);
+        // FUNCTION: Returns every Transfer in the order they were added.
+        const std::vector<Transfer>& getTransfers() { return transfers; }
+
+        // FUNCTION: Adds an Item to the preferred floor, or to the floors nearest to it if it does not fit.
+        void add(const Item& i, int preferred);
+        // FUNCTION: Locates all instances of an Item on every floor.
+        std::vector<SiteLocation> findItem(const std::string& i_name);
+
+        // FUNCTION: Measures the distances between the portals of every floor that changed since they were last measured.
+        void preprocessPortals();
+        // FUNCTION: Finds the shortest path between two cells of the Site.
+        std::pair<int, std::vector<SiteLocation> > route(SiteLocation src, SiteLocation dest);
+
+        // FUNCTION: Returns the estimated memory used by each data structure, totalled over every floor.
+        MemoryReport memoryUsage();
+
+    private:
+        // FUNCTIONS
+
+        // FUNCTION: Returns true if a cell is on one of the Site's floors.
+        bool contains(SiteLocation loc);
+        // FUNCTION: Returns the node of a portal, adding the portal if its cell is not one yet.
+        int portal(SiteLocation loc);
+        // FUNCTION: Lists every floor, nearest to a floor by Transfer cost first.
+        std::vector<int> floorOrder(int from);
+
+        // MEMBER VARIABLES
+
+        // LEVELS: The floors of the Site.
+        std::vector<std::unique_ptr<Warehouse> > levels;
+        // TRANSFERS: The Transfers between floors.
+        std::vector<Transfer> transfers;
+        // PORTALS: The portals of each floor and the distances between them.
+        std::vector<FloorPortals> portals;
+        // NODES, LINKS: The location of each portal node, and the Transfers leaving it as edges to other portal nodes.
+        std::vector<SiteLocation> nodes;
+        std::vector<std::vector<GraphEdge> > links;
+};
+
+#endif
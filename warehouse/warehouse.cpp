@@ -5,14 +5,25 @@
 //
 
 #include "warehouse.h"
+#include "parallel.h"
+#include "metrics/metrics.h"
+#include "metrics/trace.h"
+
+#include <charconv>
+#include <chrono>
+#include <climits>
+#include <cstdlib>
+#include <sstream>
+#include <set>
 
 //
 // CLASS: Warehouse
-// This class represents a typical warehouse environment. Each instance of Warehouse contains a 2D vector of StorageUnit
-// instances, a 2D vector of GraphEdge instances to represent traversing the Warehouse space, and a RangeTree instance
-// representing the remaining available space within the Warehouse instance's StorageUnits. Functions of the Warehouse
-// class include adding new StorageUnit and Item instances, finding specific items within the Warehouse, and finding the
-// shortest path between either individual storage units or a series of items. This class employs the three required
+// This class represents a typical warehouse environment. Each instance of Warehouse contains a sparse Grid of StorageUnit
+// instances, adjacency lists of GraphEdge instances to represent traversing the Warehouse space, and a RangeTree instance
+// representing the remaining available space within the Warehouse instance's StorageUnits, along with a KDTree that
+// indexes that space by location. Functions of the Warehouse class include adding new StorageUnit and Item instances,
+// finding specific items or free space within the Warehouse, and finding the shortest path between either individual
+// storage units or a series of items. This class employs the three required
 // data structures and algorithms - Dijkstra's Algorithm, Fractional Knapsack, and Range Tree - to fulfill its objective.
 // The class also stores general usage statistics to be exported at the conclusion of the program.
 //
@@ -21,137 +32,431 @@
 // this class. This instance is how the algorithms are accessed by the Warehouse instance.
 static Algorithms alg;
 
-// CONSTRUCTOR: Default constructor for the Warehouse class. Resizes the 2D vector of StorageUnit instances to a 1x1
-// grid so that StorageUnit instances can be added to the Warehouse. All other member variables are either declared in
-// the header file or at a later time.
+// MAX_PICK_CANDIDATES: The most StorageUnits holding the same Item that planPick(...) considers, closest to the origin
+// first. Items spread over many StorageUnits would otherwise make the distance matrix grow with the square of the
+// number of StorageUnits.
+static const int MAX_PICK_CANDIDATES = 6;
+
+// FUNCTION: Formats the rows of the floor for an export in bands of chunk rows, in parallel on a large floor, and writes
+// the bands to out in order, so the export is the same as one written row by row. Accepts parameters out, rows, cols,
+// and format, called with the first row of a band, the row after its last, and the text to append its lines to.
+static void writeBands(std::ostream& out, int rows, int cols, const std::function<void(int, int, std::string&)>& format){
+    std::vector<std::string> text((rows + GridChunk::SIZE - 1) / GridChunk::SIZE);
+    parallelRows(rows, cols, GridChunk::SIZE, [&](int band, int first, int last){ format(first, last, text[band]); });
+    for(const std::string& t : text) out << t;
+    return;
+}
+
+// FUNCTION: Appends the decimal digits of value to text, as an ostream writes them.
+static void appendNumber(std::string& text, long long value){
+    char digits[24];
+    text.append(digits, std::to_chars(digits, digits + sizeof(digits), value).ptr);
+    return;
+}
+
+// CONSTRUCTOR: Default constructor for the Warehouse class. The Grid starts as an empty 1x1 floor so that StorageUnit
+// instances can be added to the Warehouse. All other member variables are either declared in the header file or at a
+// later time.
 Warehouse::Warehouse(){
-    units.resize(1, std::vector<StorageUnit>(1));
+
 }
 
 // CONSTRUCTOR: Creates a Warehouse instance with StorageUnit instances at the time of creation. Accepts parameter
 // units_in, a vector of StorageUnit instances to add to the Warehouse.
-Warehouse::Warehouse(std::vector<StorageUnit> units_in){
-    units.resize(1, std::vector<StorageUnit>(1));
-    for(StorageUnit i : units_in) add_unit(i);
+Warehouse::Warehouse(const std::vector<StorageUnit>& units_in){
+    for(const StorageUnit& i : units_in) add_unit(i);
 }
 
 // FUNCTION: Adds a new StorageUnit instance with a specified capacity but no coordinates to the Warehouse. The new StorageUnit
 // instance is created with the given capacity and the coordinates of the first empty space in the Warehouse. Accepts
 // parameter capacity, an integer representing the size of the StorageUnit.
 void Warehouse::add_unit(int capacity){
-    bool added = false;
-    for(int i = 0; i < units.size(); i++){
-        for(int j = 0; j < units[i].size(); j++){
-            // Find the first empty space in the Warehouse and add a new StorageUnit instance.
-            if(!added && units[i][j].getCapacity() == 0){
-                add_unit(StorageUnit(capacity, {i,j}));
-                added = true;
-            }
-        }
-    }
+    // Find the first empty space in the Warehouse and add a new StorageUnit instance.
+    std::pair<int, int> loc = units.firstEmpty();
     // If there was no empty space in the Warehouse, the new StorageUnit will be placed at a new space in the XCoord direction.
-    // By calling add_unit(StorageUnit ...) outside of the Warehouse instance's bounds, the function will resize the Warehouse.
-    if(!added) add_unit(StorageUnit(capacity, {units.size(), units.size() - 1}));
+    // By calling add_unit(StorageUnit ...) outside of the Warehouse instance's bounds, the Grid will grow to include it.
+    if(loc.first == -1) loc = {units.getRows(), units.getCols() - 1};
+    add_unit(StorageUnit(capacity, loc));
     return;
 }
 
-// FUNCTION: Adds a new StorageUnit instance to the Warehouse. Checks if the Warehouse needs to be resized with the addition
-// of the new StorageUnit. If so, this function resizes the Warehouse and copies all previous data. Accepts parameter unit,
-// an instance of StorageUnit.
-void Warehouse::add_unit(StorageUnit unit){
-    // Checking if the Warehouse is large enough to store the new StorageUnit at its given location.
-    int newSize = 0;
-    int new_unit_max = std::max(unit.getLocation().first, unit.getLocation().second);
-    for(std::vector<StorageUnit> i : units){
-        for(StorageUnit u : i){
-            // Checking what is bigger, the current Warehouse dimensions or the position of the StorageUnit to be inserted;
-            int existing_unit_max = std::max(u.getLocation().first, u.getLocation().second);
-            newSize = std::max(newSize, std::max(new_unit_max, existing_unit_max));
-        }
+// FUNCTION: Adds a new StorageUnit instance to the Warehouse. The Grid only allocates memory around the new StorageUnit,
+// growing the square floor if the StorageUnit is outside of it. Accepts parameter unit, an instance of
+// StorageUnit.
+void Warehouse::add_unit(const StorageUnit& unit){
+    TRACE_SCOPE("add unit");
+    std::pair<int, int> loc = unit.getLocation();
+    if(loc.first < 0 || loc.second < 0){
+        std::cout << "[Add Unit Error] Unable to add a StorageUnit at (" << loc.first << "," << loc.second << ") as coordinates cannot be negative." << std::endl;
+        return;
     }
 
-    // Adjustment for C++ index starting at 0.
-    newSize++;
-
-    // If the new StorageUnit is outside the bounds of the Warehouse, the Warehouse needs to be resized.
-    if(newSize > units.size()){
-        std::vector<std::vector<StorageUnit> > temp(newSize, std::vector<StorageUnit>(newSize));
-
-        for(int i = 0; i < newSize; i++) {
-            for (int j = 0; j < newSize; j++) {
-                // Filling the new Warehouse StorageUnit 2D vector.
-                temp[i][j] = StorageUnit(0, {i, j});
-            }
-        }
-        for(int i = 0; i < units.size(); i++){
-            for(int j = 0; j < units[i].size(); j++){
-                // Copying the data from the old 2D vector.
-                if(units[i][j].getCapacity() != 0) temp[i][j] = units[i][j];
-            }
-        }
-        units = temp;
-    }
+    // Checking if the Warehouse's floor needs to grow to store the new StorageUnit at its given location.
+    bool resized = !units.inBounds(loc);
 
     // Counter for the number of StorageUnit instances in the Warehouse.
     num_units++;
+    layout_version++;
     // Adding the StorageUnit's capacity to the total Warehouse capacity.
     capacity += unit.getCapacity();
     // If a StorageUnit already has items in it, add the capacity of those items to the Warehouse's used capacity counter.
     used_capacity += unit.getUsedCapacity();
-    // Assigning the new StorageUnit to the 2D vector in the Warehouse instance.
-    units[unit.getLocation().first][unit.getLocation().second] = unit;
-    // Updating the Range Tree with the new StorageUnit.
+    // A StorageUnit replacing another at the same location takes its place in the item index, too.
+    const std::map<std::string, Item>* stored = units.items(loc);
+    if(stored != nullptr){
+        for(const std::pair<const std::string, Item>& i : *stored){
+            catalog.adjust(i.first, -i.second.quantity);
+            catalog.erase(i.first, loc);
+        }
+    }
+    // Assigning the new StorageUnit to the Grid in the Warehouse instance and indexing any Items it already holds.
+    units.set(unit);
+    stored = units.items(loc);
+    if(stored != nullptr){
+        for(const std::pair<const std::string, Item>& i : *stored){
+            catalog.insert(i.first, loc);
+            catalog.adjust(i.first, i.second.quantity);
+        }
+    }
+    // Updating the Range Tree and the KDTree with the new StorageUnit. Space held in the StorageUnit it replaces is not
+    // carried over: the reservations holding it are cancelled and all of their space released.
     tree.insert(unit);
-    // Updating the Adjacency List with the new StorageUnit.
-    graph = alg.buildGraph(units);
+    spatial.insert({loc, unit.getCapacity() - unit.getUsedCapacity()});
+    if(reservations.held(loc) != 0){
+        std::vector<Reservation> cancelled;
+        reservations.cancel(loc, cancelled);
+        for(const Reservation& r : cancelled){
+            std::cout << "[Add Unit] Reservation " << r.id << " held space in the StorageUnit replaced at (" << loc.first << "," << loc.second << ") and was cancelled." << std::endl;
+            for(const std::pair<std::pair<int, int>, int>& h : r.holds) refresh(h.first);
+        }
+    }
+    // Updating the Adjacency List with the new StorageUnit. Graph indices depend on the width of the floor, so the graph
+    // is only rebuilt when the floor grew; otherwise only the lists around the new StorageUnit change. The same goes for
+    // the clusters of the HierarchicalGraph. The ContractionHierarchy has to be preprocessed again either way.
+    if(resized){
+        graph = std::make_shared<Graph>(alg.buildGraph(units));
+        traffic = std::make_shared<TrafficMap>(*traffic, units.getRows(), units.getCols());
+        own(hierarchy).reset();
+    } else {
+        alg.updateGraph(units, own(graph), loc);
+        own(hierarchy).invalidate(loc);
+    }
+    // A hierarchy shared with another Warehouse is replaced rather than copied, as it has to be preprocessed again.
+    if(exclusive(contraction)) contraction->invalidate();
+    else contraction = std::make_shared<ContractionHierarchy>();
+    placement->invalidate();
     return;
 }
 
-// FUNCTION: Helper function used to sort a vector of StorageUnit instances. Compares each StorageUnit by their remaining
-// available space. Accepts two StorageUnit pointers as parameters and returns a boolean.
-bool compare(StorageUnit& a, StorageUnit& b) {
-    return (a.getCapacity() - a.getUsedCapacity()) < (b.getCapacity() - b.getUsedCapacity());
-}
-
 // FUNCTION: Adds a new Item instance to the Warehouse. The function attempts to find a StorageUnit instance within the
 // Warehouse that can accommodate the entire Item instance, however, if that is not possible, it uses the Fractional Knapsack
-// algorithm to distribute the Item across multiple StorageUnits. Parameter is Item i, an instance of Item.
-void Warehouse::add(Item i){
-    // Perform a range query on the range tree to find StorageUnit instances that can accommodate the Item. The lower
-    // bound of the range query is the size of a single Item and the upper bound is the size of the item multiplied
-    // by the quantity to represent the total amount of space the Item instance consumes.
-    std::vector<StorageUnit> possible_units = tree.rangeQuery({i.size_per_unit, i.size_per_unit * i.quantity});
+// algorithm to distribute the Item across multiple StorageUnits. The PlacementPolicy chooses the StorageUnit, and ranks
+// the StorageUnits the Item is split over. Parameter is Item i, an instance of Item. Placing an Item in a StorageUnit
+// that already holds an Item of the same name makes no heap allocations with the BestFitPolicy or the NearestFitPolicy:
+// the nearest neighbor query reuses its buffer, the trees store only handles, and the Item is added to the Grid in place.
+void Warehouse::add(const Item& i){
+    TRACE_SCOPE("placement");
+    // Space held or released by reservations since they were last settled is reflected first, so the Item is never
+    // placed in space that is held.
+    if(reservations.dirty()) settleReservations();
+    PlacementContext floor = {units, *graph, tree, spatial, reservations, *picks, used_capacity, picks_version};
+    // Find a StorageUnit that can accommodate the Item. The space required is the size of a single Item or the size of
+    // the item multiplied by the quantity to represent the total amount of space the Item instance consumes.
+    int space = std::max(i.size_per_unit, i.size_per_unit * i.quantity);
+    UnitHandle target;
+    bool fits = placement->choose(floor, i, space, target);
     // If there are no StorageUnits that can accommodate the entire Item instance, the Item is passed to the fractional
     // knapsack algorithm.
-    if(possible_units.empty()){
+    if(!fits){
         // Fractional knapsack returns an integer representing the amount of space it was able to use and a vector of
-        // coordinates representing StorageUnit instances that had partial Items added.
-        std::pair<int, std::vector<std::pair<int, int> > > results = alg.fknapsack(units, i);
+        // pieces, each a StorageUnit instance's coordinates and the quantity of the Item to store there.
+        std::pair<int, std::vector<std::pair<std::pair<int, int>, int> > > results = alg.fknapsack(units, i, [&](std::pair<int, int> loc){ return placement->priority(floor, i, loc); }, [&](std::pair<int, int> loc){ return reservations.held(loc); });
         int addl_used = results.first;
         // If the space used by the fractional knapsack algorithm is not the equal to the entire Item's space, notify
         // the user that not all the Item was able to fit in the Warehouse.
         if(addl_used != (i.size_per_unit * i.quantity)) std::cout << "[Add Error] Unable to store " <<  (i.size_per_unit * i.quantity) - addl_used << " " << i.name << "(s) due to lack of available storage space." << std::endl;
-        // Adding the space consumed by the new Item to the Warehouse's counter.
-        used_capacity += addl_used;
-        // For every StorageUnit that was modified, update the range tree to reflect the changes.
-        for(std::pair<int, int> loc : results.second) {
-            tree.updateNode(loc, units[loc.first][loc.second]);
-        }
+        // Storing every piece updates the Warehouse's used capacity, the item index, and the trees, and accounts for an
+        // Item of the same name but another size that a piece replaces.
+        for(const std::pair<std::pair<int, int>, int>& piece : results.second) store(piece.first, Item(i.name, piece.second, i.size_per_unit));
     } else {
         // If there is an entire StorageUnit that can accommodate the new Item instance, add the entire Item to the
-        // StorageUnit.
-        // Adding the Item to the most ideal StorageUnit instance.
-        std::sort(possible_units.begin(), possible_units.end(), compare);
-        std::pair<int,int> loc = possible_units[0].getLocation();
-        units[loc.first][loc.second].add(i);
-        // Adding the space consumed by the new Item to the Warehouse's counter.
-        used_capacity += (i.size_per_unit * i.quantity);
-        // Updating the range tree to reflect the changes.
-        tree.updateNode(loc, units[loc.first][loc.second]);
+        // most ideal StorageUnit instance.
+        store(target.loc, i);
     }
     return;
 }
 
+// FUNCTION: Stores a whole Item in the StorageUnit at loc. The Warehouse's used capacity, the item index, the RangeTree,
+// and the KDTree are only updated if the StorageUnit had room for it. Accepts parameters loc and i. Returns false if
+// nothing was stored.
+bool Warehouse::store(std::pair<int, int> loc, const Item& i){
+    // An Item of the same name but another size is replaced rather than added to, so the index is given the change in
+    // the quantity stored at the StorageUnit.
+    const std::map<std::string, Item>* held = units.items(loc);
+    std::map<std::string, Item>::const_iterator before = held == nullptr ? std::map<std::string, Item>::const_iterator() : held->find(i.name);
+    int replaced = held != nullptr && before != held->end() && before->second.size_per_unit != i.size_per_unit ? before->second.quantity : 0;
+    if(!units.add(loc, i)) return false;
+    catalog.insert(i.name, loc);
+    catalog.adjust(i.name, i.quantity - replaced);
+    // Adding the space consumed by the new Item to the Warehouse's counter.
+    used_capacity += (i.size_per_unit * i.quantity);
+    // Updating the range tree and the KDTree to reflect the changes.
+    refresh(loc);
+    return true;
+}
+
+// FUNCTION: Sets the free space of the StorageUnit at loc in the RangeTree and the KDTree to its capacity less its used
+// capacity and the space reservations hold there. Accepts parameter loc.
+void Warehouse::refresh(std::pair<int, int> loc){
+    int free = units.capacityAt(loc) - units.usedAt(loc) - reservations.held(loc);
+    tree.updateNode(loc, free);
+    spatial.update(loc, free);
+    return;
+}
+
+// FUNCTION: Holds space for an inbound Item, such as a pallet planned at a receiving dock, so that it can be stored
+// later without another dock or add(...) taking the space first. The Item is held whole in the StorageUnit with the
+// least free space that fits it, or else split over the StorageUnits with the least free space that fit at least one
+// unit of it, and a StorageUnit holding an Item of the same name but another size, or holding space for one, is never
+// used. Either the whole quantity is held or nothing is. Several docks can reserve, commit, and abort at once from
+// their own threads, as long as no other function of the Warehouse runs meanwhile: candidates are read from the
+// RangeTree, which only changes when reservations are settled, and each hold is checked against the StorageUnit's free
+// space and the space already held there under the lock of that StorageUnit's stripe in the ReservationBook. A
+// candidate another dock took first is skipped. Accepts parameters i, the Item, and timeout_ns, how long the hold lasts
+// unless committed. Returns the reservation's id, or -1 if the Warehouse cannot hold the whole Item.
+long long Warehouse::reserve(const Item& i, long long timeout_ns){
+    METRICS_TIME(OP_RESERVE);
+    TRACE_SCOPE("reserve");
+    if(i.quantity <= 0 || i.size_per_unit <= 0) return -1;
+    Reservation r;
+    r.item = i;
+    r.deadline_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count() + timeout_ns;
+
+    // A StorageUnit keeps one Item of each name, so one holding the Item at another size cannot take it. Space held for
+    // the name at another size is refused by the ReservationBook under the stripe's lock.
+    auto accepts = [&](std::pair<int, int> loc){
+        const std::map<std::string, Item>* held = units.items(loc);
+        if(held == nullptr) return true;
+        std::map<std::string, Item>::const_iterator found = held->find(i.name);
+        return found == held->end() || found->second.size_per_unit == i.size_per_unit;
+    };
+    tree.forEachFit(i.size_per_unit * i.quantity, [&](const UnitHandle& u){
+        if(!accepts(u.loc)) return false;
+        if(reservations.hold(u.loc, i, i.quantity, units.capacityAt(u.loc) - units.usedAt(u.loc), true) == 0){
+            METRICS_COUNT(RESERVATION_CONFLICTS);
+            return false;
+        }
+        r.holds.push_back({u.loc, i.quantity});
+        return true;
+    });
+    if(r.holds.empty()){
+        int left = i.quantity;
+        tree.forEachFit(i.size_per_unit, [&](const UnitHandle& u){
+            if(!accepts(u.loc)) return false;
+            int q = reservations.hold(u.loc, i, left, units.capacityAt(u.loc) - units.usedAt(u.loc), false);
+            if(q == 0) METRICS_COUNT(RESERVATION_CONFLICTS);
+            else r.holds.push_back({u.loc, q});
+            left -= q;
+            return left == 0;
+        });
+        if(left > 0){
+            for(const std::pair<std::pair<int, int>, int>& h : r.holds) reservations.release(h.first, i.name, h.second * i.size_per_unit);
+            return -1;
+        }
+    }
+    return reservations.open(std::move(r));
+}
+
+// FUNCTION: Commits a reservation: its space stays held until settleReservations(...) stores its Item. A reservation
+// past its timeout expires instead. Safe to call alongside reserve(...). Accepts parameter id. Returns the reservation's
+// state afterwards, RESERVATION_UNKNOWN if there is no open reservation with that id.
+ReservationState Warehouse::commitReservation(long long id){
+    return reservations.commit(id, std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+// FUNCTION: Aborts a reservation that has not been committed and releases its space. Safe to call alongside
+// reserve(...). Accepts parameter id. Returns the reservation's state afterwards.
+ReservationState Warehouse::abortReservation(long long id){
+    return reservations.abort(id);
+}
+
+// FUNCTION: Completes the reservations made since the last call, on the Warehouse's own thread while no dock is
+// reserving. The Item of every committed reservation is stored in the StorageUnits holding space for it, reservations
+// past their timeout are released, and the RangeTree and KDTree are given the free space of every StorageUnit whose
+// holds changed, so later queries and add(...) see the held space as taken. A hold whose Item no longer fits, or whose
+// StorageUnit has since been given the Item at another size, is reported and its space released. Returns the number of reservations whose Items were all stored and the number expired.
+std::pair<int, int> Warehouse::settleReservations(){
+    TRACE_SCOPE("settle reservations");
+    std::vector<Reservation> committed;
+    int expired = reservations.sweep(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count(), committed);
+    METRICS_ADD(RESERVATIONS_EXPIRED, expired);
+    int stored = 0;
+    for(const Reservation& r : committed){
+        bool all = true;
+        for(const std::pair<std::pair<int, int>, int>& h : r.holds){
+            reservations.release(h.first, r.item.name, h.second * r.item.size_per_unit);
+            // An Item of the same name stored at another size since the hold was made would be replaced, so the hold is
+            // released instead.
+            const std::map<std::string, Item>* stored = units.items(h.first);
+            std::map<std::string, Item>::const_iterator same = stored == nullptr ? std::map<std::string, Item>::const_iterator() : stored->find(r.item.name);
+            bool conflict = stored != nullptr && same != stored->end() && same->second.size_per_unit != r.item.size_per_unit;
+            if(!conflict && store(h.first, Item(r.item.name, h.second, r.item.size_per_unit))) continue;
+            std::cout << "[Reservation Error] Unable to store " << h.second << " " << r.item.name << "(s) of reservation " << r.id << " at (" << h.first.first << "," << h.first.second << ")." << std::endl;
+            all = false;
+        }
+        if(all) stored++;
+    }
+    std::vector<std::pair<int, int> > changed;
+    reservations.drainChanged(changed);
+    for(std::pair<int, int> loc : changed) refresh(loc);
+    return {stored, expired};
+}
+
+// FUNCTION: Removes a quantity of an Item from the Warehouse, draining the StorageUnits that were stocked with it first
+// before newer ones (first in, first out). The oldest location is found in the item index, so each StorageUnit touched
+// costs O(log n). Accepts parameters name, the name of the Item, and quantity, the quantity to remove. Returns the
+// quantity taken from each StorageUnit in the order they were drained; the total is less than quantity if the Warehouse
+// did not hold enough of the Item.
+std::vector<Withdrawal> Warehouse::remove(const std::string& name, int quantity){
+    TRACE_SCOPE("remove");
+    std::vector<Withdrawal> taken;
+    // A StorageUnit is either drained of the Item, which drops it from the index, or has enough left to finish, so the
+    // loop visits each location at most once.
+    for(const ItemLocations* at = catalog.find(name); at != nullptr && quantity > 0; at = catalog.find(name)){
+        std::pair<int, int> loc = *at->by_age.first();
+        int removed = withdraw(loc, name, quantity);
+        if(removed > 0) taken.push_back({loc, removed});
+        quantity -= removed;
+    }
+    return taken;
+}
+
+// FUNCTION: Picks a quantity of an Item from the Warehouse, draining the StorageUnits closest to src by Manhattan
+// Distance first. The StorageUnits holding the Item are listed from the item index and kept in a heap by distance, so
+// only as many of them are ordered as are drained. Accepts parameters src, the location the picker starts from, name,
+// the name of the Item, and quantity, the quantity to pick. Returns the quantity taken from each StorageUnit, nearest
+// first; the total is less than quantity if the Warehouse did not hold enough of the Item.
+std::vector<Withdrawal> Warehouse::pick(std::pair<int, int> src, const std::string& name, int quantity){
+    TRACE_SCOPE("pick");
+    std::vector<Withdrawal> taken;
+    const ItemLocations* at = catalog.find(name);
+    if(at == nullptr || quantity <= 0) return taken;
+
+    std::vector<std::pair<int, std::pair<int, int> > > nearest;
+    nearest.reserve(at->by_location.size());
+    at->by_location.forEach([&](std::pair<int, int> loc, unsigned long long){
+        nearest.push_back({std::abs(loc.first - src.first) + std::abs(loc.second - src.second), loc});
+    });
+    std::greater<std::pair<int, std::pair<int, int> > > farther;
+    std::make_heap(nearest.begin(), nearest.end(), farther);
+    while(!nearest.empty() && quantity > 0){
+        std::pop_heap(nearest.begin(), nearest.end(), farther);
+        std::pair<int, int> loc = nearest.back().second;
+        nearest.pop_back();
+        int removed = withdraw(loc, name, quantity);
+        if(removed > 0) taken.push_back({loc, removed});
+        quantity -= removed;
+    }
+    return taken;
+}
+
+// FUNCTION: Takes up to a quantity of an Item from the StorageUnit at loc. The Warehouse's used capacity, the RangeTree,
+// and the KDTree are updated with the StorageUnit's new free space, and the StorageUnit is dropped from the item index
+// once none of the Item is left in it. Accepts parameters loc, name, and quantity. Returns the quantity taken.
+int Warehouse::withdraw(std::pair<int, int> loc, const std::string& name, int quantity){
+    int before = units.usedAt(loc);
+    int removed = units.remove(loc, name, quantity);
+    METRICS_COUNT(WITHDRAWALS);
+    used_capacity -= before - units.usedAt(loc);
+    catalog.adjust(name, -removed);
+    const std::map<std::string, Item>* left = units.items(loc);
+    if(left == nullptr || left->count(name) == 0) catalog.erase(name, loc);
+    refresh(loc);
+    return removed;
+}
+
+// FUNCTION: Sets how add(...) chooses the StorageUnit for an Item. Accepts parameter policy, the PlacementPolicy to use,
+// which the Warehouse takes ownership of.
+void Warehouse::setPlacement(std::unique_ptr<PlacementPolicy> policy){
+    this->placement = std::move(policy);
+    return;
+}
+
+// FUNCTION: Counts one pick of each Item in a list. Called for every Item looked up or picked by a command, so the pick
+// counts follow the workload. Accepts parameter items, the names of the Items picked.
+void Warehouse::recordPicks(const std::vector<std::string>& items){
+    std::unordered_map<std::string, long long>& counts = own(picks);
+    for(const std::string& i : items) counts[i]++;
+    picks_version++;
+    return;
+}
+
+// FUNCTION: Adds pick counts from a CSV file with a header row and one "Name,Picks" row per Item to those already
+// recorded. Accepts parameter file, the name of the file. Returns false if the file could not be opened; rows that
+// cannot be read are reported and skipped.
+bool Warehouse::loadPicks(const std::string& file){
+    std::ifstream in(file);
+    if(!in) return false;
+    std::string line, name, count;
+    std::getline(in, line);
+    while(std::getline(in, line)){
+        std::stringstream row(line);
+        std::getline(row, name, ',');
+        std::getline(row, count, ',');
+        try {
+            own(picks)[name] += std::stoll(count);
+        } catch(const std::exception&) {
+            std::cout << "[Placement Error] Invalid pick count for " << name << " in " << file << "." << std::endl;
+        }
+    }
+    picks_version++;
+    return true;
+}
+
+// FUNCTION: Sets how getPath(...) finds the shortest path between two cells. Accepts parameters mode, the RoutingMode
+// to use, and cluster_size and spacing, the side length of the HierarchicalGraph's clusters and the distance between
+// the entrances along their borders. cluster_size and spacing are ignored in the other modes.
+void Warehouse::setRouting(RoutingMode mode, int cluster_size, int spacing){
+    this->routing = mode;
+    if(mode == HPA_ROUTING && (cluster_size != hierarchy->getClusterSize() || spacing != hierarchy->getSpacing())) own(hierarchy).configure(cluster_size, spacing);
+    return;
+}
+
+// FUNCTION: Prepares the ContractionHierarchy used by CH_ROUTING. If file names a hierarchy saved for a floor with the
+// same size and StorageUnit capacities, it is loaded; otherwise the floor is preprocessed and the result saved to file.
+// The file is remembered so the hierarchy is saved again whenever it is rebuilt after the floor changes. An empty file
+// name skips loading and saving, and keeps a hierarchy that is still current. Reports the preprocessing time, the
+// number of shortcuts, and the memory used.
+void Warehouse::preprocessRoutes(const std::string& file){
+    routes_file = file;
+    if(units.getRows() == 0 || (file.empty() && contraction->isCurrent(units))) return;
+    ContractionHierarchy& ch = own(contraction);
+    if(!file.empty() && ch.load(units, file)){
+        std::cout << "[Routing] Loaded the contraction hierarchy from " << file << ": " << ch.getShortcuts() << " shortcuts, " << ch.memoryUsage().bytes << " bytes." << std::endl;
+        return;
+    }
+
+    ch.build(units);
+    std::cout << "[Routing] Built the contraction hierarchy in " << ch.getBuildTime() / 1000000 << " ms: " << ch.getShortcuts() << " shortcuts, " << ch.memoryUsage().bytes << " bytes." << std::endl;
+    if(!file.empty() && !ch.save(file)) std::cout << "[Routing Error] Unable to save the contraction hierarchy to " << file << "." << std::endl;
+    return;
+}
+
+// FUNCTION: Sets how getPath(...) visits a series of Items. Accepts parameter mode, the PickingMode to use.
+void Warehouse::setPicking(PickingMode mode){
+    this->picking = mode;
+    return;
+}
+
+// FUNCTION: Sets how FLAT_ROUTING spreads pickers over the floor. Every path returned by route(...) is counted on the
+// edges it crosses; with a penalty above 0, FLAT_ROUTING adds penalty times that count to each edge so later paths avoid
+// busy aisles. Counts are halved every half_life routes. Accepts parameters penalty, 0 to route by distance alone, and
+// half_life, the number of routes after which traffic counts half. A TrafficMap shared with fork() is copied first.
+void Warehouse::setCongestion(int penalty, int half_life){
+    own(traffic).configure(penalty, half_life);
+    return;
+}
+
 // FUNCTION: Returns the max capacity of the Warehouse instance.
 int Warehouse::getSize() {
     return this->capacity;
@@ -168,29 +473,163 @@ float Warehouse::getUsagePercentage() {
 }
 
 // FUNCTION: Returns a StorageUnit instance from inside the Warehouse. Accepts parameter loc, a pair of integers representing
-// coordinates.
+// coordinates. Empty cells return a StorageUnit with a capacity of 0.
 StorageUnit Warehouse::getUnit(std::pair<int, int> loc) {
-    return units[loc.first][loc.second];
+    return units.unit(loc);
 }
 
 // FUNCTION: Locates any Item instance in the Warehouse that matches the provided name. Parameter i_name is a string representing\
 // the name of the Item to find. Returns a vector of integers, representing coordinates for all StorageUnit instances that\
-// contain the Item.
+// contain the Item, in row-major order. The locations come from the item index, so the floor is not scanned.
 std::vector<std::pair<int, int> > Warehouse::findItem(std::string i_name) {
+    TRACE_SCOPE("item search");
     std::vector<std::pair<int, int> > found_locations;
-    // Iterate over each unit in the Warehouse.
-    for(int i = 0; i < units.size(); i++){
-        for(int j = 0; j < units[i].size(); j++){
-            // Retrieving the Item map of the StorageUnit and checking if the Item exists.
-            std::map<std::string, Item> items = units[i][j].getItems();
-            if(items.find(i_name) != items.end()) found_locations.push_back({i,j});
-        }
-    }
+    const ItemLocations* at = catalog.find(i_name);
+    if(at == nullptr) return found_locations;
+    found_locations.reserve(at->by_location.size());
+    at->by_location.forEach([&](std::pair<int, int> loc, unsigned long long){ found_locations.push_back(loc); });
     return found_locations;
 }
 
+// FUNCTION: Locates every Item whose name matches pattern, where * stands for any run of characters and ? for any single
+// character, such as "Monitor*" for every name starting with Monitor. Results are streamed to f in name order as the
+// item index finds them, until f returns false. A pattern whose only wildcard is a single * at its end is answered as a
+// prefix query, which walks straight to the end of the prefix. An empty pattern matches no Item. Accepts parameters
+// pattern and f, called with each name and the Item's locations and quantity. Returns the number of Items passed to f,
+// or -1 if the pattern is longer than 63 characters.
+int Warehouse::findItems(const std::string& pattern, const std::function<bool(const std::string&, const ItemLocations&)>& f) {
+    TRACE_SCOPE("item search");
+    if(pattern.empty()) return 0;
+    size_t wildcard = pattern.find_first_of("*?");
+    if(wildcard == pattern.size() - 1 && pattern.back() == '*') return catalog.forEachPrefix(pattern.substr(0, wildcard), f);
+    return catalog.forEachMatch(pattern, f);
+}
+
+// FUNCTION: Locates every StorageUnit inside a rectangle of the floor with at least the given free space, using the
+// KDTree. Accepts parameters low and high, the opposite corners of the rectangle (inclusive), and space, the free space
+// required. Returns the locations and free space of the StorageUnits found in row-major order.
+std::vector<UnitHandle> Warehouse::findSpace(std::pair<int, int> low, std::pair<int, int> high, int space) {
+    std::vector<UnitHandle> results;
+    spatial.rectangle({std::min(low.first, high.first), std::min(low.second, high.second)}, {std::max(low.first, high.first), std::max(low.second, high.second)}, space, results);
+    return results;
+}
+
+// FUNCTION: Locates the StorageUnits closest to a location, by Manhattan Distance, with at least the given free space,
+// using the KDTree. Accepts parameters loc, the location to search from, space, the free space required, and count, the
+// number of StorageUnits to return. Returns the locations and free space of the StorageUnits found, nearest first.
+std::vector<UnitHandle> Warehouse::findNearestSpace(std::pair<int, int> loc, int space, int count) {
+    std::vector<UnitHandle> results;
+    spatial.nearest(loc, space, count, results);
+    return results;
+}
+
+// FUNCTION: Returns true if add(...) would store all of an Item, either in a single StorageUnit or split between several,
+// without changing the Warehouse. An Item that needs no space always fits. Accepts parameter i, an instance of Item.
+bool Warehouse::canStore(const Item& i) {
+    if(i.quantity <= 0 || i.size_per_unit <= 0) return true;
+    return maxPlaceable(i.size_per_unit) >= i.quantity;
+}
+
+// FUNCTION: Returns the largest quantity of an Item with the given positive size per unit that the Warehouse can still
+// store, splitting it between StorageUnits as add(...) does. Answered from the RangeTree's subtree totals without
+// visiting the Grid. Accepts parameter size_per_unit, the size of a single Item.
+long long Warehouse::maxPlaceable(int size_per_unit) {
+    return tree.maxPlaceable(size_per_unit);
+}
+
+// FUNCTION: Returns the number of StorageUnits with at least the given free space and the total free space they hold, in
+// O(log n) from the RangeTree. Accepts parameter space, the free space required.
+std::pair<int, long long> Warehouse::freeSpace(int space) {
+    return {tree.count(space), tree.freeSpace(space)};
+}
+
+// FUNCTION: Counts the StorageUnits in each bucket of free space using the RangeTree. Accepts parameters width, the
+// positive width of each bucket, and buckets, the number of buckets. Bucket i holds the StorageUnits with free space
+// from i * width up to (i + 1) * width; the last bucket also holds every StorageUnit with more free space.
+std::vector<int> Warehouse::freeHistogram(int width, int buckets) {
+    std::vector<int> results(buckets, 0);
+    tree.histogram(width, results);
+    return results;
+}
+
+// FUNCTION: Copies the capacity, used capacity, and Items of every StorageUnit in row-major order, so a consolidation
+// cycle can be planned on another thread without reading the Grid. Items with a quantity of 0 take no space and are
+// left out.
+std::vector<SnapshotUnit> Warehouse::snapshot() {
+    std::vector<SnapshotUnit> floor;
+    floor.reserve(units.size());
+    units.forEach([&](const GridCell& u){
+        floor.push_back({u.loc, u.capacity, u.used, {}});
+        if(u.items == nullptr) return;
+        for(const std::pair<const std::string, Item>& i : *u.items) if(i.second.quantity > 0) floor.back().items.push_back(i.second);
+    });
+    return floor;
+}
+
+// FUNCTION: Returns how scattered the Items and the free space of the Warehouse are.
+Fragmentation Warehouse::fragmentation() {
+    return Consolidator::measure(snapshot());
+}
+
+// FUNCTION: Takes a snapshot of the floor and starts planning a consolidation cycle on it on a background thread. The
+// Warehouse can keep being used while the cycle is planned. Accepts parameter budget, the most moves the cycle may
+// make. Returns false if a cycle is already being planned.
+bool Warehouse::startConsolidation(int budget) {
+    if(consolidator.running()) return false;
+    return consolidator.start(snapshot(), budget);
+}
+
+// FUNCTION: Returns true if the consolidation cycle being planned is done, so finishConsolidation() will not wait.
+bool Warehouse::consolidationReady() {
+    return consolidator.ready();
+}
+
+// FUNCTION: Waits for the consolidation cycle being planned and commits its moves in order. Moves that are no longer
+// possible because the Warehouse changed after the snapshot are skipped. Returns the number of moves made and skipped.
+std::pair<int, int> Warehouse::finishConsolidation() {
+    std::vector<ConsolidationMove> moves = consolidator.finish();
+    TRACE_SCOPE("consolidation commit");
+    int made = 0;
+    for(const ConsolidationMove& m : moves) made += commitMove(m);
+    METRICS_ADD(CONSOLIDATION_MOVES, made);
+    METRICS_ADD(CONSOLIDATION_SKIPPED, moves.size() - made);
+    return {made, (int)moves.size() - made};
+}
+
+// FUNCTION: Plans a consolidation cycle of at most budget moves and commits it. Returns the number of moves made and
+// skipped.
+std::pair<int, int> Warehouse::consolidate(int budget) {
+    if(!startConsolidation(budget)) return {0, 0};
+    return finishConsolidation();
+}
+
+// FUNCTION: Moves an Item between StorageUnits as planned by the Consolidator. The move is checked against the floor as
+// it is now: the source must still hold the quantity being moved, and the destination must have room for it and must not
+// hold an Item of the same name with a different size. Either the whole move is made, updating the Grid, the RangeTree,
+// the KDTree, and the item index, or nothing changes. The Warehouse's used capacity is the same afterwards. Accepts parameter move.
+// Returns true if the move was made.
+bool Warehouse::commitMove(const ConsolidationMove& move) {
+    const std::map<std::string, Item>* from = units.items(move.from);
+    const std::map<std::string, Item>* to = units.items(move.to);
+    if(from == nullptr || !units.occupied(move.to) || move.from == move.to) return false;
+
+    std::map<std::string, Item>::const_iterator source = from->find(move.name);
+    if(source == from->end() || source->second.size_per_unit != move.size_per_unit || source->second.quantity < move.quantity) return false;
+    if(units.capacityAt(move.to) - units.usedAt(move.to) - reservations.held(move.to) < move.quantity * move.size_per_unit) return false;
+    if(to != nullptr && to->count(move.name) != 0 && to->at(move.name).quantity > 0 && to->at(move.name).size_per_unit != move.size_per_unit) return false;
+
+    units.remove(move.from, move.name, move.quantity);
+    units.add(move.to, Item(move.name, move.quantity, move.size_per_unit));
+    // The destination is indexed first, so the Item and its quantity stay in the index while the source is dropped.
+    catalog.insert(move.name, move.to);
+    from = units.items(move.from);
+    if(from == nullptr || from->count(move.name) == 0) catalog.erase(move.name, move.from);
+    for(std::pair<int, int> loc : {move.from, move.to}) refresh(loc);
+    return true;
+}
+
 // FUNCTION: Calculates the shortest path between an origin point and a series of destination locations. Utilizes
-// Dijkstra's Algorithm to complete this calculation. Accepts parameters src, a pair of integers representing the starting
+// route(...) to complete this calculation. Accepts parameters src, a pair of integers representing the starting
 // coordinates, and dest, a vector of integer pairs representing the locations to travel to from the source node.
 // Returns an integer representing the total distance between the source and destination(s). The function also prints the
 // shortest path to the standard output.
@@ -200,12 +639,21 @@ int Warehouse::getPath(std::pair<int, int> src, std::vector <std::pair<int, int>
 
     std::pair<int, int> source;
 
+    // Every location must be part of the floor.
+    for(int k = -1; k < (int)dest.size(); k++){
+        std::pair<int, int> coords = k < 0 ? src : dest[k];
+        if(!units.inBounds(coords)){
+            std::cout << "[FIND_PATH_UNITS] The location (" << coords.first << "," << coords.second << ") is outside of the Warehouse." << std::endl;
+            return -1;
+        }
+    }
+
     // Iterate through each destination
     for(std::pair<int, int> coords : dest){
         if(path.empty()) source = src;
         else source = path[path.size() - 1];
-        // Using Dijkstra's Algorithm to find the shortest path from each StorageUnit instance to the next.
-        std::pair<int, std::vector<std::pair<int, int> > > results = alg.dijkstra(units, graph, source, coords);
+        // Using Dijkstra's Algorithm, or the HierarchicalGraph, to find the shortest path from each StorageUnit instance to the next.
+        std::pair<int, std::vector<std::pair<int, int> > > results = route(source, coords);
         // Add the distance for each specific traversal to the total for the entire traversal.
         totaldistance += results.first;
         // Push the path traveled to the vector tracking the shortest path.
@@ -224,13 +672,263 @@ int Warehouse::getPath(std::pair<int, int> src, std::vector <std::pair<int, int>
     return totaldistance;
 }
 
+// FUNCTION: Finds the shortest path between two cells of the floor, with Dijkstra's Algorithm over the whole graph in
+// FLAT_ROUTING mode, with the HierarchicalGraph in HPA_ROUTING mode, or with the ContractionHierarchy in CH_ROUTING
+// mode, preprocessing the floor first if it changed. Both cells must be inside the floor. Returns the length of the path
+// and the cells along it. The hierarchies keep their search buffers between queries, so a Warehouse made by fork() copies
+// a hierarchy it shares the first time it routes with it. Every path is recorded in the TrafficMap, which is likewise
+// copied the first time a Warehouse sharing it with a fork routes, so the routes of a fork never count as traffic in
+// another Warehouse. With a congestion penalty FLAT_ROUTING returns the path that is shortest with the penalties, along
+// with its length without them. The hierarchies are preprocessed with fixed weights and ignore the penalty. With
+// FLAT_ROUTING the floor and the graph are only read and the traffic is updated atomically, so pickers on several
+// threads can route at once, as long as the TrafficMap is no longer shared when they start.
+std::pair<int, std::vector<std::pair<int, int> > > Warehouse::route(std::pair<int, int> src, std::pair<int, int> dest) {
+    std::pair<int, std::vector<std::pair<int, int> > > path;
+    if(routing == HPA_ROUTING) path = own(hierarchy).route(units, src, dest);
+    else if(routing == CH_ROUTING){
+        if(!contraction->isCurrent(units)) preprocessRoutes(routes_file);
+        path = own(contraction).route(src, dest);
+    }
+    else if(traffic->getPenalty() > 0) path = alg.dijkstra(units, *graph, src, dest, *traffic);
+    else path = alg.dijkstra(units, *graph, src, dest);
+    own(traffic).record(path.second);
+    return path;
+}
+
+// FUNCTION: Calculates the length of the shortest path between every pair of cells in points. In CH_ROUTING mode the
+// ContractionHierarchy fills the whole matrix at once; otherwise one run of Dijkstra's Algorithm from each cell, spread
+// over every core, measures the distances to all of the others. Every cell must be inside the floor. Returns points.size() rows of points.size()
+// distances.
+std::vector<int> Warehouse::distanceMatrix(const std::vector<std::pair<int, int> >& points) {
+    METRICS_TIME(OP_DISTANCE_MATRIX);
+    std::vector<int> matrix;
+    if(routing == CH_ROUTING){
+        if(!contraction->isCurrent(units)) preprocessRoutes(routes_file);
+        own(contraction).distances(points, matrix);
+        return matrix;
+    }
+    // The searches only read the floor and the graph, so the rows are filled in parallel.
+    int k = points.size();
+    matrix.resize(k * k);
+    parallelFor(k, [&](int i){
+        std::vector<int> row = alg.distances(units, *graph, points[i], points);
+        std::copy(row.begin(), row.end(), matrix.begin() + i * k);
+    });
+    return matrix;
+}
+
+// FUNCTION: Calculates the length of the shortest path from src to each cell in targets. In CH_ROUTING mode the
+// ContractionHierarchy measures them with its many-to-many search; otherwise a single run of Dijkstra's Algorithm from src
+// stops once every target is reached. Every cell must be inside the floor. Returns one distance per target, in order.
+std::vector<int> Warehouse::distances(std::pair<int, int> src, const std::vector<std::pair<int, int> >& targets) {
+    if(routing != CH_ROUTING) return alg.distances(units, *graph, src, targets);
+    std::vector<std::pair<int, int> > points(1, src);
+    points.insert(points.end(), targets.begin(), targets.end());
+    std::vector<int> matrix = distanceMatrix(points);
+    return std::vector<int>(matrix.begin() + 1, matrix.begin() + points.size());
+}
+
+// FUNCTION: Lists the candidate StorageUnits of every Item in a pick list: up to MAX_PICK_CANDIDATES of the StorageUnits
+// holding the Item, closest to the origin first. Accepts parameters src, the origin, items, the names of the Items,
+// points and index, the locations found so far and the position of each in points, and stops, to which the positions of
+// each Item's candidates are appended. A location is only added to points once, however many Items it holds. Returns
+// false if an Item cannot be found.
+bool Warehouse::pickStops(std::pair<int, int> src, const std::vector<std::string>& items, std::vector<std::pair<int, int> >& points, std::map<std::pair<int, int>, int>& index, std::vector<std::vector<int> >& stops) {
+    for(const std::string& i : items){
+        std::vector<std::pair<int, int> > loc = findItem(i);
+        if(loc.empty() || loc[0].first == -1) return false;
+        std::sort(loc.begin(), loc.end(), [src](const std::pair<int, int>& a, const std::pair<int, int>& b){
+            return std::abs(a.first - src.first) + std::abs(a.second - src.second) < std::abs(b.first - src.first) + std::abs(b.second - src.second);
+        });
+        if((int)loc.size() > MAX_PICK_CANDIDATES) loc.resize(MAX_PICK_CANDIDATES);
+
+        std::vector<int> candidates;
+        for(std::pair<int, int> l : loc){
+            std::map<std::pair<int, int>, int>::iterator found = index.find(l);
+            if(found == index.end()){
+                found = index.insert({l, (int)points.size()}).first;
+                points.push_back(l);
+            }
+            candidates.push_back(found->second);
+        }
+        stops.push_back(candidates);
+    }
+    return true;
+}
+
+// FUNCTION: Plans the walk from an origin point that picks every Item in a list. Each Item can be picked from any of its
+// candidate StorageUnits (see pickStops(...)). The distances between the origin and all of those StorageUnits are
+// measured once, and the TourPlanner chooses one StorageUnit per Item and the order to visit them in. Accepts parameters
+// src, the starting coordinates, and items, the names of the Items to pick. Returns the locations to visit in order, or
+// an empty vector if an Item cannot be found or src is outside of the floor.
+std::vector<std::pair<int, int> > Warehouse::planPick(std::pair<int, int> src, const std::vector<std::string>& items) {
+    if(!units.inBounds(src)) return {};
+    std::vector<std::pair<int, int> > points = {src};
+    std::map<std::pair<int, int>, int> index = {{src, 0}};
+    std::vector<std::vector<int> > stops;
+    if(!pickStops(src, items, points, index, stops)) return {};
+
+    std::vector<int> matrix = distanceMatrix(points);
+    std::vector<std::pair<int, int> > ordered;
+    for(int p : planner.plan(matrix, points.size(), 0, stops, false)) ordered.push_back(points[p]);
+    return ordered;
+}
+
+// FUNCTION: Plans a wave of orders. Orders are grouped into tours of at most capacity Items, each walked by one picker
+// as a round trip from the origin. The candidate StorageUnits of every Item in the wave are measured against each other
+// once, and the same distances are used to plan each order on its own, to group the orders, and to plan each tour.
+// Tours are grouped greedily: the order whose own round trip is longest starts a tour, and the order whose Items are
+// closest to the StorageUnits already in the tour is added next until no remaining order fits. An order with more Items
+// than capacity is split into parts of capacity Items, and the last part of fewer, that are grouped like orders and
+// listed in WavePlan::split; an order without Items is skipped. Orders, and then tours, are planned in parallel. Every
+// Item is counted as picked. Accepts parameters src, the origin, orders, the Item names of each order, and capacity.
+// Returns the tours and the total distance walked by the wave and by picking every order, or part of an order,
+// separately, or a WavePlan with a distance of -1 if an Item cannot be found, src is outside of the floor, or capacity
+// is below 1.
+WavePlan Warehouse::planWave(std::pair<int, int> src, const std::vector<std::vector<std::string> >& orders, int capacity) {
+    TRACE_SCOPE("wave planning");
+    WavePlan wave;
+    for(const std::vector<std::string>& order : orders) recordPicks(order);
+    if(!units.inBounds(src) || capacity < 1){
+        wave.distance = -1;
+        return wave;
+    }
+
+    // The stops of every order share one set of points.
+    std::vector<std::pair<int, int> > points = {src};
+    std::map<std::pair<int, int>, int> index = {{src, 0}};
+    std::vector<std::vector<std::vector<int> > > stops(orders.size());
+    for(int o = 0; o < (int)orders.size(); o++){
+        if(!pickStops(src, orders[o], points, index, stops[o])){
+            wave.distance = -1;
+            return wave;
+        }
+    }
+    std::vector<int> matrix = distanceMatrix(points);
+    int n = points.size();
+
+    // Splitting the orders into parts of at most capacity Items, in the order their Items were given. An order without
+    // Items has no parts.
+    std::vector<int> owner;
+    std::vector<std::vector<std::vector<int> > > parts;
+    for(int o = 0; o < (int)orders.size(); o++){
+        if((int)stops[o].size() > capacity) wave.split.push_back(o);
+        for(int first = 0; first < (int)stops[o].size(); first += capacity){
+            owner.push_back(o);
+            parts.push_back(std::vector<std::vector<int> >(stops[o].begin() + first, stops[o].begin() + std::min<int>(first + capacity, stops[o].size())));
+        }
+    }
+
+    // Each part picked on its own.
+    std::vector<long long> alone(parts.size());
+    parallelFor(parts.size(), [&](int o){
+        TourPlanner tour_planner;
+        alone[o] = TourPlanner::length(matrix, n, 0, tour_planner.plan(matrix, n, 0, parts[o], true), true);
+    });
+    for(long long d : alone) wave.separate += d;
+
+    // Grouping the parts into tours. near[o][i] is the distance from Item i of part o to the closest StorageUnit in the
+    // tour being grouped.
+    std::vector<bool> grouped(parts.size(), false);
+    std::vector<std::vector<long long> > near(parts.size());
+    std::vector<std::vector<std::vector<int> > > tour_stops;
+    for(int remaining = parts.size(); remaining > 0; ){
+        int seed = -1;
+        for(int o = 0; o < (int)parts.size(); o++){
+            if(!grouped[o] && (seed == -1 || alone[o] > alone[seed])) seed = o;
+        }
+        WaveTour tour;
+        tour_stops.push_back({});
+        int load = 0;
+        for(int o = 0; o < (int)parts.size(); o++) near[o].assign(parts[o].size(), LLONG_MAX);
+
+        for(int next = seed; next != -1; ){
+            grouped[next] = true;
+            remaining--;
+            if(tour.orders.empty() || tour.orders.back() != owner[next]) tour.orders.push_back(owner[next]);
+            tour_stops.back().insert(tour_stops.back().end(), parts[next].begin(), parts[next].end());
+            load += parts[next].size();
+
+            std::vector<int> added;
+            for(std::vector<int>& candidates : parts[next]) added.insert(added.end(), candidates.begin(), candidates.end());
+            next = -1;
+            double best = 0;
+            for(int o = 0; o < (int)parts.size(); o++){
+                if(grouped[o] || load + (int)parts[o].size() > capacity) continue;
+                long long sum = 0;
+                for(int i = 0; i < (int)parts[o].size(); i++){
+                    for(int c : parts[o][i]){
+                        for(int p : added) near[o][i] = std::min(near[o][i], (long long)matrix[c * n + p]);
+                    }
+                    sum += near[o][i];
+                }
+                double mean = (double)sum / parts[o].size();
+                if(next == -1 || mean < best){
+                    best = mean;
+                    next = o;
+                }
+            }
+        }
+        wave.tours.push_back(tour);
+    }
+
+    // Planning each tour over the stops of all of its orders.
+    parallelFor(wave.tours.size(), [&](int t){
+        WaveTour& tour = wave.tours[t];
+        TourPlanner tour_planner;
+        std::vector<int> planned = tour_planner.plan(matrix, n, 0, tour_stops[t], true);
+        tour.distance = TourPlanner::length(matrix, n, 0, planned, true);
+        for(int p : planned) tour.stops.push_back(points[p]);
+    });
+    for(WaveTour& tour : wave.tours) wave.distance += tour.distance;
+    return wave;
+}
+
+// FUNCTION: Plans routes for several pickers or robots moving on the floor at the same time, so that no two are ever in
+// the same cell or on the same edge at once. Each step between neighboring cells takes as long as the edge's weight in
+// the floor's graph, and an agent waits in place when its way is blocked; see AgentPlanner. Accepts parameters agents,
+// the start and goal cell of each agent, and budget_ns, the planning budget in nanoseconds. Returns the AgentPlan, or an
+// AgentPlan with a makespan of -1 if a cell is outside of the floor or two agents share a start or a goal.
+AgentPlan Warehouse::planAgents(const std::vector<std::pair<std::pair<int, int>, std::pair<int, int> > >& agents, long long budget_ns) {
+    AgentPlan plan;
+    std::set<std::pair<int, int> > starts, goals;
+    for(const std::pair<std::pair<int, int>, std::pair<int, int> >& agent : agents){
+        if(!units.inBounds(agent.first) || !units.inBounds(agent.second) || !starts.insert(agent.first).second || !goals.insert(agent.second).second){
+            plan.makespan = -1;
+            return plan;
+        }
+    }
+    AgentPlanner planner;
+    return planner.plan(units, *graph, agents, budget_ns);
+}
+
 // FUNCTION: Calculates the shortest path between a specified origin point and a series of Items within the Warehouse.
 // Accepts parameters src, a pair of integers representing the starting coordinates, and items, a vector of strings representing
 // the names of Items to find and travel to. For this function, if an Item is present in multiple StorageUnits, a path is
-// only calculated for the first. Returns an integer representing the total distance between the source and destination(s).
-// The function also prints the shortest path to the standard output.
+// only calculated for the first, unless the PickingMode is OPTIMIZED_ORDER, in which case planPick(...) chooses the
+// StorageUnits and the order to visit them in. Every Item is counted as picked. Returns an integer representing the total
+// distance between the source and destination(s). The function also prints the shortest path to the standard output.
 int Warehouse::getPath(std::pair<int, int> src, std::vector<std::string> items) {
     std::vector<std::pair<int, int> > path;
+    recordPicks(items);
+
+    if(picking == OPTIMIZED_ORDER && !items.empty()){
+        if(!units.inBounds(src)){
+            std::cout << "[FIND_PATH_UNITS] The location (" << src.first << "," << src.second << ") is outside of the Warehouse." << std::endl;
+            return -1;
+        }
+        path = planPick(src, items);
+        if(path.empty()){
+            std::cout << "[FIND_PATH_ITEMS] One of the items could not be found." << std::endl;
+            return -1;
+        }
+        std::cout << "[FIND_PATH_ITEMS] Optimized order of " << items.size() << " items: ";
+        for(std::pair<int, int> stop : path) std::cout << "(" << stop.first << "," << stop.second << ") ";
+        std::cout << std::endl;
+        int totaldistance = getPath(src, path);
+        std::cout << "[FIND_PATH_ITEMS] Shortest path between all items: " << totaldistance << " units" << std::endl;
+        return totaldistance;
+    }
 
     // Iterates over all Items to be traveled to.
     for(std::string i : items){
@@ -253,8 +951,82 @@ int Warehouse::getPath(std::pair<int, int> src, std::vector<std::string> items)
     return totaldistance;
 }
 
-// FUNCTION: Generates and exports various statistics, visualizations, and data for the current Warehouse instance.
+// FUNCTION: Returns a copy of the Warehouse for what-if simulations, such as trying a batch of Items or a new layout
+// without touching the real floor. The copy is made in O(1): the Grid's chunks, the trees, the item index, the graph,
+// the TrafficMap, and the routing hierarchies are shared, and each Warehouse copies only the chunks, tree paths, and
+// pages it changes afterwards, so a fork's own memory is proportional to the StorageUnits it changes. Forks can be changed on different
+// threads. The copy gets its own copy of the PlacementPolicy and does not take over a consolidation cycle being planned
+// or any reservation: reservations are settled first, and the copy's free space indexes are given back the space held
+// in the original.
+std::unique_ptr<Warehouse> Warehouse::fork() {
+    TRACE_SCOPE("fork");
+    if(reservations.dirty()) settleReservations();
+    std::unique_ptr<Warehouse> copy(new Warehouse());
+    copy->num_units = num_units;
+    copy->capacity = capacity;
+    copy->used_capacity = used_capacity;
+    copy->layout_version = layout_version;
+    copy->units = units;
+    copy->catalog = catalog;
+    copy->graph = graph;
+    copy->tree = tree;
+    copy->spatial = spatial;
+    copy->hierarchy = hierarchy;
+    copy->contraction = contraction;
+    copy->routes_file = routes_file;
+    copy->routing = routing;
+    copy->traffic = traffic;
+    copy->picking = picking;
+    copy->planner = planner;
+    copy->placement = placement->clone();
+    copy->picks = picks;
+    copy->picks_version = picks_version;
+    std::vector<std::pair<int, int> > held;
+    reservations.forEachHeld([&](std::pair<int, int> loc, int){ held.push_back(loc); });
+    for(std::pair<int, int> loc : held) copy->refresh(loc);
+    return copy;
+}
+
+// FUNCTION: Returns a MemoryReport estimating the heap memory used by each of the Warehouse's data structures: the 2D
+// Grid of StorageUnits, the Item maps inside those StorageUnits, the adjacency lists, and the nodes and location
+// indexes of the range tree and the KDTree.
+MemoryReport Warehouse::memoryUsage() {
+    MemoryReport report;
+
+    report.add("units grid", units.memoryUsage());
+    report.add("unit item maps", units.itemMemoryUsage());
+    report.add("item index", catalog.memoryUsage());
+
+    // Hash table of adjacency lists: one node per occupied cell plus the bucket array, and each list's buffer.
+    MemoryUsage adjacency;
+    adjacency.bytes = graph->size() * (sizeof(void*) + sizeof(Graph::value_type)) + graph->bucket_count() * sizeof(void*);
+    adjacency.allocations = graph->size() + 1;
+    for(const Graph::value_type& edges : *graph) adjacency += estimateVector(edges.second);
+    report.add("graph adjacency lists", adjacency);
+
+    MemoryUsage tree_nodes, tree_index;
+    tree.memoryUsage(tree_nodes, tree_index);
+    report.add("range tree nodes", tree_nodes);
+    report.add("range tree index", tree_index);
+
+    MemoryUsage kd_nodes, kd_index;
+    spatial.memoryUsage(kd_nodes, kd_index);
+    report.add("kd-tree nodes", kd_nodes);
+    report.add("kd-tree index", kd_index);
+
+    report.add("traffic counters", traffic->memoryUsage());
+    report.add("hierarchical graph", hierarchy->memoryUsage());
+    report.add("contraction hierarchy", contraction->memoryUsage());
+    report.add("reservations", reservations.memoryUsage());
+
+    return report;
+}
+
+// FUNCTION: Generates and exports various statistics, visualizations, and data for the current Warehouse instance. The
+// sections that go over every cell of the floor are formatted in bands of rows, in parallel on a large floor, and written
+// in row order, so the exports do not depend on the number of threads.
 void Warehouse::print() {
+    TRACE_SCOPE("export");
     //
     // Exporting Warehouse Statistics
     //
@@ -274,36 +1046,138 @@ void Warehouse::print() {
 
     stat_out_file << std::endl;
 
+    // Ten buckets of free space wide enough to hold the StorageUnit with the most free space.
+    int width = tree.maxFree() / 10 + 1;
+    std::vector<int> histogram = freeHistogram(width, 10);
+    stat_out_file << "\tFree Space {" << std::endl;
+    stat_out_file << "\t\tUnits With Free Space: " << tree.count(1) << std::endl;
+    stat_out_file << "\t\tTotal Free Space: " << tree.freeSpace(0) << std::endl;
+    stat_out_file << "\t\tLargest Free Space: " << tree.maxFree() << std::endl;
+    stat_out_file << std::endl;
+    for(int b = 0; b < (int)histogram.size(); b++){
+        stat_out_file << "\t\t" << b * width;
+        if(b + 1 < (int)histogram.size()) stat_out_file << "-" << (b + 1) * width - 1;
+        else stat_out_file << "+";
+        stat_out_file << ": " << histogram[b] << std::endl;
+    }
+    stat_out_file << "\t}" << std::endl;
+
+    stat_out_file << std::endl;
+
+    memoryUsage().print(stat_out_file, "\t");
+
+    stat_out_file << std::endl;
+
     stat_out_file << "\tWarehouse Visualization {" << std::endl;
 
-    for(int i = 0; i < units.size(); i++){
-        stat_out_file << "\t\t";
-        for(int j = 0; j < units[i].size(); j++){
-            stat_out_file << units[i][j].getUsedCapacity() << ":" << units[i][j].getCapacity() << " ";
+    // Each row's capacities are read from the Grid at once. Open floor cells are shown as 0:0.
+    writeBands(stat_out_file, units.getRows(), units.getCols(), [&](int first, int last, std::string& text){
+        std::vector<int> row_capacity, row_used;
+        for(int i = first; i < last; i++){
+            units.row(i, row_capacity, row_used);
+            text += "\t\t";
+            for(int j = 0; j < units.getCols(); j++){
+                appendNumber(text, row_used[j]);
+                text += ':';
+                appendNumber(text, row_capacity[j]);
+                text += ' ';
+            }
+            text += '\n';
         }
-        stat_out_file << std::endl;
-    }
+    });
 
     stat_out_file << "\t}" << std::endl;
 
     stat_out_file << std::endl;
 
-    stat_out_file << "\tWarehouse Adjacency List {" << std::endl;
+    stat_out_file << "\tTraffic Heatmap {" << std::endl;
+    stat_out_file << "\t\tRoutes Recorded: " << traffic->getRoutes() << std::endl;
+    stat_out_file << "\t\tCongestion Penalty: " << traffic->getPenalty() << std::endl;
+    stat_out_file << "\t\tHalf Life: " << traffic->getHalfLife() << " routes" << std::endl;
 
-    for(int i = 0; i < graph.size(); i++){
-        stat_out_file << "\t\t";
-        for(int j = 0; j < graph[i].size(); j++){
-            stat_out_file << "(" << graph[i][j].src / units.size() << "," << graph[i][j].src % units.size() << ")->(" << graph[i][j].dest / units.size() << "," << graph[i][j].dest % units.size() << "): " << graph[i][j].weight << (j == graph[i].size() - 1 ? "" : ", ");
+    // The heat of a cell is the traffic on the edges touching it. Only edges with traffic are read, so the heatmap and
+    // the busiest edges cost as much as the traffic, however large the floor.
+    std::map<std::pair<int, int>, long long> heat;
+    std::vector<std::pair<int, std::pair<std::pair<int, int>, std::pair<int, int> > > > busiest;
+    traffic->forEachEdge([&](std::pair<int, int> a, std::pair<int, int> b, int count){
+        heat[a] += count;
+        heat[b] += count;
+        busiest.push_back({count, {a, b}});
+    });
+    long long hottest = 0;
+    for(const std::pair<const std::pair<int, int>, long long>& h : heat) hottest = std::max(hottest, h.second);
+    int listed = std::min<int>(5, busiest.size());
+    std::partial_sort(busiest.begin(), busiest.begin() + listed, busiest.end(), std::greater<std::pair<int, std::pair<std::pair<int, int>, std::pair<int, int> > > >());
+    for(int e = 0; e < listed; e++){
+        std::pair<int, int> a = busiest[e].second.first, b = busiest[e].second.second;
+        stat_out_file << "\t\tBusy Edge: (" << a.first << "," << a.second << ")-(" << b.first << "," << b.second << "): " << busiest[e].first << std::endl;
+    }
+    stat_out_file << std::endl;
+
+    // Only rows with traffic are shown, from their first to their last cell with traffic, each cell as a digit from 0,
+    // no traffic, to 9, the busiest cell.
+    for(std::map<std::pair<int, int>, long long>::iterator it = heat.begin(); it != heat.end();){
+        int row = it->first.first, column = it->first.second;
+        std::string text = "\t\tRow " + std::to_string(row) + ", from column " + std::to_string(column) + ": ";
+        for(; it != heat.end() && it->first.first == row; it++){
+            for(; column < it->first.second; column++) text += '0';
+            appendNumber(text, (it->second * 9 + hottest - 1) / hottest);
+            column++;
         }
-        stat_out_file<<std::endl;
+        stat_out_file << text << std::endl;
     }
 
     stat_out_file << "\t}" << std::endl;
 
+    stat_out_file << std::endl;
+
+    stat_out_file << "\tWarehouse Adjacency List {" << std::endl;
+
+    // Only occupied cells have stored adjacency lists; they are listed in row-major order.
+    int cols = units.getCols();
+    writeBands(stat_out_file, units.getRows(), cols, [&](int first, int last, std::string& text){
+        units.forEachInRows(first, last, [&](const GridCell& u){
+            const std::vector<GraphEdge>& edges = graph->at(coordToIndex(u.loc, cols));
+            text += "\t\t";
+            for(int j = 0; j < edges.size(); j++){
+                std::pair<int, int> src = indexToCoordinates(edges[j].src, cols), dest = indexToCoordinates(edges[j].dest, cols);
+                text += '(';
+                appendNumber(text, src.first);
+                text += ',';
+                appendNumber(text, src.second);
+                text += ")->(";
+                appendNumber(text, dest.first);
+                text += ',';
+                appendNumber(text, dest.second);
+                text += "): ";
+                appendNumber(text, edges[j].weight);
+                if(j != edges.size() - 1) text += ", ";
+            }
+            text += '\n';
+        });
+    });
+
+    stat_out_file << "\t}" << std::endl;
+
+#ifdef WAREHOUSE_METRICS
+    stat_out_file << std::endl;
+    Metrics::instance().print(stat_out_file, "\t");
+#endif
+
     stat_out_file << "}" << std::endl;
 
     stat_out_file.close();
 
+#ifdef WAREHOUSE_METRICS
+    //
+    // Exporting Metrics
+    //
+
+    std::ofstream metrics_out_file("./exports/warehouse_metrics.json");
+    Metrics::instance().printJSON(metrics_out_file);
+    metrics_out_file.close();
+#endif
+
     //
     // Exporting StorageUnit Data
     //
@@ -311,11 +1185,17 @@ void Warehouse::print() {
     std::ofstream units_out_file("./exports/warehouse_units.csv");
 
     units_out_file << "Capacity,XCoord,YCoord" << std::endl;
-    for(std::vector<StorageUnit> row : units){
-        for(StorageUnit u : row){
-            if(u.getCapacity() != 0) units_out_file << u.getCapacity() << "," << u.getLocation().first << "," << u.getLocation().second << std::endl;
-        }
-    }
+    writeBands(units_out_file, units.getRows(), units.getCols(), [&](int first, int last, std::string& text){
+        units.forEachInRows(first, last, [&](const GridCell& u){
+            if(u.capacity == 0) return;
+            appendNumber(text, u.capacity);
+            text += ',';
+            appendNumber(text, u.loc.first);
+            text += ',';
+            appendNumber(text, u.loc.second);
+            text += '\n';
+        });
+    });
 
     units_out_file.close();
 
@@ -326,14 +1206,20 @@ void Warehouse::print() {
     std::ofstream items_out_file("./exports/warehouse_items.csv");
 
     items_out_file << "Name,Quantity,UnitSize" << std::endl;
-    for(int i = 0; i < units.size(); i++){
-        for(int j = 0; j < units[i].size(); j++){
-            auto items = units[i][j].getItems();
-            for(auto i : items){
-                if(i.second.quantity != 0) items_out_file << i.first << "," << i.second.quantity << "," << i.second.size_per_unit << std::endl;
+    writeBands(items_out_file, units.getRows(), units.getCols(), [&](int first, int last, std::string& text){
+        units.forEachInRows(first, last, [&](const GridCell& u){
+            if(u.items == nullptr) return;
+            for(auto& i : *u.items){
+                if(i.second.quantity == 0) continue;
+                text += i.first;
+                text += ',';
+                appendNumber(text, i.second.quantity);
+                text += ',';
+                appendNumber(text, i.second.size_per_unit);
+                text += '\n';
             }
-        }
-    }
+        });
+    });
 
     items_out_file.close();
 
@@ -8,39 +8,140 @@
 #define Warehouse_H
 
 #include "container.h"
+#include "placement.h"
+#include "consolidation.h"
+#include "reservation.h"
 #include "dsa/range_tree.h"
 #include "dsa/algorithms.h"
+#include "dsa/grid.h"
+#include "dsa/kd_tree.h"
+#include "dsa/hpa.h"
+#include "dsa/contraction.h"
+#include "dsa/tour.h"
+#include "dsa/item_index.h"
+#include "dsa/agents.h"
 
 #include <string>
 #include <vector>
 #include <algorithm>
 #include <fstream>
+#include <map>
+#include <memory>
+#include <unordered_map>
+
+//
+// ENUM: RoutingMode
+// How getPath(...) finds the shortest path between two cells. FLAT_ROUTING runs Dijkstra's Algorithm over the whole
+// floor, HPA_ROUTING searches the HierarchicalGraph of clusters first and only refines the clusters along the route, and
+// CH_ROUTING searches the preprocessed ContractionHierarchy.
+//
+
+enum RoutingMode { FLAT_ROUTING, HPA_ROUTING, CH_ROUTING };
+
+//
+// ENUM: PickingMode
+// How getPath(...) visits a series of Items. INPUT_ORDER visits the first StorageUnit holding each Item in the order the
+// Items were given, and OPTIMIZED_ORDER lets the TourPlanner choose which StorageUnit to visit for each Item and the
+// order that makes the walk shortest.
+//
+
+enum PickingMode { INPUT_ORDER, OPTIMIZED_ORDER };
+
+//
+// STRUCTURE: WaveTour
+// One picker's round trip in a wave: the orders it picks, by their position in the wave, the StorageUnits it visits in
+// order, and the distance walked.
+//
+
+struct WaveTour {
+    std::vector<int> orders;
+    std::vector<std::pair<int, int> > stops;
+    long long distance = 0;
+};
+
+//
+// STRUCTURE: WavePlan
+// The tours planned for a wave of orders by Warehouse::planWave(...), the total distance they walk, and the total
+// distance walked if every order were picked on its own round trip instead. SPLIT lists the orders with more Items than
+// a tour can carry, which are picked over several tours.
+//
+
+struct WavePlan {
+    std::vector<WaveTour> tours;
+    std::vector<int> split;
+    long long distance = 0;
+    long long separate = 0;
+};
+
+//
+// STRUCTURE: Withdrawal
+// The quantity of an Item taken from the StorageUnit at LOC by Warehouse::remove(...) or Warehouse::pick(...).
+//
+
+struct Withdrawal {
+    std::pair<int, int> loc;
+    int quantity;
+};
 
 //
 // CLASS: Warehouse
-// This class represents a typical warehouse environment. Each instance of Warehouse contains a 2D vector of StorageUnit
-// instances, a 2D vector of GraphEdge instances to represent traversing the Warehouse space, and a RangeTree instance
-// representing the remaining available space within the Warehouse instance's StorageUnits. Functions of the Warehouse
-// class include adding new StorageUnit and Item instances, finding specific items within the Warehouse, and finding the
-// shortest path between either individual storage units or a series of items. This class employs the three required
+// This class represents a typical warehouse environment. Each instance of Warehouse contains a sparse Grid of StorageUnit
+// instances, adjacency lists of GraphEdge instances to represent traversing the Warehouse space, and a RangeTree instance
+// representing the remaining available space within the Warehouse instance's StorageUnits, along with a KDTree that
+// indexes that space by location. Functions of the Warehouse class include adding new StorageUnit and Item instances,
+// finding specific items or free space within the Warehouse, and finding the shortest path between either individual
+// storage units or a series of items. This class employs the three required
 // data structures and algorithms - Dijkstra's Algorithm, Fractional Knapsack, and Range Tree - to fulfill its objective.
-// The class also stores general usage statistics to be exported at the conclusion of the program.
+// The class also stores general usage statistics to be exported at the conclusion of the program. fork() copies a
+// Warehouse in O(1) for what-if simulations: the copies share their data structures and each only copies the parts it
+// changes.
 //
 
 class Warehouse{
     public:
         // CONSTRUCTORS
         Warehouse();
-        Warehouse(std::vector<StorageUnit> units);
+        Warehouse(const std::vector<StorageUnit>& units);
 
         // FUNCTIONS
 
         // FUNCTION: Add a StorageUnit to the Warehouse without a given location.
         void add_unit(int capacity);
         // FUNCTION: Add a StorageUnit to the Warehouse.
-        void add_unit(StorageUnit i);
+        void add_unit(const StorageUnit& i);
         // FUNCTION: Add an Item to the Warehouse.
-        void add(Item i);
+        void add(const Item& i);
+        // FUNCTION: Removes a quantity of an Item from the Warehouse, oldest stock first.
+        std::vector<Withdrawal> remove(const std::string& name, int quantity);
+        // FUNCTION: Picks a quantity of an Item from the StorageUnits nearest to a location.
+        std::vector<Withdrawal> pick(std::pair<int, int> src, const std::string& name, int quantity);
+        // FUNCTION: Holds space for an inbound Item until the reservation is committed, aborted, or times out. Safe to
+        // call from several threads at once, along with commitReservation(...) and abortReservation(...).
+        long long reserve(const Item& i, long long timeout_ns);
+        // FUNCTION: Commits a reservation, so its Item is stored when reservations are next settled.
+        ReservationState commitReservation(long long id);
+        // FUNCTION: Aborts a reservation, releasing its space.
+        ReservationState abortReservation(long long id);
+        // FUNCTION: Stores the Items of committed reservations, releases expired ones, and updates the free space indexes.
+        // Returns the number of reservations stored in full and the number expired.
+        std::pair<int, int> settleReservations();
+        // FUNCTION: Returns the space held by reservations at a StorageUnit.
+        int reservedAt(std::pair<int, int> loc) { return reservations.held(loc); }
+        // FUNCTION: Sets the PlacementPolicy add(...) uses to choose a StorageUnit.
+        void setPlacement(std::unique_ptr<PlacementPolicy> policy);
+        // FUNCTION: Counts a pick of each of the named Items, for policies that slot Items by how often they are picked.
+        void recordPicks(const std::vector<std::string>& items);
+        // FUNCTION: Adds the pick counts listed in a CSV file to those already recorded.
+        bool loadPicks(const std::string& file);
+
+        // FUNCTION: Sets how getPath(...) finds paths. cluster_size and spacing configure HPA_ROUTING.
+        void setRouting(RoutingMode mode, int cluster_size, int spacing);
+        // FUNCTION: Builds the ContractionHierarchy used by CH_ROUTING, or loads it from a file saved by an earlier run.
+        void preprocessRoutes(const std::string& file);
+        // FUNCTION: Sets how getPath(...) visits a series of Items.
+        void setPicking(PickingMode mode);
+        // FUNCTION: Sets the penalty FLAT_ROUTING adds per unit of traffic on an edge and how quickly traffic is forgotten.
+        void setCongestion(int penalty, int half_life);
 
         // FUNCTION: Returns the total capacity of the Warehouse.
         int getSize();
@@ -51,18 +152,83 @@ class Warehouse{
 
         // FUNCTION: Returns a StorageUnit instance from within the Warehouse.
         StorageUnit getUnit(std::pair<int, int> loc);
+        // FUNCTION: Returns true if a cell is inside the floor.
+        bool inBounds(std::pair<int, int> loc) { return units.inBounds(loc); }
+        // FUNCTION: Returns a counter that changes whenever a StorageUnit is added, and with it the length of paths.
+        unsigned long long layoutVersion() { return layout_version; }
 
         // FUNCTION: Locates all instances of an Item within the Warehouse.
         std::vector<std::pair<int, int> > findItem(std::string i_name);
+        // FUNCTION: Streams every Item whose name matches a pattern with * and ? wildcards, with its locations and quantity.
+        int findItems(const std::string& pattern, const std::function<bool(const std::string&, const ItemLocations&)>& f);
+        // FUNCTION: Returns the number of Items whose names start with a prefix and their total quantity.
+        ItemTotals itemTotals(const std::string& prefix) { return catalog.totals(prefix); }
+        // FUNCTION: Locates the StorageUnits inside a rectangle of the floor with at least a given amount of free space.
+        std::vector<UnitHandle> findSpace(std::pair<int, int> low, std::pair<int, int> high, int space);
+        // FUNCTION: Locates the StorageUnits nearest to a location with at least a given amount of free space.
+        std::vector<UnitHandle> findNearestSpace(std::pair<int, int> loc, int space, int count);
+        // FUNCTION: Returns true if an Item would be stored in full by add(...), splitting it between StorageUnits if needed.
+        bool canStore(const Item& i);
+        // FUNCTION: Returns the largest quantity of an Item with the given size per unit that the Warehouse can still store.
+        long long maxPlaceable(int size_per_unit);
+        // FUNCTION: Returns the number of StorageUnits with at least a given amount of free space and their total free space.
+        std::pair<int, long long> freeSpace(int space);
+        // FUNCTION: Counts the StorageUnits in each bucket of free space.
+        std::vector<int> freeHistogram(int width, int buckets);
+
+        // FUNCTION: Copies every StorageUnit, for planning consolidation while the Warehouse keeps changing.
+        std::vector<SnapshotUnit> snapshot();
+        // FUNCTION: Returns how scattered the Items and free space of the Warehouse are.
+        Fragmentation fragmentation();
+        // FUNCTION: Starts planning a consolidation cycle of at most budget moves on a background thread.
+        bool startConsolidation(int budget);
+        // FUNCTION: Returns true if the consolidation cycle being planned can be committed without waiting.
+        bool consolidationReady();
+        // FUNCTION: Waits for the consolidation cycle being planned and commits its moves. Returns the moves made and skipped.
+        std::pair<int, int> finishConsolidation();
+        // FUNCTION: Plans and commits a consolidation cycle of at most budget moves.
+        std::pair<int, int> consolidate(int budget);
         // FUNCTION: Calculates the shortest path between an origin point and a series of destinations.
         int getPath(std::pair<int, int> src, std::vector<std::pair<int, int> > dest);
         // FUNCTION: Calculates the shortest path between an origin point and a series of items.
         int getPath(std::pair<int, int> src, std::vector<std::string> items);
 
+        // FUNCTION: Finds the shortest path between two cells with the current RoutingMode.
+        std::pair<int, std::vector<std::pair<int, int> > > route(std::pair<int, int> src, std::pair<int, int> dest);
+        // FUNCTION: Returns the length of the shortest path between every pair of cells, row by row.
+        std::vector<int> distanceMatrix(const std::vector<std::pair<int, int> >& points);
+        // FUNCTION: Returns the length of the shortest path from one cell to each of several others.
+        std::vector<int> distances(std::pair<int, int> src, const std::vector<std::pair<int, int> >& targets);
+        // FUNCTION: Chooses a StorageUnit for each Item and the order to visit them in from an origin point.
+        std::vector<std::pair<int, int> > planPick(std::pair<int, int> src, const std::vector<std::string>& items);
+        // FUNCTION: Groups a wave of orders into tours of at most capacity Items and plans each tour from an origin point.
+        WavePlan planWave(std::pair<int, int> src, const std::vector<std::vector<std::string> >& orders, int capacity);
+        // FUNCTION: Plans conflict-free routes for several agents moving on the floor at once within a time budget.
+        AgentPlan planAgents(const std::vector<std::pair<std::pair<int, int>, std::pair<int, int> > >& agents, long long budget_ns);
+
+        // FUNCTION: Returns a copy of the Warehouse that shares its data structures until either one changes them.
+        std::unique_ptr<Warehouse> fork();
+
+        // FUNCTION: Returns the estimated memory used by each of the Warehouse's data structures.
+        MemoryReport memoryUsage();
+
         // FUNCTION: Generates and exports various statistics, visualizations, and data.
         void print();
 
     private:
+        // FUNCTIONS
+
+        // FUNCTION: Lists the candidate StorageUnits of every Item in a pick list.
+        bool pickStops(std::pair<int, int> src, const std::vector<std::string>& items, std::vector<std::pair<int, int> >& points, std::map<std::pair<int, int>, int>& index, std::vector<std::vector<int> >& stops);
+        // FUNCTION: Makes a move planned by the Consolidator if it is still possible.
+        bool commitMove(const ConsolidationMove& move);
+        // FUNCTION: Takes up to a quantity of an Item from one StorageUnit, keeping the counters and indexes up to date.
+        int withdraw(std::pair<int, int> loc, const std::string& name, int quantity);
+        // FUNCTION: Stores a whole Item in one StorageUnit, keeping the counters and indexes up to date.
+        bool store(std::pair<int, int> loc, const Item& i);
+        // FUNCTION: Sets a StorageUnit's free space in the RangeTree and the KDTree, less any space held by reservations.
+        void refresh(std::pair<int, int> loc);
+
         // MEMBER VARIABLES
 
         // NUM_UNITS: The total number of StorageUnit instances present within the Warehouse.
@@ -72,14 +238,48 @@ class Warehouse{
         int capacity = 0;
         // USED_CAPACITY: The total space used between all Item instances in the Warehouse.
         int used_capacity = 0;
+        // LAYOUT_VERSION: A counter bumped by add_unit(...), so callers caching distances can tell when they are stale.
+        unsigned long long layout_version = 0;
 
-        // UNITS: A 2D vector that contains all StorageUnit instances.
-        std::vector<std::vector<StorageUnit> > units;
-        // GRAPH: A 2D vector that contains all GraphEdge instances. This variable is initialized upon calling the buildGraph(...)
-        // function housed in the Algorithms class.
-        std::vector<std::vector<GraphEdge> > graph;
+        // UNITS: A sparse Grid that contains all StorageUnit instances.
+        Grid units;
+        // CATALOG: The StorageUnits holding each Item, kept up to date as Items are stored, moved, and removed.
+        ItemIndex catalog;
+        // GRAPH: The adjacency lists of the occupied cells. This variable is initialized upon calling the buildGraph(...)
+        // function housed in the Algorithms class and kept up to date by updateGraph(...). Shared with forks until one of
+        // them adds a StorageUnit.
+        std::shared_ptr<Graph> graph = std::make_shared<Graph>();
         // TREE: A RangeTree instance.
         RangeTree tree;
+        // SPATIAL: A KDTree over the locations and free space of the StorageUnits.
+        KDTree spatial;
+        // HIERARCHY: The clusters and entrances used by HPA_ROUTING. Kept up to date by add_unit(...) and only
+        // recalculated when a path is requested. Shared with forks until one of them changes it or routes with it.
+        std::shared_ptr<HierarchicalGraph> hierarchy = std::make_shared<HierarchicalGraph>();
+        // CONTRACTION, ROUTES_FILE: The preprocessed graph used by CH_ROUTING and the file it is saved to, if any. The
+        // hierarchy is marked out of date by add_unit(...) and preprocessed again when a path is next requested. Shared
+        // with forks like HIERARCHY.
+        std::shared_ptr<ContractionHierarchy> contraction = std::make_shared<ContractionHierarchy>();
+        std::string routes_file;
+        // ROUTING: The routing mode used by getPath(...).
+        RoutingMode routing = FLAT_ROUTING;
+        // TRAFFIC: How many recent routes crossed each edge, recorded by route(...). Shared with forks until one of them
+        // records a route or changes its congestion settings, and copied to a new map when the floor grows.
+        std::shared_ptr<TrafficMap> traffic = std::make_shared<TrafficMap>(1, 1);
+        // PICKING, PLANNER: The picking mode used by getPath(...) and the planner that orders the stops in OPTIMIZED_ORDER.
+        PickingMode picking = INPUT_ORDER;
+        TourPlanner planner;
+        // PLACEMENT: The policy used by add(...) to choose StorageUnits.
+        std::unique_ptr<PlacementPolicy> placement = std::unique_ptr<PlacementPolicy>(new BestFitPolicy());
+        // PICKS, PICKS_VERSION: How many times each Item has been picked, shared with forks until one of them records a
+        // pick, and a counter bumped whenever that changes.
+        std::shared_ptr<std::unordered_map<std::string, long long> > picks = std::make_shared<std::unordered_map<std::string, long long> >();
+        unsigned long long picks_version = 0;
+        // CONSOLIDATOR: Plans consolidation cycles on a background thread.
+        Consolidator consolidator;
+        // RESERVATIONS: The space held for inbound Items by reserve(...). The RangeTree and KDTree give each StorageUnit's
+        // free space less the space held there, as of the last time reservations were settled.
+        ReservationBook reservations;
 };
 
 #endif